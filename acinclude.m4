@@ -167,12 +167,18 @@ AC_DEFUN([AC_TINYTAC_OPENSSL],[dnl
 
    HAVE_OPENSSL=yes
    AC_CHECK_HEADERS( [openssl/evp.h],                     [], [HAVE_OPENSSL=no] )
+   AC_CHECK_HEADERS( [openssl/hmac.h],                    [], [HAVE_OPENSSL=no] )
+   AC_CHECK_HEADERS( [openssl/rand.h],                    [], [HAVE_OPENSSL=no] )
    AC_SEARCH_LIBS(   [EVP_md5],                 [crypto], [], [HAVE_OPENSSL=no], [] )
    AC_SEARCH_LIBS(   [EVP_Digest],              [crypto], [], [HAVE_OPENSSL=no], [] )
    AC_SEARCH_LIBS(   [EVP_DigestInit_ex],       [crypto], [], [HAVE_OPENSSL=no], [] )
    AC_SEARCH_LIBS(   [EVP_DigestUpdate],        [crypto], [], [HAVE_OPENSSL=no], [] )
    AC_SEARCH_LIBS(   [EVP_DigestFinal_ex],      [crypto], [], [HAVE_OPENSSL=no], [] )
    AC_SEARCH_LIBS(   [EVP_MD_CTX_free],         [crypto], [], [HAVE_OPENSSL=no], [] )
+   AC_SEARCH_LIBS(   [EVP_sha256],              [crypto], [], [HAVE_OPENSSL=no], [] )
+   AC_SEARCH_LIBS(   [HMAC],                    [crypto], [], [HAVE_OPENSSL=no], [] )
+   AC_SEARCH_LIBS(   [PKCS5_PBKDF2_HMAC],       [crypto], [], [HAVE_OPENSSL=no], [] )
+   AC_SEARCH_LIBS(   [RAND_bytes],              [crypto], [], [HAVE_OPENSSL=no], [] )
 
    if test "x${HAVE_OPENSSL}" != "xyes";then
       AC_MSG_ERROR([unable to find OpenSSL])
@@ -205,4 +211,30 @@ AC_DEFUN([AC_TINYTAC_TINYTAC],[dnl
    AM_CONDITIONAL([DISABLE_TINYTAC], [test "$ENABLE_TINYTAC" = "no"])
 ])dnl
 
+
+
+# AC_TINYTAC_TINYTACD()
+# ______________________________________________________________________________
+AC_DEFUN([AC_TINYTAC_TINYTACD],[dnl
+
+   enableval=""
+   AC_ARG_ENABLE(
+      tinytacd,
+      [AS_HELP_STRING([--disable-tinytacd], [disable TinyTac proxy daemon])],
+      [ ETINYTACD=$enableval ],
+      [ ETINYTACD=$enableval ]
+   )
+
+   if test "x${ETINYTACD}" == "xyes";then
+      ENABLE_TINYTACD="yes"
+   elif test "x${ETINYTACD}" == "xno";then
+      ENABLE_TINYTACD="no"
+   else
+      ENABLE_TINYTACD="yes"
+   fi
+
+   AM_CONDITIONAL([ENABLE_TINYTACD],  [test "$ENABLE_TINYTACD" = "yes"])
+   AM_CONDITIONAL([DISABLE_TINYTACD], [test "$ENABLE_TINYTACD" = "no"])
+])dnl
+
 # end of m4 file
@@ -112,6 +112,9 @@
 #define TTAC_EOPTION                0x0009 ///< invalid or unknown option
 #define TTAC_EOPTVAL                0x000a ///< invalid option value
 #define TTAC_ESTOPINIT              0x000b ///< stop configuration initialization (used internally)
+#define TTAC_ENETWORK               0x000c ///< network or socket error
+#define TTAC_EBADMSG                0x000d ///< malformed or unexpected packet
+#define TTAC_EUNAVAIL               0x000e ///< no TACACS+ server available
 
 
 // library user options
@@ -128,6 +131,8 @@
 #define TTAC_CHAP                   0x00000400U  ///< allow CHAP authentication
 #define TTAC_MSCHAP                 0x00000800U  ///< allow MSCHAP authentication
 #define TTAC_MSCHAPV2               0x00001000U  ///< allow MSCHAPv2 authentication
+#define TTAC_COALESCE               0x00002000U  ///< coalesce identical in-flight authorization requests
+#define TTAC_CONF_WATCH             0x00004000U  ///< follow changes of servers and keys in configuration files
 #define TTAC_AUTHEN_TYPES           (TTAC_ASCII | TTAC_PAP | TTAC_CHAP | TTAC_MSCHAP | TTAC_MSCHAPV2 )
 #define TTAC_IP_UNSPEC              (TTAC_IPV4 | TTAC_IPV6)
 #define TTAC_RND_METHODS            (TTAC_RAND | TTAC_RANDOM | TTAC_URANDOM)
@@ -156,6 +161,92 @@
 #define TTAC_OPT_AUTHEN_CHAP        22
 #define TTAC_OPT_AUTHEN_MSCHAP      23
 #define TTAC_OPT_AUTHEN_MSCHAPV2    24
+#define TTAC_OPT_COALESCE           25
+#define TTAC_OPT_CACHE_SIZE         26
+#define TTAC_OPT_CACHE_TTL          27
+#define TTAC_OPT_CACHE_NEG_TTL      28
+#define TTAC_OPT_SHM_CACHE          29
+#define TTAC_OPT_SERVER_RETRY       30
+#define TTAC_OPT_OFFLINE_DIR        31
+#define TTAC_OPT_OFFLINE_MAX_AGE    32
+#define TTAC_OPT_OFFLINE_LOCKOUT    33
+#define TTAC_OPT_PROXY              34
+#define TTAC_OPT_ACCT_QUEUE         35
+#define TTAC_OPT_ACCT_POLICY        36
+#define TTAC_OPT_ACCT_SPOOL         37
+#define TTAC_OPT_ACCT_SPOOL_SIZE    38
+#define TTAC_OPT_ACCT_REPLAY_RATE   39
+#define TTAC_OPT_ACCT_WATCHDOG      40
+#define TTAC_OPT_CONF_WATCH         41
+#define TTAC_OPT_CAPTURE            42
+#define TTAC_OPT_CAPTURE_SIZE       43
+#define TTAC_OPT_CAPTURE_PLAIN      44
+#define TTAC_OPT_STATS              45
+#define TTAC_OPT_STATS_SERVERS      46
+#define TTAC_OPT_STATS_RESET        47
+#define TTAC_OPT_TRACE              48
+
+
+// library request flags
+#define TTAC_REQ_NONE               0x00000000U
+#define TTAC_REQ_NOCOALESCE         0x00000001U  ///< do not coalesce request with identical in-flight requests
+#define TTAC_REQ_NOCACHE            0x00000002U  ///< do not use or update authorization cache
+#define TTAC_REQ_NOOFFLINE          0x00000004U  ///< do not fall back to offline authentication
+
+
+// accounting queue policies when the queue is full
+#define TTAC_ACCT_BLOCK             1   ///< wait for space in queue
+#define TTAC_ACCT_DROP              2   ///< discard oldest queued record
+#define TTAC_ACCT_SPILL             3   ///< append record to TTAC_OPT_ACCT_SPOOL
+
+
+// tinytacd control requests, sent to the socket of TTAC_OPT_PROXY and
+// obfuscated with the key like other requests
+#define TTAC_PROXY_TYPE_STATS       0xf0           ///< packet type requesting statistics of tinytacd
+#define TTAC_PROXY_STATS_BODY       "openmetrics"  ///< body of statistics request
+
+
+// latency phases of requests
+#define TTAC_PHASE_RESOLVE          0   ///< resolving name of server
+#define TTAC_PHASE_CONNECT          1   ///< connecting to server
+#define TTAC_PHASE_SEND             2   ///< writing request
+#define TTAC_PHASE_FIRST_BYTE       3   ///< from request written until header of reply is read
+#define TTAC_PHASE_REPLY            4   ///< from request written until reply is read
+#define TTAC_PHASE_DEOBFUSCATE      5   ///< de-obfuscating reply
+#define TTAC_PHASES                 6
+#define TTAC_STATS_BUCKETS          240 ///< buckets of latency histograms
+
+
+// well-known AV pair attributes (RFC 8907 sections 8.2 and 8.3)
+#define TTAC_AV_UNKNOWN             0
+#define TTAC_AV_ACL                 1   ///< acl
+#define TTAC_AV_ADDR                2   ///< addr
+#define TTAC_AV_ADDR_POOL           3   ///< addr-pool
+#define TTAC_AV_AUTOCMD             4   ///< autocmd
+#define TTAC_AV_BYTES_IN            5   ///< bytes_in
+#define TTAC_AV_BYTES_OUT           6   ///< bytes_out
+#define TTAC_AV_CMD                 7   ///< cmd
+#define TTAC_AV_CMD_ARG             8   ///< cmd-arg
+#define TTAC_AV_ELAPSED_TIME        9   ///< elapsed_time
+#define TTAC_AV_ERR_MSG             10  ///< err_msg
+#define TTAC_AV_EVENT               11  ///< event
+#define TTAC_AV_IDLETIME            12  ///< idletime
+#define TTAC_AV_INACL               13  ///< inacl
+#define TTAC_AV_NOESCAPE            14  ///< noescape
+#define TTAC_AV_NOHANGUP            15  ///< nohangup
+#define TTAC_AV_OUTACL              16  ///< outacl
+#define TTAC_AV_PAKS_IN             17  ///< paks_in
+#define TTAC_AV_PAKS_OUT            18  ///< paks_out
+#define TTAC_AV_PRIV_LVL            19  ///< priv-lvl
+#define TTAC_AV_PROTOCOL            20  ///< protocol
+#define TTAC_AV_REASON              21  ///< reason
+#define TTAC_AV_SERVICE             22  ///< service
+#define TTAC_AV_START_TIME          23  ///< start_time
+#define TTAC_AV_STOP_TIME           24  ///< stop_time
+#define TTAC_AV_TASK_ID             25  ///< task_id
+#define TTAC_AV_TIMEOUT             26  ///< timeout
+#define TTAC_AV_TIMEZONE            27  ///< timezone
+#define TTAC_AV_MAX                 28
 
 
 // library debug levels
@@ -180,6 +271,24 @@
 #define TTAC_DFLT_TIMEOUT                 10
 #define TTAC_DFLT_NET_TIMEOUT_SEC         10
 #define TTAC_DFLT_NET_TIMEOUT_USEC        0
+#define TTAC_DFLT_CACHE_SIZE              0
+#define TTAC_DFLT_CACHE_TTL               60
+#define TTAC_DFLT_CACHE_NEG_TTL           5
+#define TTAC_DFLT_SHM_CACHE               NULL
+#define TTAC_DFLT_SERVER_RETRY            30
+#define TTAC_DFLT_OFFLINE_DIR             NULL
+#define TTAC_DFLT_OFFLINE_MAX_AGE         604800
+#define TTAC_DFLT_OFFLINE_LOCKOUT         5
+#define TTAC_DFLT_PROXY                   NULL
+#define TTAC_DFLT_ACCT_QUEUE              1024
+#define TTAC_DFLT_ACCT_POLICY             TTAC_ACCT_BLOCK
+#define TTAC_DFLT_ACCT_SPOOL              NULL
+#define TTAC_DFLT_ACCT_SPOOL_SIZE         16777216
+#define TTAC_DFLT_ACCT_REPLAY_RATE        1000
+#define TTAC_DFLT_ACCT_WATCHDOG           600
+#define TTAC_DFLT_CAPTURE                 NULL
+#define TTAC_DFLT_CAPTURE_SIZE            0
+#define TTAC_DFLT_CAPTURE_PLAIN           TTAC_NO
 
 
 //////////////////
@@ -198,6 +307,11 @@ typedef struct _tinytac_author_request    tinytac_author_req_t;
 typedef struct _tinytac_author_reply      tinytac_author_reply_t;
 typedef struct _tinytac_account_request   tinytac_acct_req_t;
 typedef struct _tinytac_account_reply     tinytac_acct_reply_t;
+typedef struct _tinytac_slice             tinytac_slice_t;
+typedef struct _tinytac_reply_view        tinytac_reply_view_t;
+typedef struct _tinytac_avpairs           tinytac_avpairs_t;
+typedef struct _tinytac_stats             tinytac_stats_t;
+typedef struct _tinytac_trace             tinytac_trace_t;
 
 
 struct _tinytac_packet
@@ -293,6 +407,79 @@ struct _tinytac_account_reply
 };
 
 
+// pointer and length of a field within a packet body, not terminated
+struct _tinytac_slice
+{
+   const char *         ptr;
+   size_t               len;
+};
+
+
+// validated REPLY of any packet type referencing the packet body
+struct _tinytac_reply_view
+{
+   uint8_t              type;          // packet type
+   uint8_t              status;
+   uint8_t              flags;         // authentication REPLY flags
+   unsigned             arg_cnt;       // authorization REPLY AV pairs
+   tinytac_slice_t      server_msg;
+   tinytac_slice_t      data;
+   tinytac_slice_t      args[255];
+};
+
+
+// AV pairs split into parallel arrays, values follow the separator of the
+// name and all strings reference the packet body
+struct _tinytac_avpairs
+{
+   unsigned             count;
+   uint8_t              index[TTAC_AV_MAX];  // position + 1 of first pair of each well-known attribute
+   uint8_t              id[255];             // TTAC_AV_* attribute
+   uint8_t              optional[255];       // separator was '*'
+   uint8_t              name_len[255];
+   uint8_t              value_len[255];
+   const char *         name[255];
+};
+
+
+// Latencies are counted in log-linear histograms of microseconds.  Values
+// below 16 have a bucket each, larger values are split into 8 buckets per
+// power of two, so a bucket is at most 12.5% wide.  Use
+// tinytac_stats_bucket() to find the range of a bucket.
+struct _tinytac_stats
+{
+   char                 server[128];         // host and port of server, empty for handle
+   uint64_t             requests;
+   uint64_t             failures;
+   uint64_t             timeouts;
+   uint64_t             retries;             // servers skipped after failure
+   uint64_t             cache_hits;          // authorizations answered by caches, handle only
+   uint64_t             cache_misses;
+   uint64_t             count[TTAC_PHASES];  // samples of each phase
+   uint64_t             sum[TTAC_PHASES];    // microseconds of each phase
+   uint64_t             hist[TTAC_PHASES][TTAC_STATS_BUCKETS];
+};
+
+
+// Timing of the last authentication or authorization made by the calling
+// thread, returned by the TTAC_OPT_TRACE option.  Times are nanoseconds of
+// the monotonic clock and a phase which did not occur has a start of zero.
+// Phases of a failed server are replaced by those of the next server tried,
+// a bulk authorization keeps the phases of its last request, and a request
+// answered by a cache or by a coalesced request has no phases.
+struct _tinytac_trace
+{
+   uint64_t             start;                     // request started
+   uint64_t             end;                       // request returned
+   uint64_t             phase_start[TTAC_PHASES];
+   uint64_t             phase_end[TTAC_PHASES];
+   uint32_t             session_id;                // zero if no request was sent
+   int                  server;                    // position in list of hosts, -1 if none
+   int                  result;                    // TTAC_* result of request
+   unsigned             attempts;                  // servers tried
+};
+
+
 //////////////////
 //              //
 //  Prototypes  //
@@ -300,6 +487,292 @@ struct _tinytac_account_reply
 //////////////////
 #pragma mark - Prototypes
 
+//-----------------------//
+// accounting prototypes //
+//-----------------------//
+#pragma mark accounting prototypes
+
+/// queues accounting REQUEST for delivery by a background worker
+///
+/// The function returns without waiting for the server.  A worker started
+/// with the first record sends queued records in batches, pipelining many
+/// sessions on one connection when the server supports single-connect mode.
+/// The queue holds TTAC_OPT_ACCT_QUEUE records.  When it is full, the
+/// TTAC_OPT_ACCT_POLICY option selects whether the caller waits, the oldest
+/// record is dropped, or the record is appended to TTAC_OPT_ACCT_SPOOL.
+/// Records which cannot be delivered are appended to the spool if
+/// TTAC_OPT_ACCT_SPOOL is set.  The spool is a memory mapped ring of
+/// TTAC_OPT_ACCT_SPOOL_SIZE bytes which survives crashes of the process and
+/// may be shared by several processes.  It is written to disk whenever the
+/// queue becomes empty and replayed at TTAC_OPT_ACCT_REPLAY_RATE records per
+/// second once a server is reachable.  Queued records are sent before the
+/// handle is freed.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  pckt          accounting REQUEST built by tinytac_pckt_acct_req()
+///
+/// @return    Returns TTAC_SUCCESS if the library took ownership of the
+///            packet, TTAC_EINVAL if the packet is not an accounting
+///            REQUEST, or an error code.
+_TINYTAC_F int
+tinytac_acct_submit(
+         TinyTac *                     tt,
+         tinytac_pckt_t *              pckt );
+
+
+/// stops watchdog records of session
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  id            session identifier returned by tinytac_acct_watch()
+///
+/// @return    Returns TTAC_SUCCESS on success or TTAC_ENOENT if the session
+///            is not registered.
+_TINYTAC_F int
+tinytac_acct_unwatch(
+         TinyTac *                     tt,
+         uint32_t                      id );
+
+
+/// registers session for periodic watchdog records
+///
+/// Every TTAC_OPT_ACCT_WATCHDOG seconds, plus or minus ten percent so that
+/// sessions started together do not report together, the worker sends a
+/// WATCHDOG copy of the START record with an elapsed_time argument.  Due
+/// records are pipelined in batches on one connection.  The START record is
+/// copied, so the session is registered before the record is passed to
+/// tinytac_acct_submit().  The application calls tinytac_acct_unwatch()
+/// before it submits the STOP record.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  start         accounting START record built by tinytac_pckt_acct_req()
+/// @param[out] idp           pointer to store session identifier
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if the packet is
+///            not an accounting REQUEST, or an error code.
+_TINYTAC_F int
+tinytac_acct_watch(
+         TinyTac *                     tt,
+         const tinytac_pckt_t *        start,
+         uint32_t *                    idp );
+
+
+//---------------------------//
+// authentication prototypes //
+//---------------------------//
+#pragma mark authentication prototypes
+
+/// authenticates user with ASCII or PAP login
+///
+/// If TTAC_OPT_OFFLINE_DIR is set, a salted PBKDF2 verifier of the password
+/// is stored in the directory after each successful login.  When no server
+/// can be reached because every server failed within the last
+/// TTAC_OPT_SERVER_RETRY seconds, the password is checked against the
+/// stored verifier instead.  Verifiers older than TTAC_OPT_OFFLINE_MAX_AGE
+/// seconds are not used, and a user is locked out of offline
+/// authentication after TTAC_OPT_OFFLINE_LOCKOUT consecutive offline
+/// failures until the next successful online login.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  s             socket connected to TACACS+ server or -1 to
+///                           connect to configured servers
+/// @param[in]  user          user name
+/// @param[in]  pass          password
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_ASCII or TAC_PLUS_AUTHEN_TYPE_PAP
+/// @param[in]  flags         request flags (TTAC_REQ_NOOFFLINE)
+///
+/// @return    Returns TTAC_SUCCESS if the user was authenticated, TTAC_EACCES
+///            if authentication failed, or an error code.
+_TINYTAC_F int
+tinytac_authen_login(
+         TinyTac *                     tt,
+         int                           s,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         unsigned                      flags );
+
+
+//--------------------------//
+// authorization prototypes //
+//--------------------------//
+#pragma mark authorization prototypes
+
+/// sends authorization request and waits for the server's reply
+///
+/// If TTAC_OPT_CACHE_SIZE is non-zero, replies are cached by user,
+/// priv_lvl, authen_service, authen_method and arguments.  PASS_ADD and
+/// PASS_REPL replies are cached for TTAC_OPT_CACHE_TTL seconds and FAIL
+/// replies for TTAC_OPT_CACHE_NEG_TTL seconds.
+///
+/// If TTAC_OPT_SHM_CACHE names a POSIX shared memory object (or a file),
+/// replies are also shared with other processes using the same segment.
+/// Entries are authenticated with the handle's shared secret and the shared
+/// cache is not used if no secret is configured.
+///
+/// If TTAC_OPT_COALESCE is enabled on the handle, a request whose body is
+/// identical to a request already in flight on the same handle is not sent.
+/// The caller instead waits for the in-flight request and receives a copy
+/// of its reply.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  s             socket connected to TACACS+ server or -1 to
+///                           connect to configured servers
+/// @param[in]  req           authorization REQUEST packet
+/// @param[out] replyp        pointer to store authorization REPLY packet
+/// @param[in]  flags         request flags (TTAC_REQ_NOCOALESCE, TTAC_REQ_NOCACHE)
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+_TINYTAC_F int
+tinytac_author(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp,
+         unsigned                      flags );
+
+
+/// sends a list of authorization requests, such as the commands of a
+/// script, as one burst
+///
+/// Each request is a separate session built by tinytac_pckt_author_req().
+/// Replies found in the authorization caches are used as with
+/// tinytac_author(), but requests are not coalesced.  The first remaining
+/// request is exchanged on its own.  If the server's reply acknowledges
+/// single-connect mode, all other requests are written to the same
+/// connection at once and their replies are read in any order.  Otherwise
+/// the requests are spread over several connections and sent before any
+/// reply is read.  Either way the list costs about two round trips instead
+/// of one round trip per request.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  s             socket connected to TACACS+ server or -1 to
+///                           connect to configured servers
+/// @param[in]  reqs          authorization REQUEST packets
+/// @param[out] replies       array to store authorization REPLY packets, NULL
+///                           if request failed
+/// @param[out] results       array to store TTAC_SUCCESS or error code of each request
+/// @param[in]  cnt           number of requests
+/// @param[in]  flags         request flags (TTAC_REQ_NOCACHE)
+///
+/// @return    Returns TTAC_SUCCESS if every request received a reply,
+///            TTAC_EINVAL if a packet is not an authorization REQUEST, or the
+///            error code of the first failed request.
+_TINYTAC_F int
+tinytac_author_bulk(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         size_t                        cnt,
+         unsigned                      flags );
+
+
+/// merges arguments of an authorization REPLY into the request arguments
+///
+/// For TAC_PLUS_AUTHOR_STATUS_PASS_REPL the result is the reply arguments.
+/// For TAC_PLUS_AUTHOR_STATUS_PASS_ADD request arguments are kept unless
+/// the reply contains the same attribute, in which case all request pairs
+/// of that attribute are superseded by the reply pairs.  The resulting NULL
+/// terminated argument vector and its strings are stored in 'arena', no
+/// memory is allocated.
+///
+/// @param[in]  args          NULL terminated request arguments
+/// @param[in]  reply         unobfuscated authorization REPLY packet
+/// @param[in]  arena         buffer to store result
+/// @param[in]  arena_len     size of buffer
+/// @param[out] argvp         pointer to store argument vector
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if the reply
+///            status is not PASS_ADD or PASS_REPL, TTAC_ENOBUFS if the arena
+///            is too small, or an error code.
+_TINYTAC_F int
+tinytac_author_merge(
+         const char * const *          args,
+         const tinytac_pckt_t *        reply,
+         void *                        arena,
+         size_t                        arena_len,
+         char ***                      argvp );
+
+
+//--------------------//
+// AV pair prototypes //
+//--------------------//
+#pragma mark AV pair prototypes
+
+/// returns TTAC_AV_* identifier of attribute name
+///
+/// @param[in]  name          attribute name, need not be terminated
+/// @param[in]  len           length of attribute name
+///
+/// @return    Returns attribute identifier or TTAC_AV_UNKNOWN.
+_TINYTAC_F unsigned
+tinytac_av_id(
+         const char *                  name,
+         size_t                        len );
+
+
+/// returns name of well-known attribute
+///
+/// @param[in]  id            TTAC_AV_* attribute identifier
+///
+/// @return    Returns attribute name or NULL if the identifier is unknown.
+_TINYTAC_F const char *
+tinytac_av_name(
+         unsigned                      id );
+
+
+/// returns first pair of a well-known attribute as an integer
+///
+/// @param[in]  avp           parsed AV pairs
+/// @param[in]  id            TTAC_AV_* attribute identifier
+/// @param[out] valp          pointer to store value
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_ENOENT if the attribute
+///            is not present, or TTAC_ESYNTAX if the value is not a decimal
+///            integer.
+_TINYTAC_F int
+tinytac_avpairs_get_int(
+         const tinytac_avpairs_t *     avp,
+         unsigned                      id,
+         long long *                   valp );
+
+
+/// returns value of first pair of a well-known attribute
+///
+/// @param[in]  avp           parsed AV pairs
+/// @param[in]  id            TTAC_AV_* attribute identifier
+/// @param[out] valp          slice to store value
+///
+/// @return    Returns TTAC_SUCCESS on success or TTAC_ENOENT if the
+///            attribute is not present.
+_TINYTAC_F int
+tinytac_avpairs_get_str(
+         const tinytac_avpairs_t *     avp,
+         unsigned                      id,
+         tinytac_slice_t *             valp );
+
+
+/// splits AV pairs into name and value without copying
+///
+/// Each pair is scanned once for the first '=' (mandatory) or '*'
+/// (optional) separator and its name is mapped to a TTAC_AV_* identifier.
+/// The pairs reference the strings in 'args', typically the args of a
+/// tinytac_reply_view_t.
+///
+/// @param[out] avp           AV pairs to populate
+/// @param[in]  args          AV pair strings
+/// @param[in]  arg_cnt       number of AV pair strings (at most 255)
+///
+/// @return    Returns TTAC_SUCCESS on success or TTAC_ESYNTAX if a pair
+///            has no separator or an empty name.
+_TINYTAC_F int
+tinytac_avpairs_parse(
+         tinytac_avpairs_t *           avp,
+         const tinytac_slice_t *       args,
+         unsigned                      arg_cnt );
+
+
 //-----------------//
 // conf prototypes //
 //-----------------//
@@ -352,6 +825,28 @@ tinytac_initialize(
          unsigned                      opts );
 
 
+/// sets functions used to allocate memory of the library
+///
+/// Must be called before any other library function because memory is
+/// always released with the functions in effect when it is freed.  Packets
+/// returned by the library are allocated with these functions and must be
+/// released with tinytac_free().  Strings and arrays returned by
+/// tinytac_get_option() are allocated with malloc().  Passing NULL for all
+/// functions restores the allocator of the C library.
+///
+/// @param[in]  malloc_func   function used to allocate memory
+/// @param[in]  realloc_func  function used to resize memory
+/// @param[in]  free_func     function used to free memory
+///
+/// @return    Returns TTAC_SUCCESS on success or TTAC_EINVAL if only some of
+///            the functions are set.
+_TINYTAC_F int
+tinytac_set_allocator(
+         void * (*malloc_func)(size_t size),
+         void * (*realloc_func)(void * ptr, size_t size),
+         void (*free_func)(void * ptr) );
+
+
 _TINYTAC_F int
 tinytac_set_option(
          TinyTac *                     tt,
@@ -364,6 +859,24 @@ tinytac_set_option(
 //--------------------//
 #pragma mark network prototypes
 
+/// connects to first available configured server
+///
+/// Servers which failed within the last TTAC_OPT_SERVER_RETRY seconds are
+/// skipped without a connection attempt.  If TTAC_OPT_PROXY names the Unix
+/// domain socket of a tinytacd proxy, the proxy is used instead of the
+/// servers while the proxy is reachable.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[out] sp            pointer to store connected socket
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EUNAVAIL if no server
+///            could be reached, or an error code.
+_TINYTAC_F int
+tinytac_connect(
+         TinyTac *                     tt,
+         int *                         sp );
+
+
 _TINYTAC_F int
 tinytac_recv(
          int                           s,
@@ -383,8 +896,119 @@ tinytac_send(
 //---------------------//
 #pragma mark protocol prototypes
 
+/// builds accounting REQUEST packet
+///
+/// The size of the packet is computed from the arguments and the packet is
+/// allocated once.  String arguments may be NULL.  The packet is returned
+/// unobfuscated with a new session_id and seq_no 1.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  flags         TAC_PLUS_ACCT_FLAG_START, _STOP or _WATCHDOG
+/// @param[in]  authen_method TAC_PLUS_AUTHEN_METH_*
+/// @param[in]  priv_lvl      privilege level
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_*
+/// @param[in]  authen_service TAC_PLUS_AUTHEN_SVC_*
+/// @param[in]  user          user name
+/// @param[in]  port          port name
+/// @param[in]  rem_addr      remote address
+/// @param[in]  args          NULL terminated list of AV pairs
+/// @param[out] pcktp         pointer to store packet
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if a field
+///            exceeds 255 bytes or more than 255 AV pairs are given, or an
+///            error code.
+_TINYTAC_F int
+tinytac_pckt_acct_req(
+         TinyTac *                     tt,
+         uint8_t                       flags,
+         uint8_t                       authen_method,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp );
+
+
+/// builds authentication START packet
+///
+/// The size of the packet is computed from the arguments and the packet is
+/// allocated once.  String arguments may be NULL.  The packet is returned
+/// unobfuscated with a new session_id and seq_no 1.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  action        TAC_PLUS_AUTHEN_LOGIN, _CHPASS or _SENDAUTH
+/// @param[in]  priv_lvl      privilege level
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_*
+/// @param[in]  authen_service TAC_PLUS_AUTHEN_SVC_*
+/// @param[in]  user          user name
+/// @param[in]  port          port name
+/// @param[in]  rem_addr      remote address
+/// @param[in]  data          authentication data
+/// @param[in]  data_len      length of authentication data
+/// @param[out] pcktp         pointer to store packet
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if a field
+///            exceeds 255 bytes, or an error code.
+_TINYTAC_F int
+tinytac_pckt_authen_start(
+         TinyTac *                     tt,
+         uint8_t                       action,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const void *                  data,
+         size_t                        data_len,
+         tinytac_pckt_t **             pcktp );
+
+
+/// builds authorization REQUEST packet
+///
+/// The size of the packet is computed from the arguments and the packet is
+/// allocated once.  String arguments may be NULL.  The packet is returned
+/// unobfuscated with a new session_id and seq_no 1.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  authen_method TAC_PLUS_AUTHEN_METH_*
+/// @param[in]  priv_lvl      privilege level
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_*
+/// @param[in]  authen_service TAC_PLUS_AUTHEN_SVC_*
+/// @param[in]  user          user name
+/// @param[in]  port          port name
+/// @param[in]  rem_addr      remote address
+/// @param[in]  args          NULL terminated list of AV pairs
+/// @param[out] pcktp         pointer to store packet
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if a field
+///            exceeds 255 bytes or more than 255 AV pairs are given, or an
+///            error code.
+_TINYTAC_F int
+tinytac_pckt_author_req(
+         TinyTac *                     tt,
+         uint8_t                       authen_method,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp );
+
+
 /// prints hexdump of packet to file stream
 ///
+/// To record the packets exchanged with servers for protocol analyzers, set
+/// TTAC_OPT_CAPTURE to the path of a pcapng file instead.  The file is
+/// rotated when it would exceed TTAC_OPT_CAPTURE_SIZE bytes, and copies of
+/// the packets with de-obfuscated bodies are also recorded when
+/// TTAC_OPT_CAPTURE_PLAIN is enabled.
+///
 /// @param[in]  fs            write hexdump to file stream 'fs'
 /// @param[in]  pckt          packet used to generate psuedo-random pad
 /// @param[in]  prefix        string to prepend to each line
@@ -428,4 +1052,82 @@ tinytac_pckt_obfuscate(
          size_t                        key_len,
          unsigned                      unencrypted );
 
+
+/// validates REPLY packet and maps its fields without copying
+///
+/// The packet is checked once, with every length bounded by the body, and
+/// the view references the packet body directly.  The view is valid until
+/// the packet is freed.  The packet must not be obfuscated.
+///
+/// @param[in]  reply         authentication, authorization or accounting REPLY packet
+/// @param[out] view          view to populate
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EINVAL if the packet is
+///            obfuscated, or TTAC_EBADMSG if the packet is malformed.
+_TINYTAC_F int
+tinytac_pckt_reply_view(
+         const tinytac_pckt_t *        reply,
+         tinytac_reply_view_t *        view );
+
+
+//------------------//
+// stats prototypes //
+//------------------//
+#pragma mark stats prototypes
+
+/// returns largest latency counted in histogram bucket
+///
+/// The smallest latency of a bucket is one more than the largest latency
+/// of the previous bucket.
+///
+/// @param[in]  idx           bucket of histogram
+///
+/// @return    Returns latency in microseconds.
+_TINYTAC_F uint64_t
+tinytac_stats_bucket(
+         size_t                        idx );
+
+
+/// returns latency below which a percentage of samples of a phase fall
+///
+/// Handle statistics are returned by the TTAC_OPT_STATS option and the
+/// statistics of each server by the TTAC_OPT_STATS_SERVERS option.
+/// Setting TTAC_OPT_STATS_RESET starts counting again from zero.
+///
+/// @param[in]  stats         statistics of handle or server
+/// @param[in]  phase         TTAC_PHASE_* phase of requests
+/// @param[in]  percentile    percentage of samples, 0 to 100
+///
+/// @return    Returns upper bound of latency in microseconds or 0 if the
+///            phase has no samples.
+_TINYTAC_F uint64_t
+tinytac_stats_percentile(
+         const tinytac_stats_t *       stats,
+         unsigned                      phase,
+         double                        percentile );
+
+
+/// renders statistics of handle in OpenMetrics text format
+///
+/// Counters and latency histograms of the handle and of each server, idle
+/// sessions, cache entries and queued accounting records are written to
+/// the buffer without allocating memory, terminated by "# EOF".  Latencies
+/// are exported in seconds with the same bucket boundaries, the powers of
+/// two from 8 microseconds, on every call.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[out] buff          buffer to store text or NULL if size is 0
+/// @param[in]  size          size of buffer
+/// @param[out] lenp          pointer to store length of complete text
+///                           without the terminating NUL, or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_ENOBUFS if the text was
+///            truncated, or an error code.
+_TINYTAC_F int
+tinytac_stats_openmetrics(
+         TinyTac *                     tt,
+         char *                        buff,
+         size_t                        size,
+         size_t *                      lenp );
+
 #endif /* end of header */
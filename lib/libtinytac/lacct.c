@@ -0,0 +1,1403 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LACCT_C 1
+#include "lacct.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "lcache.h"
+#include "lcapture.h"
+#include "lmemory.h"
+#include "lnetwork.h"
+#include "lproto.h"
+#include "lspool.h"
+#include "lstats.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// The queue is a bounded ring in which each cell carries a sequence number.
+// The sequence tells a producer or the consumer whether the cell is ready
+// for its position, so positions are claimed with a single compare-and-swap
+// and submitting a record never takes a lock.  Positions are also dequeued
+// with compare-and-swap so that a producer may discard the oldest record
+// when the ring is full.
+typedef struct _tinytac_acct_cell
+{
+   atomic_size_t           seq;
+   tinytac_pckt_t *        pckt;
+} tinytac_acct_cell_t;
+
+
+// Watched sessions are kept in an array and linked by index into the slots
+// of a hashed timer wheel, so scheduling and cancelling a session are O(1)
+// and the worker only visits sessions which are due.  A session due more
+// than one turn of the wheel ahead waits for the remaining number of rounds.
+typedef struct _tinytac_watch
+{
+   uint32_t                id;         // 0 if entry is unused
+   uint32_t                next;
+   uint32_t                prev;
+   uint32_t                slot;
+   uint32_t                rounds;
+   uint64_t                started;
+   tinytac_pckt_t *        pckt;
+} tinytac_watch_t;
+
+
+struct _tinytac_acct
+{
+   _Alignas(64) atomic_size_t head;    // next position to dequeue
+   _Alignas(64) atomic_size_t tail;    // next position to enqueue
+   _Alignas(64) atomic_int    sleeping;
+   atomic_int              stop;
+   atomic_uint             waiters;    // producers blocked on full ring
+   _Atomic uint64_t        dropped;
+   TinyTac *               tt;
+   tinytac_acct_t *        next;       // started queues of process
+   size_t                  mask;
+   int                     s;          // connection pooled by worker
+   tinytac_servers_t *     servers;    // referenced servers of pooled connection
+   tinytac_metrics_t *     metrics;    // metrics of server of pooled connection
+   int                     single;     // server acknowledged single-connect
+   tinytac_spool_t *       spool;      // NULL if spool is not configured or unusable
+   uint64_t                replay_last;   // msec of previous replay
+   uint64_t                replay_tokens; // records which may be replayed times 1000
+   pthread_t               thread;
+   pthread_mutex_t         mutex;
+   pthread_cond_t          work;
+   pthread_cond_t          space;
+   pthread_mutex_t         watch_mutex;
+   tinytac_watch_t *       watches;
+   uint32_t                watches_len;   // allocated entries
+   uint32_t                watches_free;  // first unused entry
+   uint32_t                watches_gen;
+   uint64_t                wheel_now;     // monotonic second of last processed slot
+   uint32_t                wheel[TTAC_WATCH_SLOTS];
+   tinytac_acct_cell_t     cells[];
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static tinytac_pckt_t *
+tinytac_acct_dequeue(
+         tinytac_acct_t *              acct );
+
+
+static void
+tinytac_acct_discard(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n );
+
+
+static int
+tinytac_acct_enqueue(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t *              pckt );
+
+
+static size_t
+tinytac_acct_flush(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n );
+
+
+static void
+tinytac_acct_fork_child(
+         void );
+
+
+static void
+tinytac_acct_fork_parent(
+         void );
+
+
+static void
+tinytac_acct_fork_prepare(
+         void );
+
+
+static void
+tinytac_acct_init(
+         void );
+
+
+static int
+tinytac_acct_recv(
+         tinytac_acct_t *              acct,
+         char *                        key,
+         tinytac_pckt_t **             batch,
+         size_t                        cnt,
+         uint64_t                      sent );
+
+
+static void
+tinytac_acct_replay(
+         tinytac_acct_t *              acct );
+
+
+static size_t
+tinytac_acct_spill(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n );
+
+
+static int
+tinytac_acct_start(
+         TinyTac *                     tt,
+         tinytac_acct_t **             acctp );
+
+
+static void
+tinytac_acct_tick(
+         tinytac_acct_t *              acct );
+
+
+static void
+tinytac_acct_wake(
+         tinytac_acct_t *              acct );
+
+
+static uint32_t
+tinytac_acct_watch_delay(
+         TinyTac *                     tt,
+         uint32_t                      rnd );
+
+
+static void
+tinytac_acct_watch_link(
+         tinytac_acct_t *              acct,
+         uint32_t                      idx,
+         uint32_t                      delay );
+
+
+static tinytac_pckt_t *
+tinytac_acct_watch_record(
+         tinytac_watch_t *             watch,
+         uint32_t                      session_id,
+         uint64_t                      now );
+
+
+static void
+tinytac_acct_watch_unlink(
+         tinytac_acct_t *              acct,
+         uint32_t                      idx );
+
+
+static void *
+tinytac_acct_worker(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// queues of all handles, so the fork handlers can reach their locks
+static tinytac_acct_t *    tinytac_acct_list;
+static pthread_mutex_t     tinytac_acct_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t      tinytac_acct_once    = PTHREAD_ONCE_INIT;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//----------------------//
+// accounting functions //
+//----------------------//
+#pragma mark accounting functions
+
+/// removes oldest record from queue
+///
+/// @param[in]  acct          reference to accounting queue
+///
+/// @return    Returns record or NULL if the queue is empty.
+tinytac_pckt_t *
+tinytac_acct_dequeue(
+         tinytac_acct_t *              acct )
+{
+   size_t                  pos;
+   size_t                  seq;
+   intptr_t                dif;
+   tinytac_acct_cell_t *   cell;
+   tinytac_pckt_t *        pckt;
+
+   pos = atomic_load_explicit(&acct->head, memory_order_relaxed);
+   for(;;)
+   {
+      cell  = &acct->cells[pos & acct->mask];
+      seq   = atomic_load_explicit(&cell->seq, memory_order_acquire);
+      dif   = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (dif == 0)
+      {
+         if ((atomic_compare_exchange_weak_explicit(&acct->head, &pos, (pos + 1), memory_order_relaxed, memory_order_relaxed)))
+            break;
+      }
+      else if (dif < 0)
+         return(NULL);
+      else
+         pos = atomic_load_explicit(&acct->head, memory_order_relaxed);
+   };
+
+   pckt = cell->pckt;
+   atomic_store_explicit(&cell->seq, (pos + acct->mask + 1), memory_order_release);
+
+   return(pckt);
+}
+
+
+/// spools or drops records which could not be delivered
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  batch         records to discard
+/// @param[in]  n             number of records
+void
+tinytac_acct_discard(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n )
+{
+   size_t pos;
+   size_t lost;
+   if ((lost = tinytac_acct_spill(acct, batch, n)) != 0)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): dropping %zu accounting records", __func__, lost);
+      atomic_fetch_add_explicit(&acct->dropped, lost, memory_order_relaxed);
+   };
+   for(pos = 0; (pos < n); pos++)
+      tinytac_mem_free(batch[pos]);
+   return;
+}
+
+
+/// adds record to queue
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  pckt          accounting REQUEST
+///
+/// @return    Returns 0 on success or -1 if the queue is full.
+int
+tinytac_acct_enqueue(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t *              pckt )
+{
+   size_t                  pos;
+   size_t                  seq;
+   intptr_t                dif;
+   tinytac_acct_cell_t *   cell;
+
+   pos = atomic_load_explicit(&acct->tail, memory_order_relaxed);
+   for(;;)
+   {
+      cell  = &acct->cells[pos & acct->mask];
+      seq   = atomic_load_explicit(&cell->seq, memory_order_acquire);
+      dif   = (intptr_t)seq - (intptr_t)pos;
+      if (dif == 0)
+      {
+         if ((atomic_compare_exchange_weak_explicit(&acct->tail, &pos, (pos + 1), memory_order_relaxed, memory_order_relaxed)))
+            break;
+      }
+      else if (dif < 0)
+         return(-1);
+      else
+         pos = atomic_load_explicit(&acct->tail, memory_order_relaxed);
+   };
+
+   cell->pckt = pckt;
+   atomic_store_explicit(&cell->seq, (pos + 1), memory_order_release);
+
+   return(0);
+}
+
+
+/// sends records to server and waits for the replies
+///
+/// Records are written with a single call once the server has acknowledged
+/// single-connect mode, otherwise one record is sent per connection.  A
+/// failed connection is retried once with a new connection.  Once the
+/// servers of the handle have been replaced, the pooled connection is
+/// closed between batches unless its server and address are unchanged, so
+/// records are not sent to a removed server.
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  batch         records to send, undelivered records are
+///                           moved to the start of the list
+/// @param[in]  n             number of records
+///
+/// @return    Returns number of undelivered records.
+size_t
+tinytac_acct_flush(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n )
+{
+   TinyTac *               tt;
+   char *                  key;
+   size_t                  key_len;
+   size_t                  cnt;
+   size_t                  pos;
+   size_t                  idx;
+   unsigned                retries;
+   int                     rc;
+   uint64_t                sent;
+   struct iovec            iov[TTAC_ACCT_BATCH_MAX];
+   tinytac_servers_t *     servers;
+
+   TinyTacDebugTrace();
+
+   tt       = acct->tt;
+   servers  = tinytac_servers_acquire(tt);
+   key      = tinytac_net_key(servers);
+   key_len  = strlen(key);
+   retries  = 0;
+
+   // keep pooled connection to a server which is still configured,
+   // otherwise the connection is drained since no session is open
+   if ( (acct->s != -1) && (acct->servers != servers) )
+   {
+      if (tinytac_net_keep(acct->servers, &acct->metrics, servers, acct->s) == TTAC_YES)
+      {
+         tinytac_servers_release(acct->servers);
+         acct->servers = tinytac_servers_retain(servers);
+      } else
+      {
+         TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): closing connection to removed server", __func__);
+         close(acct->s);
+         tinytac_servers_release(acct->servers);
+         acct->s       = -1;
+         acct->servers = NULL;
+         acct->metrics = NULL;
+         acct->single  = 0;
+      };
+   };
+
+   while ( ((n)) && (retries < 2) )
+   {
+      if (acct->s == -1)
+      {
+         if (tinytac_net_connect(tt, servers, &acct->s, &acct->metrics) != TTAC_SUCCESS)
+            break;
+         acct->single  = 0;
+         acct->servers = tinytac_servers_retain(servers);
+      };
+
+      // pipeline sessions only after server agreed to single-connect mode
+      cnt = ((acct->single)) ? n : 1;
+      for(pos = 0; (pos < cnt); pos++)
+      {
+         tinytac_capture(acct->s, batch[pos], (TTAC_CAPTURE_SENT | TTAC_CAPTURE_PLAIN));
+         tinytac_pckt_obfuscate(batch[pos], key, key_len, TTAC_NO);
+         iov[pos].iov_base = batch[pos];
+         iov[pos].iov_len  = sizeof(tinytac_pckt_t) + ntohl(batch[pos]->pckt_length);
+      };
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): sending %zu accounting records", __func__, cnt);
+      tinytac_metrics_add(tt, acct->metrics, TTAC_STAT_REQUESTS, cnt);
+      sent = tinytac_metrics_now();
+      if ((rc = tinytac_net_sendv(acct->s, iov, cnt)) == 0)
+      {
+         sent  = tinytac_metrics_phase(tt, acct->metrics, TTAC_PHASE_SEND, sent);
+         rc    = tinytac_acct_recv(acct, key, batch, cnt, sent);
+      };
+
+      // compact undelivered records
+      for(pos = 0, idx = 0; (pos < n); pos++)
+         if ((batch[pos]))
+            batch[idx++] = batch[pos];
+      tinytac_metrics_add(tt, acct->metrics, TTAC_STAT_FAILURES, (cnt - (n - idx)));
+      n = idx;
+
+      if ( (rc == -1) || (!(acct->single)) )
+      {
+         close(acct->s);
+         tinytac_servers_release(acct->servers);
+         acct->s       = -1;
+         acct->servers = NULL;
+         acct->single  = 0;
+         retries      += (rc == -1) ? 1 : 0;
+      };
+   };
+
+   tinytac_servers_release(servers);
+
+   return(n);
+}
+
+
+/// releases queues inherited from the parent process
+///
+/// The workers do not exist in the child after fork(), so a producer using
+/// TTAC_ACCT_BLOCK would wait for space forever.  Records queued by the
+/// parent are delivered by the parent and are released without being sent.
+/// The next record submitted in the child starts a new queue and worker.
+/// The condition variables may still count waiters of threads which do not
+/// exist in the child, so the memory of a queue is released without
+/// destroying them.
+void
+tinytac_acct_fork_child(
+         void )
+{
+   uint32_t             pos;
+   tinytac_acct_t *     acct;
+   tinytac_acct_t *     next;
+   tinytac_pckt_t *     pckt;
+
+   for(acct = tinytac_acct_list; ((acct)); acct = next)
+   {
+      next = acct->next;
+      while ((pckt = tinytac_acct_dequeue(acct)) != NULL)
+         tinytac_mem_free(pckt);
+      for(pos = 0; (pos < acct->watches_len); pos++)
+         if ((acct->watches[pos].pckt))
+            tinytac_mem_free(acct->watches[pos].pckt);
+      tinytac_mem_free(acct->watches);
+      if (acct->s != -1)
+         close(acct->s);
+      tinytac_servers_release(acct->servers);
+      tinytac_spool_close(acct->spool);
+      pthread_mutex_unlock(&acct->watch_mutex);
+      pthread_mutex_unlock(&acct->mutex);
+      atomic_store(&acct->tt->acct, NULL);
+      free(acct);
+   };
+   tinytac_acct_list = NULL;
+
+   pthread_mutex_unlock(&tinytac_acct_mutex);
+
+   return;
+}
+
+
+/// releases queues after fork() in parent process
+void
+tinytac_acct_fork_parent(
+         void )
+{
+   tinytac_acct_t *     acct;
+
+   for(acct = tinytac_acct_list; ((acct)); acct = acct->next)
+   {
+      pthread_mutex_unlock(&acct->watch_mutex);
+      pthread_mutex_unlock(&acct->mutex);
+   };
+   pthread_mutex_unlock(&tinytac_acct_mutex);
+   return;
+}
+
+
+/// locks queues before fork()
+///
+/// The locks are held across fork() so the child does not inherit them
+/// locked by a worker or producer which does not exist in the child.
+void
+tinytac_acct_fork_prepare(
+         void )
+{
+   tinytac_acct_t *     acct;
+
+   pthread_mutex_lock(&tinytac_acct_mutex);
+   for(acct = tinytac_acct_list; ((acct)); acct = acct->next)
+   {
+      pthread_mutex_lock(&acct->mutex);
+      pthread_mutex_lock(&acct->watch_mutex);
+   };
+   return;
+}
+
+
+void
+tinytac_acct_free(
+         TinyTac *                     tt )
+{
+   uint32_t             pos;
+   tinytac_acct_t *     acct;
+   tinytac_acct_t **    nextp;
+   tinytac_pckt_t *     pckt;
+
+   TinyTacDebugTrace();
+
+   if ((acct = atomic_load(&tt->acct)) == NULL)
+      return;
+
+   // worker exits after draining the queue
+   pthread_mutex_lock(&acct->mutex);
+   atomic_store(&acct->stop, 1);
+   atomic_store(&acct->sleeping, 0);
+   pthread_cond_signal(&acct->work);
+   pthread_mutex_unlock(&acct->mutex);
+   pthread_join(acct->thread, NULL);
+
+   pthread_mutex_lock(&tinytac_acct_mutex);
+   for(nextp = &tinytac_acct_list; (*nextp != acct); nextp = &(*nextp)->next);
+   *nextp = acct->next;
+   pthread_mutex_unlock(&tinytac_acct_mutex);
+
+   while ((pckt = tinytac_acct_dequeue(acct)) != NULL)
+      tinytac_mem_free(pckt);
+   tinytac_spool_close(acct->spool);
+
+   for(pos = 0; (pos < acct->watches_len); pos++)
+      if ((acct->watches[pos].pckt))
+         tinytac_mem_free(acct->watches[pos].pckt);
+   tinytac_mem_free(acct->watches);
+
+   pthread_mutex_destroy(&acct->watch_mutex);
+   pthread_cond_destroy(&acct->space);
+   pthread_cond_destroy(&acct->work);
+   pthread_mutex_destroy(&acct->mutex);
+   free(acct);
+   atomic_store(&tt->acct, NULL);
+
+   return;
+}
+
+
+/// registers fork handlers of accounting queues
+void
+tinytac_acct_init(
+         void )
+{
+   pthread_atfork(&tinytac_acct_fork_prepare, &tinytac_acct_fork_parent, &tinytac_acct_fork_child);
+   return;
+}
+
+
+/// reads accounting REPLY packets and releases acknowledged records
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  key           shared secret
+/// @param[in]  batch         records which were sent
+/// @param[in]  cnt           number of records which were sent
+/// @param[in]  sent          time records were written
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+tinytac_acct_recv(
+         tinytac_acct_t *              acct,
+         char *                        key,
+         tinytac_pckt_t **             batch,
+         size_t                        cnt,
+         uint64_t                      sent )
+{
+   size_t               count;
+   size_t               pos;
+   tinytac_pckt_t *     reply;
+
+   // replies of different sessions may arrive in any order
+   for(count = 0; (count < cnt); count++)
+   {
+      if (tinytac_net_recv(acct->tt, acct->metrics, acct->s, key, &reply, sent) == -1)
+         return(-1);
+      for(pos = 0; (pos < cnt); pos++)
+         if ( ((batch[pos])) && (batch[pos]->pckt_session_id == reply->pckt_session_id) )
+            break;
+      if ( (pos == cnt) || (reply->pckt_type != TAC_PLUS_TYPE_ACCT) || (reply->pckt_seq_no != 2) )
+      {
+         tinytac_mem_free(reply);
+         return(-1);
+      };
+      acct->single = ((reply->pckt_flags & TAC_PLUS_SINGLE_CONNECT_FLAG)) ? 1 : 0;
+      tinytac_mem_free(reply);
+      tinytac_mem_free(batch[pos]);
+      batch[pos] = NULL;
+   };
+
+   return(0);
+}
+
+
+/// sends records saved in spool
+///
+/// Records are replayed at no more than TTAC_OPT_ACCT_REPLAY_RATE records
+/// per second so that a recovering server is not flooded.  The replay
+/// cursor is advanced after each delivered batch; records of a partially
+/// delivered batch are sent again.
+///
+/// @param[in]  acct          reference to accounting queue
+void
+tinytac_acct_replay(
+         tinytac_acct_t *              acct )
+{
+   TinyTac *            tt;
+   size_t               n;
+   size_t               pos;
+   size_t               max;
+   uint64_t             now;
+   uint64_t             cursor;
+   uint64_t             limit;
+   struct timespec      ts;
+   tinytac_pckt_t *     batch[TTAC_ACCT_BATCH_MAX];
+
+   tt = acct->tt;
+
+   if (!(acct->spool))
+      return;
+
+   // refill tokens, bursts are limited to one second of records
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   now   = ((uint64_t)ts.tv_sec * 1000) + ((uint64_t)ts.tv_nsec / 1000000);
+   limit = (uint64_t)tt->acct_replay_rate * 1000;
+   acct->replay_tokens += (now - acct->replay_last) * (uint64_t)tt->acct_replay_rate;
+   acct->replay_tokens  = (acct->replay_tokens > limit) ? limit : acct->replay_tokens;
+   acct->replay_last    = now;
+   if ( ((tt->acct_replay_rate)) && (acct->replay_tokens < 1000) )
+      return;
+
+   // only one process replays the spool at a time
+   if (tinytac_spool_trylock(acct->spool) == -1)
+      return;
+
+   for(;;)
+   {
+      max = TTAC_ACCT_BATCH_MAX;
+      if ( ((tt->acct_replay_rate)) && ((acct->replay_tokens / 1000) < max) )
+         max = (size_t)(acct->replay_tokens / 1000);
+      if ((n = tinytac_spool_read(acct->spool, batch, max, &cursor)) == 0)
+      {
+         tinytac_spool_commit(acct->spool, cursor);
+         break;
+      };
+      if ((n = tinytac_acct_flush(acct, batch, n)) != 0)
+      {
+         for(pos = 0; (pos < n); pos++)
+            tinytac_mem_free(batch[pos]);
+         break;
+      };
+      tinytac_spool_commit(acct->spool, cursor);
+      if ((tt->acct_replay_rate))
+         acct->replay_tokens -= max * 1000;
+   };
+
+   tinytac_spool_unlock(acct->spool);
+
+   return;
+}
+
+
+/// appends records to spool
+///
+/// Records are saved un-obfuscated so that the spool remains valid if the
+/// shared secret is changed.
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  batch         records to save
+/// @param[in]  n             number of records
+///
+/// @return    Returns number of records which could not be saved.
+size_t
+tinytac_acct_spill(
+         tinytac_acct_t *              acct,
+         tinytac_pckt_t **             batch,
+         size_t                        n )
+{
+   char *                  key;
+   size_t                  pos;
+   size_t                  lost;
+   tinytac_servers_t *     servers;
+
+   if (!(acct->spool))
+      return(n);
+
+   servers  = tinytac_servers_acquire(acct->tt);
+   key      = tinytac_net_key(servers);
+   for(pos = 0, lost = 0; (pos < n); pos++)
+   {
+      tinytac_pckt_obfuscate(batch[pos], key, strlen(key), TTAC_YES);
+      if (tinytac_spool_append(acct->spool, batch[pos]) == -1)
+         lost++;
+   };
+   tinytac_servers_release(servers);
+
+   return(lost);
+}
+
+
+/// starts accounting queue and worker of handle
+///
+/// @param[in]  tt            reference to library handle
+/// @param[out] acctp         pointer to store accounting queue
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_acct_start(
+         TinyTac *                     tt,
+         tinytac_acct_t **             acctp )
+{
+   size_t               size;
+   size_t               pos;
+   void *               ptr;
+   tinytac_acct_t *     acct;
+   sigset_t             set;
+   sigset_t             oset;
+
+   TinyTacDebugTrace();
+
+   pthread_once(&tinytac_acct_once, &tinytac_acct_init);
+   pthread_mutex_lock(&tinytac_acct_mutex);
+
+   if ((*acctp = atomic_load(&tt->acct)) != NULL)
+   {
+      pthread_mutex_unlock(&tinytac_acct_mutex);
+      return(TTAC_SUCCESS);
+   };
+
+   for(size = 2; (size < (size_t)tt->acct_queue); size <<= 1);
+   if ((posix_memalign(&ptr, 64, (sizeof(tinytac_acct_t) + (size * sizeof(tinytac_acct_cell_t))))))
+   {
+      pthread_mutex_unlock(&tinytac_acct_mutex);
+      return(TTAC_ENOMEM);
+   };
+   acct = ptr;
+   memset(acct, 0, sizeof(tinytac_acct_t));
+   for(pos = 0; (pos < size); pos++)
+      atomic_init(&acct->cells[pos].seq, pos);
+   acct->tt             = tt;
+   acct->mask           = size - 1;
+   acct->s              = -1;
+   acct->watches_free   = TTAC_WATCH_NONE;
+   acct->wheel_now      = tinytac_cache_now();
+   for(pos = 0; (pos < TTAC_WATCH_SLOTS); pos++)
+      acct->wheel[pos] = TTAC_WATCH_NONE;
+
+   if ((pthread_mutex_init(&acct->mutex, NULL)))
+   {
+      pthread_mutex_unlock(&tinytac_acct_mutex);
+      free(acct);
+      return(TTAC_ENOMEM);
+   };
+   if ((pthread_mutex_init(&acct->watch_mutex, NULL)))
+   {
+      pthread_mutex_unlock(&tinytac_acct_mutex);
+      pthread_mutex_destroy(&acct->mutex);
+      free(acct);
+      return(TTAC_ENOMEM);
+   };
+   if ( ((tt->acct_spool)) && ((tt->acct_spool[0])) )
+      acct->spool = tinytac_spool_open(tt->acct_spool, (size_t)tt->acct_spool_size);
+   pthread_cond_init(&acct->work,  NULL);
+   pthread_cond_init(&acct->space, NULL);
+
+   // worker does not handle signals of the application
+   sigfillset(&set);
+   pthread_sigmask(SIG_SETMASK, &set, &oset);
+   if ((pthread_create(&acct->thread, NULL, &tinytac_acct_worker, acct)))
+   {
+      pthread_sigmask(SIG_SETMASK, &oset, NULL);
+      pthread_mutex_unlock(&tinytac_acct_mutex);
+      pthread_cond_destroy(&acct->space);
+      pthread_cond_destroy(&acct->work);
+      pthread_mutex_destroy(&acct->watch_mutex);
+      pthread_mutex_destroy(&acct->mutex);
+      tinytac_spool_close(acct->spool);
+      free(acct);
+      return(TTAC_ENOMEM);
+   };
+   pthread_sigmask(SIG_SETMASK, &oset, NULL);
+
+   acct->next        = tinytac_acct_list;
+   tinytac_acct_list = acct;
+   atomic_store(&tt->acct, acct);
+   pthread_mutex_unlock(&tinytac_acct_mutex);
+
+   *acctp = acct;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// returns depth of accounting queue and number of discarded records
+///
+/// @param[in]  tt            reference to library handle
+/// @param[out] queuedp       pointer to store number of queued records
+/// @param[out] droppedp      pointer to store number of discarded records
+void
+tinytac_acct_stats(
+         TinyTac *                     tt,
+         uint64_t *                    queuedp,
+         uint64_t *                    droppedp )
+{
+   size_t               head;
+   size_t               tail;
+   tinytac_acct_t *     acct;
+
+   *queuedp  = 0;
+   *droppedp = 0;
+
+   if ((acct = atomic_load(&tt->acct)) == NULL)
+      return;
+
+   head      = atomic_load_explicit(&acct->head, memory_order_relaxed);
+   tail      = atomic_load_explicit(&acct->tail, memory_order_relaxed);
+   *queuedp  = (tail > head) ? (uint64_t)(tail - head) : 0;
+   *droppedp = atomic_load_explicit(&acct->dropped, memory_order_relaxed);
+
+   return;
+}
+
+
+int
+tinytac_acct_submit(
+         TinyTac *                     tt,
+         tinytac_pckt_t *              pckt )
+{
+   int                  rc;
+   tinytac_acct_t *     acct;
+   tinytac_pckt_t *     old;
+   struct timespec      ts;
+
+   TinyTacDebugTrace();
+
+   assert(tt   != NULL);
+   assert(pckt != NULL);
+
+   if ( (pckt->pckt_type != TAC_PLUS_TYPE_ACCT) || (pckt->pckt_seq_no != 1) )
+      return(TTAC_EINVAL);
+   if (ntohl(pckt->pckt_length) > (TTAC_ACCT_RECORD_MAX - sizeof(tinytac_pckt_t)))
+      return(TTAC_EINVAL);
+
+   if ((acct = atomic_load(&tt->acct)) == NULL)
+      if ((rc = tinytac_acct_start(tt, &acct)) != TTAC_SUCCESS)
+         return(rc);
+
+   while (tinytac_acct_enqueue(acct, pckt) == -1)
+   {
+      switch(tt->acct_policy)
+      {
+         case TTAC_ACCT_SPILL:
+         if (tinytac_acct_spill(acct, &pckt, 1) == 0)
+         {
+            tinytac_mem_free(pckt);
+            return(TTAC_SUCCESS);
+         };
+         // discard oldest record if the spool is not available
+         /* FALLTHROUGH */
+
+         case TTAC_ACCT_DROP:
+         if ((old = tinytac_acct_dequeue(acct)) != NULL)
+         {
+            TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): queue full, dropping oldest record", __func__);
+            atomic_fetch_add_explicit(&acct->dropped, 1, memory_order_relaxed);
+            tinytac_mem_free(old);
+         };
+         break;
+
+         default:
+         tinytac_acct_wake(acct);
+         pthread_mutex_lock(&acct->mutex);
+         atomic_fetch_add(&acct->waiters, 1);
+         if ((rc = tinytac_acct_enqueue(acct, pckt)) == -1)
+         {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += 1;
+            pthread_cond_timedwait(&acct->space, &acct->mutex, &ts);
+         };
+         atomic_fetch_sub(&acct->waiters, 1);
+         pthread_mutex_unlock(&acct->mutex);
+         if (rc == 0)
+         {
+            tinytac_acct_wake(acct);
+            return(TTAC_SUCCESS);
+         };
+         break;
+      };
+   };
+
+   tinytac_acct_wake(acct);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// wakes worker if it is waiting for records
+///
+/// @param[in]  acct          reference to accounting queue
+void
+tinytac_acct_wake(
+         tinytac_acct_t *              acct )
+{
+   // pairs with the fence of the worker after it announces that it sleeps
+   atomic_thread_fence(memory_order_seq_cst);
+   if (!(atomic_load_explicit(&acct->sleeping, memory_order_relaxed)))
+      return;
+   pthread_mutex_lock(&acct->mutex);
+   atomic_store(&acct->sleeping, 0);
+   pthread_cond_signal(&acct->work);
+   pthread_mutex_unlock(&acct->mutex);
+   return;
+}
+
+
+/// sends queued records in batches until the handle is freed
+///
+/// @param[in]  arg           reference to accounting queue
+///
+/// @return    Returns NULL.
+void *
+tinytac_acct_worker(
+         void *                        arg )
+{
+   tinytac_acct_t *     acct;
+   tinytac_pckt_t *     batch[TTAC_ACCT_BATCH_MAX];
+   size_t               n;
+   struct timespec      ts;
+
+   acct = arg;
+
+   for(;;)
+   {
+      tinytac_acct_tick(acct);
+
+      for(n = 0; (n < TTAC_ACCT_BATCH_MAX); n++)
+         if ((batch[n] = tinytac_acct_dequeue(acct)) == NULL)
+            break;
+
+      if ((n))
+      {
+         // pairs with producers registering as waiters before retrying
+         atomic_thread_fence(memory_order_seq_cst);
+         if ((atomic_load(&acct->waiters)))
+         {
+            pthread_mutex_lock(&acct->mutex);
+            pthread_cond_broadcast(&acct->space);
+            pthread_mutex_unlock(&acct->mutex);
+         };
+         if ((n = tinytac_acct_flush(acct, batch, n)) != 0)
+            tinytac_acct_discard(acct, batch, n);
+         continue;
+      };
+
+      // group commit of records spooled since the queue was last empty
+      if ((acct->spool))
+         tinytac_spool_sync(acct->spool);
+
+      if ((atomic_load(&acct->stop)))
+         break;
+
+      tinytac_acct_replay(acct);
+
+      // announce sleep, then check for records enqueued before producers
+      // could observe the announcement
+      atomic_store(&acct->sleeping, 1);
+      atomic_thread_fence(memory_order_seq_cst);
+      if (atomic_load(&acct->tail) != atomic_load(&acct->head))
+      {
+         atomic_store(&acct->sleeping, 0);
+         continue;
+      };
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_sec += 1;
+      pthread_mutex_lock(&acct->mutex);
+      while ( ((atomic_load(&acct->sleeping))) && (!(atomic_load(&acct->stop))) )
+         if (pthread_cond_timedwait(&acct->work, &acct->mutex, &ts) == ETIMEDOUT)
+            break;
+      atomic_store(&acct->sleeping, 0);
+      pthread_mutex_unlock(&acct->mutex);
+   };
+
+   if (acct->s != -1)
+      close(acct->s);
+   tinytac_servers_release(acct->servers);
+
+   return(NULL);
+}
+
+
+//--------------------//
+// watchdog functions //
+//--------------------//
+#pragma mark watchdog functions
+
+/// sends WATCHDOG records of sessions which are due
+///
+/// Slots are processed for every second which passed since the previous
+/// tick.  Records are built while the wheel is locked and sent afterwards,
+/// pipelined in batches on the pooled connection.
+///
+/// @param[in]  acct          reference to accounting queue
+void
+tinytac_acct_tick(
+         tinytac_acct_t *              acct )
+{
+   uint64_t             now;
+   uint32_t             idx;
+   uint32_t             next;
+   uint32_t             session_id;
+   size_t               cnt;
+   size_t               size;
+   size_t               pos;
+   size_t               n;
+   void *               ptr;
+   tinytac_watch_t *    watch;
+   tinytac_pckt_t *     pckt;
+   tinytac_pckt_t **    due;
+
+   now   = tinytac_cache_now();
+   due   = NULL;
+   cnt   = 0;
+   size  = 0;
+
+   pthread_mutex_lock(&acct->watch_mutex);
+   while (acct->wheel_now < now)
+   {
+      acct->wheel_now++;
+      idx = acct->wheel[acct->wheel_now % TTAC_WATCH_SLOTS];
+      acct->wheel[acct->wheel_now % TTAC_WATCH_SLOTS] = TTAC_WATCH_NONE;
+      for(; (idx != TTAC_WATCH_NONE); idx = next)
+      {
+         watch = &acct->watches[idx];
+         next  = watch->next;
+         if ((watch->rounds))
+         {
+            tinytac_acct_watch_link(acct, idx, (watch->rounds * TTAC_WATCH_SLOTS));
+            continue;
+         };
+         if (cnt == size)
+         {
+            size = ((size)) ? (size * 2) : TTAC_ACCT_BATCH_MAX;
+            if ((ptr = tinytac_mem_realloc(due, (size * sizeof(tinytac_pckt_t *)))) != NULL)
+               due = ptr;
+            else
+               size = cnt;
+         };
+         session_id = tinytac_pckt_session_id(acct->tt);
+         if ( (cnt < size) && ((pckt = tinytac_acct_watch_record(watch, session_id, now)) != NULL) )
+            due[cnt++] = pckt;
+         tinytac_acct_watch_link(acct, idx, tinytac_acct_watch_delay(acct->tt, session_id));
+      };
+   };
+   pthread_mutex_unlock(&acct->watch_mutex);
+
+   for(pos = 0; (pos < cnt); pos += TTAC_ACCT_BATCH_MAX)
+   {
+      n = ((cnt - pos) < TTAC_ACCT_BATCH_MAX) ? (cnt - pos) : TTAC_ACCT_BATCH_MAX;
+      if ((n = tinytac_acct_flush(acct, &due[pos], n)) != 0)
+         tinytac_acct_discard(acct, &due[pos], n);
+   };
+   tinytac_mem_free(due);
+
+   return;
+}
+
+
+int
+tinytac_acct_unwatch(
+         TinyTac *                     tt,
+         uint32_t                      id )
+{
+   uint32_t             idx;
+   tinytac_acct_t *     acct;
+   tinytac_watch_t *    watch;
+
+   TinyTacDebugTrace();
+
+   assert(tt != NULL);
+
+   if ((acct = atomic_load(&tt->acct)) == NULL)
+      return(TTAC_ENOENT);
+
+   idx = (id & TTAC_WATCH_MAX) - 1;
+
+   pthread_mutex_lock(&acct->watch_mutex);
+   if ( (!(id)) || (idx >= acct->watches_len) || (acct->watches[idx].id != id) )
+   {
+      pthread_mutex_unlock(&acct->watch_mutex);
+      return(TTAC_ENOENT);
+   };
+   watch = &acct->watches[idx];
+   tinytac_acct_watch_unlink(acct, idx);
+   tinytac_mem_free(watch->pckt);
+   watch->pckt          = NULL;
+   watch->id            = 0;
+   watch->next          = acct->watches_free;
+   acct->watches_free   = idx;
+   pthread_mutex_unlock(&acct->watch_mutex);
+
+   return(TTAC_SUCCESS);
+}
+
+
+int
+tinytac_acct_watch(
+         TinyTac *                     tt,
+         const tinytac_pckt_t *        start,
+         uint32_t *                    idp )
+{
+   int                  rc;
+   char *               key;
+   size_t               len;
+   uint32_t             idx;
+   uint32_t             size;
+   void *               ptr;
+   tinytac_acct_t *     acct;
+   tinytac_watch_t *    watch;
+   tinytac_pckt_t *     pckt;
+   tinytac_servers_t *  servers;
+
+   TinyTacDebugTrace();
+
+   assert(tt    != NULL);
+   assert(start != NULL);
+   assert(idp   != NULL);
+
+   len = ntohl(start->pckt_length);
+   if ( (start->pckt_type != TAC_PLUS_TYPE_ACCT) || (start->pckt_seq_no != 1) )
+      return(TTAC_EINVAL);
+   if ( (len < sizeof(tinytac_acct_req_t)) || (len > (TTAC_ACCT_RECORD_MAX - sizeof(tinytac_pckt_t) - 256)) )
+      return(TTAC_EINVAL);
+
+   if ((acct = atomic_load(&tt->acct)) == NULL)
+      if ((rc = tinytac_acct_start(tt, &acct)) != TTAC_SUCCESS)
+         return(rc);
+
+   if ((pckt = tinytac_pckt_dup(start)) == NULL)
+      return(TTAC_ENOMEM);
+   servers  = tinytac_servers_acquire(tt);
+   key      = tinytac_net_key(servers);
+   tinytac_pckt_obfuscate(pckt, key, strlen(key), TTAC_YES);
+   tinytac_servers_release(servers);
+   if (len < (sizeof(tinytac_acct_req_t) + ((tinytac_acct_req_t *)pckt->pckt_body)->bdy_arg_cnt))
+   {
+      tinytac_mem_free(pckt);
+      return(TTAC_EINVAL);
+   };
+
+   pthread_mutex_lock(&acct->watch_mutex);
+
+   if (acct->watches_free == TTAC_WATCH_NONE)
+   {
+      size = ((acct->watches_len)) ? (acct->watches_len * 2) : 64;
+      size = (size > TTAC_WATCH_MAX) ? TTAC_WATCH_MAX : size;
+      if ( (size == acct->watches_len) || ((ptr = tinytac_mem_realloc(acct->watches, (size * sizeof(tinytac_watch_t)))) == NULL) )
+      {
+         pthread_mutex_unlock(&acct->watch_mutex);
+         tinytac_mem_free(pckt);
+         return((size == acct->watches_len) ? TTAC_ENOBUFS : TTAC_ENOMEM);
+      };
+      acct->watches = ptr;
+      memset(&acct->watches[acct->watches_len], 0, ((size - acct->watches_len) * sizeof(tinytac_watch_t)));
+      for(idx = size; (idx > acct->watches_len); idx--)
+      {
+         acct->watches[idx-1].next  = acct->watches_free;
+         acct->watches_free         = idx - 1;
+      };
+      acct->watches_len = size;
+   };
+
+   idx                  = acct->watches_free;
+   watch                = &acct->watches[idx];
+   acct->watches_free   = watch->next;
+   acct->watches_gen    = (acct->watches_gen + 1) & 0xff;
+   watch->id            = (acct->watches_gen << 24) | (idx + 1);
+   watch->started       = tinytac_cache_now();
+   watch->pckt          = pckt;
+   tinytac_acct_watch_link(acct, idx, tinytac_acct_watch_delay(tt, tinytac_pckt_session_id(tt)));
+   *idp                 = watch->id;
+
+   pthread_mutex_unlock(&acct->watch_mutex);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// chooses number of seconds until next WATCHDOG record
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  rnd           random value
+///
+/// @return    Returns TTAC_OPT_ACCT_WATCHDOG plus or minus ten percent.
+uint32_t
+tinytac_acct_watch_delay(
+         TinyTac *                     tt,
+         uint32_t                      rnd )
+{
+   uint32_t             interval;
+   uint32_t             jitter;
+   uint32_t             delay;
+
+   interval = (uint32_t)tt->acct_watchdog;
+   jitter   = interval / 10;
+   delay    = interval - jitter + (rnd % ((jitter * 2) + 1));
+
+   return(((delay)) ? delay : 1);
+}
+
+
+/// adds session to timer wheel
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  idx           index of session
+/// @param[in]  delay         seconds until session is due
+void
+tinytac_acct_watch_link(
+         tinytac_acct_t *              acct,
+         uint32_t                      idx,
+         uint32_t                      delay )
+{
+   tinytac_watch_t *    watch;
+
+   watch          = &acct->watches[idx];
+   watch->slot    = (uint32_t)((acct->wheel_now + delay) % TTAC_WATCH_SLOTS);
+   watch->rounds  = (delay - 1) / TTAC_WATCH_SLOTS;
+   watch->prev    = TTAC_WATCH_NONE;
+   watch->next    = acct->wheel[watch->slot];
+   if (watch->next != TTAC_WATCH_NONE)
+      acct->watches[watch->next].prev = idx;
+   acct->wheel[watch->slot] = idx;
+
+   return;
+}
+
+
+/// builds WATCHDOG record from START record of session
+///
+/// The record is a copy of the START record with the WATCHDOG flag and an
+/// additional elapsed_time argument.
+///
+/// @param[in]  watch         registered session
+/// @param[in]  session_id    session ID of record
+/// @param[in]  now           current monotonic time
+///
+/// @return    Returns record or NULL on error.
+tinytac_pckt_t *
+tinytac_acct_watch_record(
+         tinytac_watch_t *             watch,
+         uint32_t                      session_id,
+         uint64_t                      now )
+{
+   char                 av[64];
+   size_t               av_len;
+   size_t               len;
+   size_t               off;
+   size_t               add;
+   tinytac_acct_req_t * bdy;
+   tinytac_pckt_t *     pckt;
+
+   bdy      = (tinytac_acct_req_t *)watch->pckt->pckt_body;
+   len      = ntohl(watch->pckt->pckt_length);
+   off      = sizeof(tinytac_acct_req_t) + bdy->bdy_arg_cnt;
+   av_len   = (size_t)snprintf(av, sizeof(av), "elapsed_time=%" PRIu64, (now - watch->started));
+   av_len   = (bdy->bdy_arg_cnt < 255) ? av_len : 0;
+   add      = ((av_len)) ? 1 : 0;
+
+   if ((pckt = tinytac_pckt_alloc(TAC_PLUS_TYPE_ACCT, 1, session_id, (len + add + av_len))) == NULL)
+      return(NULL);
+   pckt->pckt_version = watch->pckt->pckt_version;
+
+   // argument lengths precede user, port, rem_addr, and arguments
+   memcpy(pckt->pckt_body, watch->pckt->pckt_body, off);
+   memcpy(&pckt->pckt_body[off + add], &watch->pckt->pckt_body[off], (len - off));
+   memcpy(&pckt->pckt_body[len + add], av, av_len);
+   bdy            = (tinytac_acct_req_t *)pckt->pckt_body;
+   bdy->bdy_flags = TAC_PLUS_ACCT_FLAG_WATCHDOG;
+   if ((add))
+   {
+      bdy->bdy_bytes[bdy->bdy_arg_cnt] = (uint8_t)av_len;
+      bdy->bdy_arg_cnt++;
+   };
+
+   return(pckt);
+}
+
+
+/// removes session from timer wheel
+///
+/// @param[in]  acct          reference to accounting queue
+/// @param[in]  idx           index of session
+void
+tinytac_acct_watch_unlink(
+         tinytac_acct_t *              acct,
+         uint32_t                      idx )
+{
+   tinytac_watch_t *    watch;
+
+   watch = &acct->watches[idx];
+   if (watch->prev != TTAC_WATCH_NONE)
+      acct->watches[watch->prev].next = watch->next;
+   else
+      acct->wheel[watch->slot] = watch->next;
+   if (watch->next != TTAC_WATCH_NONE)
+      acct->watches[watch->next].prev = watch->prev;
+
+   return;
+}
+
+
+/* end of source */
@@ -0,0 +1,277 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LARENA_C 1
+#include "larena.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "lmemory.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_ARENA_ALIGN            (_Alignof(max_align_t))
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+struct _tinytac_arena_chunk
+{
+   tinytac_arena_chunk_t * next;
+   size_t                  size;
+   size_t                  used;
+   _Alignas(max_align_t) uint8_t data[];
+};
+
+
+// chunks in use and chunks released by resets of a thread
+typedef struct _tinytac_arena
+{
+   tinytac_arena_chunk_t * chunks;
+   tinytac_arena_chunk_t * spare;
+} tinytac_arena_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static void
+tinytac_arena_destroy(
+         void *                        ptr );
+
+
+static tinytac_arena_chunk_t *
+tinytac_arena_grow(
+         tinytac_arena_t *             arena,
+         size_t                        size );
+
+
+static void
+tinytac_arena_once(
+         void );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static _Thread_local tinytac_arena_t   tinytac_arena;
+static pthread_key_t                   tinytac_arena_key;
+static pthread_once_t                  tinytac_arena_key_once = PTHREAD_ONCE_INIT;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-----------------//
+// arena functions //
+//-----------------//
+#pragma mark arena functions
+
+/// allocates request-scoped memory from the arena of the calling thread
+///
+/// Memory is not freed individually; it is released by resetting the arena
+/// to a mark taken when the request started.  Chunks released by a reset
+/// are reused by later requests of the thread and freed when the thread
+/// exits.
+///
+/// @param[in]  size          number of bytes to allocate
+///
+/// @return    Returns pointer to memory aligned for any type or NULL if
+///            memory could not be allocated.
+void *
+tinytac_arena_alloc(
+         size_t                        size )
+{
+   void *                  ptr;
+   tinytac_arena_chunk_t * chunk;
+
+   size = (size + TTAC_ARENA_ALIGN - 1) & ~(TTAC_ARENA_ALIGN - 1);
+
+   if ( ((chunk = tinytac_arena.chunks) == NULL) || ((chunk->size - chunk->used) < size) )
+      if ((chunk = tinytac_arena_grow(&tinytac_arena, size)) == NULL)
+         return(NULL);
+
+   ptr          = &chunk->data[chunk->used];
+   chunk->used += size;
+
+   return(ptr);
+}
+
+
+/// frees chunks of an exiting thread
+///
+/// @param[in]  ptr           arena of the thread
+void
+tinytac_arena_destroy(
+         void *                        ptr )
+{
+   tinytac_arena_t *       arena;
+   tinytac_arena_chunk_t * chunk;
+
+   arena = ptr;
+
+   while ((chunk = arena->chunks) != NULL)
+   {
+      arena->chunks = chunk->next;
+      tinytac_mem_free(chunk);
+   };
+   while ((chunk = arena->spare) != NULL)
+   {
+      arena->spare = chunk->next;
+      tinytac_mem_free(chunk);
+   };
+
+   return;
+}
+
+
+/// pushes a chunk with room for an allocation onto the arena
+///
+/// @param[in]  arena         arena of the calling thread
+/// @param[in]  size          aligned size of the allocation
+///
+/// @return    Returns the current chunk or NULL if memory could not be
+///            allocated.
+tinytac_arena_chunk_t *
+tinytac_arena_grow(
+         tinytac_arena_t *             arena,
+         size_t                        size )
+{
+   tinytac_arena_chunk_t * chunk;
+
+   if ( ((chunk = arena->spare) != NULL) && (chunk->size >= size) )
+   {
+      arena->spare = chunk->next;
+   }
+   else
+   {
+      TinyTacDebug(TTAC_DEBUG_TRACE, "   == %s(): allocating %zu byte chunk", __func__, size);
+      size = (size < TTAC_ARENA_SIZE) ? TTAC_ARENA_SIZE : size;
+      if ((chunk = tinytac_mem_alloc(sizeof(tinytac_arena_chunk_t) + size)) == NULL)
+         return(NULL);
+      chunk->size = size;
+      if ( (!(arena->chunks)) && (!(arena->spare)) )
+      {
+         pthread_once(&tinytac_arena_key_once, &tinytac_arena_once);
+         pthread_setspecific(tinytac_arena_key, arena);
+      };
+   };
+
+   chunk->used   = 0;
+   chunk->next   = arena->chunks;
+   arena->chunks = chunk;
+
+   return(chunk);
+}
+
+
+/// records the current position of the arena of the calling thread
+///
+/// @param[out] markp         pointer to store position
+void
+tinytac_arena_mark(
+         tinytac_arena_mark_t *        markp )
+{
+   assert(markp != NULL);
+   markp->chunk = tinytac_arena.chunks;
+   markp->used  = ((markp->chunk)) ? markp->chunk->used : 0;
+   return;
+}
+
+
+/// creates key used to free the arena of exiting threads
+void
+tinytac_arena_once(
+         void )
+{
+   pthread_key_create(&tinytac_arena_key, &tinytac_arena_destroy);
+   return;
+}
+
+
+/// releases memory allocated from the arena since the mark was taken
+///
+/// @param[in]  mark          position recorded by tinytac_arena_mark()
+void
+tinytac_arena_reset(
+         const tinytac_arena_mark_t *  mark )
+{
+   tinytac_arena_chunk_t * chunk;
+
+   assert(mark != NULL);
+
+   while ( ((chunk = tinytac_arena.chunks) != NULL) && (chunk != mark->chunk) )
+   {
+      tinytac_arena.chunks = chunk->next;
+      chunk->next          = tinytac_arena.spare;
+      tinytac_arena.spare  = chunk;
+   };
+   if ((chunk))
+      chunk->used = mark->used;
+
+   return;
+}
+
+
+/* end of source */
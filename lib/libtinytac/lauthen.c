@@ -0,0 +1,350 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LAUTHEN_C 1
+#include "lauthen.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <assert.h>
+
+#include "lnetwork.h"
+#include "loffline.h"
+#include "lproto.h"
+#include "lsession.h"
+#include "lstats.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static int
+tinytac_authen_cont(
+         tinytac_session_t *           sess,
+         const char *                  user_msg,
+         uint8_t                       flags );
+
+
+static int
+tinytac_authen_exchange(
+         tinytac_session_t *           sess,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         uint8_t *                     statusp );
+
+
+static int
+tinytac_authen_login_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         unsigned                      flags );
+
+
+static int
+tinytac_authen_reply(
+         const tinytac_pckt_t *        reply,
+         uint8_t *                     statusp );
+
+
+static int
+tinytac_authen_start(
+         tinytac_session_t *           sess,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//--------------------------//
+// authentication functions //
+//--------------------------//
+#pragma mark authentication functions
+
+/// builds authentication CONTINUE packet answering a server prompt
+///
+/// @param[in]  sess          reference to session
+/// @param[in]  user_msg      answer to prompt
+/// @param[in]  flags         TAC_PLUS_CONTINUE_FLAG_*
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_authen_cont(
+         tinytac_session_t *           sess,
+         const char *                  user_msg,
+         uint8_t                       flags )
+{
+   size_t                     msg_len;
+   size_t                     hdr_len;
+   tinytac_pckt_t *           pckt;
+   tinytac_authen_cont_t *    bdy;
+
+   msg_len = strlen(user_msg);
+   hdr_len = offsetof(tinytac_authen_cont_t, bdy_bytes);
+   if ((pckt = tinytac_session_request(sess, TAC_PLUS_TYPE_AUTHEN, (hdr_len + msg_len))) == NULL)
+      return(TTAC_ENOMEM);
+
+   bdy                     = (tinytac_authen_cont_t *)pckt->pckt_body;
+   bdy->bdy_user_msg_len   = htons((uint16_t)msg_len);
+   bdy->bdy_data_len       = 0;
+   bdy->bdy_flags          = flags;
+   memcpy(&pckt->pckt_body[hdr_len], user_msg, msg_len);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// runs ASCII or PAP login over connected session
+///
+/// Each step builds its request in the buffers of the session, so a login
+/// with a recycled session does not allocate memory.
+///
+/// @param[in]  sess          reference to session
+/// @param[in]  user          user name
+/// @param[in]  pass          password
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_ASCII or TAC_PLUS_AUTHEN_TYPE_PAP
+/// @param[out] statusp       pointer to store final status of the session
+///
+/// @return    Returns TTAC_SUCCESS if the session completed or an error code.
+int
+tinytac_authen_exchange(
+         tinytac_session_t *           sess,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         uint8_t *                     statusp )
+{
+   int                  rc;
+   unsigned             round;
+   const char *         user_msg;
+   tinytac_pckt_t *     reply;
+
+   if ((rc = tinytac_authen_start(sess, user, pass, authen_type)) != TTAC_SUCCESS)
+      return(rc);
+
+   for(round = 0; (round < TTAC_AUTHEN_MAX_ROUNDS); round++)
+   {
+      if ((rc = tinytac_session_exchange(sess, &reply)) != TTAC_SUCCESS)
+         return(rc);
+      if ((rc = tinytac_authen_reply(reply, statusp)) != TTAC_SUCCESS)
+         return(rc);
+
+      // answer server prompts of ASCII login
+      switch(*statusp)
+      {
+         case TAC_PLUS_AUTHEN_STATUS_GETUSER: user_msg = user; break;
+         case TAC_PLUS_AUTHEN_STATUS_GETPASS: user_msg = pass; break;
+         case TAC_PLUS_AUTHEN_STATUS_GETDATA: user_msg = NULL; break;
+         default:
+         return(TTAC_SUCCESS);
+      };
+      if ( (authen_type != TAC_PLUS_AUTHEN_TYPE_ASCII) || (!(user_msg)) )
+      {
+         // unable to answer prompt, abort session
+         if (tinytac_authen_cont(sess, "", TAC_PLUS_CONTINUE_FLAG_ABORT) == TTAC_SUCCESS)
+            tinytac_session_send(sess);
+         return(TTAC_EBADMSG);
+      };
+      if ((rc = tinytac_authen_cont(sess, user_msg, 0)) != TTAC_SUCCESS)
+         return(rc);
+   };
+
+   return(TTAC_EBADMSG);
+}
+
+
+int
+tinytac_authen_login(
+         TinyTac *                     tt,
+         int                           s,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         unsigned                      flags )
+{
+   tinytac_trace_begin();
+   return(tinytac_trace_end(tinytac_authen_login_attempt(tt, s, user, pass, authen_type, flags)));
+}
+
+
+/// authenticates login, timed by the trace of the calling thread
+int
+tinytac_authen_login_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type,
+         unsigned                      flags )
+{
+   int                  rc;
+   uint8_t              minor;
+   uint8_t              status;
+   tinytac_session_t *  sess;
+
+   TinyTacDebugTrace();
+
+   assert(tt   != NULL);
+   assert(user != NULL);
+   assert(pass != NULL);
+
+   if ( (strlen(user) > 255) || (strlen(pass) > 255) )
+      return(TTAC_EINVAL);
+   switch(authen_type)
+   {
+      case TAC_PLUS_AUTHEN_TYPE_ASCII:
+      if (!(tt->opts & TTAC_ASCII))
+         return(TTAC_EINVAL);
+      break;
+
+      case TAC_PLUS_AUTHEN_TYPE_PAP:
+      if (!(tt->opts & TTAC_PAP))
+         return(TTAC_EINVAL);
+      break;
+
+      default:
+      return(TTAC_EINVAL);
+   };
+
+   // connect to server or fall back to offline verifier
+   minor = (authen_type == TAC_PLUS_AUTHEN_TYPE_ASCII) ? TAC_PLUS_MINOR_VER_DEFAULT : TAC_PLUS_MINOR_VER_ONE;
+   rc    = tinytac_session_alloc(tt, s, minor, &sess);
+   if ( (rc == TTAC_EUNAVAIL) && (s == -1) && (!(flags & TTAC_REQ_NOOFFLINE)) && ((tt->offline_dir)) )
+      return(tinytac_offline_verify(tt, user, pass));
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   rc = tinytac_authen_exchange(sess, user, pass, authen_type, &status);
+   tinytac_session_free(sess);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   switch(status)
+   {
+      case TAC_PLUS_AUTHEN_STATUS_PASS:
+      if ( ((tt->offline_dir)) && (!(flags & TTAC_REQ_NOOFFLINE)) )
+         tinytac_offline_store(tt, user, pass);
+      return(TTAC_SUCCESS);
+
+      case TAC_PLUS_AUTHEN_STATUS_FAIL:
+      return(TTAC_EACCES);
+
+      default:
+      break;
+   };
+
+   return(TTAC_EBADMSG);
+}
+
+
+/// validates authentication REPLY packet and returns its status
+int
+tinytac_authen_reply(
+         const tinytac_pckt_t *        reply,
+         uint8_t *                     statusp )
+{
+   tinytac_reply_view_t    view;
+
+   if (tinytac_pckt_reply_view(reply, &view) != TTAC_SUCCESS)
+      return(TTAC_EBADMSG);
+   if (view.type != TAC_PLUS_TYPE_AUTHEN)
+      return(TTAC_EBADMSG);
+   *statusp = view.status;
+   return(TTAC_SUCCESS);
+}
+
+
+/// builds authentication START packet of a login
+///
+/// PAP sends the password in the START packet, ASCII waits for a prompt.
+///
+/// @param[in]  sess          reference to session
+/// @param[in]  user          user name
+/// @param[in]  pass          password
+/// @param[in]  authen_type   TAC_PLUS_AUTHEN_TYPE_ASCII or TAC_PLUS_AUTHEN_TYPE_PAP
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_authen_start(
+         tinytac_session_t *           sess,
+         const char *                  user,
+         const char *                  pass,
+         unsigned                      authen_type )
+{
+   size_t                     user_len;
+   size_t                     data_len;
+   tinytac_pckt_t *           pckt;
+   tinytac_authen_start_t *   bdy;
+
+   user_len = strlen(user);
+   data_len = (authen_type == TAC_PLUS_AUTHEN_TYPE_PAP) ? strlen(pass) : 0;
+   if ((pckt = tinytac_session_request(sess, TAC_PLUS_TYPE_AUTHEN, (sizeof(tinytac_authen_start_t) + user_len + data_len))) == NULL)
+      return(TTAC_ENOMEM);
+
+   bdy                        = (tinytac_authen_start_t *)pckt->pckt_body;
+   bdy->bdy_action            = TAC_PLUS_AUTHEN_LOGIN;
+   bdy->bdy_priv_lvl          = TAC_PLUS_PRIV_LVL_USER;
+   bdy->bdy_authen_type       = (uint8_t)authen_type;
+   bdy->bdy_authen_service    = TAC_PLUS_AUTHEN_SVC_LOGIN;
+   bdy->bdy_user_len          = (uint8_t)user_len;
+   bdy->bdy_port_len          = 0;
+   bdy->bdy_rem_addr_len      = 0;
+   bdy->bdy_data_len          = (uint8_t)data_len;
+   memcpy(bdy->bdy_bytes,              user, user_len);
+   memcpy(&bdy->bdy_bytes[user_len],   pass, data_len);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/* end of source */
@@ -0,0 +1,941 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LAUTHOR_C 1
+#include "lauthor.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "larena.h"
+#include "lavpair.h"
+#include "lcache.h"
+#include "lcapture.h"
+#include "lmemory.h"
+#include "lnetwork.h"
+#include "lprobe.h"
+#include "lproto.h"
+#include "lshm.h"
+#include "lstats.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_AUTHOR_BULK_CONNS      16    // connections opened at once without single-connect
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// reply attribute name hashed for the merge of a PASS_ADD reply
+typedef struct _tinytac_merge_name
+{
+   uint64_t                hash;
+   const char *            name;
+   size_t                  len;
+} tinytac_merge_name_t;
+
+
+struct _tinytac_flight
+{
+   tinytac_flight_t *      next;
+   uint64_t                hash;
+   uint8_t *               body;
+   size_t                  body_len;
+   tinytac_pckt_t *        reply;
+   int                     rc;
+   int                     done;
+   size_t                  waiters;
+   pthread_cond_t          cond;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static int
+tinytac_author_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp,
+         unsigned                      flags );
+
+
+static int
+tinytac_author_bulk_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         size_t                        cnt,
+         unsigned                      flags );
+
+
+static int
+tinytac_author_coalesce(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp );
+
+
+static char *
+tinytac_author_merge_copy(
+         uint8_t **                    nextp,
+         const uint8_t *               end,
+         const char *                  str,
+         size_t                        len );
+
+
+static void
+tinytac_author_pipeline(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t *           metrics,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         const size_t *                idx,
+         size_t                        n );
+
+
+static void
+tinytac_author_spread(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         const size_t *                idx,
+         size_t                        n );
+
+
+static int
+tinytac_author_wait(
+         TinyTac *                     tt,
+         tinytac_flight_t *            flight,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp );
+
+
+static tinytac_flight_t *
+tinytac_flight_alloc(
+         uint64_t                      hash,
+         const uint8_t *               body,
+         size_t                        body_len );
+
+
+static void
+tinytac_flight_free(
+         tinytac_flight_t *            flight );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-------------------------//
+// authorization functions //
+//-------------------------//
+#pragma mark authorization functions
+
+int
+tinytac_author(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp,
+         unsigned                      flags )
+{
+   tinytac_trace_begin();
+   return(tinytac_trace_end(tinytac_author_attempt(tt, s, req, replyp, flags)));
+}
+
+
+/// authorizes request, timed by the trace of the calling thread
+int
+tinytac_author_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp,
+         unsigned                      flags )
+{
+   int                     rc;
+   char *                  key;
+   tinytac_servers_t *     servers;
+   tinytac_cache_key_t *   ckey;
+   tinytac_reply_view_t    view;
+   tinytac_arena_mark_t    mark;
+
+   TinyTacDebugTrace();
+
+   assert(tt     != NULL);
+   assert(req    != NULL);
+   assert(replyp != NULL);
+
+   *replyp = NULL;
+   ckey    = NULL;
+
+   if (req->pckt_type != TAC_PLUS_TYPE_AUTHOR)
+      return(TTAC_EINVAL);
+
+   tinytac_arena_mark(&mark);
+
+   // normalize request body before comparing with cached and in-flight requests
+   servers  = tinytac_servers_acquire(tt);
+   key      = tinytac_net_key(servers);
+   tinytac_pckt_obfuscate(req, key, strlen(key), TTAC_YES);
+
+   // check in-process and shared authorization caches
+   if ( ( ((tt->cache_size)) || ((tt->shm_cache)) ) && (!(flags & TTAC_REQ_NOCACHE)) )
+   {
+      if ((rc = tinytac_cache_key(req, &ckey)) == TTAC_ENOMEM)
+      {
+         tinytac_servers_release(servers);
+         return(rc);
+      };
+      if ( ((ckey)) && ((rc = tinytac_cache_lookup(tt, ckey, req, replyp)) != TTAC_ENOENT) )
+      {
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_HITS, 1);
+         TinyTacProbe1(cache__hit, ntohl(req->pckt_session_id));
+         tinytac_servers_release(servers);
+         tinytac_arena_reset(&mark);
+         return(rc);
+      };
+      if ( ((ckey)) && ((rc = tinytac_shm_lookup(tt, ckey, req, replyp)) != TTAC_ENOENT) )
+      {
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_HITS, 1);
+         TinyTacProbe1(cache__hit, ntohl(req->pckt_session_id));
+         tinytac_servers_release(servers);
+         tinytac_arena_reset(&mark);
+         return(rc);
+      };
+      if ((ckey))
+      {
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_MISSES, 1);
+         TinyTacProbe1(cache__miss, ntohl(req->pckt_session_id));
+      };
+   };
+
+   // send request
+   if ( (!(tt->opts & TTAC_COALESCE)) || ((flags & TTAC_REQ_NOCOALESCE)) )
+      rc = tinytac_net_exchange(tt, servers, NULL, s, req, replyp);
+   else
+      rc = tinytac_author_coalesce(tt, servers, s, req, replyp);
+   tinytac_servers_release(servers);
+
+   // do not return or cache a malformed reply
+   if ( (rc == TTAC_SUCCESS) && (tinytac_pckt_reply_view(*replyp, &view) != TTAC_SUCCESS) )
+   {
+      tinytac_mem_free(*replyp);
+      *replyp = NULL;
+      rc      = TTAC_EBADMSG;
+   };
+
+   // update authorization cache
+   if ( ((ckey)) && (rc == TTAC_SUCCESS) )
+   {
+      tinytac_cache_store(tt, ckey, *replyp);
+      tinytac_shm_store(tt, ckey, *replyp);
+   };
+
+   tinytac_arena_reset(&mark);
+
+   return(rc);
+}
+
+
+int
+tinytac_author_bulk(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         size_t                        cnt,
+         unsigned                      flags )
+{
+   tinytac_trace_begin();
+   return(tinytac_trace_end(tinytac_author_bulk_attempt(tt, s, reqs, replies, results, cnt, flags)));
+}
+
+
+/// authorizes requests, timed by the trace of the calling thread
+int
+tinytac_author_bulk_attempt(
+         TinyTac *                     tt,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         size_t                        cnt,
+         unsigned                      flags )
+{
+   int                     rc;
+   int                     sock;
+   char *                  key;
+   size_t                  pos;
+   size_t                  n;
+   size_t *                idx;
+   tinytac_servers_t *     servers;
+   tinytac_metrics_t *     metrics;
+   tinytac_cache_key_t **  ckeys;
+   tinytac_reply_view_t    view;
+   tinytac_arena_mark_t    mark;
+
+   TinyTacDebugTrace();
+
+   assert(tt      != NULL);
+   assert(reqs    != NULL);
+   assert(replies != NULL);
+   assert(results != NULL);
+
+   for(pos = 0; (pos < cnt); pos++)
+   {
+      replies[pos] = NULL;
+      results[pos] = TTAC_EUNKNOWN;
+   };
+   for(pos = 0; (pos < cnt); pos++)
+      if (reqs[pos]->pckt_type != TAC_PLUS_TYPE_AUTHOR)
+         return(TTAC_EINVAL);
+   if (!(cnt))
+      return(TTAC_SUCCESS);
+
+   tinytac_arena_mark(&mark);
+   idx   = tinytac_arena_alloc(cnt * sizeof(size_t));
+   ckeys = tinytac_arena_alloc(cnt * sizeof(tinytac_cache_key_t *));
+   if ( (!(idx)) || (!(ckeys)) )
+   {
+      tinytac_arena_reset(&mark);
+      return(TTAC_ENOMEM);
+   };
+   memset(ckeys, 0, (cnt * sizeof(tinytac_cache_key_t *)));
+
+   // answer requests from caches and list the remaining requests
+   servers  = tinytac_servers_acquire(tt);
+   key      = tinytac_net_key(servers);
+   for(pos = 0, n = 0; (pos < cnt); pos++)
+   {
+      tinytac_pckt_obfuscate(reqs[pos], key, strlen(key), TTAC_YES);
+      if ( ( ((tt->cache_size)) || ((tt->shm_cache)) ) && (!(flags & TTAC_REQ_NOCACHE)) )
+      {
+         if ((results[pos] = tinytac_cache_key(reqs[pos], &ckeys[pos])) == TTAC_ENOMEM)
+            continue;
+         if ( ((ckeys[pos])) && ((results[pos] = tinytac_cache_lookup(tt, ckeys[pos], reqs[pos], &replies[pos])) != TTAC_ENOENT) )
+         {
+            tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_HITS, 1);
+            TinyTacProbe1(cache__hit, ntohl(reqs[pos]->pckt_session_id));
+            continue;
+         };
+         if ( ((ckeys[pos])) && ((results[pos] = tinytac_shm_lookup(tt, ckeys[pos], reqs[pos], &replies[pos])) != TTAC_ENOENT) )
+         {
+            tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_HITS, 1);
+            TinyTacProbe1(cache__hit, ntohl(reqs[pos]->pckt_session_id));
+            continue;
+         };
+         if ((ckeys[pos]))
+         {
+            tinytac_metrics_add(tt, NULL, TTAC_STAT_CACHE_MISSES, 1);
+            TinyTacProbe1(cache__miss, ntohl(reqs[pos]->pckt_session_id));
+         };
+      };
+      idx[n++] = pos;
+   };
+
+   // the first reply tells whether sessions may share the connection
+   if ((n))
+   {
+      sock     = s;
+      metrics  = NULL;
+      if ( (s != -1) || ((rc = tinytac_net_connect(tt, servers, &sock, &metrics)) == TTAC_SUCCESS) )
+      {
+         results[idx[0]] = tinytac_net_exchange(tt, servers, metrics, sock, reqs[idx[0]], &replies[idx[0]]);
+         if ( (results[idx[0]] == TTAC_SUCCESS) && ((replies[idx[0]]->pckt_flags & TAC_PLUS_SINGLE_CONNECT_FLAG)) )
+            tinytac_author_pipeline(tt, servers, metrics, sock, reqs, replies, results, &idx[1], (n - 1));
+         else
+            tinytac_author_spread(tt, servers, reqs, replies, results, &idx[1], (n - 1));
+         if (s == -1)
+            close(sock);
+      }
+      else
+      {
+         for(pos = 0; (pos < n); pos++)
+            results[idx[pos]] = rc;
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_REQUESTS, n);
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_FAILURES, n);
+      };
+   };
+   tinytac_servers_release(servers);
+
+   // do not return or cache malformed replies
+   for(pos = 0; (pos < n); pos++)
+   {
+      if (results[idx[pos]] != TTAC_SUCCESS)
+         continue;
+      if (tinytac_pckt_reply_view(replies[idx[pos]], &view) != TTAC_SUCCESS)
+      {
+         tinytac_mem_free(replies[idx[pos]]);
+         replies[idx[pos]] = NULL;
+         results[idx[pos]] = TTAC_EBADMSG;
+         continue;
+      };
+      if ((ckeys[idx[pos]]))
+      {
+         tinytac_cache_store(tt, ckeys[idx[pos]], replies[idx[pos]]);
+         tinytac_shm_store(tt, ckeys[idx[pos]], replies[idx[pos]]);
+      };
+   };
+
+   tinytac_arena_reset(&mark);
+
+   rc = TTAC_SUCCESS;
+   for(pos = 0; (pos < cnt); pos++)
+      rc = (rc == TTAC_SUCCESS) ? results[pos] : rc;
+
+   return(rc);
+}
+
+
+int
+tinytac_author_coalesce(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp )
+{
+   int                  rc;
+   size_t               waiters;
+   size_t               body_len;
+   uint64_t             hash;
+   tinytac_flight_t *   flight;
+   tinytac_flight_t **  flightp;
+   tinytac_pckt_t *     reply;
+
+   TinyTacDebugTrace();
+
+   body_len = ntohl(req->pckt_length);
+   hash     = tinytac_hash(TTAC_HASH_INIT, &req->pckt_version, 1);
+   hash     = tinytac_hash(hash, req->pckt_body, body_len);
+
+   pthread_mutex_lock(&tt->flights_mutex);
+
+   // attach to identical in-flight request
+   for(flight = tt->flights; ((flight)); flight = flight->next)
+   {
+      if (flight->hash != hash)
+         continue;
+      if (flight->body_len != body_len)
+         continue;
+      if ((memcmp(flight->body, req->pckt_body, body_len)))
+         continue;
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): coalescing request %016" PRIx64, __func__, hash);
+      return(tinytac_author_wait(tt, flight, req, replyp));
+   };
+
+   // register request as in flight
+   if ((flight = tinytac_flight_alloc(hash, req->pckt_body, body_len)) == NULL)
+   {
+      pthread_mutex_unlock(&tt->flights_mutex);
+      return(TTAC_ENOMEM);
+   };
+   flight->next = tt->flights;
+   tt->flights  = flight;
+
+   pthread_mutex_unlock(&tt->flights_mutex);
+
+   reply = NULL;
+   rc    = tinytac_net_exchange(tt, servers, NULL, s, req, &reply);
+
+   pthread_mutex_lock(&tt->flights_mutex);
+
+   // remove request from in-flight list
+   for(flightp = &tt->flights; (*flightp != flight); flightp = &(*flightp)->next);
+   *flightp = flight->next;
+
+   // publish reply to waiting callers
+   flight->rc = rc;
+   if ( (rc == TTAC_SUCCESS) && ((flight->waiters)) )
+      if ((flight->reply = tinytac_pckt_dup(reply)) == NULL)
+         flight->rc = TTAC_ENOMEM;
+   flight->done = TTAC_YES;
+   waiters      = flight->waiters;
+   pthread_cond_broadcast(&flight->cond);
+
+   pthread_mutex_unlock(&tt->flights_mutex);
+
+   if (!(waiters))
+      tinytac_flight_free(flight);
+
+   *replyp = reply;
+
+   return(rc);
+}
+
+
+/// merges arguments of a PASS_ADD or PASS_REPL reply with the request
+///
+/// PASS_REPL replaces the request arguments with the reply arguments.
+/// PASS_ADD keeps request arguments whose attribute does not appear in the
+/// reply and appends every reply argument, so a reply attribute, including
+/// its mandatory or optional separator, supersedes all request pairs of the
+/// same name.  Reply attribute names are hashed once, making the merge
+/// linear in the number of arguments.
+int
+tinytac_author_merge(
+         const char * const *          args,
+         const tinytac_pckt_t *        reply,
+         void *                        arena,
+         size_t                        arena_len,
+         char ***                      argvp )
+{
+   int                        rc;
+   size_t                     arg_cnt;
+   size_t                     len;
+   size_t                     mask;
+   size_t                     pos;
+   size_t                     argc;
+   size_t                     slot;
+   size_t                     tbl_size;
+   uint64_t                   hash;
+   uint8_t *                  next;
+   uint8_t *                  end;
+   char **                    argv;
+   tinytac_merge_name_t *     tbl;
+   tinytac_reply_view_t       view;
+
+   TinyTacDebugTrace();
+
+   assert(reply  != NULL);
+   assert(arena  != NULL);
+   assert(argvp  != NULL);
+
+   *argvp = NULL;
+
+   if ((rc = tinytac_pckt_reply_view(reply, &view)) != TTAC_SUCCESS)
+      return(rc);
+   if (view.type != TAC_PLUS_TYPE_AUTHOR)
+      return(TTAC_EINVAL);
+   switch(view.status)
+   {
+      case TAC_PLUS_AUTHOR_STATUS_PASS_ADD:
+      for(arg_cnt = 0; ( ((args)) && ((args[arg_cnt])) ); arg_cnt++);
+      break;
+
+      case TAC_PLUS_AUTHOR_STATUS_PASS_REPL:
+      arg_cnt = 0;
+      break;
+
+      default:
+      return(TTAC_EINVAL);
+   };
+
+   // carve argument vector and name table from the start of the arena
+   for(tbl_size = 8; (tbl_size < (view.arg_cnt * 2)); tbl_size <<= 1);
+   mask  = tbl_size - 1;
+   len   = (sizeof(char *) * (arg_cnt + view.arg_cnt + 1)) + (sizeof(tinytac_merge_name_t) * tbl_size);
+   next  = (uint8_t *)(((uintptr_t)arena + (sizeof(uint64_t) - 1)) & ~((uintptr_t)sizeof(uint64_t) - 1));
+   end   = (uint8_t *)arena + arena_len;
+   if ( (next > end) || (len > (size_t)(end - next)) )
+      return(TTAC_ENOBUFS);
+   tbl   = (tinytac_merge_name_t *)next;
+   argv  = (char **)&tbl[tbl_size];
+   next += len;
+   memset(tbl, 0, (sizeof(tinytac_merge_name_t) * tbl_size));
+
+   // hash attribute names of reply
+   for(pos = 0; ( (arg_cnt > 0) && (pos < view.arg_cnt) ); pos++)
+   {
+      len  = tinytac_av_scan(view.args[pos].ptr, view.args[pos].len);
+      hash = tinytac_hash(TTAC_HASH_INIT, view.args[pos].ptr, len);
+      for(slot = (size_t)hash & mask; ((tbl[slot].name)); slot = (slot + 1) & mask)
+         if ( (tbl[slot].hash == hash) && (tbl[slot].len == len) && (!(memcmp(tbl[slot].name, view.args[pos].ptr, len))) )
+            break;
+      tbl[slot].hash = hash;
+      tbl[slot].name = view.args[pos].ptr;
+      tbl[slot].len  = len;
+   };
+
+   // keep request arguments not superseded by reply
+   argc = 0;
+   for(pos = 0; (pos < arg_cnt); pos++)
+   {
+      len  = tinytac_av_scan(args[pos], strlen(args[pos]));
+      hash = tinytac_hash(TTAC_HASH_INIT, args[pos], len);
+      for(slot = (size_t)hash & mask; ((tbl[slot].name)); slot = (slot + 1) & mask)
+         if ( (tbl[slot].hash == hash) && (tbl[slot].len == len) && (!(memcmp(tbl[slot].name, args[pos], len))) )
+            break;
+      if ((tbl[slot].name))
+         continue;
+      if ((argv[argc++] = tinytac_author_merge_copy(&next, end, args[pos], strlen(args[pos]))) == NULL)
+         return(TTAC_ENOBUFS);
+   };
+
+   // append reply arguments
+   for(pos = 0; (pos < view.arg_cnt); pos++)
+      if ((argv[argc++] = tinytac_author_merge_copy(&next, end, view.args[pos].ptr, view.args[pos].len)) == NULL)
+         return(TTAC_ENOBUFS);
+   argv[argc] = NULL;
+
+   *argvp = argv;
+
+   return(TTAC_SUCCESS);
+}
+
+
+char *
+tinytac_author_merge_copy(
+         uint8_t **                    nextp,
+         const uint8_t *               end,
+         const char *                  str,
+         size_t                        len )
+{
+   char *      dst;
+   if (len >= (size_t)(end - *nextp))
+      return(NULL);
+   dst = (char *)*nextp;
+   memcpy(dst, str, len);
+   dst[len] = '\0';
+   *nextp += len + 1;
+   return(dst);
+}
+
+
+/// writes requests to a single-connect connection and reads the replies
+///
+/// Requests are written with a single call and replies are matched to
+/// requests by session_id.  Requests without a reply are marked with the
+/// error which ended the exchange.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  servers       referenced set of servers of handle
+/// @param[in]  metrics       metrics of server connected to socket or NULL
+/// @param[in]  s             socket connected in single-connect mode
+/// @param[in]  reqs          authorization REQUEST packets
+/// @param[out] replies       array to store authorization REPLY packets
+/// @param[out] results       array to store result of each request
+/// @param[in]  idx           indexes of requests to send
+/// @param[in]  n             number of requests to send
+void
+tinytac_author_pipeline(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t *           metrics,
+         int                           s,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         const size_t *                idx,
+         size_t                        n )
+{
+   int                  rc;
+   char *               key;
+   size_t               count;
+   size_t               pos;
+   uint64_t             sent;
+   struct iovec *       iov;
+   tinytac_pckt_t *     reply;
+   tinytac_pckt_t *     req;
+
+   if (!(n))
+      return;
+
+   tinytac_metrics_add(tt, metrics, TTAC_STAT_REQUESTS, n);
+
+   if ((iov = tinytac_arena_alloc(n * sizeof(struct iovec))) == NULL)
+   {
+      for(pos = 0; (pos < n); pos++)
+         results[idx[pos]] = TTAC_ENOMEM;
+      tinytac_metrics_add(tt, metrics, TTAC_STAT_FAILURES, n);
+      return;
+   };
+
+   key = tinytac_net_key(servers);
+   for(pos = 0; (pos < n); pos++)
+   {
+      tinytac_capture(s, reqs[idx[pos]], (TTAC_CAPTURE_SENT | TTAC_CAPTURE_PLAIN));
+      tinytac_pckt_obfuscate(reqs[idx[pos]], key, strlen(key), TTAC_NO);
+      iov[pos].iov_base = reqs[idx[pos]];
+      iov[pos].iov_len  = sizeof(tinytac_pckt_t) + ntohl(reqs[idx[pos]]->pckt_length);
+   };
+   TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): sending %zu authorization requests", __func__, n);
+   sent  = tinytac_metrics_now();
+   rc    = (tinytac_net_sendv(s, iov, n) == -1) ? TTAC_ENETWORK : TTAC_SUCCESS;
+   sent  = tinytac_metrics_phase(tt, metrics, TTAC_PHASE_SEND, sent);
+
+   // replies of different sessions may arrive in any order
+   for(count = 0; ( (rc == TTAC_SUCCESS) && (count < n) ); count++)
+   {
+      if (tinytac_net_recv(tt, metrics, s, key, &reply, sent) == -1)
+      {
+         rc = (errno == EBADMSG) ? TTAC_EBADMSG : TTAC_ENETWORK;
+         break;
+      };
+      for(pos = 0; (pos < n); pos++)
+         if ( (!(replies[idx[pos]])) && (reqs[idx[pos]]->pckt_session_id == reply->pckt_session_id) )
+            break;
+      req = (pos < n) ? reqs[idx[pos]] : NULL;
+      if ( (!(req)) || (reply->pckt_type != req->pckt_type) || (reply->pckt_seq_no != ((req->pckt_seq_no + 1) & 0xff)) )
+      {
+         tinytac_mem_free(reply);
+         rc = TTAC_EBADMSG;
+         break;
+      };
+      replies[idx[pos]] = reply;
+      results[idx[pos]] = TTAC_SUCCESS;
+   };
+
+   for(pos = 0, count = 0; (pos < n); pos++)
+   {
+      if ((replies[idx[pos]]))
+         continue;
+      results[idx[pos]] = rc;
+      count++;
+   };
+   tinytac_metrics_add(tt, metrics, TTAC_STAT_FAILURES, count);
+
+   return;
+}
+
+
+/// sends requests on separate connections before reading the replies
+///
+/// Used when the server does not support single-connect mode.  At most
+/// TTAC_AUTHOR_BULK_CONNS connections are open at once.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  servers       referenced set of servers of handle
+/// @param[in]  reqs          authorization REQUEST packets
+/// @param[out] replies       array to store authorization REPLY packets
+/// @param[out] results       array to store result of each request
+/// @param[in]  idx           indexes of requests to send
+/// @param[in]  n             number of requests to send
+void
+tinytac_author_spread(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_pckt_t **             reqs,
+         tinytac_pckt_t **             replies,
+         int *                         results,
+         const size_t *                idx,
+         size_t                        n )
+{
+   int                  socks[TTAC_AUTHOR_BULK_CONNS];
+   uint64_t             sent[TTAC_AUTHOR_BULK_CONNS];
+   tinytac_metrics_t *  metrics[TTAC_AUTHOR_BULK_CONNS];
+   char *               key;
+   size_t               off;
+   size_t               pos;
+   size_t               cnt;
+   tinytac_pckt_t *     reply;
+   tinytac_pckt_t *     req;
+
+   key = tinytac_net_key(servers);
+
+   tinytac_metrics_add(tt, NULL, TTAC_STAT_REQUESTS, n);
+
+   for(off = 0; (off < n); off += cnt)
+   {
+      cnt = ((n - off) < TTAC_AUTHOR_BULK_CONNS) ? (n - off) : TTAC_AUTHOR_BULK_CONNS;
+
+      for(pos = 0; (pos < cnt); pos++)
+      {
+         if ((results[idx[off+pos]] = tinytac_net_connect(tt, servers, &socks[pos], &metrics[pos])) != TTAC_SUCCESS)
+         {
+            tinytac_metrics_add(tt, NULL, TTAC_STAT_FAILURES, 1);
+            continue;
+         };
+         tinytac_metrics_add(NULL, metrics[pos], TTAC_STAT_REQUESTS, 1);
+         if (tinytac_net_send(tt, metrics[pos], socks[pos], key, reqs[idx[off+pos]], &sent[pos]) == -1)
+         {
+            tinytac_metrics_add(tt, metrics[pos], TTAC_STAT_FAILURES, 1);
+            results[idx[off+pos]] = TTAC_ENETWORK;
+            close(socks[pos]);
+            socks[pos] = -1;
+         };
+      };
+
+      for(pos = 0; (pos < cnt); pos++)
+      {
+         if (socks[pos] == -1)
+            continue;
+         req = reqs[idx[off+pos]];
+         if (tinytac_net_recv(tt, metrics[pos], socks[pos], key, &reply, sent[pos]) == -1)
+            results[idx[off+pos]] = (errno == EBADMSG) ? TTAC_EBADMSG : TTAC_ENETWORK;
+         else if ( (reply->pckt_session_id != req->pckt_session_id) ||
+                   (reply->pckt_type       != req->pckt_type) ||
+                   (reply->pckt_seq_no     != ((req->pckt_seq_no + 1) & 0xff)) )
+         {
+            tinytac_mem_free(reply);
+            results[idx[off+pos]] = TTAC_EBADMSG;
+         }
+         else
+            replies[idx[off+pos]] = reply;
+         if (results[idx[off+pos]] != TTAC_SUCCESS)
+            tinytac_metrics_add(tt, metrics[pos], TTAC_STAT_FAILURES, 1);
+         close(socks[pos]);
+      };
+   };
+
+   return;
+}
+
+
+/// waits for in-flight request to complete
+///
+/// Must be called with flights_mutex held, returns with mutex released.
+int
+tinytac_author_wait(
+         TinyTac *                     tt,
+         tinytac_flight_t *            flight,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp )
+{
+   int                  rc;
+   size_t               waiters;
+   tinytac_pckt_t *     reply;
+
+   TinyTacDebugTrace();
+
+   flight->waiters++;
+   while(!(flight->done))
+      pthread_cond_wait(&flight->cond, &tt->flights_mutex);
+
+   reply = NULL;
+   if ((rc = flight->rc) == TTAC_SUCCESS)
+   {
+      if ((reply = tinytac_pckt_dup(flight->reply)) != NULL)
+      {
+         reply->pckt_session_id  = req->pckt_session_id;
+         reply->pckt_seq_no      = (req->pckt_seq_no + 1) & 0xff;
+      } else {
+         rc = TTAC_ENOMEM;
+      };
+   };
+
+   waiters = --flight->waiters;
+
+   pthread_mutex_unlock(&tt->flights_mutex);
+
+   if (!(waiters))
+      tinytac_flight_free(flight);
+
+   *replyp = reply;
+
+   return(rc);
+}
+
+
+//------------------//
+// flight functions //
+//------------------//
+#pragma mark flight functions
+
+tinytac_flight_t *
+tinytac_flight_alloc(
+         uint64_t                      hash,
+         const uint8_t *               body,
+         size_t                        body_len )
+{
+   tinytac_flight_t *      flight;
+
+   TinyTacDebugTrace();
+
+   if ((flight = tinytac_mem_alloc(sizeof(tinytac_flight_t) + body_len)) == NULL)
+      return(NULL);
+   memset(flight, 0, sizeof(tinytac_flight_t));
+
+   if ((pthread_cond_init(&flight->cond, NULL)))
+   {
+      tinytac_mem_free(flight);
+      return(NULL);
+   };
+
+   flight->hash      = hash;
+   flight->body      = (uint8_t *)&flight[1];
+   flight->body_len  = body_len;
+   memcpy(flight->body, body, body_len);
+
+   return(flight);
+}
+
+
+void
+tinytac_flight_free(
+         tinytac_flight_t *            flight )
+{
+   TinyTacDebugTrace();
+   if (!(flight))
+      return;
+   pthread_cond_destroy(&flight->cond);
+   if ((flight->reply))
+      tinytac_mem_free(flight->reply);
+   tinytac_mem_free(flight);
+   return;
+}
+
+
+/* end of source */
@@ -0,0 +1,338 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LAVPAIR_C 1
+#include "lavpair.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "lproto.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SWAR_ONES              0x0101010101010101ULL
+#define TTAC_SWAR_HIGHS             0x8080808080808080ULL
+#define TTAC_SWAR_BYTE( c )         (TTAC_SWAR_ONES * (uint8_t)(c))
+#define TTAC_SWAR_HASZERO( v )      (((v) - TTAC_SWAR_ONES) & ~(v) & TTAC_SWAR_HIGHS)
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytac_av_entry
+{
+   const char *            name;
+   size_t                  len;
+   unsigned                id;
+} tinytac_av_entry_t;
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// indexed by top TTAC_AV_HASH_BITS bits of tinytac_hash(TTAC_AV_HASH_SEED, name)
+static const tinytac_av_entry_t tinytac_av_table[TTAC_AV_HASH_SIZE] =
+{
+   [ 0] = { "acl",           3, TTAC_AV_ACL          },
+   [ 2] = { "bytes_out",     9, TTAC_AV_BYTES_OUT    },
+   [ 3] = { "addr",          4, TTAC_AV_ADDR         },
+   [ 5] = { "cmd",           3, TTAC_AV_CMD          },
+   [ 8] = { "addr-pool",     9, TTAC_AV_ADDR_POOL    },
+   [10] = { "inacl",         5, TTAC_AV_INACL        },
+   [11] = { "start_time",   10, TTAC_AV_START_TIME   },
+   [13] = { "stop_time",     9, TTAC_AV_STOP_TIME    },
+   [18] = { "autocmd",       7, TTAC_AV_AUTOCMD      },
+   [20] = { "noescape",      8, TTAC_AV_NOESCAPE     },
+   [21] = { "protocol",      8, TTAC_AV_PROTOCOL     },
+   [27] = { "nohangup",      8, TTAC_AV_NOHANGUP     },
+   [28] = { "elapsed_time", 12, TTAC_AV_ELAPSED_TIME },
+   [29] = { "paks_in",       7, TTAC_AV_PAKS_IN      },
+   [32] = { "idletime",      8, TTAC_AV_IDLETIME     },
+   [35] = { "timeout",       7, TTAC_AV_TIMEOUT      },
+   [38] = { "paks_out",      8, TTAC_AV_PAKS_OUT     },
+   [39] = { "timezone",      8, TTAC_AV_TIMEZONE     },
+   [41] = { "err_msg",       7, TTAC_AV_ERR_MSG      },
+   [43] = { "task_id",       7, TTAC_AV_TASK_ID      },
+   [44] = { "outacl",        6, TTAC_AV_OUTACL       },
+   [45] = { "bytes_in",      8, TTAC_AV_BYTES_IN     },
+   [46] = { "reason",        6, TTAC_AV_REASON       },
+   [50] = { "priv-lvl",      8, TTAC_AV_PRIV_LVL     },
+   [51] = { "cmd-arg",       7, TTAC_AV_CMD_ARG      },
+   [52] = { "event",         5, TTAC_AV_EVENT        },
+   [59] = { "service",       7, TTAC_AV_SERVICE      },
+};
+
+
+static const char * const tinytac_av_names[TTAC_AV_MAX] =
+{
+   [TTAC_AV_UNKNOWN]         = NULL,
+   [TTAC_AV_ACL]             = "acl",
+   [TTAC_AV_ADDR]            = "addr",
+   [TTAC_AV_ADDR_POOL]       = "addr-pool",
+   [TTAC_AV_AUTOCMD]         = "autocmd",
+   [TTAC_AV_BYTES_IN]        = "bytes_in",
+   [TTAC_AV_BYTES_OUT]       = "bytes_out",
+   [TTAC_AV_CMD]             = "cmd",
+   [TTAC_AV_CMD_ARG]         = "cmd-arg",
+   [TTAC_AV_ELAPSED_TIME]    = "elapsed_time",
+   [TTAC_AV_ERR_MSG]         = "err_msg",
+   [TTAC_AV_EVENT]           = "event",
+   [TTAC_AV_IDLETIME]        = "idletime",
+   [TTAC_AV_INACL]           = "inacl",
+   [TTAC_AV_NOESCAPE]        = "noescape",
+   [TTAC_AV_NOHANGUP]        = "nohangup",
+   [TTAC_AV_OUTACL]          = "outacl",
+   [TTAC_AV_PAKS_IN]         = "paks_in",
+   [TTAC_AV_PAKS_OUT]        = "paks_out",
+   [TTAC_AV_PRIV_LVL]        = "priv-lvl",
+   [TTAC_AV_PROTOCOL]        = "protocol",
+   [TTAC_AV_REASON]          = "reason",
+   [TTAC_AV_SERVICE]         = "service",
+   [TTAC_AV_START_TIME]      = "start_time",
+   [TTAC_AV_STOP_TIME]       = "stop_time",
+   [TTAC_AV_TASK_ID]         = "task_id",
+   [TTAC_AV_TIMEOUT]         = "timeout",
+   [TTAC_AV_TIMEZONE]        = "timezone",
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//---------------------//
+// attribute functions //
+//---------------------//
+#pragma mark attribute functions
+
+unsigned
+tinytac_av_id(
+         const char *                  name,
+         size_t                        len )
+{
+   const tinytac_av_entry_t *    entry;
+
+   assert(name != NULL);
+
+   entry = &tinytac_av_table[tinytac_hash(TTAC_AV_HASH_SEED, name, len) >> (64 - TTAC_AV_HASH_BITS)];
+   if ( (entry->len != len) || (!(entry->name)) )
+      return(TTAC_AV_UNKNOWN);
+   if ((memcmp(entry->name, name, len)))
+      return(TTAC_AV_UNKNOWN);
+
+   return(entry->id);
+}
+
+
+const char *
+tinytac_av_name(
+         unsigned                      id )
+{
+   if (id >= TTAC_AV_MAX)
+      return(NULL);
+   return(tinytac_av_names[id]);
+}
+
+
+/// returns offset of first '=' or '*' in string, or 'len' if not found
+///
+/// Eight bytes are compared at a time using SWAR zero byte detection, the
+/// matching word is then scanned bytewise.
+size_t
+tinytac_av_scan(
+         const char *                  str,
+         size_t                        len )
+{
+   size_t         pos;
+   uint64_t       word;
+
+   for(pos = 0; ((pos + 8) <= len); pos += 8)
+   {
+      memcpy(&word, &str[pos], sizeof(word));
+      if ( ((TTAC_SWAR_HASZERO(word ^ TTAC_SWAR_BYTE('=')))) || ((TTAC_SWAR_HASZERO(word ^ TTAC_SWAR_BYTE('*')))) )
+         break;
+   };
+   for(; (pos < len); pos++)
+      if ( (str[pos] == '=') || (str[pos] == '*') )
+         return(pos);
+
+   return(len);
+}
+
+
+//-------------------//
+// AV pair functions //
+//-------------------//
+#pragma mark AV pair functions
+
+int
+tinytac_avpairs_get_int(
+         const tinytac_avpairs_t *     avp,
+         unsigned                      id,
+         long long *                   valp )
+{
+   int                  rc;
+   int                  neg;
+   size_t               pos;
+   long long            val;
+   tinytac_slice_t      str;
+
+   assert(avp  != NULL);
+   assert(valp != NULL);
+
+   if ((rc = tinytac_avpairs_get_str(avp, id, &str)) != TTAC_SUCCESS)
+      return(rc);
+   if (!(str.len))
+      return(TTAC_ESYNTAX);
+
+   pos = 0;
+   neg = ((str.ptr[0] == '-')) ? 1 : 0;
+   if ( (str.ptr[0] == '-') || (str.ptr[0] == '+') )
+      pos++;
+   if (pos == str.len)
+      return(TTAC_ESYNTAX);
+
+   // accumulate as a negative number so LLONG_MIN does not overflow
+   for(val = 0; (pos < str.len); pos++)
+   {
+      if ( (str.ptr[pos] < '0') || (str.ptr[pos] > '9') )
+         return(TTAC_ESYNTAX);
+      if (val < ((LLONG_MIN + (str.ptr[pos] - '0')) / 10))
+         return(TTAC_ESYNTAX);
+      val = (val * 10) - (str.ptr[pos] - '0');
+   };
+   if ( (!(neg)) && (val == LLONG_MIN) )
+      return(TTAC_ESYNTAX);
+
+   *valp = ((neg)) ? val : -val;
+
+   return(TTAC_SUCCESS);
+}
+
+
+int
+tinytac_avpairs_get_str(
+         const tinytac_avpairs_t *     avp,
+         unsigned                      id,
+         tinytac_slice_t *             valp )
+{
+   unsigned       pos;
+
+   assert(avp  != NULL);
+   assert(valp != NULL);
+
+   if ( (id == TTAC_AV_UNKNOWN) || (id >= TTAC_AV_MAX) )
+      return(TTAC_ENOENT);
+   if ((pos = avp->index[id]) == 0)
+      return(TTAC_ENOENT);
+   pos--;
+
+   valp->ptr = &avp->name[pos][avp->name_len[pos] + 1];
+   valp->len = avp->value_len[pos];
+
+   return(TTAC_SUCCESS);
+}
+
+
+int
+tinytac_avpairs_parse(
+         tinytac_avpairs_t *           avp,
+         const tinytac_slice_t *       args,
+         unsigned                      arg_cnt )
+{
+   size_t         len;
+   unsigned       id;
+   unsigned       pos;
+
+   TinyTacDebugTrace();
+
+   assert(avp != NULL);
+   assert( (args != NULL) || (arg_cnt == 0) );
+
+   if (arg_cnt > 255)
+      return(TTAC_ESYNTAX);
+
+   avp->count = 0;
+   memset(avp->index, 0, sizeof(avp->index));
+
+   for(pos = 0; (pos < arg_cnt); pos++)
+   {
+      // pair must have a non-empty name followed by a separator
+      len = tinytac_av_scan(args[pos].ptr, args[pos].len);
+      if ( (args[pos].len > 255) || (len == args[pos].len) || (!(len)) )
+      {
+         memset(avp->index, 0, sizeof(avp->index));
+         return(TTAC_ESYNTAX);
+      };
+
+      id                   = tinytac_av_id(args[pos].ptr, len);
+      avp->id[pos]         = (uint8_t)id;
+      avp->optional[pos]   = (args[pos].ptr[len] == '*') ? 1 : 0;
+      avp->name[pos]       = args[pos].ptr;
+      avp->name_len[pos]   = (uint8_t)len;
+      avp->value_len[pos]  = (uint8_t)(args[pos].len - len - 1);
+      if ( ((id)) && (!(avp->index[id])) )
+         avp->index[id] = (uint8_t)(pos + 1);
+   };
+   avp->count = arg_cnt;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/* end of source */
@@ -0,0 +1,513 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LCACHE_C 1
+#include "lcache.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "larena.h"
+#include "lmemory.h"
+#include "lproto.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_CACHE_MIN_SLOTS        8
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytac_cache_entry
+{
+   uint64_t                hash;
+   uint64_t                expires;
+   size_t                  key_len;
+   const uint8_t *         key;
+   tinytac_pckt_t *        reply;      // NULL if slot is empty, key is stored in same allocation
+   int                     ref;        // CLOCK reference bit
+} tinytac_cache_entry_t;
+
+
+struct _tinytac_cache
+{
+   size_t                  max;
+   size_t                  count;
+   size_t                  mask;
+   size_t                  hand;
+   tinytac_cache_entry_t   slots[];
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static tinytac_cache_t *
+tinytac_cache_alloc(
+         size_t                        max );
+
+
+static void
+tinytac_cache_evict(
+         tinytac_cache_t *             cache );
+
+
+static ssize_t
+tinytac_cache_find(
+         tinytac_cache_t *             cache,
+         const tinytac_cache_key_t *   key );
+
+
+static void
+tinytac_cache_remove(
+         tinytac_cache_t *             cache,
+         size_t                        idx );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+tinytac_cache_t *
+tinytac_cache_alloc(
+         size_t                        max )
+{
+   size_t                  slots;
+   size_t                  size;
+   tinytac_cache_t *       cache;
+
+   TinyTacDebugTrace();
+
+   // keep load factor at or below 0.5 so probe sequences stay short
+   for(slots = TTAC_CACHE_MIN_SLOTS; (slots < (max * 2)); slots <<= 1);
+
+   size = sizeof(tinytac_cache_t) + (sizeof(tinytac_cache_entry_t) * slots);
+   if ((cache = tinytac_mem_alloc(size)) == NULL)
+      return(NULL);
+   memset(cache, 0, size);
+
+   cache->max  = max;
+   cache->mask = slots - 1;
+
+   return(cache);
+}
+
+
+/// returns number of replies in cache of handle
+///
+/// @param[in]  tt            reference to library handle
+///
+/// @return    Returns number of cached replies.
+size_t
+tinytac_cache_count(
+         TinyTac *                     tt )
+{
+   size_t count;
+   pthread_mutex_lock(&tt->cache_mutex);
+   count = ((tt->cache)) ? tt->cache->count : 0;
+   pthread_mutex_unlock(&tt->cache_mutex);
+   return(count);
+}
+
+
+void
+tinytac_cache_evict(
+         tinytac_cache_t *             cache )
+{
+   tinytac_cache_entry_t *    entry;
+
+   TinyTacDebugTrace();
+
+   while((cache->count))
+   {
+      entry = &cache->slots[cache->hand];
+      if ((entry->reply))
+      {
+         if (!(entry->ref))
+         {
+            tinytac_cache_remove(cache, cache->hand);
+            return;
+         };
+         entry->ref = 0;
+      };
+      cache->hand = (cache->hand + 1) & cache->mask;
+   };
+
+   return;
+}
+
+
+ssize_t
+tinytac_cache_find(
+         tinytac_cache_t *             cache,
+         const tinytac_cache_key_t *   key )
+{
+   size_t                     idx;
+   tinytac_cache_entry_t *    entry;
+
+   for(idx = key->hash & cache->mask; ((cache->slots[idx].reply)); idx = (idx + 1) & cache->mask)
+   {
+      entry = &cache->slots[idx];
+      if (entry->hash != key->hash)
+         continue;
+      if (entry->key_len != key->len)
+         continue;
+      if ((memcmp(entry->key, key->bytes, key->len)))
+         continue;
+      return((ssize_t)idx);
+   };
+
+   return(-1);
+}
+
+
+void
+tinytac_cache_free(
+         tinytac_cache_t *             cache )
+{
+   size_t idx;
+   TinyTacDebugTrace();
+   if (!(cache))
+      return;
+   for(idx = 0; (idx <= cache->mask); idx++)
+      if ((cache->slots[idx].reply))
+         tinytac_mem_free(cache->slots[idx].reply);
+   tinytac_mem_free(cache);
+   return;
+}
+
+
+/// generates cache key from authorization request
+///
+/// The key contains the authen_method, priv_lvl, authen_service, user and
+/// arguments of the request.  The port and rem_addr fields are not part of
+/// the key.  The key is allocated from the request arena of the calling
+/// thread and is released when the arena is reset.
+///
+/// @param[in]  req           un-obfuscated authorization REQUEST packet
+/// @param[out] keyp          pointer to store allocated key
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_cache_key(
+         const tinytac_pckt_t *        req,
+         tinytac_cache_key_t **        keyp )
+{
+   size_t                           pos;
+   size_t                           off;
+   size_t                           args_len;
+   size_t                           body_len;
+   size_t                           key_len;
+   const uint8_t *                  arg_lens;
+   const uint8_t *                  args;
+   const tinytac_author_req_t *     bdy;
+   tinytac_cache_key_t *            key;
+   uint8_t *                        ptr;
+
+   TinyTacDebugTrace();
+
+   assert(req  != NULL);
+   assert(keyp != NULL);
+
+   // verify request body
+   body_len = ntohl(req->pckt_length);
+   if (body_len < sizeof(tinytac_author_req_t))
+      return(TTAC_EBADMSG);
+   bdy = (const tinytac_author_req_t *)req->pckt_body;
+   off = sizeof(tinytac_author_req_t) + bdy->bdy_arg_cnt;
+   off += bdy->bdy_user_len + bdy->bdy_port_len + bdy->bdy_rem_addr_len;
+   if (off > body_len)
+      return(TTAC_EBADMSG);
+   arg_lens = bdy->bdy_bytes;
+   for(pos = 0, args_len = 0; (pos < bdy->bdy_arg_cnt); pos++)
+      args_len += arg_lens[pos];
+   if ((off + args_len) > body_len)
+      return(TTAC_EBADMSG);
+   args = &req->pckt_body[off];
+
+   // allocate key
+   key_len = 4 + bdy->bdy_user_len + 1 + bdy->bdy_arg_cnt + args_len;
+   if ((key = tinytac_arena_alloc(sizeof(tinytac_cache_key_t) + key_len)) == NULL)
+      return(TTAC_ENOMEM);
+   key->len = key_len;
+
+   // assemble key
+   ptr    = key->bytes;
+   *ptr++ = bdy->bdy_authen_method;
+   *ptr++ = bdy->bdy_priv_lvl;
+   *ptr++ = bdy->bdy_authen_service;
+   *ptr++ = bdy->bdy_user_len;
+   memcpy(ptr, &arg_lens[bdy->bdy_arg_cnt], bdy->bdy_user_len);
+   ptr   += bdy->bdy_user_len;
+   *ptr++ = bdy->bdy_arg_cnt;
+   memcpy(ptr, arg_lens, bdy->bdy_arg_cnt);
+   ptr   += bdy->bdy_arg_cnt;
+   memcpy(ptr, args, args_len);
+
+   key->hash = tinytac_hash(TTAC_HASH_INIT, key->bytes, key->len);
+
+   *keyp = key;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// retrieves copy of cached reply
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  key           cache key of request
+/// @param[in]  req           request used to set session_id and seq_no of reply
+/// @param[out] replyp        pointer to store copy of cached reply
+///
+/// @return    Returns TTAC_SUCCESS on cache hit, TTAC_ENOENT on cache miss,
+///            or an error code.
+int
+tinytac_cache_lookup(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        req,
+         tinytac_pckt_t **             replyp )
+{
+   ssize_t                    idx;
+   tinytac_cache_t *          cache;
+   tinytac_cache_entry_t *    entry;
+   tinytac_pckt_t *           reply;
+
+   TinyTacDebugTrace();
+
+   pthread_mutex_lock(&tt->cache_mutex);
+
+   if ((cache = tt->cache) == NULL)
+   {
+      pthread_mutex_unlock(&tt->cache_mutex);
+      return(TTAC_ENOENT);
+   };
+
+   if ((idx = tinytac_cache_find(cache, key)) == -1)
+   {
+      pthread_mutex_unlock(&tt->cache_mutex);
+      return(TTAC_ENOENT);
+   };
+
+   entry = &cache->slots[idx];
+   if (entry->expires <= tinytac_cache_now())
+   {
+      tinytac_cache_remove(cache, (size_t)idx);
+      pthread_mutex_unlock(&tt->cache_mutex);
+      return(TTAC_ENOENT);
+   };
+   entry->ref = 1;
+
+   if ((reply = tinytac_pckt_dup(entry->reply)) == NULL)
+   {
+      pthread_mutex_unlock(&tt->cache_mutex);
+      return(TTAC_ENOMEM);
+   };
+
+   pthread_mutex_unlock(&tt->cache_mutex);
+
+   TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): cache hit %016" PRIx64, __func__, key->hash);
+
+   reply->pckt_session_id  = req->pckt_session_id;
+   reply->pckt_seq_no      = (req->pckt_seq_no + 1) & 0xff;
+   *replyp                 = reply;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// returns seconds on the system-wide monotonic clock
+uint64_t
+tinytac_cache_now(
+         void )
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return((uint64_t)ts.tv_sec);
+}
+
+
+void
+tinytac_cache_remove(
+         tinytac_cache_t *             cache,
+         size_t                        idx )
+{
+   size_t         next;
+   size_t         home;
+
+   tinytac_mem_free(cache->slots[idx].reply);
+   cache->count--;
+
+   // backward shift deletion keeps probe sequences intact without tombstones
+   for(next = (idx + 1) & cache->mask; ((cache->slots[next].reply)); next = (next + 1) & cache->mask)
+   {
+      home = cache->slots[next].hash & cache->mask;
+      if (((next - home) & cache->mask) < ((next - idx) & cache->mask))
+         continue;
+      cache->slots[idx] = cache->slots[next];
+      idx = next;
+   };
+   memset(&cache->slots[idx], 0, sizeof(tinytac_cache_entry_t));
+
+   return;
+}
+
+
+/// stores copy of reply in cache
+///
+/// PASS_ADD and PASS_REPL replies are cached for TTAC_OPT_CACHE_TTL seconds
+/// and FAIL replies for TTAC_OPT_CACHE_NEG_TTL seconds.  The complete reply
+/// body, including status and arguments, is cached so that replayed replies
+/// are applied by the caller exactly as the original reply.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  key           cache key of request
+/// @param[in]  reply         un-obfuscated authorization REPLY packet
+void
+tinytac_cache_store(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        reply )
+{
+   int                        ttl;
+   ssize_t                    found;
+   size_t                     idx;
+   size_t                     reply_len;
+   tinytac_cache_t *          cache;
+   tinytac_cache_entry_t *    entry;
+   tinytac_pckt_t *           data;
+
+   TinyTacDebugTrace();
+
+   if ((ttl = tinytac_cache_ttl(tt, reply)) < 1)
+      return;
+   reply_len = sizeof(tinytac_pckt_t) + ntohl(reply->pckt_length);
+
+   if ((data = tinytac_mem_alloc(reply_len + key->len)) == NULL)
+      return;
+   memcpy(data, reply, reply_len);
+   memcpy(((uint8_t *)data) + reply_len, key->bytes, key->len);
+
+   pthread_mutex_lock(&tt->cache_mutex);
+
+   // resize cache if maximum number of entries was changed
+   if ( ((tt->cache)) && (tt->cache->max != (size_t)tt->cache_size) )
+   {
+      tinytac_cache_free(tt->cache);
+      tt->cache = NULL;
+   };
+   if ( (!(tt->cache)) && (tt->cache_size > 0) )
+      tt->cache = tinytac_cache_alloc((size_t)tt->cache_size);
+   if ((cache = tt->cache) == NULL)
+   {
+      pthread_mutex_unlock(&tt->cache_mutex);
+      tinytac_mem_free(data);
+      return;
+   };
+
+   // remove stale entry and make room for new entry
+   if ((found = tinytac_cache_find(cache, key)) != -1)
+      tinytac_cache_remove(cache, (size_t)found);
+   while(cache->count >= cache->max)
+      tinytac_cache_evict(cache);
+
+   // insert entry
+   for(idx = key->hash & cache->mask; ((cache->slots[idx].reply)); idx = (idx + 1) & cache->mask);
+   entry             = &cache->slots[idx];
+   entry->hash       = key->hash;
+   entry->expires    = tinytac_cache_now() + (uint64_t)ttl;
+   entry->key_len    = key->len;
+   entry->key        = ((const uint8_t *)data) + reply_len;
+   entry->reply      = data;
+   entry->ref        = 0;
+   cache->count++;
+
+   pthread_mutex_unlock(&tt->cache_mutex);
+
+   return;
+}
+
+
+/// determines number of seconds a reply may be cached
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  reply         un-obfuscated authorization REPLY packet
+///
+/// @return    Returns TTL in seconds or 0 if the reply must not be cached.
+int
+tinytac_cache_ttl(
+         TinyTac *                     tt,
+         const tinytac_pckt_t *        reply )
+{
+   if (ntohl(reply->pckt_length) < sizeof(tinytac_author_reply_t))
+      return(0);
+   switch(((const tinytac_author_reply_t *)reply->pckt_body)->bdy_status)
+   {
+      case TAC_PLUS_AUTHOR_STATUS_PASS_ADD:  return(tt->cache_ttl);
+      case TAC_PLUS_AUTHOR_STATUS_PASS_REPL: return(tt->cache_ttl);
+      case TAC_PLUS_AUTHOR_STATUS_FAIL:      return(tt->cache_neg_ttl);
+      default:                               break;
+   };
+   return(0);
+}
+
+
+/* end of source */
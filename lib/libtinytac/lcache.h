@@ -0,0 +1,109 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LCACHE_H
+#define _LIB_LIBTINYTAC_LCACHE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytac_cache_key
+{
+   uint64_t                hash;
+   size_t                  len;
+   uint8_t                 bytes[];
+} tinytac_cache_key_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+size_t
+tinytac_cache_count(
+         TinyTac *                     tt );
+
+
+void
+tinytac_cache_free(
+         tinytac_cache_t *             cache );
+
+
+int
+tinytac_cache_key(
+         const tinytac_pckt_t *        req,
+         tinytac_cache_key_t **        keyp );
+
+
+uint64_t
+tinytac_cache_now(
+         void );
+
+
+int
+tinytac_cache_lookup(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        req,
+         tinytac_pckt_t **             replyp );
+
+
+void
+tinytac_cache_store(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        reply );
+
+
+int
+tinytac_cache_ttl(
+         TinyTac *                     tt,
+         const tinytac_pckt_t *        reply );
+
+
+#endif /* end of header */
@@ -0,0 +1,1003 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LCAPTURE_C 1
+#include "lcapture.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <assert.h>
+
+#include "lmemory.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+// pcapng block types and options
+#define TTAC_PCAPNG_SHB             0x0a0d0d0aU
+#define TTAC_PCAPNG_IDB             0x00000001U
+#define TTAC_PCAPNG_EPB             0x00000006U
+#define TTAC_PCAPNG_MAGIC           0x1a2b3c4dU
+#define TTAC_PCAPNG_LINKTYPE_RAW    101         // raw IPv4 or IPv6 packets
+#define TTAC_PCAPNG_OPT_END         0
+#define TTAC_PCAPNG_OPT_IF_NAME     2
+#define TTAC_PCAPNG_OPT_EPB_FLAGS   2
+#define TTAC_PCAPNG_INBOUND         0x00000001U
+#define TTAC_PCAPNG_OUTBOUND        0x00000002U
+
+
+// interfaces of capture file
+#define TTAC_CAPTURE_IF_WIRE        0     // packets as sent or received
+#define TTAC_CAPTURE_IF_PLAIN       1     // packets with body de-obfuscated
+
+
+// space reserved in a block for headers, options, and padding
+#define TTAC_CAPTURE_FRAME_HDR      60    // IPv6 header and TCP header
+#define TTAC_CAPTURE_BLOCK_MAX      (TTAC_CAPTURE_SNAPLEN + TTAC_CAPTURE_FRAME_HDR + 64)
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// A packet is copied into a slot of the ring by the thread which sends or
+// receives it and is written to the capture file by the writer thread.
+// The ring is a bounded queue with a sequence number in each slot, so
+// threads claim slots with a single compare-and-swap and never wait for
+// the writer.  Packets are dropped and counted when the ring is full.
+typedef struct _tinytac_capture_rec
+{
+   atomic_size_t           seq;
+   struct timespec         ts;
+   unsigned                flags;      // TTAC_CAPTURE_*
+   int                     family;     // AF_INET or AF_INET6
+   uint16_t                lport;      // local port, network byte order
+   uint16_t                rport;      // remote port, network byte order
+   uint8_t                 laddr[16];
+   uint8_t                 raddr[16];
+   uint32_t                len;        // length of packet
+   uint32_t                caplen;     // length of packet recorded
+   uint8_t                 data[TTAC_CAPTURE_SNAPLEN];
+} tinytac_capture_rec_t;
+
+
+// TCP sequence numbers of a connection, keyed by addresses and ports
+typedef struct _tinytac_capture_flow
+{
+   uint64_t                used;       // records written when flow was last used
+   int                     family;
+   unsigned                plain;
+   uint16_t                lport;
+   uint16_t                rport;
+   uint8_t                 laddr[16];
+   uint8_t                 raddr[16];
+   uint32_t                lseq;       // next sequence number sent by local end
+   uint32_t                rseq;       // next sequence number sent by remote end
+} tinytac_capture_flow_t;
+
+
+typedef struct _tinytac_capture
+{
+   atomic_size_t           tail;       // next slot claimed by threads
+   size_t                  head;       // next slot written by writer
+   atomic_int              sleeping;   // writer waits for tinytac_capture_cond
+   _Atomic uint64_t        dropped;
+   uint64_t                reported;
+   uint64_t                written;
+   FILE *                  fs;
+   char *                  path;       // path of open capture file
+   size_t                  bytes;      // bytes written to open capture file
+   size_t                  start;      // bytes of headers of open capture file
+   unsigned                gen;        // generation of open capture file
+   unsigned                want;       // generation of requested capture file
+   tinytac_capture_flow_t  flows[TTAC_CAPTURE_FLOWS];
+   tinytac_capture_rec_t   recs[TTAC_CAPTURE_RING_LEN];
+} tinytac_capture_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static void
+tinytac_capture_addr(
+         const struct sockaddr_storage * sa,
+         int *                         familyp,
+         uint8_t *                     addr,
+         uint16_t *                    portp );
+
+
+static size_t
+tinytac_capture_drain(
+         tinytac_capture_t *           cap );
+
+
+static void
+tinytac_capture_flush(
+         void );
+
+
+static tinytac_capture_flow_t *
+tinytac_capture_flow(
+         tinytac_capture_t *           cap,
+         const tinytac_capture_rec_t * rec );
+
+
+static size_t
+tinytac_capture_frame(
+         tinytac_capture_t *           cap,
+         const tinytac_capture_rec_t * rec,
+         uint8_t *                     buff );
+
+
+static void
+tinytac_capture_fork_child(
+         void );
+
+
+static void
+tinytac_capture_fork_parent(
+         void );
+
+
+static void
+tinytac_capture_fork_prepare(
+         void );
+
+
+static void
+tinytac_capture_header(
+         tinytac_capture_t *           cap );
+
+
+static void
+tinytac_capture_init(
+         void );
+
+
+static uint8_t *
+tinytac_capture_opt(
+         uint8_t *                     ptr,
+         uint16_t                      code,
+         const void *                  val,
+         uint16_t                      len );
+
+
+static void
+tinytac_capture_reopen(
+         tinytac_capture_t *           cap,
+         int                           rotate );
+
+
+static void
+tinytac_capture_write(
+         tinytac_capture_t *           cap,
+         const void *                  buff,
+         size_t                        len );
+
+
+static void *
+tinytac_capture_writer(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+atomic_int                    tinytac_capture_active  = 0;
+char *                        tinytac_capture_path    = NULL;
+int                           tinytac_capture_plain   = TTAC_DFLT_CAPTURE_PLAIN;
+int                           tinytac_capture_size    = TTAC_DFLT_CAPTURE_SIZE;
+
+
+// The ring and writer are created when capturing is first started and are
+// kept until the process exits, so threads which are still copying a packet
+// when capturing is stopped never reference released memory.
+static tinytac_capture_t *    tinytac_capture_ring    = NULL;
+static pthread_mutex_t        tinytac_capture_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t         tinytac_capture_cond    = PTHREAD_COND_INITIALIZER;
+static pthread_once_t         tinytac_capture_once    = PTHREAD_ONCE_INIT;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// records packet in capture ring
+///
+/// The packet is copied with the addresses and ports of the connection.
+/// Packets are dropped instead of waiting for the writer thread.
+///
+/// @param[in]  s             socket packet was sent to or received from
+/// @param[in]  pckt          packet to record
+/// @param[in]  flags         direction and form of packet (TTAC_CAPTURE_*)
+void
+tinytac_capture(
+         int                           s,
+         const tinytac_pckt_t *        pckt,
+         unsigned                      flags )
+{
+   size_t                     pos;
+   intptr_t                   dif;
+   socklen_t                  sa_len;
+   struct sockaddr_storage    sa;
+   tinytac_capture_t *        cap;
+   tinytac_capture_rec_t *    rec;
+
+   if (!(atomic_load_explicit(&tinytac_capture_active, memory_order_relaxed)))
+      return;
+   if ( ((flags & TTAC_CAPTURE_PLAIN)) && (!(tinytac_capture_plain)) )
+      return;
+   cap = tinytac_capture_ring;
+
+   // claim slot
+   pos = atomic_load_explicit(&cap->tail, memory_order_relaxed);
+   while(1)
+   {
+      rec = &cap->recs[pos & (TTAC_CAPTURE_RING_LEN-1)];
+      dif = (intptr_t)atomic_load_explicit(&rec->seq, memory_order_acquire) - (intptr_t)pos;
+      if (dif == 0)
+      {
+         if ((atomic_compare_exchange_weak_explicit(&cap->tail, &pos, (pos + 1), memory_order_relaxed, memory_order_relaxed)))
+            break;
+      } else if (dif < 0)
+      {
+         atomic_fetch_add_explicit(&cap->dropped, 1, memory_order_relaxed);
+         return;
+      } else
+      {
+         pos = atomic_load_explicit(&cap->tail, memory_order_relaxed);
+      };
+   };
+
+   clock_gettime(CLOCK_REALTIME, &rec->ts);
+   rec->flags  = flags;
+   rec->len    = (uint32_t)(sizeof(tinytac_pckt_t) + ntohl(pckt->pckt_length));
+   rec->caplen = (rec->len < sizeof(rec->data)) ? rec->len : (uint32_t)sizeof(rec->data);
+   memcpy(rec->data, pckt, rec->caplen);
+
+   // mark de-obfuscated packets so the body is not decoded again by analyzers
+   if ((flags & TTAC_CAPTURE_PLAIN))
+      ((tinytac_pckt_t *)rec->data)->pckt_flags |= TAC_PLUS_UNENCRYPTED_FLAG;
+
+   // record addresses of connection, sockets which are not IP are
+   // recorded as a loopback connection to the TACACS+ port
+   rec->family = AF_INET;
+   rec->lport  = 0;
+   rec->rport  = htons(TTAC_DFLT_PORT);
+   memset(rec->laddr, 0, sizeof(rec->laddr));
+   memset(rec->raddr, 0, sizeof(rec->raddr));
+   rec->laddr[0] = 127; rec->laddr[3] = 1;
+   rec->raddr[0] = 127; rec->raddr[3] = 2;
+   sa_len = sizeof(sa);
+   if (getsockname(s, (struct sockaddr *)&sa, &sa_len) == 0)
+   {
+      tinytac_capture_addr(&sa, &rec->family, rec->laddr, &rec->lport);
+      sa_len = sizeof(sa);
+      if (getpeername(s, (struct sockaddr *)&sa, &sa_len) == 0)
+         tinytac_capture_addr(&sa, &rec->family, rec->raddr, &rec->rport);
+   };
+
+   atomic_store_explicit(&rec->seq, (pos + 1), memory_order_release);
+
+   // pairs with the fence of the writer after it announces that it sleeps
+   atomic_thread_fence(memory_order_seq_cst);
+   if ((atomic_load_explicit(&cap->sleeping, memory_order_relaxed)))
+   {
+      pthread_mutex_lock(&tinytac_capture_mutex);
+      pthread_cond_signal(&tinytac_capture_cond);
+      pthread_mutex_unlock(&tinytac_capture_mutex);
+   };
+
+   return;
+}
+
+
+/// copies address and port of IP socket
+///
+/// @param[in]  sa            address of socket
+/// @param[out] familyp       family of address
+/// @param[out] addr          buffer of 16 bytes to store address
+/// @param[out] portp         port in network byte order
+void
+tinytac_capture_addr(
+         const struct sockaddr_storage * sa,
+         int *                         familyp,
+         uint8_t *                     addr,
+         uint16_t *                    portp )
+{
+   const struct sockaddr_in *    sin;
+   const struct sockaddr_in6 *   sin6;
+
+   switch(sa->ss_family)
+   {
+      case AF_INET:
+      sin      = (const struct sockaddr_in *)sa;
+      *familyp = AF_INET;
+      *portp   = sin->sin_port;
+      memcpy(addr, &sin->sin_addr, 4);
+      return;
+
+      case AF_INET6:
+      sin6     = (const struct sockaddr_in6 *)sa;
+      *portp   = sin6->sin6_port;
+      if ((IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)))
+      {
+         *familyp = AF_INET;
+         memcpy(addr, &sin6->sin6_addr.s6_addr[12], 4);
+         return;
+      };
+      *familyp = AF_INET6;
+      memcpy(addr, &sin6->sin6_addr, 16);
+      return;
+
+      default:
+      return;
+   };
+}
+
+
+/// writes queued packets to capture file
+///
+/// The caller holds tinytac_capture_mutex.
+///
+/// @param[in]  cap           capture ring
+///
+/// @return    Returns number of packets written.
+size_t
+tinytac_capture_drain(
+         tinytac_capture_t *           cap )
+{
+   size_t                     len;
+   size_t                     total;
+   uint64_t                   dropped;
+   tinytac_capture_rec_t *    rec;
+   uint8_t                    buff[TTAC_CAPTURE_BLOCK_MAX];
+
+   for(total = 0; (1); total++)
+   {
+      rec = &cap->recs[cap->head & (TTAC_CAPTURE_RING_LEN-1)];
+      if (atomic_load_explicit(&rec->seq, memory_order_acquire) != (cap->head + 1))
+         break;
+      if ((cap->fs))
+      {
+         len = tinytac_capture_frame(cap, rec, buff);
+         if ( ((tinytac_capture_size)) && ((cap->bytes + len) > (size_t)tinytac_capture_size) && (cap->bytes > cap->start) )
+            tinytac_capture_reopen(cap, 1);
+         tinytac_capture_write(cap, buff, len);
+      };
+      atomic_store_explicit(&rec->seq, (cap->head + TTAC_CAPTURE_RING_LEN), memory_order_release);
+      cap->head++;
+      cap->written++;
+   };
+
+   if ((dropped = atomic_load_explicit(&cap->dropped, memory_order_relaxed)) != cap->reported)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %" PRIu64 " captured packets dropped", __func__, (dropped - cap->reported));
+      cap->reported = dropped;
+   };
+
+   if ( ((total)) && ((cap->fs)) )
+      fflush(cap->fs);
+
+   return(total);
+}
+
+
+/// writes queued packets before process exits
+void
+tinytac_capture_flush(
+         void )
+{
+   pthread_mutex_lock(&tinytac_capture_mutex);
+   if ((tinytac_capture_ring))
+      tinytac_capture_drain(tinytac_capture_ring);
+   pthread_mutex_unlock(&tinytac_capture_mutex);
+   return;
+}
+
+
+/// stops capturing in child process
+///
+/// The writer thread does not exist in the child after fork(), and the
+/// child must not write to the capture file of the parent.  The ring is
+/// released and capturing stays stopped until the child sets
+/// TTAC_OPT_CAPTURE, which starts a new ring and writer.  The forking
+/// thread holds tinytac_capture_mutex since tinytac_capture_fork_prepare().
+void
+tinytac_capture_fork_child(
+         void )
+{
+   atomic_store(&tinytac_capture_active, 0);
+   free(tinytac_capture_path);
+   tinytac_capture_path = NULL;
+   if ((tinytac_capture_ring))
+   {
+      if ((tinytac_capture_ring->fs))
+         fclose(tinytac_capture_ring->fs);
+      free(tinytac_capture_ring->path);
+      tinytac_mem_free(tinytac_capture_ring);
+      tinytac_capture_ring = NULL;
+   };
+   pthread_cond_init(&tinytac_capture_cond, NULL);
+
+   pthread_mutex_unlock(&tinytac_capture_mutex);
+
+   return;
+}
+
+
+/// releases writer after fork() in parent process
+void
+tinytac_capture_fork_parent(
+         void )
+{
+   pthread_mutex_unlock(&tinytac_capture_mutex);
+   return;
+}
+
+
+/// waits for writer before fork()
+///
+/// The mutex is held across fork() so the child does not inherit it locked
+/// by the writer thread, which does not exist in the child.  Buffered data
+/// is written first, so the child does not write it again when it closes
+/// its copy of the capture file.
+void
+tinytac_capture_fork_prepare(
+         void )
+{
+   pthread_mutex_lock(&tinytac_capture_mutex);
+   if ( ((tinytac_capture_ring)) && ((tinytac_capture_ring->fs)) )
+      fflush(tinytac_capture_ring->fs);
+   return;
+}
+
+
+/// returns TCP state of connection of packet
+///
+/// The least recently used flow is replaced when the table is full.
+///
+/// @param[in]  cap           capture ring
+/// @param[in]  rec           captured packet
+///
+/// @return    Returns flow of connection.
+tinytac_capture_flow_t *
+tinytac_capture_flow(
+         tinytac_capture_t *           cap,
+         const tinytac_capture_rec_t * rec )
+{
+   size_t                     pos;
+   unsigned                   plain;
+   tinytac_capture_flow_t *   flow;
+   tinytac_capture_flow_t *   lru;
+
+   plain = rec->flags & TTAC_CAPTURE_PLAIN;
+   lru   = &cap->flows[0];
+   for(pos = 0; (pos < TTAC_CAPTURE_FLOWS); pos++)
+   {
+      flow = &cap->flows[pos];
+      if ( (flow->family == rec->family) && (flow->plain == plain) &&
+           (flow->lport == rec->lport) && (flow->rport == rec->rport) &&
+           (!(memcmp(flow->laddr, rec->laddr, sizeof(flow->laddr)))) &&
+           (!(memcmp(flow->raddr, rec->raddr, sizeof(flow->raddr)))) )
+      {
+         flow->used = cap->written;
+         return(flow);
+      };
+      if (flow->used < lru->used)
+         lru = flow;
+   };
+
+   flow           = lru;
+   flow->used     = cap->written;
+   flow->family   = rec->family;
+   flow->plain    = plain;
+   flow->lport    = rec->lport;
+   flow->rport    = rec->rport;
+   flow->lseq     = 1;
+   flow->rseq     = 1;
+   memcpy(flow->laddr, rec->laddr, sizeof(flow->laddr));
+   memcpy(flow->raddr, rec->raddr, sizeof(flow->raddr));
+
+   return(flow);
+}
+
+
+/// formats captured packet as an enhanced packet block
+///
+/// The packet is framed as the payload of a TCP segment so that analyzers
+/// decode it as TACACS+.  De-obfuscated packets are recorded on a separate
+/// interface with separate sequence numbers.
+///
+/// @param[in]  cap           capture ring
+/// @param[in]  rec           captured packet
+/// @param[out] buff          buffer of TTAC_CAPTURE_BLOCK_MAX bytes
+///
+/// @return    Returns length of block.
+size_t
+tinytac_capture_frame(
+         tinytac_capture_t *           cap,
+         const tinytac_capture_rec_t * rec,
+         uint8_t *                     buff )
+{
+   size_t                     hdr;
+   size_t                     len;
+   uint32_t                   u32;
+   uint32_t                   sum;
+   uint64_t                   usec;
+   uint8_t *                  ip;
+   uint8_t *                  tcp;
+   uint8_t *                  ptr;
+   const uint8_t *            src;
+   const uint8_t *            dst;
+   uint16_t                   sport;
+   uint16_t                   dport;
+   uint32_t                   seq;
+   uint32_t                   ack;
+   tinytac_capture_flow_t *   flow;
+
+   flow = tinytac_capture_flow(cap, rec);
+   if ((rec->flags & TTAC_CAPTURE_SENT))
+   {
+      src = rec->laddr;  sport = rec->lport;  seq = flow->lseq;
+      dst = rec->raddr;  dport = rec->rport;  ack = flow->rseq;
+      flow->lseq += rec->len;
+   } else
+   {
+      src = rec->raddr;  sport = rec->rport;  seq = flow->rseq;
+      dst = rec->laddr;  dport = rec->lport;  ack = flow->lseq;
+      flow->rseq += rec->len;
+   };
+
+   // IP header
+   ip  = &buff[28];
+   hdr = (rec->family == AF_INET6) ? 40 : 20;
+   memset(ip, 0, (hdr + 20));
+   if (rec->family == AF_INET6)
+   {
+      ip[0] = 0x60;
+      len   = 20 + rec->len;
+      ip[4] = (uint8_t)(len >> 8);
+      ip[5] = (uint8_t)len;
+      ip[6] = IPPROTO_TCP;
+      ip[7] = 64;
+      memcpy(&ip[8],  src, 16);
+      memcpy(&ip[24], dst, 16);
+   } else
+   {
+      ip[0] = 0x45;
+      len   = 40 + rec->len;
+      len   = (len < 0xffff) ? len : 0xffff;
+      ip[2] = (uint8_t)(len >> 8);
+      ip[3] = (uint8_t)len;
+      ip[6] = 0x40;                       // do not fragment
+      ip[8] = 64;
+      ip[9] = IPPROTO_TCP;
+      memcpy(&ip[12], src, 4);
+      memcpy(&ip[16], dst, 4);
+      for(sum = 0, len = 0; (len < 20); len += 2)
+         sum += (uint32_t)((ip[len] << 8) | ip[len+1]);
+      sum   = (sum & 0xffff) + (sum >> 16);
+      sum   = (sum & 0xffff) + (sum >> 16);
+      ip[10] = (uint8_t)(~sum >> 8);
+      ip[11] = (uint8_t)~sum;
+   };
+
+   // TCP header, checksum is not calculated
+   tcp = &ip[hdr];
+   memcpy(&tcp[0], &sport, 2);
+   memcpy(&tcp[2], &dport, 2);
+   u32 = htonl(seq);  memcpy(&tcp[4], &u32, 4);
+   u32 = htonl(ack);  memcpy(&tcp[8], &u32, 4);
+   tcp[12] = 0x50;                        // header length of 5 words
+   tcp[13] = 0x18;                        // PSH, ACK
+   tcp[14] = 0xff;
+   tcp[15] = 0xff;
+   memcpy(&tcp[20], rec->data, rec->caplen);
+
+   // enhanced packet block
+   len  = hdr + 20 + rec->caplen;
+   usec = ((uint64_t)rec->ts.tv_sec * 1000000) + ((uint64_t)rec->ts.tv_nsec / 1000);
+   u32 = TTAC_PCAPNG_EPB;                                                           memcpy(&buff[0],  &u32, 4);
+   u32 = ((rec->flags & TTAC_CAPTURE_PLAIN)) ? TTAC_CAPTURE_IF_PLAIN : TTAC_CAPTURE_IF_WIRE; memcpy(&buff[8],  &u32, 4);
+   u32 = (uint32_t)(usec >> 32);                                                    memcpy(&buff[12], &u32, 4);
+   u32 = (uint32_t)usec;                                                            memcpy(&buff[16], &u32, 4);
+   u32 = (uint32_t)len;                                                             memcpy(&buff[20], &u32, 4);
+   u32 = (uint32_t)(hdr + 20 + rec->len);                                           memcpy(&buff[24], &u32, 4);
+   ptr = &buff[28 + len];
+   while (((ptr - buff) & 0x03))
+      *ptr++ = 0;
+   u32 = ((rec->flags & TTAC_CAPTURE_SENT)) ? TTAC_PCAPNG_OUTBOUND : TTAC_PCAPNG_INBOUND;
+   ptr = tinytac_capture_opt(ptr, TTAC_PCAPNG_OPT_EPB_FLAGS, &u32, 4);
+   ptr = tinytac_capture_opt(ptr, TTAC_PCAPNG_OPT_END, NULL, 0);
+   len = (size_t)(ptr - buff) + 4;
+   u32 = (uint32_t)len;
+   memcpy(&buff[4], &u32, 4);
+   memcpy(ptr, &u32, 4);
+
+   return(len);
+}
+
+
+/// writes section header and interface blocks to new capture file
+///
+/// @param[in]  cap           capture ring
+void
+tinytac_capture_header(
+         tinytac_capture_t *           cap )
+{
+   size_t         pos;
+   uint8_t        buff[128];
+   uint8_t *      ptr;
+   uint32_t       u32;
+   uint16_t       u16;
+   int64_t        i64;
+   const char *   names[] = { "tacacs", "tacacs-plain" };
+
+   // section header block
+   u32 = TTAC_PCAPNG_SHB;     memcpy(&buff[0],  &u32, 4);
+   u32 = 28;                  memcpy(&buff[4],  &u32, 4);
+   u32 = TTAC_PCAPNG_MAGIC;   memcpy(&buff[8],  &u32, 4);
+   u16 = 1;                   memcpy(&buff[12], &u16, 2);
+   u16 = 0;                   memcpy(&buff[14], &u16, 2);
+   i64 = -1;                  memcpy(&buff[16], &i64, 8);
+   u32 = 28;                  memcpy(&buff[24], &u32, 4);
+   tinytac_capture_write(cap, buff, 28);
+
+   // interface description blocks
+   for(pos = 0; (pos < (sizeof(names)/sizeof(names[0]))); pos++)
+   {
+      u32 = TTAC_PCAPNG_IDB;              memcpy(&buff[0],  &u32, 4);
+      u16 = TTAC_PCAPNG_LINKTYPE_RAW;     memcpy(&buff[8],  &u16, 2);
+      u16 = 0;                            memcpy(&buff[10], &u16, 2);
+      u32 = TTAC_CAPTURE_SNAPLEN + TTAC_CAPTURE_FRAME_HDR; memcpy(&buff[12], &u32, 4);
+      ptr = tinytac_capture_opt(&buff[16], TTAC_PCAPNG_OPT_IF_NAME, names[pos], (uint16_t)strlen(names[pos]));
+      ptr = tinytac_capture_opt(ptr, TTAC_PCAPNG_OPT_END, NULL, 0);
+      u32 = (uint32_t)(ptr - buff) + 4;
+      memcpy(&buff[4], &u32, 4);
+      memcpy(ptr, &u32, 4);
+      tinytac_capture_write(cap, buff, u32);
+   };
+
+   return;
+}
+
+
+/// registers exit and fork handlers of capture writer
+void
+tinytac_capture_init(
+         void )
+{
+   atexit(&tinytac_capture_flush);
+   pthread_atfork(&tinytac_capture_fork_prepare, &tinytac_capture_fork_parent, &tinytac_capture_fork_child);
+   return;
+}
+
+
+/// appends option to block
+///
+/// @param[in]  ptr           end of block
+/// @param[in]  code          option code
+/// @param[in]  val           option value
+/// @param[in]  len           length of option value
+///
+/// @return    Returns end of block after option.
+uint8_t *
+tinytac_capture_opt(
+         uint8_t *                     ptr,
+         uint16_t                      code,
+         const void *                  val,
+         uint16_t                      len )
+{
+   memcpy(&ptr[0], &code, 2);
+   memcpy(&ptr[2], &len,  2);
+   ptr += 4;
+   if ((len))
+      memcpy(ptr, val, len);
+   ptr += len;
+   while ((len & 0x03))
+   {
+      *ptr++ = 0;
+      len++;
+   };
+   return(ptr);
+}
+
+
+/// starts or stops recording packets to capture file
+///
+/// The capture file is opened by the writer thread.  Packets are written
+/// in pcapng format and the file is rotated when it would exceed
+/// TTAC_OPT_CAPTURE_SIZE bytes.
+///
+/// @param[in]  path          path of capture file or NULL to stop capturing
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_capture_open(
+         const char *                  path )
+{
+   char *                  str;
+   size_t                  pos;
+   pthread_t               thread;
+   pthread_attr_t          attr;
+   sigset_t                set;
+   sigset_t                oset;
+   int                     rc;
+
+   TinyTacDebugTrace();
+
+   str = NULL;
+   if ( ((path)) && ((str = tinytacb_strdup(path)) == NULL) )
+      return(TTAC_ENOMEM);
+
+   pthread_mutex_lock(&tinytac_capture_mutex);
+
+   // create ring and writer when capturing is first started
+   if ( ((path)) && (!(tinytac_capture_ring)) )
+   {
+      if ((tinytac_capture_ring = tinytac_mem_calloc(1, sizeof(tinytac_capture_t))) == NULL)
+      {
+         pthread_mutex_unlock(&tinytac_capture_mutex);
+         free(str);
+         return(TTAC_ENOMEM);
+      };
+      for(pos = 0; (pos < TTAC_CAPTURE_RING_LEN); pos++)
+         atomic_init(&tinytac_capture_ring->recs[pos].seq, pos);
+
+      // writer does not handle signals of the application
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      sigfillset(&set);
+      pthread_sigmask(SIG_SETMASK, &set, &oset);
+      rc = pthread_create(&thread, &attr, &tinytac_capture_writer, tinytac_capture_ring);
+      pthread_sigmask(SIG_SETMASK, &oset, NULL);
+      pthread_attr_destroy(&attr);
+      if ((rc))
+      {
+         tinytac_mem_free(tinytac_capture_ring);
+         tinytac_capture_ring = NULL;
+         pthread_mutex_unlock(&tinytac_capture_mutex);
+         free(str);
+         return(TTAC_EUNKNOWN);
+      };
+      pthread_once(&tinytac_capture_once, &tinytac_capture_init);
+   };
+
+   free(tinytac_capture_path);
+   tinytac_capture_path = str;
+   if ((tinytac_capture_ring))
+   {
+      tinytac_capture_ring->want++;
+      pthread_cond_signal(&tinytac_capture_cond);
+   };
+   atomic_store(&tinytac_capture_active, (((path)) ? 1 : 0));
+
+   pthread_mutex_unlock(&tinytac_capture_mutex);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// records packets of vector in capture ring
+///
+/// @param[in]  s             socket packets were sent to or received from
+/// @param[in]  iov           packets to record, one packet per element
+/// @param[in]  cnt           number of packets
+/// @param[in]  flags         direction and form of packets (TTAC_CAPTURE_*)
+void
+tinytac_capture_iov(
+         int                           s,
+         const struct iovec *          iov,
+         size_t                        cnt,
+         unsigned                      flags )
+{
+   size_t pos;
+   if (!(atomic_load_explicit(&tinytac_capture_active, memory_order_relaxed)))
+      return;
+   for(pos = 0; (pos < cnt); pos++)
+      tinytac_capture(s, iov[pos].iov_base, flags);
+   return;
+}
+
+
+/// closes capture file and opens requested capture file
+///
+/// When rotating, the current file is renamed with the suffix ".1" and
+/// older files are shifted up to TTAC_CAPTURE_KEEP files.  The caller holds
+/// tinytac_capture_mutex.
+///
+/// @param[in]  cap           capture ring
+/// @param[in]  rotate        rotate current file instead of opening new path
+void
+tinytac_capture_reopen(
+         tinytac_capture_t *           cap,
+         int                           rotate )
+{
+   int            fd;
+   int            pos;
+   size_t         len;
+   char *         src;
+   char *         dst;
+
+   if ((cap->fs))
+   {
+      fclose(cap->fs);
+      cap->fs = NULL;
+   };
+
+   if ( ((rotate)) && ((cap->path)) )
+   {
+      len = strlen(cap->path) + 16;
+      src = tinytac_mem_alloc(len);
+      dst = tinytac_mem_alloc(len);
+      if ( ((src)) && ((dst)) )
+      {
+         for(pos = TTAC_CAPTURE_KEEP; (pos > 1); pos--)
+         {
+            snprintf(src, len, "%s.%i", cap->path, (pos - 1));
+            snprintf(dst, len, "%s.%i", cap->path, pos);
+            rename(src, dst);
+         };
+         snprintf(dst, len, "%s.1", cap->path);
+         rename(cap->path, dst);
+      };
+      tinytac_mem_free(src);
+      tinytac_mem_free(dst);
+   };
+
+   if (!(rotate))
+   {
+      free(cap->path);
+      cap->path   = ((tinytac_capture_path)) ? tinytacb_strdup(tinytac_capture_path) : NULL;
+      cap->gen    = cap->want;
+      memset(cap->flows, 0, sizeof(cap->flows));
+   };
+
+   // captures may hold cleartext passwords, so the file is readable only
+   // by its owner and a symbolic link is not followed
+   cap->bytes = 0;
+   if (!(cap->path))
+      return;
+   if ((fd = open(cap->path, (O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC), 0600)) == -1)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to open capture file %s", __func__, cap->path);
+      return;
+   };
+   if ((cap->fs = fdopen(fd, "w")) == NULL)
+   {
+      close(fd);
+      return;
+   };
+   tinytac_capture_header(cap);
+   cap->start = cap->bytes;
+
+   return;
+}
+
+
+/// writes block to capture file
+///
+/// @param[in]  cap           capture ring
+/// @param[in]  buff          block to write
+/// @param[in]  len           length of block
+void
+tinytac_capture_write(
+         tinytac_capture_t *           cap,
+         const void *                  buff,
+         size_t                        len )
+{
+   if (!(cap->fs))
+      return;
+   if (fwrite(buff, len, 1, cap->fs) == 1)
+      cap->bytes += len;
+   return;
+}
+
+
+/// writes captured packets to capture file
+///
+/// @param[in]  arg           capture ring
+///
+/// @return    Does not return.
+void *
+tinytac_capture_writer(
+         void *                        arg )
+{
+   tinytac_capture_t *     cap;
+   tinytac_capture_rec_t * rec;
+   struct timespec         ts;
+
+   cap = arg;
+
+   pthread_mutex_lock(&tinytac_capture_mutex);
+   while(1)
+   {
+      if (cap->gen != cap->want)
+         tinytac_capture_reopen(cap, 0);
+      if (tinytac_capture_drain(cap) != 0)
+         continue;
+
+      // announce sleep, then check for packets recorded before threads
+      // could observe the announcement
+      atomic_store(&cap->sleeping, 1);
+      atomic_thread_fence(memory_order_seq_cst);
+      rec = &cap->recs[cap->head & (TTAC_CAPTURE_RING_LEN-1)];
+      if (atomic_load_explicit(&rec->seq, memory_order_acquire) != (cap->head + 1))
+      {
+         clock_gettime(CLOCK_REALTIME, &ts);
+         ts.tv_sec++;
+         pthread_cond_timedwait(&tinytac_capture_cond, &tinytac_capture_mutex, &ts);
+      };
+      atomic_store(&cap->sleeping, 0);
+   };
+   pthread_mutex_unlock(&tinytac_capture_mutex);
+
+   return(NULL);
+}
+
+/* end of source */
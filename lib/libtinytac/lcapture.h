@@ -0,0 +1,106 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LCAPTURE_H
+#define _LIB_LIBTINYTAC_LCAPTURE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+#include <sys/uio.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_CAPTURE_RING_LEN       512   // packets queued for writer, power of two
+#define TTAC_CAPTURE_SNAPLEN        2048  // bytes of packet recorded, longer packets are truncated
+#define TTAC_CAPTURE_FLOWS          64    // connections tracked for TCP sequence numbers
+#define TTAC_CAPTURE_KEEP           4     // rotated capture files kept
+
+
+// direction and form of captured packet
+#define TTAC_CAPTURE_SENT           0x01
+#define TTAC_CAPTURE_RECV           0x02
+#define TTAC_CAPTURE_PLAIN          0x04  // packet is not obfuscated
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+extern atomic_int    tinytac_capture_active;
+extern char *        tinytac_capture_path;
+extern int           tinytac_capture_plain;
+extern int           tinytac_capture_size;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+void
+tinytac_capture(
+         int                           s,
+         const tinytac_pckt_t *        pckt,
+         unsigned                      flags );
+
+
+void
+tinytac_capture_iov(
+         int                           s,
+         const struct iovec *          iov,
+         size_t                        cnt,
+         unsigned                      flags );
+
+
+int
+tinytac_capture_open(
+         const char *                  path );
+
+
+#endif /* end of header */
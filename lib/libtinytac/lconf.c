@@ -50,6 +50,8 @@
 #include <assert.h>
 
 #include "lmemory.h"
+#include "lproto.h"
+#include "lsnapshot.h"
 
 
 ///////////////////
@@ -87,6 +89,16 @@ typedef struct _tinytac_opt
 } tinytac_opt_t;
 
 
+// servers and keys collected while configuration is re-read
+typedef struct _tinytac_conf_rld
+{
+   int                     rc;         // TTAC_ENOMEM if a value could not be stored
+   char *                  hosts;
+   char **                 keys;
+   char **                 paths;      // configuration files consulted
+} tinytac_conf_rld_t;
+
+
 /////////////////
 //             //
 //  Variables  //
@@ -98,14 +110,42 @@ typedef struct _tinytac_opt
 static atomic_int tinytac_conf_init;
 
 
+#pragma mark tinytac_conf_rld
+static tinytac_conf_rld_t * tinytac_conf_rld;
+
+
+#pragma mark tinytac_conf_snap
+static tinytac_snapshot_t * tinytac_conf_snap;
+
+
+// set while files and variables of the invoking user are processed by
+// set-user-ID and set-group-ID processes
+#pragma mark tinytac_conf_untrusted
+static int tinytac_conf_untrusted;
+
+
 #pragma mark tinytac_conf_options[]
 static tinytac_opt_t tinytac_conf_options[] =
 {
+   { .opt_name = "ACCT_POLICY",        .opt_id = TTAC_OPT_ACCT_POLICY,     .opt_type = TTAC_OTYPE_OTHER },
+   { .opt_name = "ACCT_QUEUE",         .opt_id = TTAC_OPT_ACCT_QUEUE,      .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "ACCT_REPLAY_RATE",   .opt_id = TTAC_OPT_ACCT_REPLAY_RATE, .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "ACCT_SPOOL",         .opt_id = TTAC_OPT_ACCT_SPOOL,      .opt_type = TTAC_OTYPE_STR },
+   { .opt_name = "ACCT_SPOOL_SIZE",    .opt_id = TTAC_OPT_ACCT_SPOOL_SIZE, .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "ACCT_WATCHDOG",      .opt_id = TTAC_OPT_ACCT_WATCHDOG,   .opt_type = TTAC_OTYPE_INT },
    { .opt_name = "AUTHEN_ASCII",       .opt_id = TTAC_OPT_AUTHEN_ASCII,    .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "AUTHEN_CHAP",        .opt_id = TTAC_OPT_AUTHEN_CHAP,     .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "AUTHEN_MSCHAP",      .opt_id = TTAC_OPT_AUTHEN_MSCHAP,   .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "AUTHEN_MSCHAPV2",    .opt_id = TTAC_OPT_AUTHEN_MSCHAPV2, .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "AUTHEN_PAP",         .opt_id = TTAC_OPT_AUTHEN_PAP,      .opt_type = TTAC_OTYPE_FLAG },
+   { .opt_name = "CACHE_NEG_TTL",      .opt_id = TTAC_OPT_CACHE_NEG_TTL,   .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "CACHE_SIZE",         .opt_id = TTAC_OPT_CACHE_SIZE,      .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "CACHE_TTL",          .opt_id = TTAC_OPT_CACHE_TTL,       .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "CAPTURE",            .opt_id = TTAC_OPT_CAPTURE,         .opt_type = TTAC_OTYPE_STR },
+   { .opt_name = "CAPTURE_PLAIN",      .opt_id = TTAC_OPT_CAPTURE_PLAIN,   .opt_type = TTAC_OTYPE_FLAG },
+   { .opt_name = "CAPTURE_SIZE",       .opt_id = TTAC_OPT_CAPTURE_SIZE,    .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "COALESCE",           .opt_id = TTAC_OPT_COALESCE,        .opt_type = TTAC_OTYPE_FLAG },
+   { .opt_name = "CONF_WATCH",         .opt_id = TTAC_OPT_CONF_WATCH,      .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "DEBUG_LEVEL",        .opt_id = TTAC_OPT_DEBUG_LEVEL,     .opt_type = TTAC_OTYPE_UINT },
    { .opt_name = "DEBUG_SYSLOG",       .opt_id = TTAC_OPT_DEBUG_SYSLOG,    .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "HOST",               .opt_id = TTAC_OPT_HOSTS,           .opt_type = TTAC_OTYPE_STR },
@@ -113,7 +153,13 @@ static tinytac_opt_t tinytac_conf_options[] =
    { .opt_name = "IPV6",               .opt_id = TTAC_OPT_IPV6,            .opt_type = TTAC_OTYPE_FLAG },
    { .opt_name = "KEY",                .opt_id = TTAC_OPT_KEY,             .opt_type = TTAC_OTYPE_STR },
    { .opt_name = "NETWORK_TIMEOUT",    .opt_id = TTAC_OPT_NETWORK_TIMEOUT, .opt_type = TTAC_OTYPE_TV },
+   { .opt_name = "OFFLINE_DIR",        .opt_id = TTAC_OPT_OFFLINE_DIR,     .opt_type = TTAC_OTYPE_STR },
+   { .opt_name = "OFFLINE_LOCKOUT",    .opt_id = TTAC_OPT_OFFLINE_LOCKOUT, .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "OFFLINE_MAX_AGE",    .opt_id = TTAC_OPT_OFFLINE_MAX_AGE, .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "PROXY",              .opt_id = TTAC_OPT_PROXY,           .opt_type = TTAC_OTYPE_STR },
    { .opt_name = "RANDOM",             .opt_id = TTAC_OPT_RANDOM,          .opt_type = TTAC_OTYPE_OTHER },
+   { .opt_name = "SERVER_RETRY",       .opt_id = TTAC_OPT_SERVER_RETRY,    .opt_type = TTAC_OTYPE_INT },
+   { .opt_name = "SHM_CACHE",          .opt_id = TTAC_OPT_SHM_CACHE,       .opt_type = TTAC_OTYPE_STR },
    { .opt_name = "STOPINIT",           .opt_id = TTAC_OPT_STOPINIT,        .opt_type = TTAC_OTYPE_NONE },
    { .opt_name = "TIMEOUT",            .opt_id = TTAC_OPT_TIMEOUT,         .opt_type = TTAC_OTYPE_INT },
    { .opt_name = NULL,                 .opt_id = 0,                        .opt_type = 0 }
@@ -137,6 +183,11 @@ tinytac_conf_file(
          const char *                  path );
 
 
+static int
+tinytac_conf_load(
+         void );
+
+
 static int
 tinytac_conf_opt(
          const tinytac_opt_t *         opt,
@@ -155,6 +206,12 @@ tinytac_conf_opt_int(
          const char *                  value );
 
 
+static int
+tinytac_conf_opt_reload(
+         const tinytac_opt_t *         opt,
+         const char *                  value );
+
+
 static int
 tinytac_conf_opt_timeval(
          const tinytac_opt_t *         opt,
@@ -168,6 +225,28 @@ tinytac_conf_print_line(
          const char *                  value );
 
 
+static int
+tinytac_conf_replay(
+         unsigned                      opt_id,
+         const char *                  value );
+
+
+static uint64_t
+tinytac_conf_schema(
+         void );
+
+
+static const char *
+tinytac_conf_snapshot_file(
+         char *                        buff,
+         size_t                        size );
+
+
+static tinytac_opt_t *
+tinytac_opt_lookup_id(
+         unsigned                      opt_id );
+
+
 static tinytac_opt_t *
 tinytac_opt_lookup_name(
          const char *                  name );
@@ -186,13 +265,8 @@ tinytac_conf(
          unsigned                      opts )
 {
    int               rc;
-   const char *      tintacrc;
-   const char *      tinytacconf;
-   char              buff[4096];
-   char              path[128];
-   const char *      home;
-   struct passwd     pwd;
-   struct passwd *   pwres;
+   const char *      file;
+   char              buff[512];
 
    TinyTacDebugTrace();
 
@@ -206,66 +280,22 @@ tinytac_conf(
    if ((getenv("TINYTAC_NOINIT")))
       return(TTAC_SUCCESS);
 
-   // system information
-   getpwuid_r(getuid(), &pwd, buff, sizeof(buff), &pwres);
-   home = (((pwres)) ? pwres->pw_dir : "/");
-
    // load defaults
    if ((rc = tinytac_defaults(NULL)) != TTAC_SUCCESS)
       return(rc);
 
-   // process "/usr/local/etc/tinytac.conf"
-   tinytac_conf_file(SYSCONFDIR "/tinytac.conf");
-
-   // process "~/tinytacrc"
-   tinytacb_strlcpy(path, home,           sizeof(path));
-   tinytacb_strlcat(path, "/tinytacrc",   sizeof(path));
-   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-      return(TTAC_SUCCESS);
-
-   // process "~/.tinytacrc"
-   tinytacb_strlcpy(path, home,           sizeof(path));
-   tinytacb_strlcat(path, "/.tinytacrc",  sizeof(path));
-   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-      return(TTAC_SUCCESS);
-
-   // process "./tinytacrc"
-   tinytacb_strlcpy(path, "./tinytacrc",  sizeof(path));
-   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-      return(TTAC_SUCCESS);
-
-   // process "${TINYTACCONF}"
-   if ((tinytacconf = getenv("TINYTACCONF")) != NULL)
-      if (tinytac_conf_file(tinytacconf) == TTAC_ESTOPINIT)
+   // apply snapshot of configuration if files and environment are unchanged
+   if ((file = tinytac_conf_snapshot_file(buff, sizeof(buff))) != NULL)
+      if (tinytac_snapshot_load(file, tinytac_conf_schema(), &tinytac_conf_replay) == TTAC_SUCCESS)
          return(TTAC_SUCCESS);
 
-   // determine TINYTACRC suffix
-   if ((tintacrc = getenv("TINYTACRC")) != NULL)
-   {
-      // process "~/${TINYTACRC}"
-      tinytacb_strlcpy(path, home,        sizeof(path));
-      tinytacb_strlcat(path, "/",         sizeof(path));
-      tinytacb_strlcat(path, tintacrc,    sizeof(path));
-      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-         return(TTAC_SUCCESS);
-
-      // process "~/.{$TINYTACRC}"
-      tinytacb_strlcpy(path, home,        sizeof(path));
-      tinytacb_strlcat(path, "/.",        sizeof(path));
-      tinytacb_strlcat(path, tintacrc,    sizeof(path));
-      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-         return(TTAC_SUCCESS);
-
-      // process "./${TINYTACRC}"
-      tinytacb_strlcpy(path, "./",        sizeof(path));
-      tinytacb_strlcat(path, tintacrc,    sizeof(path));
-      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
-         return(TTAC_SUCCESS);
-   };
-
-   // process environment variables
-   if (tinytac_conf_environment() == TTAC_ESTOPINIT)
-      return(TTAC_SUCCESS);
+   // process configuration files and environment while recording snapshot
+   tinytac_conf_snap = ((file)) ? tinytac_snapshot_alloc(tinytac_conf_schema()) : NULL;
+   if ((rc = tinytac_conf_load()) == TTAC_SUCCESS)
+      tinytac_snapshot_save(tinytac_conf_snap, file);
+   tinytac_snapshot_free(tinytac_conf_snap);
+   tinytac_conf_snap       = NULL;
+   tinytac_conf_untrusted  = 0;
 
    return(TTAC_SUCCESS);
 }
@@ -289,8 +319,11 @@ tinytac_conf_environment(
          continue;
       tinytacb_strlcpy(varname, "TINYTAC_", sizeof(varname));
       tinytacb_strlcat(varname, opt->opt_name, sizeof(varname));
-      if ((value = getenv(varname)) != NULL)
-         tinytac_conf_opt(opt, value);
+      if ((value = getenv(varname)) == NULL)
+         continue;
+      tinytac_snapshot_opt(tinytac_conf_snap, (unsigned)opt->opt_id, value);
+      if (tinytac_conf_opt(opt, value) == TTAC_ENOMEM)
+         tinytac_snapshot_taint(tinytac_conf_snap);
    };
 
    if (getenv("TINYTAC_STOPINIT") != NULL)
@@ -321,6 +354,10 @@ tinytac_conf_file(
 
    if (!(path))
       return(TTAC_SUCCESS);
+   tinytac_snapshot_path(tinytac_conf_snap, path);
+   if ((tinytac_conf_rld))
+      if (tinytacb_strsadd(&tinytac_conf_rld->paths, path) != 0)
+         tinytac_conf_rld->rc = TTAC_ENOMEM;
    if ((fd = open(path, O_RDONLY)) == -1)
       return(TTAC_SUCCESS);
 
@@ -349,10 +386,13 @@ tinytac_conf_file(
          continue;
       };
       val = tinytacb_strexpand(value, argv[1], sizeof(value), TTAC_NO);
+      if ( ((val)) && ((argv[1])) && ((strcmp(val, argv[1]))) )
+         tinytac_snapshot_taint(tinytac_conf_snap);
+      tinytac_snapshot_opt(tinytac_conf_snap, (unsigned)opt->opt_id, val);
       switch(tinytac_conf_opt(opt, val))
       {
          case TTAC_ESTOPINIT: rc = TTAC_ESTOPINIT; break;
-         case TTAC_ENOMEM:    rc = TTAC_ENOMEM;    break;
+         case TTAC_ENOMEM:    rc = TTAC_ENOMEM;    tinytac_snapshot_taint(tinytac_conf_snap); break;
          default:                                  break;
       };
       tinytacb_strsfree(argv);
@@ -364,6 +404,87 @@ tinytac_conf_file(
 }
 
 
+/// processes configuration files and environment variables
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_conf_load(
+         void )
+{
+   const char *      tintacrc;
+   const char *      tinytacconf;
+   char              buff[4096];
+   char              path[128];
+   const char *      home;
+   struct passwd     pwd;
+   struct passwd *   pwres;
+
+   TinyTacDebugTrace();
+
+   // system information
+   getpwuid_r(getuid(), &pwd, buff, sizeof(buff), &pwres);
+   home = (((pwres)) ? pwres->pw_dir : "/");
+
+   // process "/usr/local/etc/tinytac.conf"
+   tinytac_conf_file(SYSCONFDIR "/tinytac.conf");
+
+   // remaining files and variables are chosen by the invoking user
+   tinytac_conf_untrusted = ( (getuid() != geteuid()) || (getgid() != getegid()) );
+
+   // process "~/tinytacrc"
+   tinytacb_strlcpy(path, home,           sizeof(path));
+   tinytacb_strlcat(path, "/tinytacrc",   sizeof(path));
+   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+      return(TTAC_SUCCESS);
+
+   // process "~/.tinytacrc"
+   tinytacb_strlcpy(path, home,           sizeof(path));
+   tinytacb_strlcat(path, "/.tinytacrc",  sizeof(path));
+   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+      return(TTAC_SUCCESS);
+
+   // process "./tinytacrc"
+   tinytacb_strlcpy(path, "./tinytacrc",  sizeof(path));
+   if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+      return(TTAC_SUCCESS);
+
+   // process "${TINYTACCONF}"
+   if ((tinytacconf = getenv("TINYTACCONF")) != NULL)
+      if (tinytac_conf_file(tinytacconf) == TTAC_ESTOPINIT)
+         return(TTAC_SUCCESS);
+
+   // determine TINYTACRC suffix
+   if ((tintacrc = getenv("TINYTACRC")) != NULL)
+   {
+      // process "~/${TINYTACRC}"
+      tinytacb_strlcpy(path, home,        sizeof(path));
+      tinytacb_strlcat(path, "/",         sizeof(path));
+      tinytacb_strlcat(path, tintacrc,    sizeof(path));
+      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+         return(TTAC_SUCCESS);
+
+      // process "~/.{$TINYTACRC}"
+      tinytacb_strlcpy(path, home,        sizeof(path));
+      tinytacb_strlcat(path, "/.",        sizeof(path));
+      tinytacb_strlcat(path, tintacrc,    sizeof(path));
+      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+         return(TTAC_SUCCESS);
+
+      // process "./${TINYTACRC}"
+      tinytacb_strlcpy(path, "./",        sizeof(path));
+      tinytacb_strlcat(path, tintacrc,    sizeof(path));
+      if (tinytac_conf_file(path) == TTAC_ESTOPINIT)
+         return(TTAC_SUCCESS);
+   };
+
+   // process environment variables
+   if (tinytac_conf_environment() == TTAC_ESTOPINIT)
+      return(TTAC_SUCCESS);
+
+   return(TTAC_SUCCESS);
+}
+
+
 int
 tinytac_conf_opt(
          const tinytac_opt_t *         opt,
@@ -373,8 +494,58 @@ tinytac_conf_opt(
 
    TinyTacDebugTrace();
 
+   // re-read of configuration only collects servers and keys
+   if ((tinytac_conf_rld))
+      return(tinytac_conf_opt_reload(opt, value));
+
+   // the invoking user of a set-user-ID process may not choose files
+   // which the process creates or writes
+   if ((tinytac_conf_untrusted))
+   {
+      switch(opt->opt_id)
+      {
+         case TTAC_OPT_ACCT_SPOOL:
+         case TTAC_OPT_CAPTURE:
+         case TTAC_OPT_OFFLINE_DIR:
+         case TTAC_OPT_SHM_CACHE:
+         TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s(): ignoring %s of invoking user", __func__, opt->opt_name);
+         return(TTAC_SUCCESS);
+
+         default:
+         break;
+      };
+   };
+
    switch(opt->opt_id)
    {
+      case TTAC_OPT_ACCT_POLICY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_POLICY, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      if      (!(strcasecmp(value, "block")))   ival = TTAC_ACCT_BLOCK;
+      else if (!(strcasecmp(value, "drop")))    ival = TTAC_ACCT_DROP;
+      else if (!(strcasecmp(value, "spill")))   ival = TTAC_ACCT_SPILL;
+      else return(TTAC_SUCCESS);
+      return(tinytac_set_option(NULL, TTAC_OPT_ACCT_POLICY, &ival));
+
+      case TTAC_OPT_ACCT_QUEUE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_QUEUE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_ACCT_REPLAY_RATE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_REPLAY_RATE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_ACCT_SPOOL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_SPOOL, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_set_option(NULL, TTAC_OPT_ACCT_SPOOL, value));
+
+      case TTAC_OPT_ACCT_SPOOL_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_SPOOL_SIZE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_ACCT_WATCHDOG:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_ACCT_WATCHDOG, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
       case TTAC_OPT_AUTHEN_ASCII:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_AUTHEN_ASCII, \"%s\" )", __func__, (((value)) ? value : "(null)"));
       return(tinytac_conf_opt_flag(opt, value));
@@ -395,6 +566,38 @@ tinytac_conf_opt(
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_AUTHEN_PAP, \"%s\" )", __func__, (((value)) ? value : "(null)"));
       return(tinytac_conf_opt_flag(opt, value));
 
+      case TTAC_OPT_CACHE_NEG_TTL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CACHE_NEG_TTL, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_CACHE_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CACHE_SIZE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_CACHE_TTL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CACHE_TTL, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_CAPTURE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CAPTURE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_set_option(NULL, TTAC_OPT_CAPTURE, value));
+
+      case TTAC_OPT_CAPTURE_PLAIN:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CAPTURE_PLAIN, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_flag(opt, value));
+
+      case TTAC_OPT_CAPTURE_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CAPTURE_SIZE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_COALESCE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_COALESCE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_flag(opt, value));
+
+      case TTAC_OPT_CONF_WATCH:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_CONF_WATCH, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_flag(opt, value));
+
       case TTAC_OPT_DEBUG_LEVEL:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_DEBUG_LEVEL, \"%s\" )", __func__, (((value)) ? value : "(null)"));
       return(tinytac_conf_opt_int(opt, value));
@@ -417,7 +620,7 @@ tinytac_conf_opt(
 
       case TTAC_OPT_KEY:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_KEY, \"%s\" )", __func__, (((value)) ? value : "(null)"));
-      if ((tinytac_dflt.keys))
+      if ((atomic_load_explicit(&tinytac_dflt.servers, memory_order_relaxed)->keys))
          return(TTAC_SUCCESS);
       return(tinytac_set_option(NULL, TTAC_OPT_KEY, value));
 
@@ -429,6 +632,22 @@ tinytac_conf_opt(
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_NOINIT, \"%s\" )", __func__, (((value)) ? value : "(null)"));
       return(tinytac_conf_opt_flag(opt, value));
 
+      case TTAC_OPT_OFFLINE_DIR:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_OFFLINE_DIR, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_set_option(NULL, TTAC_OPT_OFFLINE_DIR, value));
+
+      case TTAC_OPT_OFFLINE_LOCKOUT:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_OFFLINE_LOCKOUT, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_OFFLINE_MAX_AGE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_OFFLINE_MAX_AGE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_PROXY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_PROXY, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_set_option(NULL, TTAC_OPT_PROXY, value));
+
       case TTAC_OPT_RANDOM:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( tr, TTAC_OPT_RANDOM, \"%s\" )", __func__, (((value)) ? value : "(null)"));
       if      (!(strcasecmp(value, "rand")))    ival = TTAC_RAND;
@@ -437,6 +656,14 @@ tinytac_conf_opt(
       else return(TTAC_SUCCESS);
       return(tinytac_set_option(NULL, TTAC_OPT_RANDOM, &ival));
 
+      case TTAC_OPT_SERVER_RETRY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_SERVER_RETRY, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_conf_opt_int(opt, value));
+
+      case TTAC_OPT_SHM_CACHE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( TTAC_OPT_SHM_CACHE, \"%s\" )", __func__, (((value)) ? value : "(null)"));
+      return(tinytac_set_option(NULL, TTAC_OPT_SHM_CACHE, value));
+
       case TTAC_OPT_STOPINIT:
       return(TTAC_ESTOPINIT);
 
@@ -491,6 +718,56 @@ tinytac_conf_opt_int(
 }
 
 
+/// collects servers and keys while configuration is re-read
+///
+/// @param[in]  opt           option to collect
+/// @param[in]  value         value of option or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_conf_opt_reload(
+         const tinytac_opt_t *         opt,
+         const char *                  value )
+{
+   char *            str;
+
+   TinyTacDebugTrace();
+
+   switch(opt->opt_id)
+   {
+      case TTAC_OPT_HOSTS:
+      TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): HOST \"%s\"", __func__, (((value)) ? value : "(null)"));
+      if ((str = tinytacb_strdup(((value)) ? value : TTAC_DFLT_HOSTS)) == NULL)
+      {
+         tinytac_conf_rld->rc = TTAC_ENOMEM;
+         return(TTAC_ENOMEM);
+      };
+      if ((tinytac_conf_rld->hosts))
+         free(tinytac_conf_rld->hosts);
+      tinytac_conf_rld->hosts = str;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_KEY:
+      if ( ((tinytac_conf_rld->keys)) || (!(value)) )
+         return(TTAC_SUCCESS);
+      if (tinytacb_strsadd(&tinytac_conf_rld->keys, value) != 0)
+      {
+         tinytac_conf_rld->rc = TTAC_ENOMEM;
+         return(TTAC_ENOMEM);
+      };
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_STOPINIT:
+      return(TTAC_ESTOPINIT);
+
+      default:
+      break;
+   };
+
+   return(TTAC_SUCCESS);
+}
+
+
 int
 tinytac_conf_opt_timeval(
          const tinytac_opt_t *         opt,
@@ -547,13 +824,23 @@ tinytac_conf_print(
          case TTAC_OTYPE_STR:
          if ((tinytac_get_option(tt, (int)opt->opt_id, &str)) == TTAC_SUCCESS)
          {
-            snprintf(buff, sizeof(buff), "'%s'", str);
+            snprintf(buff, sizeof(buff), "'%s'", (((str)) ? str : ""));
             tinytac_conf_print_line(0, opt->opt_name, buff);
             free(str);
          };
          break;
 
          case TTAC_OTYPE_OTHER:
+         if (opt->opt_id == TTAC_OPT_ACCT_POLICY)
+         {  if ((tinytac_get_option(tt, TTAC_OPT_ACCT_POLICY, &ival)) == TTAC_SUCCESS)
+            {  switch(ival)
+               {  case TTAC_ACCT_BLOCK: tinytac_conf_print_line(0, opt->opt_name, "block"); break;
+                  case TTAC_ACCT_DROP:  tinytac_conf_print_line(0, opt->opt_name, "drop"); break;
+                  case TTAC_ACCT_SPILL: tinytac_conf_print_line(0, opt->opt_name, "spill"); break;
+                  default:              tinytac_conf_print_line(1, opt->opt_name, "unknown option"); break;
+               };
+            };
+         };
          if (opt->opt_id == TTAC_OPT_RANDOM)
          {  if ((tinytac_get_option(tt, TTAC_OPT_RANDOM, &ival)) == TTAC_SUCCESS)
             {  switch(ival)
@@ -603,6 +890,156 @@ tinytac_conf_print_line(
 }
 
 
+/// re-reads servers and keys from configuration files and environment
+///
+/// Only the host and key options are collected, other options keep the
+/// values applied when the library was initialized.  Called by the thread
+/// which follows changes of the configuration files.
+///
+/// @param[out] hostsp        pointer to store configured servers
+/// @param[out] keysp         pointer to store configured keys or NULL
+/// @param[out] pathsp        pointer to store configuration files consulted
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EUNAVAIL if the library
+///            does not read configuration files, or an error code.
+int
+tinytac_conf_reload(
+         char **                       hostsp,
+         char ***                      keysp,
+         char ***                      pathsp )
+{
+   int                     rc;
+   tinytac_conf_rld_t      rld;
+
+   TinyTacDebugTrace();
+
+   assert(hostsp != NULL);
+   assert(keysp  != NULL);
+   assert(pathsp != NULL);
+
+   *hostsp = NULL;
+   *keysp  = NULL;
+   *pathsp = NULL;
+
+   if ((tinytac_dflt.opts & TTAC_NOINIT))
+      return(TTAC_EUNAVAIL);
+   if ( ((getenv("TINYTACNOINIT"))) || ((getenv("TINYTAC_NOINIT"))) )
+      return(TTAC_EUNAVAIL);
+
+   memset(&rld, 0, sizeof(rld));
+   tinytac_conf_rld = &rld;
+   rc               = tinytac_conf_load();
+   tinytac_conf_rld = NULL;
+
+   rc = (rc == TTAC_SUCCESS) ? rld.rc : rc;
+   if ( (rc == TTAC_SUCCESS) && (!(rld.hosts)) )
+      if ((rld.hosts = tinytacb_strdup(TTAC_DFLT_HOSTS)) == NULL)
+         rc = TTAC_ENOMEM;
+   if (rc != TTAC_SUCCESS)
+   {
+      if ((rld.hosts))
+         free(rld.hosts);
+      tinytacb_strsfree(rld.keys);
+      tinytacb_strsfree(rld.paths);
+      return(rc);
+   };
+
+   *hostsp = rld.hosts;
+   *keysp  = rld.keys;
+   *pathsp = rld.paths;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// applies option recorded in configuration snapshot
+///
+/// @param[in]  opt_id        option identifier
+/// @param[in]  value         value of option or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_conf_replay(
+         unsigned                      opt_id,
+         const char *                  value )
+{
+   const tinytac_opt_t *   opt;
+   if ((opt = tinytac_opt_lookup_id(opt_id)) == NULL)
+      return(TTAC_SUCCESS);
+   return(tinytac_conf_opt(opt, value));
+}
+
+
+/// hashes library version and option table
+///
+/// Snapshots written by a library with different options are not applied.
+///
+/// @return    Returns hash of library version and option table.
+uint64_t
+tinytac_conf_schema(
+         void )
+{
+   size_t      pos;
+   uint64_t    hash;
+   uint32_t    opt_id;
+
+   hash = tinytac_hash(TTAC_HASH_INIT, PACKAGE_VERSION, strlen(PACKAGE_VERSION));
+   for(pos = 0; ((tinytac_conf_options[pos].opt_name)); pos++)
+   {
+      opt_id = (uint32_t)tinytac_conf_options[pos].opt_id;
+      hash   = tinytac_hash(hash, tinytac_conf_options[pos].opt_name, strlen(tinytac_conf_options[pos].opt_name));
+      hash   = tinytac_hash(hash, &opt_id, sizeof(opt_id));
+   };
+
+   return(hash);
+}
+
+
+/// determines path of configuration snapshot
+///
+/// The snapshot is stored as "${TINYTACSNAPSHOT}" or, if unset, within
+/// "${XDG_RUNTIME_DIR}".  Setting TINYTACSNAPSHOT to an empty string
+/// disables snapshots.  Snapshots are not used by set-user-ID and
+/// set-group-ID processes.
+///
+/// @param[out] buff          buffer used to assemble path
+/// @param[in]  size          size of buffer
+///
+/// @return    Returns path of snapshot or NULL if snapshots are disabled.
+const char *
+tinytac_conf_snapshot_file(
+         char *                        buff,
+         size_t                        size )
+{
+   const char *   str;
+
+   if ( (getuid() != geteuid()) || (getgid() != getegid()) )
+      return(NULL);
+
+   if ((str = getenv("TINYTACSNAPSHOT")) != NULL)
+      return( ((str[0])) ? str : NULL );
+
+   if ( ((str = getenv("XDG_RUNTIME_DIR")) == NULL) || (str[0] != '/') )
+      return(NULL);
+   if ((size_t)snprintf(buff, size, "%s/%s", str, TTAC_SNAPSHOT_NAME) >= size)
+      return(NULL);
+
+   return(buff);
+}
+
+
+tinytac_opt_t *
+tinytac_opt_lookup_id(
+         unsigned                      opt_id )
+{
+   size_t pos;
+   for(pos = 0; ((tinytac_conf_options[pos].opt_name)); pos++)
+      if (tinytac_conf_options[pos].opt_id == opt_id)
+         return(&tinytac_conf_options[pos]);
+   return(NULL);
+}
+
+
 tinytac_opt_t *
 tinytac_opt_lookup_name(
          const char *                  name )
@@ -54,4 +54,11 @@ tinytac_conf(
          unsigned                      opts );
 
 
+int
+tinytac_conf_reload(
+         char **                       hostsp,
+         char ***                      keysp,
+         char ***                      pathsp );
+
+
 #endif /* end of header */
@@ -42,13 +42,21 @@
 #undef NDEBUG
 
 #include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <strings.h>
 #include <unistd.h>
+#include <signal.h>
 #include <syslog.h>
 #include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/uio.h>
 #include <assert.h>
 
+#include "lmemory.h"
+
 
 ///////////////////
 //               //
@@ -88,6 +96,104 @@
 #endif
 
 
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytac_debug_line
+{
+   size_t                  len;
+   int                     syslog;     // line is sent to syslog instead of stdout
+   char                    text[TTAC_DEBUG_LINE_LEN];
+} tinytac_debug_line_t;
+
+
+// Each thread formats its messages into its own ring, which is emptied only
+// by the writer thread.  The thread advances the tail and the writer
+// advances the head, so neither side takes a lock and a slow terminal or
+// syslog daemon never stalls the thread logging the message.  Messages are
+// dropped and counted when the ring is full, and the writer reports the
+// number of dropped messages with the next lines of the ring.
+typedef struct _tinytac_debug_ring tinytac_debug_ring_t;
+struct _tinytac_debug_ring
+{
+   atomic_size_t           head;       // next line written by writer
+   atomic_size_t           tail;       // next line formatted by thread
+   _Atomic uint64_t        dropped;
+   uint64_t                reported;   // dropped lines reported by writer
+   atomic_int              orphaned;   // thread of ring has exited
+   tinytac_debug_ring_t *  next;
+   tinytac_debug_line_t    lines[TTAC_DEBUG_RING_LEN];
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static size_t
+tinytac_debug_drain(
+         void );
+
+
+static void
+tinytac_debug_flush(
+         void );
+
+
+static void
+tinytac_debug_fork_child(
+         void );
+
+
+static void
+tinytac_debug_fork_parent(
+         void );
+
+
+static void
+tinytac_debug_fork_prepare(
+         void );
+
+
+static void
+tinytac_debug_init(
+         void );
+
+
+static void
+tinytac_debug_orphan(
+         void *                        ptr );
+
+
+static tinytac_debug_ring_t *
+tinytac_debug_ring(
+         void );
+
+
+static void
+tinytac_debug_sync(
+         const char *                  fmt,
+         va_list                       args );
+
+
+static void
+tinytac_debug_write(
+         struct iovec *                iov,
+         int                           cnt );
+
+
+static void *
+tinytac_debug_writer(
+         void *                        arg );
+
+
 /////////////////
 //             //
 //  Variables  //
@@ -102,6 +208,17 @@ int            tinytac_debug_level     = TTAC_DFLT_DEBUG_LEVEL;
 int            tinytac_debug_syslog    = TTAC_DFLT_DEBUG_SYSLOG;
 
 
+// rings of all threads, new rings are pushed onto the head of the list
+static tinytac_debug_ring_t * _Atomic     tinytac_debug_rings;
+static _Thread_local tinytac_debug_ring_t * tinytac_debug_tring;
+static pthread_key_t                      tinytac_debug_key;
+static pthread_once_t                     tinytac_debug_once = PTHREAD_ONCE_INIT;
+static int                                tinytac_debug_started;
+static pthread_mutex_t                    tinytac_debug_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                     tinytac_debug_cond  = PTHREAD_COND_INITIALIZER;
+static atomic_int                         tinytac_debug_sleeping;
+
+
 /////////////////
 //             //
 //  Functions  //
@@ -115,25 +232,399 @@ tinytac_debug(
          const char *                  fmt,
          ... )
 {
-   va_list  args;
+   va_list                 args;
+   size_t                  head;
+   size_t                  tail;
+   size_t                  len;
+   int                     rc;
+   tinytac_debug_ring_t *  ring;
+   tinytac_debug_line_t *  line;
 
    if ( ((level & tinytac_debug_level) == 0) || (!(fmt)) )
       return;
 
-   if (!(tinytac_debug_syslog))
-      printf("%s: DEBUG: ", tinytac_debug_ident);
-
    va_start(args, fmt);
+
+   // write synchronously if the writer thread is not available
+   if ((ring = tinytac_debug_ring()) == NULL)
+   {
+      tinytac_debug_sync(fmt, args);
+      va_end(args);
+      return;
+   };
+
+   tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+   head = atomic_load_explicit(&ring->head, memory_order_acquire);
+   if ((tail - head) >= TTAC_DEBUG_RING_LEN)
+   {
+      atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+      va_end(args);
+      return;
+   };
+
+   // format message into ring, truncated lines keep their newline
+   line           = &ring->lines[tail & (TTAC_DEBUG_RING_LEN-1)];
+   line->syslog   = tinytac_debug_syslog;
+   len            = 0;
+   if (!(line->syslog))
+      if ((rc = snprintf(line->text, sizeof(line->text), "%s: DEBUG: ", tinytac_debug_ident)) > 0)
+         len = ((size_t)rc < sizeof(line->text)) ? (size_t)rc : (sizeof(line->text) - 1);
+   if ((rc = vsnprintf(&line->text[len], (sizeof(line->text) - len), fmt, args)) > 0)
+      len += ((size_t)rc < (sizeof(line->text) - len)) ? (size_t)rc : (sizeof(line->text) - len - 1);
+   va_end(args);
+   if (!(line->syslog))
+   {
+      len = (len < (sizeof(line->text) - 1)) ? len : (sizeof(line->text) - 2);
+      line->text[len++] = '\n';
+   };
+   line->len = len;
+
+   atomic_store(&ring->tail, (tail + 1));
+   if ((atomic_load(&tinytac_debug_sleeping)))
+   {
+      pthread_mutex_lock(&tinytac_debug_mutex);
+      pthread_cond_signal(&tinytac_debug_cond);
+      pthread_mutex_unlock(&tinytac_debug_mutex);
+   };
+
+   return;
+}
+
+
+/// writes queued lines of all threads
+///
+/// Rings of exited threads are released once they are empty.  The caller
+/// holds tinytac_debug_mutex.
+///
+/// @return    Returns number of lines written.
+size_t
+tinytac_debug_drain(
+         void )
+{
+   int                     cnt;
+   size_t                  head;
+   size_t                  tail;
+   size_t                  total;
+   uint64_t                dropped;
+   char                    msg[128];
+   struct iovec            iov[TTAC_DEBUG_IOV_MAX];
+   tinytac_debug_ring_t *  ring;
+   tinytac_debug_ring_t *  prev;
+   tinytac_debug_ring_t *  next;
+   tinytac_debug_line_t *  line;
+
+   total = 0;
+   prev  = NULL;
+   ring  = atomic_load_explicit(&tinytac_debug_rings, memory_order_acquire);
+
+   while((ring))
+   {
+      next = ring->next;
+
+      // report lines dropped since last report
+      if ((dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed)) != ring->reported)
+      {
+         if ((tinytac_debug_syslog))
+         {
+            syslog(LOG_DEBUG, "%" PRIu64 " debug messages dropped", (dropped - ring->reported));
+         } else
+         {
+            iov[0].iov_base   = msg;
+            iov[0].iov_len    = (size_t)snprintf(msg, sizeof(msg), "%s: DEBUG: %" PRIu64 " debug messages dropped\n", tinytac_debug_ident, (dropped - ring->reported));
+            iov[0].iov_len    = (iov[0].iov_len < sizeof(msg)) ? iov[0].iov_len : (sizeof(msg) - 1);
+            tinytac_debug_write(iov, 1);
+         };
+         ring->reported = dropped;
+         total++;
+      };
+
+      // write lines, a line is released to the thread after it was written
+      head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+      tail = atomic_load(&ring->tail);
+      while (head != tail)
+      {
+         for(cnt = 0; ( (head != tail) && (cnt < TTAC_DEBUG_IOV_MAX) ); head++, total++)
+         {
+            line = &ring->lines[head & (TTAC_DEBUG_RING_LEN-1)];
+            if ((line->syslog))
+            {
+               tinytac_debug_write(iov, cnt);
+               cnt = 0;
+               syslog(LOG_DEBUG, "%.*s", (int)line->len, line->text);
+               continue;
+            };
+            iov[cnt].iov_base = line->text;
+            iov[cnt].iov_len  = line->len;
+            cnt++;
+         };
+         tinytac_debug_write(iov, cnt);
+         atomic_store_explicit(&ring->head, head, memory_order_release);
+      };
+
+      // rings are only pushed onto the head of the list, so any other
+      // ring can be unlinked without synchronizing with threads
+      if ( ((prev)) && ((atomic_load_explicit(&ring->orphaned, memory_order_acquire))) &&
+           (atomic_load(&ring->tail) == head) )
+      {
+         prev->next = next;
+         tinytac_mem_free(ring);
+         ring = next;
+         continue;
+      };
+
+      prev = ring;
+      ring = next;
+   };
+
+   return(total);
+}
+
+
+/// writes queued lines before process exits
+void
+tinytac_debug_flush(
+         void )
+{
+   pthread_mutex_lock(&tinytac_debug_mutex);
+   tinytac_debug_drain();
+   pthread_mutex_unlock(&tinytac_debug_mutex);
+   return;
+}
+
+
+/// discards rings and writes messages synchronously in child process
+///
+/// The writer thread does not exist in the child after fork().  The lines
+/// queued by the parent are released without being written, so the child
+/// does not repeat them.  The forking thread holds tinytac_debug_mutex
+/// since tinytac_debug_fork_prepare(), so no ring is being drained.
+void
+tinytac_debug_fork_child(
+         void )
+{
+   tinytac_debug_ring_t *  ring;
+   tinytac_debug_ring_t *  next;
+
+   for(ring = atomic_load(&tinytac_debug_rings); ((ring)); ring = next)
+   {
+      next = ring->next;
+      tinytac_mem_free(ring);
+   };
+   atomic_store(&tinytac_debug_rings, NULL);
+   atomic_store(&tinytac_debug_sleeping, 0);
+   pthread_setspecific(tinytac_debug_key, NULL);
+
+   tinytac_debug_started   = 0;
+   tinytac_debug_tring     = NULL;
+
+   pthread_mutex_unlock(&tinytac_debug_mutex);
+
+   return;
+}
+
+
+/// releases writer after fork() in parent process
+void
+tinytac_debug_fork_parent(
+         void )
+{
+   pthread_mutex_unlock(&tinytac_debug_mutex);
+   return;
+}
+
+
+/// waits for writer to finish draining before fork()
+///
+/// The mutex is held across fork() so the child does not inherit it locked
+/// by the writer thread, which does not exist in the child.
+void
+tinytac_debug_fork_prepare(
+         void )
+{
+   pthread_mutex_lock(&tinytac_debug_mutex);
+   return;
+}
+
+
+/// starts writer thread
+void
+tinytac_debug_init(
+         void )
+{
+   pthread_t               thread;
+   pthread_attr_t          attr;
+   sigset_t                set;
+   sigset_t                oset;
+   int                     rc;
+
+   if ((pthread_key_create(&tinytac_debug_key, &tinytac_debug_orphan)))
+      return;
+
+   // writer does not handle signals of the application
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   sigfillset(&set);
+   pthread_sigmask(SIG_SETMASK, &set, &oset);
+   rc = pthread_create(&thread, &attr, &tinytac_debug_writer, NULL);
+   pthread_sigmask(SIG_SETMASK, &oset, NULL);
+   pthread_attr_destroy(&attr);
+   if ((rc))
+      return;
+
+   atexit(&tinytac_debug_flush);
+   pthread_atfork(&tinytac_debug_fork_prepare, &tinytac_debug_fork_parent, &tinytac_debug_fork_child);
+   tinytac_debug_started = 1;
+
+   return;
+}
+
+
+/// marks ring of exiting thread for release by the writer
+///
+/// @param[in]  ptr           ring of thread
+void
+tinytac_debug_orphan(
+         void *                        ptr )
+{
+   tinytac_debug_ring_t * ring = ptr;
+   atomic_store_explicit(&ring->orphaned, 1, memory_order_release);
+   return;
+}
+
+
+/// returns ring of calling thread
+///
+/// @return    Returns ring of thread or NULL if messages are written
+///            synchronously.
+tinytac_debug_ring_t *
+tinytac_debug_ring(
+         void )
+{
+   tinytac_debug_ring_t *  ring;
+
+   if ((tinytac_debug_tring))
+      return(tinytac_debug_tring);
+
+   pthread_once(&tinytac_debug_once, &tinytac_debug_init);
+   if (!(tinytac_debug_started))
+      return(NULL);
+
+   if ((ring = tinytac_mem_calloc(1, sizeof(tinytac_debug_ring_t))) == NULL)
+      return(NULL);
+   pthread_setspecific(tinytac_debug_key, ring);
+
+   ring->next = atomic_load_explicit(&tinytac_debug_rings, memory_order_relaxed);
+   while(!(atomic_compare_exchange_weak_explicit(&tinytac_debug_rings, &ring->next, ring, memory_order_release, memory_order_relaxed)));
+
+   tinytac_debug_tring = ring;
+
+   return(ring);
+}
+
+
+/// writes message on calling thread
+///
+/// @param[in]  fmt           format of message
+/// @param[in]  args          arguments of format
+void
+tinytac_debug_sync(
+         const char *                  fmt,
+         va_list                       args )
+{
    if ((tinytac_debug_syslog))
+   {
       vsyslog(LOG_DEBUG, fmt, args);
-   else
-      vprintf(fmt, args);
-   va_end(args);
+      return;
+   };
+   flockfile(stdout);
+   printf("%s: DEBUG: ", tinytac_debug_ident);
+   vprintf(fmt, args);
+   printf("\n");
+   funlockfile(stdout);
+   return;
+}
+
+
+/// writes lines to standard output
+///
+/// Output buffered by stdio is flushed first and stdout is locked while the
+/// lines are written, so the lines do not interleave with the output of
+/// the application.
+///
+/// @param[in]  iov           lines to write
+/// @param[in]  cnt           number of lines
+void
+tinytac_debug_write(
+         struct iovec *                iov,
+         int                           cnt )
+{
+   ssize_t                 len;
+
+   if (cnt < 1)
+      return;
 
-   if (!(tinytac_debug_syslog))
-      printf("\n");
+   flockfile(stdout);
+   fflush(stdout);
+   while (cnt > 0)
+   {
+      if ((len = writev(STDOUT_FILENO, iov, cnt)) == -1)
+         break;
+      while ( (cnt > 0) && ((size_t)len >= iov[0].iov_len) )
+      {
+         len -= (ssize_t)iov[0].iov_len;
+         iov++;
+         cnt--;
+      };
+      if (cnt > 0)
+      {
+         iov[0].iov_base  = ((char *)iov[0].iov_base) + len;
+         iov[0].iov_len  -= (size_t)len;
+      };
+   };
+   funlockfile(stdout);
 
    return;
 }
 
+
+/// writes queued messages of all threads
+///
+/// @param[in]  arg           unused
+///
+/// @return    Does not return.
+void *
+tinytac_debug_writer(
+         void *                        arg )
+{
+   struct timespec         ts;
+   tinytac_debug_ring_t *  ring;
+   int                     pending;
+
+   (void)arg;
+
+   pthread_mutex_lock(&tinytac_debug_mutex);
+   while(1)
+   {
+      if (tinytac_debug_drain() != 0)
+         continue;
+
+      // check for lines queued while announcing sleep
+      atomic_store(&tinytac_debug_sleeping, 1);
+      pending = 0;
+      for(ring = atomic_load(&tinytac_debug_rings); ( ((ring)) && (!(pending)) ); ring = ring->next)
+         if (atomic_load(&ring->tail) != atomic_load_explicit(&ring->head, memory_order_relaxed))
+            pending = 1;
+      if (!(pending))
+      {
+         clock_gettime(CLOCK_REALTIME, &ts);
+         ts.tv_sec++;
+         pthread_cond_timedwait(&tinytac_debug_cond, &tinytac_debug_mutex, &ts);
+      };
+      atomic_store(&tinytac_debug_sleeping, 0);
+   };
+   pthread_mutex_unlock(&tinytac_debug_mutex);
+
+   return(NULL);
+}
+
 /* end of source */
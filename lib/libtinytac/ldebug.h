@@ -54,6 +54,10 @@
 ///////////////////
 #pragma mark - Definitions
 
+#define TTAC_DEBUG_RING_LEN         128   // lines queued per thread, power of two
+#define TTAC_DEBUG_LINE_LEN         512   // longer messages are truncated
+#define TTAC_DEBUG_IOV_MAX          64    // lines written with one system call
+
 
 /////////////////
 //             //
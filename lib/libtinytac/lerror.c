@@ -86,6 +86,9 @@ tinytac_error_map(
       case TTAC_EOPTION:      return("invalid or unknown option");
       case TTAC_EOPTVAL:      return("invalid option value");
       case TTAC_ESTOPINIT:    return("stop configuration initialization (used internally)");
+      case TTAC_ENETWORK:     return("network or socket error");
+      case TTAC_EBADMSG:      return("malformed or unexpected packet");
+      case TTAC_EUNAVAIL:     return("no TACACS+ server available");
       default:
       break;
    };
@@ -51,6 +51,7 @@
 #include <stdio.h>
 #include <sys/time.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 #include <tinytac.h>
 #include <bindle_prefix.h>
@@ -93,6 +94,21 @@
 #define TTAC_MAGIC                  ((const uint8_t *)"\0TnyTac\0")
 
 
+// TinyTacObj flags
+#define TTAC_OBJ_CONFINED           0x0001   // object is only referenced by a single thread
+
+
+// slab caches of TinyTacObj types
+#define TTAC_SLAB_NONE              0
+#define TTAC_SLAB_TINYTAC           1
+#define TTAC_SLAB_MAX               2
+
+
+// parts of a server set replaced by tinytac_servers_publish()
+#define TTAC_SERVERS_HOSTS          0x0001   // hosts, budps and circuit
+#define TTAC_SERVERS_KEYS           0x0002
+
+
 #define TTAC_LINE_MAX_LEN           256
 
 
@@ -109,23 +125,91 @@
 
 typedef struct _tinytac_obj
 {
-   uint8_t                 magic[8];
-   atomic_intptr_t         ref_count;
+   uint64_t                magic;      // TTAC_MAGIC compared as a single word
+   atomic_int_least32_t    ref_count;
+   uint16_t                slab;       // slab cache of object
+   uint16_t                flags;
    void (*free_func)(void * ptr);
 } TinyTacObj;
 
 
-struct _tinytac
+typedef struct _tinytac_acct   tinytac_acct_t;
+typedef struct _tinytac_cache  tinytac_cache_t;
+typedef struct _tinytac_flight tinytac_flight_t;
+typedef struct _tinytac_metrics tinytac_metrics_t;
+typedef struct _tinytac_servers tinytac_servers_t;
+typedef struct _tinytac_session tinytac_session_t;
+typedef struct _tinytac_shm    tinytac_shm_t;
+typedef struct _tinytac_spool  tinytac_spool_t;
+
+
+// Servers and keys of a handle are published as a set which is not
+// modified once requests can see it.  Requests hold a reference to the set
+// they use and a replaced set is freed with its last reference.  Parts
+// which were not replaced are shared with the previous set and are counted
+// separately, so a part is freed with the last set which uses it.
+typedef struct _tinytac_servers_part
 {
-   TinyTacObj              obj;
+   _Atomic unsigned        refs;       // sets using part
    char *                  hosts;
+   char **                 keys;
    BindleURLDesc **        budps;
+   struct addrinfo **      addrs;      // per server, resolved when published or NULL
+   tinytac_metrics_t *     metrics;    // per server
+   _Atomic uint64_t        circuit[];  // per server, monotonic time until which server is skipped
+} tinytac_servers_part_t;
+
+
+struct _tinytac_servers
+{
+   _Atomic unsigned        refs;       // handle and requests using set
+   tinytac_servers_part_t * hosts_part; // hosts, budps, addrs, circuit and metrics
+   tinytac_servers_part_t * keys_part;
+   char *                  hosts;
    char **                 keys;
+   BindleURLDesc **        budps;
+   struct addrinfo **      addrs;      // per server, resolved when published or NULL
+   _Atomic uint64_t *      circuit;    // per server, monotonic time until which server is skipped
+   tinytac_metrics_t *     metrics;    // per server
+};
+
+
+struct _tinytac
+{
+   TinyTacObj              obj;
+   pthread_mutex_t         servers_mutex;    // serializes publishing and referencing of servers
+   tinytac_servers_t * _Atomic servers;
+   unsigned                servers_pinned;   // parts set by application (TTAC_SERVERS_*)
    struct timeval          net_timeout;
    int                     padint;
    int                     timeout;
    unsigned                opts;
    unsigned                opts_neg;
+   int                     cache_size;
+   int                     cache_ttl;
+   int                     cache_neg_ttl;
+   pthread_mutex_t         cache_mutex;
+   tinytac_cache_t *       cache;
+   pthread_mutex_t         flights_mutex;
+   tinytac_flight_t *      flights;
+   pthread_mutex_t         sessions_mutex;
+   tinytac_session_t *     sessions;   // idle sessions
+   size_t                  sessions_cnt;
+   char *                  shm_cache;
+   tinytac_shm_t *         shm;
+   int                     server_retry;
+   char *                  offline_dir;
+   int                     offline_max_age;
+   int                     offline_lockout;
+   char *                  proxy;
+   int                     acct_queue;
+   int                     acct_policy;
+   char *                  acct_spool;
+   int                     acct_spool_size;
+   int                     acct_replay_rate;
+   int                     acct_watchdog;
+   tinytac_acct_t * _Atomic acct;
+   tinytac_metrics_t *     metrics;
 };
 
 
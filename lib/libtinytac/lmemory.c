@@ -54,6 +54,14 @@
 #include <errno.h>
 #include <assert.h>
 
+#include "lacct.h"
+#include "lcache.h"
+#include "lcapture.h"
+#include "lreload.h"
+#include "lsession.h"
+#include "lshm.h"
+#include "lspool.h"
+#include "lstats.h"
 #include "lconf.h"
 
 
@@ -66,6 +74,34 @@
 
 #define TTAC_SOCKET_BIND_ADDRESSES_LEN (INET6_ADDRSTRLEN+INET6_ADDRSTRLEN+2)
 
+#define TTAC_SLAB_MAG_SIZE          16    // objects cached by each thread per slab
+#define TTAC_SLAB_DEPOT_MAX         64    // objects shared by all threads per slab
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// freed objects of a type shared by all threads
+typedef struct _tinytac_slab
+{
+   size_t                  size;
+   pthread_mutex_t         mutex;
+   size_t                  depot_cnt;
+   void *                  depot[TTAC_SLAB_DEPOT_MAX];
+} tinytac_slab_t;
+
+
+// freed objects of a type cached by a thread without locking
+typedef struct _tinytac_slab_mag
+{
+   size_t                  cnt;
+   void *                  objs[TTAC_SLAB_MAG_SIZE];
+} tinytac_slab_mag_t;
+
 
 //////////////////
 //              //
@@ -114,11 +150,74 @@ tinytac_tinytac_free_budps(
 //-------------------//
 #pragma mark object prototypes
 
+static void
+tinytac_slab_flush(
+         void *                        ptr );
+
+
+static void
+tinytac_slab_once(
+         void );
+
+
+static void
+tinytac_slab_put(
+         tinytac_slab_t *              slab,
+         tinytac_slab_mag_t *          mag,
+         size_t                        cnt );
+
+
+static void
+tinytac_slab_register(
+         void );
+
+
 static int
 tinytac_verify_is_obj(
          TinyTacObj *                  obj );
 
 
+#ifndef NDEBUG
+static int
+tinytac_verify_obj(
+         TinyTacObj *                  obj );
+#endif
+
+
+//--------------------//
+// servers prototypes //
+//--------------------//
+#pragma mark servers prototypes
+
+static void
+tinytac_servers_free(
+         tinytac_servers_t *           servers );
+
+
+static int
+tinytac_servers_parse(
+         const char *                  hosts,
+         BindleURLDesc ***             budpsp,
+         size_t *                      lenp );
+
+
+static void
+tinytac_servers_part_release(
+         tinytac_servers_part_t *      part );
+
+
+static struct addrinfo **
+tinytac_servers_resolve(
+         BindleURLDesc **              budps,
+         size_t                        len );
+
+
+static void
+tinytac_servers_resolve_free(
+         struct addrinfo **            addrs,
+         size_t                        len );
+
+
 /////////////////
 //             //
 //  Variables  //
@@ -126,17 +225,61 @@ tinytac_verify_is_obj(
 /////////////////
 #pragma mark - Variables
 
-TinyTac tinytac_dflt =
+// servers of defaults are replaced in place and do not resolve hosts
+static tinytac_servers_t tinytac_dflt_servers =
 {
+   .refs                   = 1,
+   .hosts_part             = NULL,
+   .keys_part              = NULL,
    .hosts                  = NULL,
-   .budps                  = NULL,
    .keys                   = NULL,
+   .budps                  = NULL,
+   .circuit                = NULL,
+   .metrics                = NULL,
+};
+
+
+TinyTac tinytac_dflt =
+{
+   .servers_mutex          = PTHREAD_MUTEX_INITIALIZER,
+   .servers                = &tinytac_dflt_servers,
    .opts                   = TTAC_DFLT_OPTS,
    .opts_neg               = TTAC_DFLT_OPTS_NEG,
    .timeout                = TTAC_DFLT_TIMEOUT,
    .net_timeout.tv_sec     = TTAC_DFLT_NET_TIMEOUT_SEC,
    .net_timeout.tv_usec    = TTAC_DFLT_NET_TIMEOUT_USEC,
+   .cache_size             = TTAC_DFLT_CACHE_SIZE,
+   .cache_ttl              = TTAC_DFLT_CACHE_TTL,
+   .cache_neg_ttl          = TTAC_DFLT_CACHE_NEG_TTL,
+   .shm_cache              = TTAC_DFLT_SHM_CACHE,
+   .server_retry           = TTAC_DFLT_SERVER_RETRY,
+   .offline_dir            = TTAC_DFLT_OFFLINE_DIR,
+   .offline_max_age        = TTAC_DFLT_OFFLINE_MAX_AGE,
+   .offline_lockout        = TTAC_DFLT_OFFLINE_LOCKOUT,
+   .proxy                  = TTAC_DFLT_PROXY,
+   .acct_queue             = TTAC_DFLT_ACCT_QUEUE,
+   .acct_policy            = TTAC_DFLT_ACCT_POLICY,
+   .acct_spool             = TTAC_DFLT_ACCT_SPOOL,
+   .acct_spool_size        = TTAC_DFLT_ACCT_SPOOL_SIZE,
+   .acct_replay_rate       = TTAC_DFLT_ACCT_REPLAY_RATE,
+   .acct_watchdog          = TTAC_DFLT_ACCT_WATCHDOG,
+};
+
+
+// allocator of library memory, replaced by tinytac_set_allocator()
+static void * (*tinytac_malloc_func)(size_t size)              = &malloc;
+static void * (*tinytac_realloc_func)(void * ptr, size_t size) = &realloc;
+static void (*tinytac_free_func)(void * ptr)                   = &free;
+
+
+static tinytac_slab_t tinytac_slabs[TTAC_SLAB_MAX] =
+{
+   [TTAC_SLAB_TINYTAC]     = { .size = sizeof(TinyTac), .mutex = PTHREAD_MUTEX_INITIALIZER },
 };
+static _Thread_local tinytac_slab_mag_t   tinytac_slab_mags[TTAC_SLAB_MAX];
+static _Thread_local int                  tinytac_slab_mags_used;
+static pthread_key_t                      tinytac_slab_key;
+static pthread_once_t                     tinytac_slab_key_once = PTHREAD_ONCE_INIT;
 
 
 const char *            tinytac_dflt_hosts      = TTAC_DFLT_HOSTS;
@@ -160,17 +303,34 @@ tinytac_defaults(
 {
    int rc;
 
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_POLICY,      NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_QUEUE,       NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_REPLAY_RATE, NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_SPOOL,       NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_SPOOL_SIZE,  NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_ACCT_WATCHDOG,    NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_AUTHEN_ASCII,     NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_AUTHEN_PAP,       NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_AUTHEN_CHAP,      NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_AUTHEN_MSCHAP,    NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_AUTHEN_MSCHAPV2,  NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_CACHE_NEG_TTL,    NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_CACHE_SIZE,       NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_CACHE_TTL,        NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_COALESCE,         NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_CONF_WATCH,       NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_HOSTS,            NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_IPV4,             NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_IPV6,             NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_KEY,              NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_NETWORK_TIMEOUT,  NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_OFFLINE_DIR,      NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_OFFLINE_LOCKOUT,  NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_OFFLINE_MAX_AGE,  NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_PROXY,            NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_RANDOM,           NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_SERVER_RETRY,     NULL)) != TTAC_SUCCESS) return(rc);
+   if ((rc = tinytac_set_option(tt, TTAC_OPT_SHM_CACHE,        NULL)) != TTAC_SUCCESS) return(rc);
    if ((rc = tinytac_set_option(tt, TTAC_OPT_TIMEOUT,          NULL)) != TTAC_SUCCESS) return(rc);
 
    return(TTAC_SUCCESS);
@@ -183,11 +343,16 @@ tinytac_get_option(
          int                           option,
          void *                        outvalue )
 {
-   int            rc;
-   const char *   str;
-   unsigned       opts;
-   void *         ptr;
-   size_t         pos;
+   int                  rc;
+   const char *         str;
+   unsigned             opts;
+   void *               ptr;
+   size_t               pos;
+   size_t               idx;
+   size_t               len;
+   BindleURLDesc *      budp;
+   tinytac_servers_t *  servers;
+   tinytac_stats_t *    stats;
 
    TinyTacDebugTrace();
 
@@ -202,6 +367,52 @@ tinytac_get_option(
    // get global options
    switch(option)
    {
+      case TTAC_OPT_ACCT_POLICY:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_POLICY, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->acct_policy);
+      *((int *)outvalue) = tt->acct_policy;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_QUEUE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_QUEUE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->acct_queue);
+      *((int *)outvalue) = tt->acct_queue;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_REPLAY_RATE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_REPLAY_RATE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->acct_replay_rate);
+      *((int *)outvalue) = tt->acct_replay_rate;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_SPOOL:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      *((char **)outvalue) = NULL;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_SPOOL, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      if (!(tt->acct_spool))
+         return(TTAC_SUCCESS);
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->acct_spool);
+      if ((*((char **)outvalue) = tinytacb_strdup(tt->acct_spool)) == NULL)
+         return(TTAC_ENOMEM);
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_SPOOL_SIZE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_SPOOL_SIZE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->acct_spool_size);
+      *((int *)outvalue) = tt->acct_spool_size;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_WATCHDOG:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_WATCHDOG, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->acct_watchdog);
+      *((int *)outvalue) = tt->acct_watchdog;
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_AUTHEN_ALL:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_AUTHEN_ALL, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
       TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", ((opts & TTAC_AUTHEN_TYPES) == TTAC_AUTHEN_TYPES) ? "TTAC_YES" : "TTAC_NO");
@@ -238,6 +449,61 @@ tinytac_get_option(
       *((int *)outvalue) = ((opts & TTAC_PAP)) ? TTAC_YES : TTAC_NO;
       return(TTAC_SUCCESS);
 
+      case TTAC_OPT_CACHE_NEG_TTL:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_NEG_TTL, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->cache_neg_ttl);
+      *((int *)outvalue) = tt->cache_neg_ttl;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CACHE_SIZE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_SIZE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->cache_size);
+      *((int *)outvalue) = tt->cache_size;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CACHE_TTL:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_TTL, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->cache_ttl);
+      *((int *)outvalue) = tt->cache_ttl;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CAPTURE:
+      *((char **)outvalue) = NULL;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      if (!(tinytac_capture_path))
+         return(TTAC_SUCCESS);
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tinytac_capture_path);
+      if ((*((char **)outvalue) = tinytacb_strdup(tinytac_capture_path)) == NULL)
+         return(TTAC_ENOMEM);
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CAPTURE_PLAIN:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE_PLAIN, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", ((tinytac_capture_plain)) ? "TTAC_YES" : "TTAC_NO");
+      *((int *)outvalue) = ((tinytac_capture_plain)) ? TTAC_YES : TTAC_NO;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CAPTURE_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE_SIZE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tinytac_capture_size);
+      *((int *)outvalue) = tinytac_capture_size;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_COALESCE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_COALESCE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", ((opts & TTAC_COALESCE)) ? "TTAC_YES" : "TTAC_NO");
+      *((int *)outvalue) = ((opts & TTAC_COALESCE)) ? TTAC_YES : TTAC_NO;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CONF_WATCH:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CONF_WATCH, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", ((opts & TTAC_CONF_WATCH)) ? "TTAC_YES" : "TTAC_NO");
+      *((int *)outvalue) = ((opts & TTAC_CONF_WATCH)) ? TTAC_YES : TTAC_NO;
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_DEBUG_IDENT:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( tt, TTAC_OPT_DEBUG_IDENT, outvalue )", __func__);
       TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tinytac_debug_ident);
@@ -258,10 +524,13 @@ tinytac_get_option(
       return(TTAC_SUCCESS);
 
       case TTAC_OPT_HOSTS:
-      str = ((tt)) ? tt->hosts : tinytac_dflt_hosts;
+      servers = tinytac_servers_acquire(tt);
+      str     = ((servers)) ? servers->hosts : tinytac_dflt_hosts;
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_HOSTS, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
       TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", str);
-      if ((*((char **)outvalue) = tinytacb_strdup(str)) == NULL)
+      *((char **)outvalue) = tinytacb_strdup(str);
+      tinytac_servers_release(servers);
+      if (!(*((char **)outvalue)))
          return(TTAC_ENOMEM);
       return(TTAC_SUCCESS);
 
@@ -281,26 +550,34 @@ tinytac_get_option(
       tt = ((tt)) ? tt : &tinytac_dflt;
       *((char **)outvalue) = NULL;
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_KEY, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
-      if (!(tt->keys))
+      if ((servers = tinytac_servers_acquire(tt)) == NULL)
          return(TTAC_SUCCESS);
-      if (!(tt->keys[0]))
-         return(TTAC_SUCCESS);
-      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->keys[0]);
-      if ((*((char **)outvalue) = tinytacb_strdup(tt->keys[0])) == NULL)
-         return(TTAC_ENOMEM);
-      return(TTAC_SUCCESS);
+      rc = TTAC_SUCCESS;
+      if ( ((servers->keys)) && ((servers->keys[0])) )
+      {
+         TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", servers->keys[0]);
+         if ((*((char **)outvalue) = tinytacb_strdup(servers->keys[0])) == NULL)
+            rc = TTAC_ENOMEM;
+      };
+      tinytac_servers_release(servers);
+      return(rc);
 
       case TTAC_OPT_KEYS:
       tt = ((tt)) ? tt : &tinytac_dflt;
       *((char **)outvalue) = NULL;
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_KEY, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
-      if (!(tt->keys))
+      if ((servers = tinytac_servers_acquire(tt)) == NULL)
          return(TTAC_SUCCESS);
-      for(pos = 0; ((tt->keys[pos])); pos++)
-         TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->keys[pos]);
-      if ((tinytacb_strsdup((char ***)outvalue, tt->keys)))
-         return(TTAC_ENOMEM);
-      return(TTAC_SUCCESS);
+      rc = TTAC_SUCCESS;
+      if ((servers->keys))
+      {
+         for(pos = 0; ((servers->keys[pos])); pos++)
+            TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", servers->keys[pos]);
+         if ((tinytacb_strsdup((char ***)outvalue, servers->keys)))
+            rc = TTAC_ENOMEM;
+      };
+      tinytac_servers_release(servers);
+      return(rc);
 
       case TTAC_OPT_NETWORK_TIMEOUT:
       tt = ((tt)) ? tt : &tinytac_dflt;
@@ -312,6 +589,42 @@ tinytac_get_option(
       *((struct timeval **)outvalue) = ptr;
       return(TTAC_SUCCESS);
 
+      case TTAC_OPT_OFFLINE_DIR:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      *((char **)outvalue) = NULL;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_DIR, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      if (!(tt->offline_dir))
+         return(TTAC_SUCCESS);
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->offline_dir);
+      if ((*((char **)outvalue) = tinytacb_strdup(tt->offline_dir)) == NULL)
+         return(TTAC_ENOMEM);
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_OFFLINE_LOCKOUT:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_LOCKOUT, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->offline_lockout);
+      *((int *)outvalue) = tt->offline_lockout;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_OFFLINE_MAX_AGE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_MAX_AGE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->offline_max_age);
+      *((int *)outvalue) = tt->offline_max_age;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_PROXY:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      *((char **)outvalue) = NULL;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_PROXY, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      if (!(tt->proxy))
+         return(TTAC_SUCCESS);
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->proxy);
+      if ((*((char **)outvalue) = tinytacb_strdup(tt->proxy)) == NULL)
+         return(TTAC_ENOMEM);
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_RANDOM:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_RANDOM, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
       switch(opts & TTAC_RND_METHODS)
@@ -324,6 +637,59 @@ tinytac_get_option(
       *((int *)outvalue) = opts & TTAC_RND_METHODS;
       return(TTAC_SUCCESS);
 
+      case TTAC_OPT_SERVER_RETRY:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_SERVER_RETRY, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %i", tt->server_retry);
+      *((int *)outvalue) = tt->server_retry;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_SHM_CACHE:
+      tt = ((tt)) ? tt : &tinytac_dflt;
+      *((char **)outvalue) = NULL;
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_SHM_CACHE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      if (!(tt->shm_cache))
+         return(TTAC_SUCCESS);
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   <= outvalue: %s", tt->shm_cache);
+      if ((*((char **)outvalue) = tinytacb_strdup(tt->shm_cache)) == NULL)
+         return(TTAC_ENOMEM);
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_STATS:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_STATS, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      *((tinytac_stats_t **)outvalue) = NULL;
+      if ( (!(tt)) || (!(tt->metrics)) )
+         return(TTAC_EINVAL);
+      if ((stats = malloc(sizeof(tinytac_stats_t))) == NULL)
+         return(TTAC_ENOMEM);
+      stats->server[0] = '\0';
+      tinytac_metrics_read(tt->metrics, stats);
+      *((tinytac_stats_t **)outvalue) = stats;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_STATS_SERVERS:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_STATS_SERVERS, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      *((tinytac_stats_t **)outvalue) = NULL;
+      if (!(tt))
+         return(TTAC_EINVAL);
+      if ((servers = tinytac_servers_acquire(tt)) == NULL)
+         return(TTAC_EINVAL);
+      for(len = 0; ( ((servers->budps)) && ((servers->budps[len])) ); len++);
+      if ((stats = calloc(len+1, sizeof(tinytac_stats_t))) == NULL)
+      {
+         tinytac_servers_release(servers);
+         return(TTAC_ENOMEM);
+      };
+      for(idx = 0; ( ((servers->metrics)) && (idx < len) ); idx++)
+      {
+         budp = servers->budps[idx];
+         tinytac_metrics_name(budp, stats[idx].server, sizeof(stats[idx].server));
+         tinytac_metrics_read(&servers->metrics[idx], &stats[idx]);
+      };
+      tinytac_servers_release(servers);
+      *((tinytac_stats_t **)outvalue) = stats;
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_TIMEOUT:
       tt = ((tt)) ? tt : &tinytac_dflt;
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_TIMEOUT, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
@@ -331,6 +697,11 @@ tinytac_get_option(
       *((int *)outvalue) = tt->timeout;
       return(TTAC_SUCCESS);
 
+      case TTAC_OPT_TRACE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_TRACE, outvalue )", __func__, (((tt)) ? "tt" : "NULL"));
+      tinytac_trace_read((tinytac_trace_t *)outvalue);
+      return(TTAC_SUCCESS);
+
       default:
       break;
    };
@@ -356,8 +727,41 @@ tinytac_initialize(
    if ((rc = tinytac_conf(opts)) != TTAC_SUCCESS)
       return(rc);
 
-   if ((tt = tinytac_obj_alloc(sizeof(TinyTac), (void(*)(void*))&tinytac_tinytac_free)) == NULL)
+   if ((tt = tinytac_obj_alloc(sizeof(TinyTac), TTAC_SLAB_TINYTAC, 0, (void(*)(void*))&tinytac_tinytac_free)) == NULL)
+      return(TTAC_ENOMEM);
+   if ((pthread_mutex_init(&tt->flights_mutex, NULL)))
+   {
+      tinytac_obj_dealloc(tt);
+      return(TTAC_ENOMEM);
+   };
+   if ((pthread_mutex_init(&tt->cache_mutex, NULL)))
+   {
+      pthread_mutex_destroy(&tt->flights_mutex);
+      tinytac_obj_dealloc(tt);
+      return(TTAC_ENOMEM);
+   };
+   if ((pthread_mutex_init(&tt->sessions_mutex, NULL)))
+   {
+      pthread_mutex_destroy(&tt->cache_mutex);
+      pthread_mutex_destroy(&tt->flights_mutex);
+      tinytac_obj_dealloc(tt);
+      return(TTAC_ENOMEM);
+   };
+   if ((pthread_mutex_init(&tt->servers_mutex, NULL)))
+   {
+      pthread_mutex_destroy(&tt->sessions_mutex);
+      pthread_mutex_destroy(&tt->cache_mutex);
+      pthread_mutex_destroy(&tt->flights_mutex);
+      tinytac_obj_dealloc(tt);
+      return(TTAC_ENOMEM);
+   };
+
+   // counters and latency histograms of requests
+   if ((tt->metrics = tinytac_metrics_alloc(1)) == NULL)
+   {
+      tinytac_tinytac_free(tt);
       return(TTAC_ENOMEM);
+   };
 
    // apply default options
    if ((rc = tinytac_defaults(tt)) != TTAC_SUCCESS)
@@ -404,6 +808,16 @@ tinytac_initialize(
       return(rc);
    };
 
+   // follow configuration files if requested with flags of application
+   if ((tt->opts & TTAC_CONF_WATCH))
+   {
+      if ((rc = tinytac_reload_add(tt)) != TTAC_SUCCESS)
+      {
+         tinytac_tinytac_free(tt);
+         return(rc);
+      };
+   };
+
    *ttp = tinytac_obj_retain(&tt->obj);
 
    return(TTAC_SUCCESS);
@@ -420,8 +834,11 @@ tinytac_set_option(
    int               ival;
    int               idflt;
    const char *      istr;
+   char *            ostr;
+   size_t            len;
    struct timeval    tv;
    const void *      ptr;
+   tinytac_servers_t * servers;
 
    TinyTacDebugTrace();
 
@@ -431,6 +848,73 @@ tinytac_set_option(
 
    switch(option)
    {
+      case TTAC_OPT_ACCT_POLICY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_POLICY, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.acct_policy : TTAC_DFLT_ACCT_POLICY;
+      ival  = ((invalue)) ? *((const int *)invalue)  : idflt;
+      switch(ival)
+      {  case TTAC_ACCT_BLOCK: TinyTacDebug(TTAC_DEBUG_ARGS, "   <= invalue: %s", "TTAC_ACCT_BLOCK"); break;
+         case TTAC_ACCT_DROP:  TinyTacDebug(TTAC_DEBUG_ARGS, "   <= invalue: %s", "TTAC_ACCT_DROP");  break;
+         case TTAC_ACCT_SPILL: TinyTacDebug(TTAC_DEBUG_ARGS, "   <= invalue: %s", "TTAC_ACCT_SPILL"); break;
+         default:              TinyTacDebug(TTAC_DEBUG_ARGS, "   <= invalue: %i", ival); return(TTAC_EOPTVAL);
+      };
+      tt    = ((tt))      ? tt                       : &tinytac_dflt;
+      tt->acct_policy = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_QUEUE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_QUEUE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.acct_queue : TTAC_DFLT_ACCT_QUEUE;
+      ival  = ((invalue)) ? *((const int *)invalue) : idflt;
+      if (ival < 1)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                      : &tinytac_dflt;
+      tt->acct_queue = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_REPLAY_RATE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_REPLAY_RATE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.acct_replay_rate : TTAC_DFLT_ACCT_REPLAY_RATE;
+      ival  = ((invalue)) ? *((const int *)invalue)       : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                            : &tinytac_dflt;
+      tt->acct_replay_rate = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_SPOOL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_SPOOL, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      istr  = ((tt))      ? tinytac_dflt.acct_spool : TTAC_DFLT_ACCT_SPOOL;
+      istr  = ((invalue)) ? (const char *)invalue   : istr;
+      ostr  = NULL;
+      if ( ((istr)) && ((ostr = tinytacb_strdup(istr)) == NULL) )
+         return(TTAC_ENOMEM);
+      tt    = ((tt))      ? tt                      : &tinytac_dflt;
+      if ((tt->acct_spool))
+         free(tt->acct_spool);
+      tt->acct_spool = ostr;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_SPOOL_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_SPOOL_SIZE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.acct_spool_size : TTAC_DFLT_ACCT_SPOOL_SIZE;
+      ival  = ((invalue)) ? *((const int *)invalue)      : idflt;
+      if ( (ival < 1) || (ival > (int)TTAC_SPOOL_LEN_MASK) )
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                           : &tinytac_dflt;
+      tt->acct_spool_size = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_ACCT_WATCHDOG:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_ACCT_WATCHDOG, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.acct_watchdog : TTAC_DFLT_ACCT_WATCHDOG;
+      ival  = ((invalue)) ? *((const int *)invalue)    : idflt;
+      if (ival < 1)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                         : &tinytac_dflt;
+      tt->acct_watchdog = ival;
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_AUTHEN_ALL:
       TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_AUTHEN_ALL, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
       ival = TTAC_YES;
@@ -457,6 +941,75 @@ tinytac_set_option(
       TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_AUTHEN_PAP, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
       return(tinytac_set_option_flag(tt, TTAC_PAP, invalue));
 
+      case TTAC_OPT_CACHE_NEG_TTL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_NEG_TTL, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.cache_neg_ttl : TTAC_DFLT_CACHE_NEG_TTL;
+      ival  = ((invalue)) ? *((const int *)invalue)    : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                         : &tinytac_dflt;
+      tt->cache_neg_ttl = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CACHE_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_SIZE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.cache_size : TTAC_DFLT_CACHE_SIZE;
+      ival  = ((invalue)) ? *((const int *)invalue) : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                      : &tinytac_dflt;
+      tt->cache_size = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CACHE_TTL:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CACHE_TTL, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.cache_ttl  : TTAC_DFLT_CACHE_TTL;
+      ival  = ((invalue)) ? *((const int *)invalue) : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                      : &tinytac_dflt;
+      tt->cache_ttl = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CAPTURE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      return(tinytac_capture_open(invalue));
+
+      case TTAC_OPT_CAPTURE_PLAIN:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE_PLAIN, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      ival = (((const int *)invalue)) ? *((const int *)invalue) : TTAC_DFLT_CAPTURE_PLAIN;
+      tinytac_capture_plain = ((ival)) ? TTAC_YES : TTAC_NO;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_CAPTURE_SIZE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CAPTURE_SIZE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      ival = (((const int *)invalue)) ? *((const int *)invalue) : TTAC_DFLT_CAPTURE_SIZE;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tinytac_capture_size = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_COALESCE:
+      TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_COALESCE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      return(tinytac_set_option_flag(tt, TTAC_COALESCE, invalue));
+
+      case TTAC_OPT_CONF_WATCH:
+      TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_CONF_WATCH, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      if ((rc = tinytac_set_option_flag(tt, TTAC_CONF_WATCH, invalue)) != TTAC_SUCCESS)
+         return(rc);
+      if (!(tt))
+         return(TTAC_SUCCESS);
+      if (!(tt->opts & TTAC_CONF_WATCH))
+      {
+         tinytac_reload_remove(tt);
+         return(TTAC_SUCCESS);
+      };
+      if ((rc = tinytac_reload_add(tt)) == TTAC_SUCCESS)
+         return(TTAC_SUCCESS);
+      ival = TTAC_NO;
+      tinytac_set_option_flag(tt, TTAC_CONF_WATCH, &ival);
+      return(rc);
+
       case TTAC_OPT_DEBUG_IDENT:
       TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_DEBUG_IDENT, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
       istr = (((const char *)invalue)) ? ((const char *)invalue) : TTAC_DFLT_DEBUG_IDENT;
@@ -512,6 +1065,52 @@ tinytac_set_option(
       ival = ((invalue)) ? *((const int *)invalue) : TTAC_YES;
       return(tinytac_set_option_flag(tt, TTAC_NOINIT, &ival));
 
+      case TTAC_OPT_OFFLINE_DIR:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_DIR, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      istr  = ((tt))      ? tinytac_dflt.offline_dir : TTAC_DFLT_OFFLINE_DIR;
+      istr  = ((invalue)) ? (const char *)invalue    : istr;
+      ostr  = NULL;
+      if ( ((istr)) && ((ostr = tinytacb_strdup(istr)) == NULL) )
+         return(TTAC_ENOMEM);
+      tt    = ((tt))      ? tt                       : &tinytac_dflt;
+      if ((tt->offline_dir))
+         free(tt->offline_dir);
+      tt->offline_dir = ostr;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_OFFLINE_LOCKOUT:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_LOCKOUT, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.offline_lockout : TTAC_DFLT_OFFLINE_LOCKOUT;
+      ival  = ((invalue)) ? *((const int *)invalue)      : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                           : &tinytac_dflt;
+      tt->offline_lockout = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_OFFLINE_MAX_AGE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_OFFLINE_MAX_AGE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.offline_max_age : TTAC_DFLT_OFFLINE_MAX_AGE;
+      ival  = ((invalue)) ? *((const int *)invalue)      : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                           : &tinytac_dflt;
+      tt->offline_max_age = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_PROXY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_PROXY, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      istr  = ((tt))      ? tinytac_dflt.proxy     : TTAC_DFLT_PROXY;
+      istr  = ((invalue)) ? (const char *)invalue  : istr;
+      ostr  = NULL;
+      if ( ((istr)) && ((ostr = tinytacb_strdup(istr)) == NULL) )
+         return(TTAC_ENOMEM);
+      tt    = ((tt))      ? tt                     : &tinytac_dflt;
+      if ((tt->proxy))
+         free(tt->proxy);
+      tt->proxy = ostr;
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_RANDOM:
       TinyTacDebug(  TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_RANDOM, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
       idflt = ((tt))      ? tinytac_dflt.opts       : TTAC_DFLT_OPTS;
@@ -529,6 +1128,41 @@ tinytac_set_option(
       tt->opts_neg |= ~ival & TTAC_RND_METHODS;
       return(TTAC_SUCCESS);
 
+      case TTAC_OPT_SERVER_RETRY:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_SERVER_RETRY, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      idflt = ((tt))      ? tinytac_dflt.server_retry : TTAC_DFLT_SERVER_RETRY;
+      ival  = ((invalue)) ? *((const int *)invalue)   : idflt;
+      if (ival < 0)
+         return(TTAC_EOPTVAL);
+      tt    = ((tt))      ? tt                        : &tinytac_dflt;
+      tt->server_retry = ival;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_SHM_CACHE:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_SHM_CACHE, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      istr  = ((tt))      ? tinytac_dflt.shm_cache  : TTAC_DFLT_SHM_CACHE;
+      istr  = ((invalue)) ? (const char *)invalue   : istr;
+      ostr  = NULL;
+      if ( ((istr)) && ((ostr = tinytacb_strdup(istr)) == NULL) )
+         return(TTAC_ENOMEM);
+      tt    = ((tt))      ? tt                      : &tinytac_dflt;
+      if ((tt->shm_cache))
+         free(tt->shm_cache);
+      tt->shm_cache = ostr;
+      return(TTAC_SUCCESS);
+
+      case TTAC_OPT_STATS_RESET:
+      TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_STATS_RESET, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
+      if ( (!(tt)) || (!(tt->metrics)) )
+         return(TTAC_EINVAL);
+      tinytac_metrics_reset(tt->metrics);
+      if ((servers = tinytac_servers_acquire(tt)) == NULL)
+         return(TTAC_SUCCESS);
+      for(len = 0; ( ((servers->metrics)) && ((servers->budps)) && ((servers->budps[len])) ); len++)
+         tinytac_metrics_reset(&servers->metrics[len]);
+      tinytac_servers_release(servers);
+      return(TTAC_SUCCESS);
+
       case TTAC_OPT_TIMEOUT:
       TinyTacDebug(TTAC_DEBUG_ARGS, "   == %s( %s, TTAC_OPT_TIMEOUT, invalue )", __func__, (((tt)) ? "tt" : "NULL") );
       idflt = ((tt))      ? tinytac_dflt.timeout    : TTAC_DFLT_TIMEOUT;
@@ -585,110 +1219,42 @@ tinytac_set_option_host(
          const char *                  invalue )
 {
    int                     rc;
-   char *                  buff;
    char *                  ostr;
    const char *            dflt;
-   char *                  eol;
-   char *                  str;
-   void *                  ptr;
-   size_t                  budps_len;
    BindleURLDesc **        budps;
 
    TinyTacDebugTrace();
 
    dflt      = ((tt))      ? tinytac_dflt_hosts : TTAC_DFLT_HOSTS;
-   invalue   = ((invalue)) ? invalue            : dflt;
-   budps     = NULL;
-   budps_len = 0;
-
-   if ((buff = tinytacb_strdup(invalue)) == NULL)
-      return(TTAC_ENOMEM);
 
-   str = buff;
-   while( ((str)) && ((str[0])) )
+   if ((tt))
    {
-      // find next whitespace
-      eol = strchr(str, ' ');
-      eol = ((eol)) ? eol : strchr(str, '\t');
-      if ((eol))
-         eol[0] = '\0';
-
-      // skip empty host
-      if (str[0] == '\0')
-      {
-         str = ((eol)) ? &eol[1] : NULL;
-         continue;
-      };
-
-      // increase size of URL list
-      if ((ptr = realloc(budps, sizeof(BindleURLDesc *)*(budps_len+2))) == NULL)
-      {
-         free(buff);
-         tinytac_tinytac_free_budps(budps);
-         return(TTAC_ENOMEM);
-      };
-      budps              = ptr;
-      budps[budps_len+0] = NULL;
-      budps[budps_len+1] = NULL;
-
-      // parse URL
-      if ((rc = tinytacb_urldesc_parse(str, &budps[budps_len])) != 0)
+      // hosts set by application are not replaced by configuration changes
+      pthread_mutex_lock(&tt->servers_mutex);
+      if ((rc = tinytac_servers_publish(tt, ((invalue)) ? invalue : dflt, NULL, TTAC_SERVERS_HOSTS)) == TTAC_SUCCESS)
       {
-         free(buff);
-         tinytac_tinytac_free_budps(budps);
-         return((rc == ENOMEM) ? TTAC_ENOMEM : TTAC_EINVAL);
-      };
-
-      // check URL result
-      if ( ((budps[budps_len]->bud_scheme)) && (!(strcasecmp("tacacs+", budps[budps_len]->bud_scheme))) )
-      {
-         free(buff);
-         tinytac_tinytac_free_budps(budps);
-         return(TTAC_EINVAL);
-      };
-      if ( ((budps[budps_len]->bud_userinfo)) || ((budps[budps_len]->bud_path)) ||
-           ((budps[budps_len]->bud_query)) || ((budps[budps_len]->bud_fragment)) )
-      {
-         free(buff);
-         tinytac_tinytac_free_budps(budps);
-         return(TTAC_EINVAL);
-      };
-
-      // resolve URL host
-      if ((rc = tinytacb_urldesc_resolve(budps[budps_len], AF_UNSPEC, TTAC_DFLT_PORT)) != 0)
-      {
-         free(buff);
-         tinytac_tinytac_free_budps(budps);
-         return((rc == ENOMEM) ? TTAC_ENOMEM : TTAC_EINVAL);
+         if ((invalue))
+            tt->servers_pinned |= TTAC_SERVERS_HOSTS;
+         else
+            tt->servers_pinned &= ~TTAC_SERVERS_HOSTS;
       };
-
-      // shift string
-      str = ((eol)) ? &eol[1] : NULL;
+      pthread_mutex_unlock(&tt->servers_mutex);
+      return(rc);
    };
+   invalue   = ((invalue)) ? invalue            : dflt;
 
-   free(buff);
+   // validate default host string
+   if ((rc = tinytac_servers_parse(invalue, &budps, NULL)) != TTAC_SUCCESS)
+      return(rc);
+   tinytac_tinytac_free_budps(budps);
 
    // saves host string
    if ((ostr = tinytacb_strdup(invalue)) == NULL)
-   {
-      tinytac_tinytac_free_budps(budps);
       return(TTAC_ENOMEM);
-   };
-   if (!(tt))
-   {
-      tinytac_tinytac_free_budps(budps);
-      if ((tinytac_dflt.hosts))
-         free(tinytac_dflt.hosts);
-      tinytac_dflt.hosts = ostr;
-      tinytac_dflt_hosts      = tinytac_dflt.hosts;
-   } else
-   {
-      tinytac_tinytac_free_budps(tt->budps);
-      tt->budps = budps;
-      if ((tt->hosts))
-         free(tt->hosts);
-      tt->hosts = ostr;
-   };
+   if ((tinytac_dflt_servers.hosts))
+      free(tinytac_dflt_servers.hosts);
+   tinytac_dflt_servers.hosts = ostr;
+   tinytac_dflt_hosts         = tinytac_dflt_servers.hosts;
 
    return(TTAC_SUCCESS);
 }
@@ -700,13 +1266,12 @@ tinytac_set_option_keys(
          const char *                  invalue,
          char * const *                invalues )
 {
-   char ***       strsp;
+   int            rc;
    char **        strs;
 
    TinyTacDebugTrace();
 
    strs     = NULL;
-   strsp    = ((tt)) ? &tt->keys : &tinytac_dflt.keys;
 
    if ((invalue))
    {
@@ -720,15 +1285,31 @@ tinytac_set_option_keys(
    }
    else if ((tt))
    {
-      if ((tinytac_dflt.keys))
-         if (tinytacb_strsdup(&strs, tinytac_dflt.keys) != 0)
+      if ((tinytac_dflt_servers.keys))
+         if (tinytacb_strsdup(&strs, tinytac_dflt_servers.keys) != 0)
             return(TTAC_ENOMEM);
    };
 
-   tinytacb_strsfree(*strsp);
-   *strsp = strs;
+   if (!(tt))
+   {
+      tinytacb_strsfree(tinytac_dflt_servers.keys);
+      tinytac_dflt_servers.keys = strs;
+      return(TTAC_SUCCESS);
+   };
 
-   return(TTAC_SUCCESS);
+   // keys set by application are not replaced by configuration changes
+   pthread_mutex_lock(&tt->servers_mutex);
+   if ((rc = tinytac_servers_publish(tt, NULL, strs, TTAC_SERVERS_KEYS)) == TTAC_SUCCESS)
+   {
+      if ( ((invalue)) || ((invalues)) )
+         tt->servers_pinned |= TTAC_SERVERS_KEYS;
+      else
+         tt->servers_pinned &= ~TTAC_SERVERS_KEYS;
+   };
+   pthread_mutex_unlock(&tt->servers_mutex);
+   tinytacb_strsfree(strs);
+
+   return(rc);
 }
 
 
@@ -740,15 +1321,32 @@ tinytac_tinytac_free(
 
    assert(tt != NULL);
 
-   if ((tt->hosts))
-      free(tt->hosts);
-   if ((tt->keys))
-      tinytacb_strsfree(tt->keys);
-
-   tinytac_tinytac_free_budps(tt->budps);
-
-   memset(tt, 0, sizeof(TinyTac));
-   free(tt);
+   // stop following configuration before servers are released
+   tinytac_reload_remove(tt);
+
+   // deliver queued accounting records while servers and keys are set
+   tinytac_acct_free(tt);
+
+   tinytac_servers_release(atomic_exchange_explicit(&tt->servers, NULL, memory_order_acq_rel));
+
+   tinytac_cache_free(tt->cache);
+   tinytac_shm_free(tt->shm);
+   if ((tt->shm_cache))
+      free(tt->shm_cache);
+   if ((tt->offline_dir))
+      free(tt->offline_dir);
+   if ((tt->proxy))
+      free(tt->proxy);
+   if ((tt->acct_spool))
+      free(tt->acct_spool);
+   tinytac_session_flush(tt);
+   pthread_mutex_destroy(&tt->sessions_mutex);
+   pthread_mutex_destroy(&tt->cache_mutex);
+   pthread_mutex_destroy(&tt->flights_mutex);
+   pthread_mutex_destroy(&tt->servers_mutex);
+   tinytac_metrics_free(tt->metrics);
+
+   tinytac_obj_dealloc(tt);
 
    return;
 }
@@ -768,6 +1366,101 @@ tinytac_tinytac_free_budps(
 }
 
 
+//---------------------//
+// allocator functions //
+//---------------------//
+#pragma mark allocator functions
+
+/// allocates memory with the allocator of the library
+///
+/// @param[in]  size          number of bytes to allocate
+///
+/// @return    Returns pointer to memory or NULL if memory could not be
+///            allocated.
+void *
+tinytac_mem_alloc(
+         size_t                        size )
+{
+   return(tinytac_malloc_func(size));
+}
+
+
+/// allocates zeroed memory for an array with the allocator of the library
+///
+/// @param[in]  nmemb         number of elements of array
+/// @param[in]  size          size of each element
+///
+/// @return    Returns pointer to memory or NULL if memory could not be
+///            allocated.
+void *
+tinytac_mem_calloc(
+         size_t                        nmemb,
+         size_t                        size )
+{
+   void *   ptr;
+   if ( ((size)) && (nmemb > (SIZE_MAX / size)) )
+      return(NULL);
+   if ((ptr = tinytac_malloc_func(nmemb * size)) != NULL)
+      memset(ptr, 0, (nmemb * size));
+   return(ptr);
+}
+
+
+/// frees memory allocated with the allocator of the library
+///
+/// @param[in]  ptr           memory to free or NULL
+void
+tinytac_mem_free(
+         void *                        ptr )
+{
+   if ((ptr))
+      tinytac_free_func(ptr);
+   return;
+}
+
+
+/// resizes memory allocated with the allocator of the library
+///
+/// @param[in]  ptr           memory to resize or NULL
+/// @param[in]  size          new size of memory
+///
+/// @return    Returns pointer to memory or NULL if memory could not be
+///            allocated.
+void *
+tinytac_mem_realloc(
+         void *                        ptr,
+         size_t                        size )
+{
+   return(tinytac_realloc_func(ptr, size));
+}
+
+
+int
+tinytac_set_allocator(
+         void * (*malloc_func)(size_t size),
+         void * (*realloc_func)(void * ptr, size_t size),
+         void (*free_func)(void * ptr) )
+{
+   TinyTacDebugTrace();
+
+   if ( (!(malloc_func)) && (!(realloc_func)) && (!(free_func)) )
+   {
+      tinytac_malloc_func  = &malloc;
+      tinytac_realloc_func = &realloc;
+      tinytac_free_func    = &free;
+      return(TTAC_SUCCESS);
+   };
+   if ( (!(malloc_func)) || (!(realloc_func)) || (!(free_func)) )
+      return(TTAC_EINVAL);
+
+   tinytac_malloc_func  = malloc_func;
+   tinytac_realloc_func = realloc_func;
+   tinytac_free_func    = free_func;
+
+   return(TTAC_SUCCESS);
+}
+
+
 //------------------//
 // object functions //
 //------------------//
@@ -782,7 +1475,7 @@ tinytac_free(
       return;
    if (tinytac_verify_is_obj(ptr) == TTAC_NO)
    {
-      free(ptr);
+      tinytac_mem_free(ptr);
       return;
    };
    tinytac_obj_release(ptr);
@@ -790,32 +1483,123 @@ tinytac_free(
 }
 
 
+/// allocates reference counted object
+///
+/// Objects of a slab type are taken from the magazine of the calling thread
+/// and then from the depot of the slab before memory is allocated.
+///
+/// @param[in]  size          size of object including TinyTacObj header
+/// @param[in]  slab          slab cache of object type or TTAC_SLAB_NONE
+/// @param[in]  flags         TinyTacObj flags
+/// @param[in]  free_func     function called when the last reference is
+///                           released or NULL to use tinytac_obj_dealloc()
+///
+/// @return    Returns pointer to object or NULL if memory could not be
+///            allocated.
 void *
 tinytac_obj_alloc(
          size_t                        size,
+         unsigned                      slab,
+         unsigned                      flags,
          void (*free_func)(void * ptr) )
 {
-   TinyTacObj *      obj;
+   TinyTacObj *            obj;
+   tinytac_slab_t *        cache;
+   tinytac_slab_mag_t *    mag;
+
    TinyTacDebugTrace();
+
    assert(size > sizeof(TinyTacObj));
-   if ((obj = malloc(size)) == NULL)
+   assert(slab < TTAC_SLAB_MAX);
+   assert( (slab == TTAC_SLAB_NONE) || (size == tinytac_slabs[slab].size) );
+
+   obj = NULL;
+   if (slab != TTAC_SLAB_NONE)
+   {
+      cache = &tinytac_slabs[slab];
+      mag   = &tinytac_slab_mags[slab];
+      if (!(mag->cnt))
+      {
+         // refill half of the magazine from the depot
+         pthread_mutex_lock(&cache->mutex);
+         while ( ((cache->depot_cnt)) && (mag->cnt < (TTAC_SLAB_MAG_SIZE/2)) )
+            mag->objs[mag->cnt++] = cache->depot[--cache->depot_cnt];
+         pthread_mutex_unlock(&cache->mutex);
+         if ((mag->cnt))
+            tinytac_slab_register();
+      };
+      if ((mag->cnt))
+         obj = mag->objs[--mag->cnt];
+   };
+   if ( (!(obj)) && ((obj = tinytac_mem_alloc(size)) == NULL) )
       return(NULL);
+
    memset(obj, 0, size);
-   memcpy(obj->magic, TTAC_MAGIC, 8);
+   memcpy(&obj->magic, TTAC_MAGIC, sizeof(obj->magic));
    atomic_init(&obj->ref_count, 0);
-   obj->free_func = ((free_func)) ? free_func : &free;
+   obj->slab      = (uint16_t)slab;
+   obj->flags     = (uint16_t)flags;
+   obj->free_func = ((free_func)) ? free_func : &tinytac_obj_dealloc;
+
    return(obj);
 }
 
 
+/// returns memory of object to its slab cache
+///
+/// Called by the free function of an object after its fields are released.
+/// The magic number is cleared so stale references are not mistaken for
+/// objects.
+///
+/// @param[in]  ptr           object to deallocate
+void
+tinytac_obj_dealloc(
+         void *                        ptr )
+{
+   TinyTacObj *            obj;
+   tinytac_slab_mag_t *    mag;
+
+   TinyTacDebugTrace();
+
+   if (!(obj = ptr))
+      return;
+   obj->magic = 0;
+
+   if (obj->slab == TTAC_SLAB_NONE)
+   {
+      tinytac_mem_free(obj);
+      return;
+   };
+
+   tinytac_slab_register();
+
+   mag = &tinytac_slab_mags[obj->slab];
+   if (mag->cnt == TTAC_SLAB_MAG_SIZE)
+      tinytac_slab_put(&tinytac_slabs[obj->slab], mag, (TTAC_SLAB_MAG_SIZE/2));
+   mag->objs[mag->cnt++] = obj;
+
+   return;
+}
+
+
 void
 tinytac_obj_release(
          TinyTacObj *                  obj )
 {
+   int_least32_t  count;
    TinyTacDebugTrace();
    assert(obj != NULL);
-   assert(tinytac_verify_is_obj(obj) == TTAC_YES);
-   if (atomic_fetch_sub(&obj->ref_count, 1) > 1)
+   assert(tinytac_verify_obj(obj) == TTAC_YES);
+   if ((obj->flags & TTAC_OBJ_CONFINED))
+   {
+      count = atomic_load_explicit(&obj->ref_count, memory_order_relaxed);
+      atomic_store_explicit(&obj->ref_count, (count - 1), memory_order_relaxed);
+   }
+   else
+   {
+      count = atomic_fetch_sub(&obj->ref_count, 1);
+   };
+   if (count > 1)
       return;
    obj->free_func(obj);
    return;
@@ -826,10 +1610,17 @@ void *
 tinytac_obj_retain(
          TinyTacObj *                  obj )
 {
+   int_least32_t  count;
    TinyTacDebugTrace();
    if (obj == NULL)
       return(NULL);
-   assert(tinytac_verify_is_obj(obj) == TTAC_YES);
+   assert(tinytac_verify_obj(obj) == TTAC_YES);
+   if ((obj->flags & TTAC_OBJ_CONFINED))
+   {
+      count = atomic_load_explicit(&obj->ref_count, memory_order_relaxed);
+      atomic_store_explicit(&obj->ref_count, (count + 1), memory_order_relaxed);
+      return(obj);
+   };
    atomic_fetch_add(&obj->ref_count, 1);
    return(obj);
 }
@@ -842,24 +1633,538 @@ tinytac_obj_retain_count(
    TinyTacDebugTrace();
    if (obj == NULL)
       return(0);
-   assert(tinytac_verify_is_obj(obj) == TTAC_YES);
-   return(atomic_fetch_add(&obj->ref_count, 0));
+   assert(tinytac_verify_obj(obj) == TTAC_YES);
+   return(atomic_load(&obj->ref_count));
+}
+
+
+/// empties magazines of an exiting thread
+///
+/// @param[in]  ptr           magazines of the thread
+void
+tinytac_slab_flush(
+         void *                        ptr )
+{
+   unsigned                slab;
+   tinytac_slab_mag_t *    mags;
+
+   mags = ptr;
+   for(slab = 0; (slab < TTAC_SLAB_MAX); slab++)
+      tinytac_slab_put(&tinytac_slabs[slab], &mags[slab], mags[slab].cnt);
+
+   return;
+}
+
+
+/// creates key used to empty magazines of exiting threads
+void
+tinytac_slab_once(
+         void )
+{
+   pthread_key_create(&tinytac_slab_key, &tinytac_slab_flush);
+   return;
 }
 
 
+/// moves objects from a magazine to the depot of the slab
+///
+/// Objects which do not fit into the depot are freed.
+///
+/// @param[in]  slab          slab cache of objects
+/// @param[in]  mag           magazine of calling thread
+/// @param[in]  cnt           number of objects to move
+void
+tinytac_slab_put(
+         tinytac_slab_t *              slab,
+         tinytac_slab_mag_t *          mag,
+         size_t                        cnt )
+{
+   void *   obj;
+
+   if (!(cnt))
+      return;
+
+   pthread_mutex_lock(&slab->mutex);
+   for(; ((cnt)); cnt--)
+   {
+      obj = mag->objs[--mag->cnt];
+      if (slab->depot_cnt < TTAC_SLAB_DEPOT_MAX)
+         slab->depot[slab->depot_cnt++] = obj;
+      else
+         tinytac_mem_free(obj);
+   };
+   pthread_mutex_unlock(&slab->mutex);
+
+   return;
+}
+
+
+/// registers magazines of calling thread to be emptied when it exits
+///
+/// Called whenever objects are placed into a magazine, either when an
+/// object is freed or when the magazine is refilled from the depot.
+void
+tinytac_slab_register(
+         void )
+{
+   if ((tinytac_slab_mags_used))
+      return;
+   pthread_once(&tinytac_slab_key_once, &tinytac_slab_once);
+   pthread_setspecific(tinytac_slab_key, tinytac_slab_mags);
+   tinytac_slab_mags_used = 1;
+   return;
+}
+
+
+/// tests for the magic number of TinyTacObj
+///
+/// tinytac_free() uses the test to distinguish objects from packets and
+/// strings which may be shorter than the magic number.  The magic number is
+/// compared bytewise so that the comparison stops at the first byte which
+/// differs, which is the first byte of any string which is not empty.
+///
+/// @param[in]  obj           object or memory to test
+///
+/// @return    Returns TTAC_YES if memory starts with the magic number.
 int
 tinytac_verify_is_obj(
          TinyTacObj *                  obj )
 {
-   size_t   pos;
+   size_t            pos;
+   const uint8_t *   bytes;
    TinyTacDebugTrace();
    if (!(obj))
       return(TTAC_NO);
-   for(pos = 0; (pos < 8); pos++)
-      if (obj->magic[pos] != TTAC_MAGIC[pos])
+   bytes = (const uint8_t *)&obj->magic;
+   for(pos = 0; (pos < sizeof(obj->magic)); pos++)
+      if (bytes[pos] != TTAC_MAGIC[pos])
          return(TTAC_NO);
    return(TTAC_YES);
 }
 
 
+#ifndef NDEBUG
+/// tests the magic number of memory known to be a TinyTacObj
+///
+/// The magic number is compared as a single word.  Only used by assertions
+/// of retain and release.
+///
+/// @param[in]  obj           object to test
+///
+/// @return    Returns TTAC_YES if object starts with the magic number.
+int
+tinytac_verify_obj(
+         TinyTacObj *                  obj )
+{
+   uint64_t magic;
+   memcpy(&magic, TTAC_MAGIC, sizeof(magic));
+   return( (obj->magic == magic) ? TTAC_YES : TTAC_NO );
+}
+#endif
+
+
+//-------------------//
+// servers functions //
+//-------------------//
+#pragma mark servers functions
+
+/// references current set of servers of handle
+///
+/// The set remains valid until it is released, even if the servers or keys
+/// of the handle are replaced in the meantime.
+///
+/// @param[in]  tt            reference to library handle or NULL
+///
+/// @return    Returns set of servers or NULL if handle has no servers.
+tinytac_servers_t *
+tinytac_servers_acquire(
+         TinyTac *                     tt )
+{
+   tinytac_servers_t *     servers;
+
+   if (!(tt))
+      return(NULL);
+
+   pthread_mutex_lock(&tt->servers_mutex);
+   if ((servers = atomic_load_explicit(&tt->servers, memory_order_relaxed)) != NULL)
+      atomic_fetch_add_explicit(&servers->refs, 1, memory_order_relaxed);
+   pthread_mutex_unlock(&tt->servers_mutex);
+
+   return(servers);
+}
+
+
+/// frees set of servers and releases its parts
+///
+/// @param[in]  servers       set of servers without references
+void
+tinytac_servers_free(
+         tinytac_servers_t *           servers )
+{
+   TinyTacDebugTrace();
+   tinytac_servers_part_release(servers->hosts_part);
+   tinytac_servers_part_release(servers->keys_part);
+   tinytac_mem_free(servers);
+   return;
+}
+
+
+/// parses and resolves space separated list of server URLs
+///
+/// @param[in]  hosts         list of server URLs
+/// @param[out] budpsp        pointer to store NULL terminated list of URLs
+/// @param[out] lenp          pointer to store number of URLs or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_servers_parse(
+         const char *                  hosts,
+         BindleURLDesc ***             budpsp,
+         size_t *                      lenp )
+{
+   int                     rc;
+   char *                  buff;
+   char *                  eol;
+   char *                  str;
+   void *                  ptr;
+   size_t                  budps_len;
+   BindleURLDesc **        budps;
+
+   TinyTacDebugTrace();
+
+   *budpsp   = NULL;
+   budps     = NULL;
+   budps_len = 0;
+
+   if ((buff = tinytacb_strdup(hosts)) == NULL)
+      return(TTAC_ENOMEM);
+
+   str = buff;
+   while( ((str)) && ((str[0])) )
+   {
+      // find next whitespace
+      eol = strchr(str, ' ');
+      eol = ((eol)) ? eol : strchr(str, '\t');
+      if ((eol))
+         eol[0] = '\0';
+
+      // skip empty host
+      if (str[0] == '\0')
+      {
+         str = ((eol)) ? &eol[1] : NULL;
+         continue;
+      };
+
+      // increase size of URL list
+      if ((ptr = realloc(budps, sizeof(BindleURLDesc *)*(budps_len+2))) == NULL)
+      {
+         free(buff);
+         tinytac_tinytac_free_budps(budps);
+         return(TTAC_ENOMEM);
+      };
+      budps              = ptr;
+      budps[budps_len+0] = NULL;
+      budps[budps_len+1] = NULL;
+
+      // parse URL
+      if ((rc = tinytacb_urldesc_parse(str, &budps[budps_len])) != 0)
+      {
+         free(buff);
+         tinytac_tinytac_free_budps(budps);
+         return((rc == ENOMEM) ? TTAC_ENOMEM : TTAC_EINVAL);
+      };
+
+      // check URL result
+      if ( ((budps[budps_len]->bud_scheme)) && ((strcasecmp("tacacs+", budps[budps_len]->bud_scheme))) )
+      {
+         free(buff);
+         tinytac_tinytac_free_budps(budps);
+         return(TTAC_EINVAL);
+      };
+      if ( ((budps[budps_len]->bud_userinfo)) || ((budps[budps_len]->bud_path)) ||
+           ((budps[budps_len]->bud_query)) || ((budps[budps_len]->bud_fragment)) )
+      {
+         free(buff);
+         tinytac_tinytac_free_budps(budps);
+         return(TTAC_EINVAL);
+      };
+
+      // resolve URL host
+      if ((rc = tinytacb_urldesc_resolve(budps[budps_len], AF_UNSPEC, TTAC_DFLT_PORT)) != 0)
+      {
+         free(buff);
+         tinytac_tinytac_free_budps(budps);
+         return((rc == ENOMEM) ? TTAC_ENOMEM : TTAC_EINVAL);
+      };
+
+      // shift string
+      budps_len++;
+      str = ((eol)) ? &eol[1] : NULL;
+   };
+
+   free(buff);
+
+   *budpsp = budps;
+   if ((lenp))
+      *lenp = budps_len;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// releases part of sets of servers and frees it with its last set
+///
+/// @param[in]  part          part of set of servers or NULL
+void
+tinytac_servers_part_release(
+         tinytac_servers_part_t *      part )
+{
+   size_t                  len;
+   if (!(part))
+      return;
+   if (atomic_fetch_sub_explicit(&part->refs, 1, memory_order_acq_rel) > 1)
+      return;
+   if ((part->hosts))
+      free(part->hosts);
+   for(len = 0; ( ((part->budps)) && ((part->budps[len])) ); len++);
+   tinytac_servers_resolve_free(part->addrs, len);
+   tinytac_tinytac_free_budps(part->budps);
+   tinytac_metrics_free(part->metrics);
+   if ((part->keys))
+      tinytacb_strsfree(part->keys);
+   tinytac_mem_free(part);
+   return;
+}
+
+
+/// publishes servers and keys of handle
+///
+/// A new set is built from the replaced parts and the remaining parts of
+/// the current set, so requests in progress keep using the set they
+/// referenced.  The reference of the handle to the replaced set is
+/// released.  Servers which are listed in the current set keep the time
+/// until which they are skipped after a failure.  The caller holds
+/// servers_mutex of the handle.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  hosts         space separated list of server URLs
+/// @param[in]  keys          NULL terminated list of keys or NULL
+/// @param[in]  flags         parts to replace (TTAC_SERVERS_HOSTS, TTAC_SERVERS_KEYS)
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_servers_publish(
+         TinyTac *                     tt,
+         const char *                  hosts,
+         char * const *                keys,
+         unsigned                      flags )
+{
+   int                        rc;
+   size_t                     len;
+   size_t                     idx;
+   size_t                     pos;
+   BindleURLDesc *            budp;
+   BindleURLDesc *            obudp;
+   BindleURLDesc **           budps;
+   tinytac_servers_t *        cur;
+   tinytac_servers_t *        servers;
+   tinytac_servers_part_t *   part;
+
+   TinyTacDebugTrace();
+
+   assert(tt != NULL);
+
+   cur   = atomic_load_explicit(&tt->servers, memory_order_relaxed);
+   budps = NULL;
+   len   = 0;
+
+   if ((flags & TTAC_SERVERS_HOSTS))
+      if ((rc = tinytac_servers_parse(hosts, &budps, &len)) != TTAC_SUCCESS)
+         return(rc);
+
+   if ((servers = tinytac_mem_calloc(1, sizeof(tinytac_servers_t))) == NULL)
+   {
+      tinytac_tinytac_free_budps(budps);
+      return(TTAC_ENOMEM);
+   };
+   atomic_init(&servers->refs, 1);
+
+   if ((flags & TTAC_SERVERS_HOSTS))
+   {
+      // circuit of servers is allocated with the part
+      if ((part = tinytac_mem_calloc(1, (sizeof(tinytac_servers_part_t) + (sizeof(_Atomic uint64_t) * (len+1))))) == NULL)
+      {
+         tinytac_tinytac_free_budps(budps);
+         tinytac_servers_free(servers);
+         return(TTAC_ENOMEM);
+      };
+      atomic_init(&part->refs, 1);
+      servers->hosts_part = part;
+      part->budps         = budps;
+      part->addrs         = tinytac_servers_resolve(budps, len);
+      part->metrics       = tinytac_metrics_alloc(len);
+      part->hosts         = tinytacb_strdup(hosts);
+      if ( (!(part->addrs)) || (!(part->metrics)) || (!(part->hosts)) )
+      {
+         tinytac_servers_free(servers);
+         return(TTAC_ENOMEM);
+      };
+      for(idx = 0; ( ((cur)) && ((cur->budps)) && (idx < len) ); idx++)
+      {
+         budp = budps[idx];
+         for(pos = 0; ((cur->budps[pos])); pos++)
+         {
+            obudp = cur->budps[pos];
+            if ( (!(budp->bud_host)) || (!(obudp->bud_host)) || (budp->bud_port != obudp->bud_port) )
+               continue;
+            if ((strcasecmp(budp->bud_host, obudp->bud_host)))
+               continue;
+            atomic_store_explicit(&part->circuit[idx], atomic_load_explicit(&cur->circuit[pos], memory_order_relaxed), memory_order_relaxed);
+            if ((cur->metrics))
+               tinytac_metrics_merge(&part->metrics[idx], &cur->metrics[pos]);
+            break;
+         };
+      };
+   } else if ( ((cur)) && ((servers->hosts_part = cur->hosts_part) != NULL) )
+   {
+      atomic_fetch_add_explicit(&servers->hosts_part->refs, 1, memory_order_relaxed);
+   };
+
+   if ((flags & TTAC_SERVERS_KEYS))
+   {
+      if ((part = tinytac_mem_calloc(1, sizeof(tinytac_servers_part_t))) == NULL)
+      {
+         tinytac_servers_free(servers);
+         return(TTAC_ENOMEM);
+      };
+      atomic_init(&part->refs, 1);
+      servers->keys_part = part;
+      if ( ((keys)) && (tinytacb_strsdup(&part->keys, keys) != 0) )
+      {
+         tinytac_servers_free(servers);
+         return(TTAC_ENOMEM);
+      };
+   } else if ( ((cur)) && ((servers->keys_part = cur->keys_part) != NULL) )
+   {
+      atomic_fetch_add_explicit(&servers->keys_part->refs, 1, memory_order_relaxed);
+   };
+
+   if ((part = servers->hosts_part) != NULL)
+   {
+      servers->hosts    = part->hosts;
+      servers->budps    = part->budps;
+      servers->addrs    = part->addrs;
+      servers->circuit  = part->circuit;
+      servers->metrics  = part->metrics;
+   };
+   if ((part = servers->keys_part) != NULL)
+      servers->keys     = part->keys;
+
+   TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): publishing servers \"%s\"", __func__, (((servers->hosts)) ? servers->hosts : ""));
+   atomic_store_explicit(&tt->servers, servers, memory_order_release);
+   tinytac_servers_release(cur);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// releases reference to set of servers
+///
+/// The set and the parts which are no longer shared are freed with the
+/// last reference.
+///
+/// @param[in]  servers       set of servers or NULL
+void
+tinytac_servers_release(
+         tinytac_servers_t *           servers )
+{
+   if (!(servers))
+      return;
+   if (atomic_fetch_sub_explicit(&servers->refs, 1, memory_order_acq_rel) == 1)
+      tinytac_servers_free(servers);
+   return;
+}
+
+
+/// resolves addresses of servers
+///
+/// Servers are connected to the addresses resolved when the set was
+/// published, so a reloaded configuration also picks up changed addresses
+/// of unchanged server names.  A server which could not be resolved is
+/// left NULL and is resolved again when it is connected.
+///
+/// @param[in]  budps         NULL terminated list of URLs
+/// @param[in]  len           number of URLs
+///
+/// @return    Returns list of addresses of each server or NULL if out of
+///            memory.
+struct addrinfo **
+tinytac_servers_resolve(
+         BindleURLDesc **              budps,
+         size_t                        len )
+{
+   size_t                  idx;
+   char                    port[16];
+   struct addrinfo         hints;
+   struct addrinfo **      addrs;
+
+   TinyTacDebugTrace();
+
+   if ((addrs = tinytac_mem_calloc((len+1), sizeof(struct addrinfo *))) == NULL)
+      return(NULL);
+
+   // addresses of all families are kept, TTAC_OPT_IP is applied when connecting
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+
+   for(idx = 0; (idx < len); idx++)
+   {
+      snprintf(port, sizeof(port), "%u", (unsigned)budps[idx]->bud_port);
+      if (getaddrinfo(budps[idx]->bud_host, port, &hints, &addrs[idx]) != 0)
+      {
+         TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to resolve %s", __func__, budps[idx]->bud_host);
+         addrs[idx] = NULL;
+      };
+   };
+
+   return(addrs);
+}
+
+
+/// frees addresses of servers
+///
+/// @param[in]  addrs         list of addresses of each server or NULL
+/// @param[in]  len           number of servers
+void
+tinytac_servers_resolve_free(
+         struct addrinfo **            addrs,
+         size_t                        len )
+{
+   size_t                  idx;
+   if (!(addrs))
+      return;
+   for(idx = 0; (idx < len); idx++)
+      if ((addrs[idx]))
+         freeaddrinfo(addrs[idx]);
+   tinytac_mem_free(addrs);
+   return;
+}
+
+
+/// adds reference to set of servers which is already referenced
+///
+/// @param[in]  servers       set of servers or NULL
+///
+/// @return    Returns set of servers.
+tinytac_servers_t *
+tinytac_servers_retain(
+         tinytac_servers_t *           servers )
+{
+   if ((servers))
+      atomic_fetch_add_explicit(&servers->refs, 1, memory_order_relaxed);
+   return(servers);
+}
+
+
 /* end of source */
@@ -83,6 +83,33 @@ tinytac_defaults(
          TinyTac *                     tt );
 
 
+//----------------------//
+// allocator prototypes //
+//----------------------//
+#pragma mark allocator prototypes
+
+void *
+tinytac_mem_alloc(
+         size_t                        size );
+
+
+void *
+tinytac_mem_calloc(
+         size_t                        nmemb,
+         size_t                        size );
+
+
+void
+tinytac_mem_free(
+         void *                        ptr );
+
+
+void *
+tinytac_mem_realloc(
+         void *                        ptr,
+         size_t                        size );
+
+
 //-------------------//
 // object prototypes //
 //-------------------//
@@ -91,9 +118,16 @@ tinytac_defaults(
 void *
 tinytac_obj_alloc(
          size_t                        size,
+         unsigned                      slab,
+         unsigned                      flags,
          void (*free_func)(void * ptr) );
 
 
+void
+tinytac_obj_dealloc(
+         void *                        ptr );
+
+
 void
 tinytac_obj_release(
          TinyTacObj *                  obj );
@@ -109,4 +143,32 @@ tinytac_obj_retain_count(
          TinyTacObj *                  obj );
 
 
+//--------------------//
+// servers prototypes //
+//--------------------//
+#pragma mark servers prototypes
+
+tinytac_servers_t *
+tinytac_servers_acquire(
+         TinyTac *                     tt );
+
+
+int
+tinytac_servers_publish(
+         TinyTac *                     tt,
+         const char *                  hosts,
+         char * const *                keys,
+         unsigned                      flags );
+
+
+void
+tinytac_servers_release(
+         tinytac_servers_t *           servers );
+
+
+tinytac_servers_t *
+tinytac_servers_retain(
+         tinytac_servers_t *           servers );
+
+
 #endif /* end of header */
@@ -40,13 +40,24 @@
 #pragma mark - Headers
 
 #include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <assert.h>
 
+#include "lcache.h"
+#include "lcapture.h"
+#include "lmemory.h"
+#include "lprobe.h"
+#include "lstats.h"
+
 
 ///////////////////
 //               //
@@ -55,6 +66,10 @@
 ///////////////////
 #pragma mark - Definitions
 
+#ifndef MSG_NOSIGNAL
+#   define MSG_NOSIGNAL 0
+#endif
+
 
 //////////////////
 //              //
@@ -63,6 +78,16 @@
 //////////////////
 #pragma mark - Prototypes
 
+static int
+tinytac_connect_addr(
+         TinyTac *                     tt,
+         const struct addrinfo *       ai );
+
+
+static int
+tinytac_connect_proxy(
+         TinyTac *                     tt );
+
 
 /////////////////
 //             //
@@ -71,99 +96,508 @@
 /////////////////
 #pragma mark - Functions
 
-char *
-tinytac_ntop(
+int
+tinytac_connect(
+         TinyTac *                     tt,
+         int *                         sp )
+{
+   int                     rc;
+   tinytac_servers_t *     servers;
+
+   TinyTacDebugTrace();
+
+   servers  = tinytac_servers_acquire(tt);
+   rc       = tinytac_net_connect(tt, servers, sp, NULL);
+   tinytac_servers_release(servers);
+
+   return(rc);
+}
+
+
+/// connects socket to address within the network timeout of the handle
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  ai            address of server
+///
+/// @return    Returns connected socket or -1 on error.
+int
+tinytac_connect_addr(
+         TinyTac *                     tt,
+         const struct addrinfo *       ai )
+{
+   int                     s;
+   int                     flags;
+   int                     err;
+   int                     msec;
+   socklen_t               len;
+   struct pollfd           pfd;
+
+   if ((s = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol)) == -1)
+      return(-1);
+
+   // connect without blocking longer than the network timeout
+   flags = fcntl(s, F_GETFL);
+   fcntl(s, F_SETFL, flags | O_NONBLOCK);
+   if (connect(s, ai->ai_addr, ai->ai_addrlen) == -1)
+   {
+      if (errno != EINPROGRESS)
+      {
+         close(s);
+         return(-1);
+      };
+      msec        = (int)((tt->net_timeout.tv_sec * 1000) + (tt->net_timeout.tv_usec / 1000));
+      pfd.fd      = s;
+      pfd.events  = POLLOUT;
+      if ((err = poll(&pfd, 1, ((msec > 0) ? msec : -1))) != 1)
+      {
+         close(s);
+         errno = (err == 0) ? ETIMEDOUT : errno;
+         return(-1);
+      };
+      len = sizeof(err);
+      if ( (getsockopt(s, SOL_SOCKET, SO_ERROR, &err, &len) == -1) || ((err)) )
+      {
+         close(s);
+         return(-1);
+      };
+   };
+   fcntl(s, F_SETFL, flags);
+
+   // bound blocking reads and writes by the network timeout
+   if ( ((tt->net_timeout.tv_sec)) || ((tt->net_timeout.tv_usec)) )
+   {
+      setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tt->net_timeout, sizeof(tt->net_timeout));
+      setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tt->net_timeout, sizeof(tt->net_timeout));
+   };
+
+   return(s);
+}
+
+
+/// connects to Unix domain socket of local proxy
+///
+/// @param[in]  tt            reference to library handle
+///
+/// @return    Returns connected socket or -1 on error.
+int
+tinytac_connect_proxy(
+         TinyTac *                     tt )
+{
+   int                     s;
+   struct sockaddr_un      sa;
+
+   if (strlen(tt->proxy) >= sizeof(sa.sun_path))
+      return(-1);
+   memset(&sa, 0, sizeof(sa));
+   sa.sun_family = AF_UNIX;
+   tinytacb_strlcpy(sa.sun_path, tt->proxy, sizeof(sa.sun_path));
+
+   if ((s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1)
+      return(-1);
+   if (connect(s, (struct sockaddr *)&sa, sizeof(sa)) == -1)
+   {
+      close(s);
+      return(-1);
+   };
+   if ( ((tt->net_timeout.tv_sec)) || ((tt->net_timeout.tv_usec)) )
+   {
+      setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tt->net_timeout, sizeof(tt->net_timeout));
+      setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tt->net_timeout, sizeof(tt->net_timeout));
+   };
+
+   return(s);
+}
+
+
+/// connects to first available server
+///
+/// Servers are connected to the addresses resolved when the set of servers
+/// was published.  Servers which could not be resolved then are resolved
+/// again.  Connections to the local proxy are not counted in the metrics
+/// of a server.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  servers       referenced set of servers of handle or NULL
+/// @param[out] sp            pointer to store connected socket
+/// @param[out] metricsp      pointer to store metrics of connected server or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_net_connect(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         int *                         sp,
+         tinytac_metrics_t **          metricsp )
+{
+   size_t                  idx;
+   size_t                  attempts;
+   int                     s;
+   int                     rc;
+   uint64_t                now;
+   uint64_t                start;
+   char                    port[16];
+   struct addrinfo         hints;
+   struct addrinfo *       res;
+   struct addrinfo *       own;
+   struct addrinfo *       ai;
+   BindleURLDesc *         budp;
+   tinytac_metrics_t *     metrics;
+
+   TinyTacDebugTrace();
+
+   assert(tt != NULL);
+   assert(sp != NULL);
+
+   *sp = -1;
+   if ((metricsp))
+      *metricsp = NULL;
+
+   // prefer local proxy, fall back to servers if proxy is not running
+   if ( ((tt->proxy)) && ((tt->proxy[0])) )
+   {
+      if ((s = tinytac_connect_proxy(tt)) != -1)
+      {
+         *sp = s;
+         return(TTAC_SUCCESS);
+      };
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to connect to proxy %s", __func__, tt->proxy);
+   };
+
+   if (!(servers))
+      return(TTAC_EUNAVAIL);
+   if ( (!(servers->budps)) || (!(servers->circuit)) )
+      return(TTAC_EUNAVAIL);
+
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_socktype = SOCK_STREAM;
+   switch(tt->opts & TTAC_IP_UNSPEC)
+   {
+      case TTAC_IPV4: hints.ai_family = AF_INET;   break;
+      case TTAC_IPV6: hints.ai_family = AF_INET6;  break;
+      default:        hints.ai_family = AF_UNSPEC; break;
+   };
+
+   for(idx = 0, attempts = 0; ((servers->budps[idx])); idx++)
+   {
+      budp     = servers->budps[idx];
+      metrics  = ((servers->metrics)) ? &servers->metrics[idx] : NULL;
+      now      = tinytac_cache_now();
+
+      // skip servers with open circuit
+      if (atomic_load_explicit(&servers->circuit[idx], memory_order_relaxed) > now)
+      {
+         TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): skipping %s", __func__, budp->bud_host);
+         continue;
+      };
+
+      // each server tried after a failed server is a retry of the handle
+      if ((attempts++))
+      {
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_RETRIES, 1);
+         TinyTacProbe2(retry, (int)idx, (unsigned)attempts);
+      };
+
+      start = tinytac_metrics_now();
+      own   = NULL;
+      rc    = 0;
+      if ( (!(servers->addrs)) || ((res = servers->addrs[idx]) == NULL) )
+      {
+         snprintf(port, sizeof(port), "%u", (unsigned)budp->bud_port);
+         rc    = getaddrinfo(budp->bud_host, port, &hints, &own);
+         res   = own;
+      };
+      start = tinytac_metrics_phase(tt, metrics, TTAC_PHASE_RESOLVE, start);
+      if (rc != 0)
+      {
+         if (rc == EAI_MEMORY)
+            return(TTAC_ENOMEM);
+         tinytac_metrics_add(NULL, metrics, TTAC_STAT_FAILURES, 1);
+         atomic_store_explicit(&servers->circuit[idx], (now + (uint64_t)tt->server_retry), memory_order_relaxed);
+         TinyTacProbe2(failover, (int)idx, TTAC_EUNAVAIL);
+         continue;
+      };
+
+      for(ai = res; ((ai)); ai = ai->ai_next)
+      {
+         if ( (hints.ai_family != AF_UNSPEC) && (ai->ai_family != hints.ai_family) )
+            continue;
+         if ((s = tinytac_connect_addr(tt, ai)) == -1)
+         {
+            if (errno == ETIMEDOUT)
+               tinytac_metrics_add(tt, metrics, TTAC_STAT_TIMEOUTS, 1);
+            continue;
+         };
+         now = tinytac_metrics_phase(tt, metrics, TTAC_PHASE_CONNECT, start);
+         TinyTacProbe3(connect, (int)idx, TTAC_SUCCESS, TinyTacProbeUsec(start, now));
+         if ((own))
+            freeaddrinfo(own);
+         TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): connected to %s", __func__, tinytac_ntop(s, TTAC_YES));
+         atomic_store_explicit(&servers->circuit[idx], 0, memory_order_relaxed);
+         if ((metricsp))
+            *metricsp = metrics;
+         *sp = s;
+         return(TTAC_SUCCESS);
+      };
+      if ((own))
+         freeaddrinfo(own);
+
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to connect to %s", __func__, budp->bud_host);
+      tinytac_metrics_add(NULL, metrics, TTAC_STAT_FAILURES, 1);
+      atomic_store_explicit(&servers->circuit[idx], (now + (uint64_t)tt->server_retry), memory_order_relaxed);
+      if (TinyTacProbeEnabled(connect))
+         TinyTacProbe3(connect, (int)idx, TTAC_EUNAVAIL, TinyTacProbeUsec(start, tinytac_metrics_now()));
+      TinyTacProbe2(failover, (int)idx, TTAC_EUNAVAIL);
+   };
+
+   return(TTAC_EUNAVAIL);
+}
+
+
+/// sends request packet and receives the matching reply packet
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  servers       referenced set of servers of handle or NULL
+/// @param[in]  metrics       metrics of server connected to socket or NULL
+/// @param[in]  s             socket connected to TACACS+ server or -1 to
+///                           connect to configured servers
+/// @param[in]  req           request packet (obfuscated in place when sent)
+/// @param[out] replyp        pointer to store un-obfuscated reply packet
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_net_exchange(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t *           metrics,
          int                           s,
-         unsigned                      peer )
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp )
 {
-   struct sockaddr_storage    sa;
-   socklen_t                  sa_len;
-   char                       addrstr[INET6_ADDRSTRLEN];
-   static char                buff[INET6_ADDRSTRLEN+16];
-   int                        port;
+   int                  rc;
+   uint32_t             session_id;
+   uint8_t              seq_no;
+   uint8_t              type;
+   uint64_t             sent;
+   uint64_t             start;
+   char *               key;
+   tinytac_pckt_t *     reply;
 
-   sa_len = sizeof(sa);
-   if ((peer))
+   TinyTacDebugTrace();
+
+   assert(req    != NULL);
+   assert(replyp != NULL);
+
+   if (s == -1)
    {
-      if (getpeername(s, (struct sockaddr *)&sa, &sa_len) == -1)
-         return(NULL);
-   } else {
-      if (getsockname(s, (struct sockaddr *)&sa, &sa_len) == -1)
-         return(NULL);
+      if ((rc = tinytac_net_connect(tt, servers, &s, &metrics)) != TTAC_SUCCESS)
+      {
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_REQUESTS, 1);
+         tinytac_metrics_add(tt, NULL, TTAC_STAT_FAILURES, 1);
+         return(rc);
+      };
+      rc = tinytac_net_exchange(tt, servers, metrics, s, req, replyp);
+      close(s);
+      return(rc);
    };
 
-   switch(sa.ss_family)
+   key         = tinytac_net_key(servers);
+   session_id  = req->pckt_session_id;
+   seq_no      = req->pckt_seq_no;
+   type        = req->pckt_type;
+   rc          = TTAC_SUCCESS;
+
+   tinytac_metrics_add(tt, metrics, TTAC_STAT_REQUESTS, 1);
+   tinytac_trace_session(ntohl(session_id));
+   TinyTacProbe3(request__start, ntohl(session_id), TTAC_METRICS_SERVER(metrics), ntohl(req->pckt_length));
+   start = (TinyTacProbeEnabled(request__done)) ? tinytac_metrics_now() : 0;
+
+   if (tinytac_net_send(tt, metrics, s, key, req, &sent) == -1)
+      rc = TTAC_ENETWORK;
+   else if (tinytac_net_recv(tt, metrics, s, key, &reply, sent) == -1)
+      rc = (errno == EBADMSG) ? TTAC_EBADMSG : TTAC_ENETWORK;
+   else if ( (reply->pckt_session_id != session_id) ||
+             (reply->pckt_type       != type) ||
+             (reply->pckt_seq_no     != ((seq_no + 1) & 0xff)) )
    {
-      case AF_INET:
-      inet_ntop(AF_INET, &((const struct sockaddr_in *)&sa)->sin_addr, addrstr, sizeof(addrstr));
-      port = ntohs(((const struct sockaddr_in *)&sa)->sin_port);
-      snprintf(buff, (sizeof(buff)-1), "%s:%i", addrstr, port);
-      break;
+      tinytac_mem_free(reply);
+      rc = TTAC_EBADMSG;
+   };
+   if (TinyTacProbeEnabled(request__done))
+      TinyTacProbe4(request__done, ntohl(session_id), TTAC_METRICS_SERVER(metrics), rc, TinyTacProbeUsec(start, tinytac_metrics_now()));
+   if (rc != TTAC_SUCCESS)
+   {
+      tinytac_metrics_add(tt, metrics, TTAC_STAT_FAILURES, 1);
+      return(rc);
+   };
 
-      case AF_INET6:
-      inet_ntop(AF_INET6, &((const struct sockaddr_in6 *)&sa)->sin6_addr, addrstr, sizeof(addrstr));
-      port = ntohs(((const struct sockaddr_in6 *)&sa)->sin6_port);
-      snprintf(buff, (sizeof(buff)-1), "[%s]:%i", addrstr, port);
-      break;
+   *replyp = reply;
 
-      default:
-      return(NULL);
+   return(TTAC_SUCCESS);
+}
+
+
+char *
+tinytac_net_key(
+         tinytac_servers_t *           servers )
+{
+   static char          empty[] = "";
+   if (!(servers))
+      return(empty);
+   if ( (!(servers->keys)) || (!(servers->keys[0])) )
+      return(empty);
+   return(servers->keys[0]);
+}
+
+
+/// tests whether connection remains valid for replacing set of servers
+///
+/// A connection to the local proxy, or to servers of a set whose servers
+/// were not replaced, is kept.  Otherwise the connection is kept only if
+/// its server is listed in the new set and the address of the connection
+/// is still an address of the server.  The metrics of the server in the
+/// new set are stored to metricsp.
+///
+/// @param[in]  servers       set of servers of connection
+/// @param[out] metricsp      metrics of server of connection
+/// @param[in]  next          replacing set of servers
+/// @param[in]  s             connected socket
+///
+/// @return    Returns TTAC_YES if connection is kept, otherwise TTAC_NO.
+int
+tinytac_net_keep(
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t **          metricsp,
+         tinytac_servers_t *           next,
+         int                           s )
+{
+   size_t                  idx;
+   size_t                  cur;
+   socklen_t               len;
+   struct sockaddr_storage sa;
+   struct addrinfo *       ai;
+   BindleURLDesc *         budp;
+
+   TinyTacDebugTrace();
+
+   len = sizeof(sa);
+   if (getpeername(s, (struct sockaddr *)&sa, &len) == -1)
+      return(TTAC_NO);
+   if (sa.ss_family == AF_UNIX)
+      return(TTAC_YES);
+
+   if (servers->hosts_part == next->hosts_part)
+      return(TTAC_YES);
+   if ( (!(servers->budps)) || (!(servers->metrics)) || (!(*metricsp)) || (!(next->budps)) )
+      return(TTAC_NO);
+
+   cur  = (size_t)(*metricsp - servers->metrics);
+   budp = servers->budps[cur];
+   for(idx = 0; ((next->budps[idx])); idx++)
+   {
+      if ( (next->budps[idx]->bud_port != budp->bud_port) || (!(next->budps[idx]->bud_host)) || (!(budp->bud_host)) )
+         continue;
+      if ((strcasecmp(next->budps[idx]->bud_host, budp->bud_host)))
+         continue;
+
+      // server which could not be resolved again keeps its connection
+      if ( ((next->addrs)) && ((next->addrs[idx])) )
+      {
+         for(ai = next->addrs[idx]; ((ai)); ai = ai->ai_next)
+            if ( (ai->ai_addrlen == len) && (!(memcmp(ai->ai_addr, &sa, len))) )
+               break;
+         if (!(ai))
+            return(TTAC_NO);
+      };
+
+      *metricsp = ((next->metrics)) ? &next->metrics[idx] : NULL;
+      return(TTAC_YES);
    };
-   buff[sizeof(buff)-1] = '\0';
 
-   return(buff);
+   return(TTAC_NO);
 }
 
 
+/// reads packet from connection and de-obfuscates it
+///
+/// @param[in]  tt            reference to library handle or NULL
+/// @param[in]  metrics       metrics of server connected to socket or NULL
+/// @param[in]  s             connected socket
+/// @param[in]  key           obfuscation key
+/// @param[out] pcktp         pointer to store un-obfuscated packet
+/// @param[in]  sent          time request was written or 0 if the reply
+///                           is not timed
+///
+/// @return    Returns 0 on success or -1 on error.
 int
-tinytac_recv(
+tinytac_net_recv(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           metrics,
          int                           s,
          char *                        key,
-         tinytac_pckt_t **             pcktp )
+         tinytac_pckt_t **             pcktp,
+         uint64_t                      sent )
 {
    size_t               pckt_len;
    ssize_t              rc;
+   uint64_t             start;
    tinytac_pckt_t *     pckt;
    void *               ptr;
 
    pckt_len = sizeof(tinytac_pckt_t);
 
-   if ((pckt = malloc(pckt_len)) == NULL)
+   if ((pckt = tinytac_mem_alloc(pckt_len)) == NULL)
       return(-1);
 
-   if ((rc = recv(s, pckt, pckt_len, 0)) == -1)
+   if ((rc = recv(s, pckt, pckt_len, MSG_WAITALL)) == -1)
    {
-      free(pckt);
+      if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+         tinytac_metrics_add(tt, metrics, TTAC_STAT_TIMEOUTS, 1);
+      tinytac_mem_free(pckt);
       return(-1);
    };
    if (((size_t)rc) != pckt_len)
    {
-      free(pckt);
+      tinytac_mem_free(pckt);
       errno = EBADMSG;
       return(-1);
    };
+   if ((sent))
+      tinytac_metrics_phase(tt, metrics, TTAC_PHASE_FIRST_BYTE, sent);
 
    pckt_len = ntohl(pckt->pckt_length) + sizeof(tinytac_pckt_t);
-   if ((ptr = realloc(pckt, pckt_len)) == NULL)
+   if ((ptr = tinytac_mem_realloc(pckt, pckt_len)) == NULL)
    {
-      free(pckt);
+      tinytac_mem_free(pckt);
       return(-1);
    };
    pckt = ptr;
 
-   if ((rc = recv(s, pckt->pckt_body, ntohl(pckt->pckt_length), 0)) == -1)
+   if ((rc = recv(s, pckt->pckt_body, ntohl(pckt->pckt_length), MSG_WAITALL)) == -1)
    {
-      free(pckt);
+      if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+         tinytac_metrics_add(tt, metrics, TTAC_STAT_TIMEOUTS, 1);
+      tinytac_mem_free(pckt);
       return(-1);
    };
    if (((size_t)rc) != ntohl(pckt->pckt_length))
    {
-      free(pckt);
+      tinytac_mem_free(pckt);
       errno = EBADMSG;
       return(-1);
    };
+   if ((sent))
+   {
+      start = tinytac_metrics_phase(tt, metrics, TTAC_PHASE_REPLY, sent);
+      TinyTacProbe4(recv, ntohl(pckt->pckt_session_id), TTAC_METRICS_SERVER(metrics), pckt_len, TinyTacProbeUsec(sent, start));
+   };
 
-   tinytac_pckt_obfuscate(pckt, key, strlen(key), TTAC_NO);
+   tinytac_capture(s, pckt, TTAC_CAPTURE_RECV);
+   tinytac_pckt_obfuscate(pckt, key, strlen(key), TTAC_YES);
+   if ((sent))
+      tinytac_metrics_phase(tt, metrics, TTAC_PHASE_DEOBFUSCATE, start);
+   if ( ((sent)) && (TinyTacProbeEnabled(deobfuscate)) )
+      TinyTacProbe3(deobfuscate, ntohl(pckt->pckt_session_id), pckt_len, TinyTacProbeUsec(start, tinytac_metrics_now()));
+   tinytac_capture(s, pckt, (TTAC_CAPTURE_RECV | TTAC_CAPTURE_PLAIN));
 
    *pcktp = pckt;
 
@@ -171,25 +605,162 @@ tinytac_recv(
 }
 
 
+/// obfuscates packet and writes it to connection
+///
+/// @param[in]  tt            reference to library handle or NULL
+/// @param[in]  metrics       metrics of server connected to socket or NULL
+/// @param[in]  s             connected socket
+/// @param[in]  key           obfuscation key
+/// @param[in]  pckt          packet (obfuscated in place)
+/// @param[out] sentp         pointer to store time packet was written or NULL
+///
+/// @return    Returns 0 on success or -1 on error.
 int
-tinytac_send(
+tinytac_net_send(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           metrics,
          int                           s,
          char *                        key,
-         tinytac_pckt_t *              pckt )
+         tinytac_pckt_t *              pckt,
+         uint64_t *                    sentp )
 {
    size_t   pckt_len;
    ssize_t  rc;
-   tinytac_pckt_obfuscate(pckt, key, strlen(key), TTAC_YES);
+   uint64_t start;
+   tinytac_capture(s, pckt, (TTAC_CAPTURE_SENT | TTAC_CAPTURE_PLAIN));
+   tinytac_pckt_obfuscate(pckt, key, strlen(key), TTAC_NO);
+   tinytac_capture(s, pckt, TTAC_CAPTURE_SENT);
    pckt_len = ntohl(pckt->pckt_length) + sizeof(tinytac_pckt_t);
-   if ((rc = send(s, pckt, pckt_len, 0)) == -1)
+   start    = ((sentp)) ? tinytac_metrics_now() : 0;
+   if ((rc = send(s, pckt, pckt_len, MSG_NOSIGNAL)) == -1)
+   {
+      if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+         tinytac_metrics_add(tt, metrics, TTAC_STAT_TIMEOUTS, 1);
       return(-1);
+   };
    if (((size_t)rc) != pckt_len)
    {
       errno = EBADMSG;
       return(-1);
    };
+   if ((sentp))
+   {
+      *sentp = tinytac_metrics_phase(tt, metrics, TTAC_PHASE_SEND, start);
+      TinyTacProbe4(send, ntohl(pckt->pckt_session_id), TTAC_METRICS_SERVER(metrics), pckt_len, TinyTacProbeUsec(start, *sentp));
+   };
+   return(0);
+}
+
+
+/// writes packets to connection with a single system call where possible
+///
+/// @param[in]  s             connected socket
+/// @param[in]  iov           packets to write
+/// @param[in]  cnt           number of packets
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+tinytac_net_sendv(
+         int                           s,
+         struct iovec *                iov,
+         size_t                        cnt )
+{
+   ssize_t              rc;
+   struct msghdr        msg;
+
+   tinytac_capture_iov(s, iov, cnt, TTAC_CAPTURE_SENT);
+
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov    = iov;
+   msg.msg_iovlen = cnt;
+
+   while (msg.msg_iovlen > 0)
+   {
+      if ((rc = sendmsg(s, &msg, MSG_NOSIGNAL)) == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         return(-1);
+      };
+      while ( (msg.msg_iovlen > 0) && (((size_t)rc) >= msg.msg_iov->iov_len) )
+      {
+         rc -= (ssize_t)msg.msg_iov->iov_len;
+         msg.msg_iov++;
+         msg.msg_iovlen--;
+      };
+      if (msg.msg_iovlen > 0)
+      {
+         msg.msg_iov->iov_base  = ((char *)msg.msg_iov->iov_base) + rc;
+         msg.msg_iov->iov_len  -= (size_t)rc;
+      };
+   };
+
    return(0);
 }
 
 
+char *
+tinytac_ntop(
+         int                           s,
+         unsigned                      peer )
+{
+   struct sockaddr_storage    sa;
+   socklen_t                  sa_len;
+   char                       addrstr[INET6_ADDRSTRLEN];
+   static char                buff[INET6_ADDRSTRLEN+16];
+   int                        port;
+
+   sa_len = sizeof(sa);
+   if ((peer))
+   {
+      if (getpeername(s, (struct sockaddr *)&sa, &sa_len) == -1)
+         return(NULL);
+   } else {
+      if (getsockname(s, (struct sockaddr *)&sa, &sa_len) == -1)
+         return(NULL);
+   };
+
+   switch(sa.ss_family)
+   {
+      case AF_INET:
+      inet_ntop(AF_INET, &((const struct sockaddr_in *)&sa)->sin_addr, addrstr, sizeof(addrstr));
+      port = ntohs(((const struct sockaddr_in *)&sa)->sin_port);
+      snprintf(buff, (sizeof(buff)-1), "%s:%i", addrstr, port);
+      break;
+
+      case AF_INET6:
+      inet_ntop(AF_INET6, &((const struct sockaddr_in6 *)&sa)->sin6_addr, addrstr, sizeof(addrstr));
+      port = ntohs(((const struct sockaddr_in6 *)&sa)->sin6_port);
+      snprintf(buff, (sizeof(buff)-1), "[%s]:%i", addrstr, port);
+      break;
+
+      default:
+      return(NULL);
+   };
+   buff[sizeof(buff)-1] = '\0';
+
+   return(buff);
+}
+
+
+int
+tinytac_recv(
+         int                           s,
+         char *                        key,
+         tinytac_pckt_t **             pcktp )
+{
+   return(tinytac_net_recv(NULL, NULL, s, key, pcktp, 0));
+}
+
+
+int
+tinytac_send(
+         int                           s,
+         char *                        key,
+         tinytac_pckt_t *              pckt )
+{
+   return(tinytac_net_send(NULL, NULL, s, key, pckt, NULL));
+}
+
+
 /* end of source */
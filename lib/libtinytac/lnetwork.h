@@ -41,6 +41,8 @@
 
 #include "libtinytac.h"
 
+#include <sys/uio.h>
+
 
 ///////////////////
 //               //
@@ -57,6 +59,64 @@
 //////////////////
 #pragma mark - Prototypes
 
+int
+tinytac_net_connect(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         int *                         sp,
+         tinytac_metrics_t **          metricsp );
+
+
+int
+tinytac_net_exchange(
+         TinyTac *                     tt,
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t *           metrics,
+         int                           s,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp );
+
+
+char *
+tinytac_net_key(
+         tinytac_servers_t *           servers );
+
+
+int
+tinytac_net_keep(
+         tinytac_servers_t *           servers,
+         tinytac_metrics_t **          metricsp,
+         tinytac_servers_t *           next,
+         int                           s );
+
+
+int
+tinytac_net_recv(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           metrics,
+         int                           s,
+         char *                        key,
+         tinytac_pckt_t **             pcktp,
+         uint64_t                      sent );
+
+
+int
+tinytac_net_send(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           metrics,
+         int                           s,
+         char *                        key,
+         tinytac_pckt_t *              pckt,
+         uint64_t *                    sentp );
+
+
+int
+tinytac_net_sendv(
+         int                           s,
+         struct iovec *                iov,
+         size_t                        cnt );
+
+
 char *
 tinytac_ntop(
          int                           s,
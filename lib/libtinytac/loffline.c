@@ -0,0 +1,326 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LOFFLINE_C 1
+#include "loffline.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <assert.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// On-disk verifier, one file per user.  The file is only read by the host
+// which wrote it and is stored in host byte order.
+typedef struct _tinytac_offline_rec
+{
+   uint8_t                 magic[8];
+   uint32_t                iterations;
+   uint32_t                failures;   // consecutive offline failures
+   int64_t                 created;    // time of last successful online login
+   uint8_t                 salt[TTAC_OFFLINE_SALT_LEN];
+   uint8_t                 hash[TTAC_OFFLINE_HASH_LEN];
+} tinytac_offline_rec_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static int
+tinytac_offline_hash(
+         const char *                  pass,
+         const tinytac_offline_rec_t * rec,
+         uint8_t *                     hash );
+
+
+static int
+tinytac_offline_path(
+         TinyTac *                     tt,
+         const char *                  user,
+         char *                        path,
+         size_t                        path_len );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//--------------------------//
+// offline authen functions //
+//--------------------------//
+#pragma mark offline authen functions
+
+/// derives password hash using the salt and iterations of the verifier
+int
+tinytac_offline_hash(
+         const char *                  pass,
+         const tinytac_offline_rec_t * rec,
+         uint8_t *                     hash )
+{
+   if (!(PKCS5_PBKDF2_HMAC(pass, (int)strlen(pass), rec->salt, sizeof(rec->salt), (int)rec->iterations, EVP_sha256(), TTAC_OFFLINE_HASH_LEN, hash)))
+      return(TTAC_EUNKNOWN);
+   return(TTAC_SUCCESS);
+}
+
+
+/// builds path of verifier file from SHA-256 of user name
+int
+tinytac_offline_path(
+         TinyTac *                     tt,
+         const char *                  user,
+         char *                        path,
+         size_t                        path_len )
+{
+   size_t            pos;
+   size_t            off;
+   unsigned          md_len;
+   uint8_t           md[EVP_MAX_MD_SIZE];
+
+   if (!(EVP_Digest(user, strlen(user), md, &md_len, EVP_sha256(), NULL)))
+      return(TTAC_EUNKNOWN);
+
+   off = (size_t)snprintf(path, path_len, "%s/", tt->offline_dir);
+   if ((off + (md_len * 2) + 1) > path_len)
+      return(TTAC_ENOBUFS);
+   for(pos = 0; (pos < md_len); pos++)
+      snprintf(&path[off + (pos * 2)], 3, "%02x", md[pos]);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// stores verifier of password after successful online authentication
+///
+/// The verifier replaces any previous verifier of the user, which also
+/// resets the user's offline failure counter.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  user          user name
+/// @param[in]  pass          password accepted by the server
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_offline_store(
+         TinyTac *                     tt,
+         const char *                  user,
+         const char *                  pass )
+{
+   int                     rc;
+   int                     fd;
+   char                    path[TTAC_LINE_MAX_LEN*2];
+   char                    tmp[TTAC_LINE_MAX_LEN*2+8];
+   tinytac_offline_rec_t   rec;
+
+   TinyTacDebugTrace();
+
+   assert(tt   != NULL);
+   assert(user != NULL);
+   assert(pass != NULL);
+
+   if ( (!(tt->offline_dir)) || (!(pass[0])) )
+      return(TTAC_SUCCESS);
+
+   if ((rc = tinytac_offline_path(tt, user, path, sizeof(path))) != TTAC_SUCCESS)
+      return(rc);
+
+   memset(&rec, 0, sizeof(rec));
+   memcpy(rec.magic, TTAC_OFFLINE_MAGIC, sizeof(rec.magic));
+   rec.iterations = TTAC_OFFLINE_ITERATIONS;
+   rec.failures   = 0;
+   rec.created    = (int64_t)time(NULL);
+   if (RAND_bytes(rec.salt, sizeof(rec.salt)) != 1)
+      return(TTAC_EUNKNOWN);
+   if ((rc = tinytac_offline_hash(pass, &rec, rec.hash)) != TTAC_SUCCESS)
+      return(rc);
+
+   // write new verifier and atomically replace previous verifier
+   snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+   if ((fd = mkstemp(tmp)) == -1)
+      return(TTAC_EACCES);
+   fchmod(fd, S_IRUSR | S_IWUSR);
+   if ( (write(fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) || (fsync(fd) == -1) )
+   {
+      close(fd);
+      unlink(tmp);
+      return(TTAC_EUNKNOWN);
+   };
+   close(fd);
+   if (rename(tmp, path) == -1)
+   {
+      unlink(tmp);
+      return(TTAC_EACCES);
+   };
+   OPENSSL_cleanse(&rec, sizeof(rec));
+
+   // persist directory entry so a crash does not lose the new verifier
+   if ((fd = open(tt->offline_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) != -1)
+   {
+      fsync(fd);
+      close(fd);
+   };
+
+   TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): stored verifier for %s", __func__, user);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// verifies password against stored verifier while servers are unavailable
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  user          user name
+/// @param[in]  pass          password to verify
+///
+/// @return    Returns TTAC_SUCCESS if the password matches, TTAC_EACCES if
+///            the password does not match or the user is locked out, or
+///            TTAC_EUNAVAIL if no usable verifier exists.
+int
+tinytac_offline_verify(
+         TinyTac *                     tt,
+         const char *                  user,
+         const char *                  pass )
+{
+   int                     rc;
+   int                     fd;
+   int64_t                 age;
+   char                    path[TTAC_LINE_MAX_LEN*2];
+   uint8_t                 hash[TTAC_OFFLINE_HASH_LEN];
+   struct stat             sb;
+   tinytac_offline_rec_t   rec;
+
+   TinyTacDebugTrace();
+
+   assert(tt   != NULL);
+   assert(user != NULL);
+   assert(pass != NULL);
+
+   if (!(tt->offline_dir))
+      return(TTAC_EUNAVAIL);
+   if ((rc = tinytac_offline_path(tt, user, path, sizeof(path))) != TTAC_SUCCESS)
+      return(rc);
+
+   // open verifier and serialize failure counter updates
+   if ((fd = open(path, O_RDWR | O_NOFOLLOW | O_CLOEXEC)) == -1)
+      return(TTAC_EUNAVAIL);
+   if ( (fstat(fd, &sb) == -1) || (sb.st_uid != geteuid()) || ((sb.st_mode & (S_IWGRP | S_IWOTH))) )
+   {
+      close(fd);
+      return(TTAC_EUNAVAIL);
+   };
+   if (flock(fd, LOCK_EX) == -1)
+   {
+      close(fd);
+      return(TTAC_EUNAVAIL);
+   };
+   if (pread(fd, &rec, sizeof(rec), 0) != (ssize_t)sizeof(rec))
+   {
+      close(fd);
+      return(TTAC_EUNAVAIL);
+   };
+   if ( ((memcmp(rec.magic, TTAC_OFFLINE_MAGIC, sizeof(rec.magic)))) ||
+        (rec.iterations < 1) || (rec.iterations > (TTAC_OFFLINE_ITERATIONS * 10)) )
+   {
+      close(fd);
+      return(TTAC_EUNAVAIL);
+   };
+
+   // check staleness and lockout
+   age = (int64_t)time(NULL) - rec.created;
+   if ( ((tt->offline_max_age)) && (age > (int64_t)tt->offline_max_age) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): verifier for %s is stale", __func__, user);
+      close(fd);
+      return(TTAC_EUNAVAIL);
+   };
+   if ( ((tt->offline_lockout)) && (rec.failures >= (uint32_t)tt->offline_lockout) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s is locked out", __func__, user);
+      close(fd);
+      return(TTAC_EACCES);
+   };
+
+   // verify password
+   if ((rc = tinytac_offline_hash(pass, &rec, hash)) != TTAC_SUCCESS)
+   {
+      close(fd);
+      return(rc);
+   };
+   if ( (!(pass[0])) || ((CRYPTO_memcmp(hash, rec.hash, sizeof(hash)))) )
+   {
+      rec.failures++;
+      rc = TTAC_EACCES;
+   } else
+   {
+      rec.failures = 0;
+      rc = TTAC_SUCCESS;
+   };
+   if (pwrite(fd, &rec.failures, sizeof(rec.failures), offsetof(tinytac_offline_rec_t, failures)) == -1)
+      rc = TTAC_EACCES;
+   close(fd);
+
+   OPENSSL_cleanse(hash, sizeof(hash));
+
+   TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): offline authentication of %s %s", __func__, user, ((rc == TTAC_SUCCESS) ? "passed" : "failed"));
+
+   return(rc);
+}
+
+/* end of source */
@@ -0,0 +1,57 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LPROBE_C 1
+#include "lprobe.h"
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// semaphores are incremented by tracers attached to the matching probe
+#ifdef HAVE_SYS_SDT_H
+#define TTAC_PROBE_SEMAPHORE __attribute__((section(".probes")))
+unsigned short tinytac_cache__hit_semaphore       TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_cache__miss_semaphore      TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_connect_semaphore          TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_deobfuscate_semaphore      TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_failover_semaphore         TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_recv_semaphore             TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_request__done_semaphore    TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_request__start_semaphore   TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_retry_semaphore            TTAC_PROBE_SEMAPHORE = 0;
+unsigned short tinytac_send_semaphore             TTAC_PROBE_SEMAPHORE = 0;
+#endif
+
+/* end of source */
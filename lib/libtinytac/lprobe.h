@@ -0,0 +1,115 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LPROBE_H
+#define _LIB_LIBTINYTAC_LPROBE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+#ifdef HAVE_SYS_SDT_H
+#   define _SDT_HAS_SEMAPHORES 1
+#   include <sys/sdt.h>
+#endif
+
+
+//////////////
+//          //
+//  Macros  //
+//          //
+//////////////
+#pragma mark - Macros
+
+// USDT probes of provider "tinytac".  A probe is a single nop until a
+// tracer attaches.  Arguments which are expensive to compute are guarded by
+// TinyTacProbeEnabled(), which tests the semaphore a tracer increments.
+// Without <sys/sdt.h> the arguments are only type checked, not evaluated.
+#ifdef HAVE_SYS_SDT_H
+#   define TinyTacProbeEnabled( name )              (__builtin_expect(tinytac_##name##_semaphore, 0))
+#   define TinyTacProbe1( name, a1 )                STAP_PROBE1(tinytac, name, a1)
+#   define TinyTacProbe2( name, a1, a2 )            STAP_PROBE2(tinytac, name, a1, a2)
+#   define TinyTacProbe3( name, a1, a2, a3 )        STAP_PROBE3(tinytac, name, a1, a2, a3)
+#   define TinyTacProbe4( name, a1, a2, a3, a4 )    STAP_PROBE4(tinytac, name, a1, a2, a3, a4)
+#else
+#   define TinyTacProbeEnabled( name )              (0)
+#   define TinyTacProbe1( name, a1 )                ((void)sizeof(a1))
+#   define TinyTacProbe2( name, a1, a2 )            ((void)(sizeof(a1) + sizeof(a2)))
+#   define TinyTacProbe3( name, a1, a2, a3 )        ((void)(sizeof(a1) + sizeof(a2) + sizeof(a3)))
+#   define TinyTacProbe4( name, a1, a2, a3, a4 )    ((void)(sizeof(a1) + sizeof(a2) + sizeof(a3) + sizeof(a4)))
+#endif
+
+// microseconds between monotonic times of tinytac_metrics_now()
+#define TinyTacProbeUsec( start, end )             ((unsigned long)(((end) - (start)) / 1000))
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// Probes and their arguments:
+//
+//    request__start    session_id, server, length of request
+//    request__done     session_id, server, result code, usec
+//    connect           server, result code, usec
+//    send              session_id, server, bytes, usec
+//    recv              session_id, server, bytes, usec since request was sent
+//    deobfuscate       session_id, bytes, usec
+//    retry             server, attempt
+//    failover          server, result code
+//    cache__hit        session_id
+//    cache__miss       session_id
+//
+// The server is the position of the server in the list of hosts, or -1 for
+// the local proxy and sockets connected by the application.
+#ifdef HAVE_SYS_SDT_H
+extern unsigned short   tinytac_cache__hit_semaphore;
+extern unsigned short   tinytac_cache__miss_semaphore;
+extern unsigned short   tinytac_connect_semaphore;
+extern unsigned short   tinytac_deobfuscate_semaphore;
+extern unsigned short   tinytac_failover_semaphore;
+extern unsigned short   tinytac_recv_semaphore;
+extern unsigned short   tinytac_request__done_semaphore;
+extern unsigned short   tinytac_request__start_semaphore;
+extern unsigned short   tinytac_retry_semaphore;
+extern unsigned short   tinytac_send_semaphore;
+#endif
+
+
+#endif /* end of header */
@@ -54,6 +54,8 @@
 #include <assert.h>
 #include <openssl/evp.h>
 
+#include "lmemory.h"
+
 
 //////////////////
 //              //
@@ -62,12 +64,26 @@
 //////////////////
 #pragma mark - Prototypes
 
-extern tinytac_pckt_t *
-tinytac_pckt_alloc(
+static void
+tinytac_pckt_md5pad_ctx(
+         EVP_MD_CTX *                  mdctx,
+         const tinytac_pckt_t *        pckt,
+         const char *                  key,
+         size_t                        key_len,
+         const uint8_t *               md5pad_prev,
+         uint8_t *                     md5pad );
+
+
+static int
+tinytac_pckt_req(
+         TinyTac *                     tt,
          uint8_t                       pckt_type,
-         uint8_t                       seq_no,
-         uint32_t                      session_id,
-         size_t                        nbytes );
+         size_t                        hdr_len,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp );
 
 
 /////////////////
@@ -77,6 +93,36 @@ tinytac_pckt_alloc(
 /////////////////
 #pragma mark - Functions
 
+//----------------//
+// hash functions //
+//----------------//
+#pragma mark hash functions
+
+/// computes 64-bit FNV-1a hash of data
+///
+/// @param[in]  hash          previous hash value or TTAC_HASH_INIT
+/// @param[in]  data          data to hash
+/// @param[in]  len           length of data
+///
+/// @return    Returns updated hash value.
+uint64_t
+tinytac_hash(
+         uint64_t                      hash,
+         const void *                  data,
+         size_t                        len )
+{
+   const uint8_t *   bytes;
+   size_t            pos;
+   bytes = data;
+   for(pos = 0; (pos < len); pos++)
+   {
+      hash ^= bytes[pos];
+      hash *= 0x100000001b3ULL;
+   };
+   return(hash);
+}
+
+
 //------------------//
 // packet functions //
 //------------------//
@@ -94,9 +140,9 @@ tinytac_pckt_alloc(
 
    size = sizeof(tinytac_pckt_t) + nbytes;
 
-   if ((pckt = malloc(size)) == NULL)
+   // body is not zeroed, callers write every byte of the body
+   if ((pckt = tinytac_mem_alloc(size)) == NULL)
       return(NULL);
-   memset(pckt, 0, size);
    pckt->pckt_version      = TTAC_VERSION(TAC_PLUS_MAJOR_VER, TAC_PLUS_MINOR_VER_DEFAULT);
    pckt->pckt_type         = pckt_type;
    pckt->pckt_seq_no       = seq_no;
@@ -108,6 +154,270 @@ tinytac_pckt_alloc(
 }
 
 
+int
+tinytac_pckt_acct_req(
+         TinyTac *                     tt,
+         uint8_t                       flags,
+         uint8_t                       authen_method,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp )
+{
+   int                     rc;
+   tinytac_acct_req_t *    bdy;
+
+   TinyTacDebugTrace();
+
+   assert(tt    != NULL);
+   assert(pcktp != NULL);
+
+   if ((rc = tinytac_pckt_req(tt, TAC_PLUS_TYPE_ACCT, sizeof(tinytac_acct_req_t), user, port, rem_addr, args, pcktp)) != TTAC_SUCCESS)
+      return(rc);
+
+   bdy                        = (tinytac_acct_req_t *)(*pcktp)->pckt_body;
+   bdy->bdy_flags             = flags;
+   bdy->bdy_authen_method     = authen_method;
+   bdy->bdy_priv_lvl          = priv_lvl;
+   bdy->bdy_authen_type       = authen_type;
+   bdy->bdy_authen_service    = authen_service;
+
+   return(TTAC_SUCCESS);
+}
+
+
+int
+tinytac_pckt_authen_start(
+         TinyTac *                     tt,
+         uint8_t                       action,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const void *                  data,
+         size_t                        data_len,
+         tinytac_pckt_t **             pcktp )
+{
+   size_t                     user_len;
+   size_t                     port_len;
+   size_t                     rem_addr_len;
+   uint8_t *                  ptr;
+   tinytac_pckt_t *           pckt;
+   tinytac_authen_start_t *   bdy;
+
+   TinyTacDebugTrace();
+
+   assert(tt    != NULL);
+   assert(pcktp != NULL);
+
+   user           = ((user))     ? user     : "";
+   port           = ((port))     ? port     : "";
+   rem_addr       = ((rem_addr)) ? rem_addr : "";
+   user_len       = strlen(user);
+   port_len       = strlen(port);
+   rem_addr_len   = strlen(rem_addr);
+   data_len       = ((data))     ? data_len : 0;
+   data           = ((data))     ? data     : "";
+   if ( (user_len > 255) || (port_len > 255) || (rem_addr_len > 255) || (data_len > 255) )
+      return(TTAC_EINVAL);
+
+   if ((pckt = tinytac_pckt_alloc(TAC_PLUS_TYPE_AUTHEN, 1, tinytac_pckt_session_id(tt), (sizeof(tinytac_authen_start_t) + user_len + port_len + rem_addr_len + data_len))) == NULL)
+      return(TTAC_ENOMEM);
+   if (authen_type != TAC_PLUS_AUTHEN_TYPE_ASCII)
+      pckt->pckt_version = TTAC_VERSION(TAC_PLUS_MAJOR_VER, TAC_PLUS_MINOR_VER_ONE);
+
+   bdy                        = (tinytac_authen_start_t *)pckt->pckt_body;
+   bdy->bdy_action            = action;
+   bdy->bdy_priv_lvl          = priv_lvl;
+   bdy->bdy_authen_type       = authen_type;
+   bdy->bdy_authen_service    = authen_service;
+   bdy->bdy_user_len          = (uint8_t)user_len;
+   bdy->bdy_port_len          = (uint8_t)port_len;
+   bdy->bdy_rem_addr_len      = (uint8_t)rem_addr_len;
+   bdy->bdy_data_len          = (uint8_t)data_len;
+
+   ptr = bdy->bdy_bytes;
+   memcpy(ptr, user,     user_len);     ptr += user_len;
+   memcpy(ptr, port,     port_len);     ptr += port_len;
+   memcpy(ptr, rem_addr, rem_addr_len); ptr += rem_addr_len;
+   memcpy(ptr, data,     data_len);
+
+   *pcktp = pckt;
+
+   return(TTAC_SUCCESS);
+}
+
+
+int
+tinytac_pckt_author_req(
+         TinyTac *                     tt,
+         uint8_t                       authen_method,
+         uint8_t                       priv_lvl,
+         uint8_t                       authen_type,
+         uint8_t                       authen_service,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp )
+{
+   int                     rc;
+   tinytac_author_req_t *  bdy;
+
+   TinyTacDebugTrace();
+
+   assert(tt    != NULL);
+   assert(pcktp != NULL);
+
+   if ((rc = tinytac_pckt_req(tt, TAC_PLUS_TYPE_AUTHOR, sizeof(tinytac_author_req_t), user, port, rem_addr, args, pcktp)) != TTAC_SUCCESS)
+      return(rc);
+
+   bdy                        = (tinytac_author_req_t *)(*pcktp)->pckt_body;
+   bdy->bdy_authen_method     = authen_method;
+   bdy->bdy_priv_lvl          = priv_lvl;
+   bdy->bdy_authen_type       = authen_type;
+   bdy->bdy_authen_service    = authen_service;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// builds body of authorization or accounting REQUEST
+///
+/// Both bodies end their fixed header with user_len, port_len,
+/// rem_addr_len and arg_cnt followed by the argument lengths and the
+/// variable fields.  The leading fields of the header are left to the
+/// caller.
+int
+tinytac_pckt_req(
+         TinyTac *                     tt,
+         uint8_t                       pckt_type,
+         size_t                        hdr_len,
+         const char *                  user,
+         const char *                  port,
+         const char *                  rem_addr,
+         const char * const *          args,
+         tinytac_pckt_t **             pcktp )
+{
+   size_t               user_len;
+   size_t               port_len;
+   size_t               rem_addr_len;
+   size_t               arg_cnt;
+   size_t               arg_len;
+   size_t               len;
+   size_t               pos;
+   uint8_t              arg_lens[255];
+   uint8_t *            hdr;
+   uint8_t *            ptr;
+   tinytac_pckt_t *     pckt;
+
+   user           = ((user))     ? user     : "";
+   port           = ((port))     ? port     : "";
+   rem_addr       = ((rem_addr)) ? rem_addr : "";
+   user_len       = strlen(user);
+   port_len       = strlen(port);
+   rem_addr_len   = strlen(rem_addr);
+   if ( (user_len > 255) || (port_len > 255) || (rem_addr_len > 255) )
+      return(TTAC_EINVAL);
+
+   // size and validate arguments in a single pass
+   arg_len = 0;
+   for(arg_cnt = 0; ( ((args)) && ((args[arg_cnt])) ); arg_cnt++)
+   {
+      if (arg_cnt == 255)
+         return(TTAC_EINVAL);
+      if ((len = strlen(args[arg_cnt])) > 255)
+         return(TTAC_EINVAL);
+      arg_lens[arg_cnt]  = (uint8_t)len;
+      arg_len           += len;
+   };
+
+   len = hdr_len + arg_cnt + user_len + port_len + rem_addr_len + arg_len;
+   if ((pckt = tinytac_pckt_alloc(pckt_type, 1, tinytac_pckt_session_id(tt), len)) == NULL)
+      return(TTAC_ENOMEM);
+
+   hdr            = pckt->pckt_body;
+   hdr[hdr_len-4] = (uint8_t)user_len;
+   hdr[hdr_len-3] = (uint8_t)port_len;
+   hdr[hdr_len-2] = (uint8_t)rem_addr_len;
+   hdr[hdr_len-1] = (uint8_t)arg_cnt;
+
+   ptr = &hdr[hdr_len];
+   memcpy(ptr, arg_lens, arg_cnt);        ptr += arg_cnt;
+   memcpy(ptr, user,     user_len);       ptr += user_len;
+   memcpy(ptr, port,     port_len);       ptr += port_len;
+   memcpy(ptr, rem_addr, rem_addr_len);   ptr += rem_addr_len;
+   for(pos = 0; (pos < arg_cnt); pos++)
+   {
+      memcpy(ptr, args[pos], arg_lens[pos]);
+      ptr += arg_lens[pos];
+   };
+
+   *pcktp = pckt;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// generates random session_id for a new session
+///
+/// The random number source is selected with TTAC_OPT_RANDOM.
+///
+/// @param[in]  tt            reference to library handle
+///
+/// @return    Returns session_id in network byte order.
+uint32_t
+tinytac_pckt_session_id(
+         TinyTac *                     tt )
+{
+   int         fd;
+   uint32_t    session_id;
+
+   switch(tt->opts & TTAC_RND_METHODS)
+   {
+      case TTAC_RAND:
+      session_id = (uint32_t)rand();
+      break;
+
+      case TTAC_RANDOM:
+      session_id = (uint32_t)random();
+      break;
+
+      default:
+      session_id = (uint32_t)random();
+      if ((fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC)) == -1)
+         break;
+      if (read(fd, &session_id, sizeof(session_id)) != sizeof(session_id))
+         session_id = (uint32_t)random();
+      close(fd);
+      break;
+   };
+
+   return(htonl(session_id));
+}
+
+
+tinytac_pckt_t *
+tinytac_pckt_dup(
+         const tinytac_pckt_t *        pckt )
+{
+   tinytac_pckt_t *        dup;
+   size_t                  size;
+   assert(pckt != NULL);
+   size = sizeof(tinytac_pckt_t) + ntohl(pckt->pckt_length);
+   if ((dup = tinytac_mem_alloc(size)) == NULL)
+      return(NULL);
+   memcpy(dup, pckt, size);
+   return(dup);
+}
+
+
 void
 tinytac_pckt_hexdump(
          FILE *                        fs,
@@ -118,13 +428,15 @@ tinytac_pckt_hexdump(
    unsigned          line;
    unsigned          pos;
    unsigned          pckt_len;
+   size_t            len;
    const char *      str;
+   char              buff[96];
+   static const char hex[] = "0123456789abcdef";
 
    bytes    = (void *)pckt;
    pckt_len = ntohl(pckt->pckt_length) + sizeof(tinytac_pckt_t);
    prefix   = ((prefix)) ? prefix : "";
 
-   fprintf(fs, "%spacket: version: %u.%u;", prefix, (pckt->pckt_version >> 4), (pckt->pckt_version & 0x0f));
    switch(pckt->pckt_type)
    {
       case TAC_PLUS_TYPE_AUTHEN: str = "authen";  break;
@@ -132,40 +444,37 @@ tinytac_pckt_hexdump(
       case TAC_PLUS_TYPE_ACCT:   str = "acct";    break;
       default:                   str = "unknown"; break;
    };
-   fprintf(fs, " type: %s;", str);
-   fprintf(fs, " seq_no: %u;", pckt->pckt_seq_no);
-   fprintf(fs, " session_id: %08x;", ntohl(pckt->pckt_session_id));
-   fprintf(fs, "\n%spacket: length: %u (0x%x);", prefix, pckt_len, pckt_len);
-   fprintf(fs, " flags:");
-   if (!(pckt->pckt_flags))
-      fprintf(fs, " NONE");
-   if ((pckt->pckt_flags & TAC_PLUS_SINGLE_CONNECT_FLAG))
-      fprintf(fs, " SINGLE-CONNECT");
-   if ((pckt->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG))
-      fprintf(fs, " UNENCRYPTED");
-   fprintf(fs, ";");
-   fprintf(fs, "\n");
-
-
+   fprintf(fs, "%spacket: version: %u.%u; type: %s; seq_no: %u; session_id: %08x;\n%spacket: length: %u (0x%x); flags:%s%s%s;\n",
+      prefix, (pckt->pckt_version >> 4), (pckt->pckt_version & 0x0f), str, pckt->pckt_seq_no, ntohl(pckt->pckt_session_id),
+      prefix, pckt_len, pckt_len,
+      ((!(pckt->pckt_flags)) ? " NONE" : ""),
+      (((pckt->pckt_flags & TAC_PLUS_SINGLE_CONNECT_FLAG)) ? " SINGLE-CONNECT" : ""),
+      (((pckt->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG))    ? " UNENCRYPTED"    : "") );
+
+   // format each line in a buffer instead of writing each byte to stream
    fprintf(fs, "%s offset    0  1  2  3   4  5  6  7   8  9  a  b   c  d  e  f  0123456789abcdef\n", prefix);
    for(line = 0; (line < pckt_len); line += 0x10)
    {
-      fprintf(fs, "%s%08x", prefix, line);
+      len = 0;
+      for(pos = 32; (pos > 0); pos -= 4)
+         buff[len++] = hex[(line >> (pos - 4)) & 0x0f];
       for(pos = line; (pos < (line+0x10)); pos++)
       {
          if ((pos & 0x03) == 0)
-            fprintf(fs, " ");
-         if (pos < pckt_len)
-            fprintf(fs, " %02x", bytes[pos]);
-         else
-            fprintf(fs, "   ");
+            buff[len++] = ' ';
+         buff[len++] = ' ';
+         buff[len++] = (pos < pckt_len) ? hex[bytes[pos] >> 4]   : ' ';
+         buff[len++] = (pos < pckt_len) ? hex[bytes[pos] & 0x0f] : ' ';
       };
-      fprintf(fs, "  ");
+      buff[len++] = ' ';
+      buff[len++] = ' ';
       for(pos = line; ((pos < (line+0x10)) && (pos < pckt_len)); pos++)
-         fprintf(fs, "%c", ((bytes[pos] < 0x20) || (bytes[pos] > 0x7e)) ? '.' : bytes[pos]);
-      fprintf(fs, "\n");
+         buff[len++] = ((bytes[pos] < 0x20) || (bytes[pos] > 0x7e)) ? '.' : (char)bytes[pos];
+      buff[len++] = '\n';
       if ((line & 0xf0) == 0xf0)
-         fprintf(fs, "\n");
+         buff[len++] = '\n';
+      fputs(prefix, fs);
+      fwrite(buff, len, 1, fs);
    };
 
    return;
@@ -180,17 +489,47 @@ tinytac_pckt_md5pad(
          uint8_t *                     md5pad_prev,
          uint8_t *                     md5pad )
 {
-   unsigned             md_len;
    EVP_MD_CTX *         mdctx;
 
    assert(pckt    != NULL);
    assert(key     != NULL);
    assert(md5pad  != NULL);
 
+   if ((mdctx = EVP_MD_CTX_new()) == NULL)
+      return(-1);
+   EVP_DigestInit_ex(mdctx, EVP_md5(), NULL);
+   tinytac_pckt_md5pad_ctx(mdctx, pckt, key, key_len, md5pad_prev, md5pad);
+   EVP_MD_CTX_free(mdctx);
+
+   return(0);
+}
+
+
+/// generates pseudo-random pad with an existing digest context
+///
+/// The context is reset with the digest it was initialized with, which
+/// avoids fetching the MD5 implementation for every pad.
+///
+/// @param[in]  mdctx         digest context initialized for MD5
+/// @param[in]  pckt          packet used to generate psuedo-random pad
+/// @param[in]  key           shared secret
+/// @param[in]  key_len       length of shared secret
+/// @param[in]  md5pad_prev   previously generated pad or NULL
+/// @param[out] md5pad        buffer to store generated pad
+void
+tinytac_pckt_md5pad_ctx(
+         EVP_MD_CTX *                  mdctx,
+         const tinytac_pckt_t *        pckt,
+         const char *                  key,
+         size_t                        key_len,
+         const uint8_t *               md5pad_prev,
+         uint8_t *                     md5pad )
+{
+   unsigned             md_len;
+
    key_len = ((key)) ? key_len : 0;
 
-   mdctx = EVP_MD_CTX_new();
-   EVP_DigestInit_ex(mdctx, EVP_md5(), NULL);
+   EVP_DigestInit_ex(mdctx, NULL, NULL);
    EVP_DigestUpdate(mdctx, &pckt->pckt_session_id, 4);
    EVP_DigestUpdate(mdctx, key, key_len);
    EVP_DigestUpdate(mdctx, &pckt->pckt_version, 1);
@@ -198,9 +537,8 @@ tinytac_pckt_md5pad(
    if ((md5pad_prev))
       EVP_DigestUpdate(mdctx, md5pad_prev, 16);
    EVP_DigestFinal_ex(mdctx, md5pad, &md_len);
-   EVP_MD_CTX_free(mdctx);
 
-   return(0);
+   return;
 }
 
 
@@ -210,15 +548,49 @@ tinytac_pckt_obfuscate(
          char *                        key,
          size_t                        key_len,
          unsigned                      unencrypted )
+{
+   int            rc;
+   EVP_MD_CTX *   mdctx;
+
+   assert(pckt != NULL);
+   assert(key  != NULL);
+
+   if ((pckt->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG) == ((unencrypted == TTAC_NO) ? 0 : TAC_PLUS_UNENCRYPTED_FLAG))
+      return(0);
+
+   // one digest context is reused for every pad of the packet
+   if ((mdctx = EVP_MD_CTX_new()) == NULL)
+      return(-1);
+   EVP_DigestInit_ex(mdctx, EVP_md5(), NULL);
+   rc = tinytac_pckt_obfuscate_ctx(pckt, key, key_len, unencrypted, mdctx);
+   EVP_MD_CTX_free(mdctx);
+
+   return(rc);
+}
+
+
+/// obfuscates or unobfuscates packet with an existing digest context
+///
+/// @param[in]  pckt          packet to obfuscate or unobfuscate
+/// @param[in]  key           shared secret
+/// @param[in]  key_len       length of shared secret
+/// @param[in]  unencrypted   packet should not be obfuscated (TTAC_YES or TTAC_NO)
+/// @param[in]  mdctx         digest context initialized for MD5
+///
+/// @return    Returns 0.
+int
+tinytac_pckt_obfuscate_ctx(
+         tinytac_pckt_t *              pckt,
+         const char *                  key,
+         size_t                        key_len,
+         unsigned                      unencrypted,
+         EVP_MD_CTX *                  mdctx )
 {
    uint8_t        md_value[EVP_MAX_MD_SIZE];
    size_t         pckt_len;
    size_t         off;
    size_t         pos;
 
-   assert(pckt != NULL);
-   assert(key  != NULL);
-
    // check for existing obfuscation and flip flag
    unencrypted = (unencrypted == TTAC_NO) ? 0 : TAC_PLUS_UNENCRYPTED_FLAG;
    if ((pckt->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG) == unencrypted)
@@ -226,7 +598,7 @@ tinytac_pckt_obfuscate(
    pckt->pckt_flags ^= TAC_PLUS_UNENCRYPTED_FLAG;
 
    // create initial pad
-   tinytac_pckt_md5pad(pckt, key, key_len, NULL, md_value);
+   tinytac_pckt_md5pad_ctx(mdctx, pckt, key, key_len, NULL, md_value);
    pckt_len = ntohl(pckt->pckt_length);
 
    // apply pads to packet body
@@ -234,7 +606,7 @@ tinytac_pckt_obfuscate(
    {
       for(pos = 0; (pos < 16); pos++)
          pckt->pckt_body[off+pos] ^= md_value[pos];
-      tinytac_pckt_md5pad(pckt, key, key_len, md_value, md_value);
+      tinytac_pckt_md5pad_ctx(mdctx, pckt, key, key_len, md_value, md_value);
    };
    for(pos = 0; ((pos+off) < pckt_len); pos++)
       pckt->pckt_body[off+pos] ^= md_value[pos];
@@ -243,4 +615,93 @@ tinytac_pckt_obfuscate(
 }
 
 
+int
+tinytac_pckt_reply_view(
+         const tinytac_pckt_t *        reply,
+         tinytac_reply_view_t *        view )
+{
+   size_t               body_len;
+   size_t               hdr_len;
+   size_t               off;
+   size_t               pos;
+   const uint8_t *      body;
+
+   TinyTacDebugTrace();
+
+   assert(reply != NULL);
+   assert(view  != NULL);
+
+   if (!(reply->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG))
+      return(TTAC_EINVAL);
+
+   body        = reply->pckt_body;
+   body_len    = ntohl(reply->pckt_length);
+   memset(view, 0, offsetof(tinytac_reply_view_t, args));
+   view->type  = reply->pckt_type;
+
+   // fixed header, which excludes trailing padding of its structure, and
+   // multi-byte lengths are read bytewise since the body is not aligned and
+   // is in network byte order
+   switch(reply->pckt_type)
+   {
+      case TAC_PLUS_TYPE_AUTHEN:
+      if ((hdr_len = offsetof(tinytac_authen_reply_t, bdy_bytes)) > body_len)
+         return(TTAC_EBADMSG);
+      view->status            = body[0];
+      view->flags             = body[1];
+      view->server_msg.len    = (size_t)((body[2] << 8) | body[3]);
+      view->data.len          = (size_t)((body[4] << 8) | body[5]);
+      break;
+
+      case TAC_PLUS_TYPE_AUTHOR:
+      if ((hdr_len = offsetof(tinytac_author_reply_t, bdy_bytes)) > body_len)
+         return(TTAC_EBADMSG);
+      view->status            = body[0];
+      view->arg_cnt           = body[1];
+      view->server_msg.len    = (size_t)((body[2] << 8) | body[3]);
+      view->data.len          = (size_t)((body[4] << 8) | body[5]);
+      break;
+
+      case TAC_PLUS_TYPE_ACCT:
+      if ((hdr_len = offsetof(tinytac_acct_reply_t, bdy_bytes)) > body_len)
+         return(TTAC_EBADMSG);
+      view->server_msg.len    = (size_t)((body[0] << 8) | body[1]);
+      view->data.len          = (size_t)((body[2] << 8) | body[3]);
+      view->status            = body[4];
+      break;
+
+      default:
+      return(TTAC_EBADMSG);
+   };
+
+   // argument lengths precede the variable fields
+   off = hdr_len + view->arg_cnt;
+   if (off > body_len)
+      return(TTAC_EBADMSG);
+   for(pos = 0; (pos < view->arg_cnt); pos++)
+      view->args[pos].len = body[hdr_len + pos];
+
+   // map variable fields
+   if (view->server_msg.len > (body_len - off))
+      return(TTAC_EBADMSG);
+   view->server_msg.ptr = (const char *)&body[off];
+   off += view->server_msg.len;
+
+   if (view->data.len > (body_len - off))
+      return(TTAC_EBADMSG);
+   view->data.ptr = (const char *)&body[off];
+   off += view->data.len;
+
+   for(pos = 0; (pos < view->arg_cnt); pos++)
+   {
+      if (view->args[pos].len > (body_len - off))
+         return(TTAC_EBADMSG);
+      view->args[pos].ptr = (const char *)&body[off];
+      off += view->args[pos].len;
+   };
+
+   return(TTAC_SUCCESS);
+}
+
+
 /* end of source */
@@ -45,6 +45,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <openssl/evp.h>
 
 
 ///////////////////
@@ -60,6 +61,8 @@
 #define TTAC_VERSION_TO_MINOR( version )     ((version & 0x0f) >> 0)
 #define TTAC_VERSION_TO_MAJOR( version )     ((version & 0xf0) >> 4)
 
+#define TTAC_HASH_INIT                       0xcbf29ce484222325ULL
+
 
 //////////////////
 //              //
@@ -76,5 +79,38 @@
 //////////////////
 #pragma mark - Prototypes
 
+uint64_t
+tinytac_hash(
+         uint64_t                      hash,
+         const void *                  data,
+         size_t                        len );
+
+
+tinytac_pckt_t *
+tinytac_pckt_alloc(
+         uint8_t                       pckt_type,
+         uint8_t                       seq_no,
+         uint32_t                      session_id,
+         size_t                        nbytes );
+
+
+tinytac_pckt_t *
+tinytac_pckt_dup(
+         const tinytac_pckt_t *        pckt );
+
+
+int
+tinytac_pckt_obfuscate_ctx(
+         tinytac_pckt_t *              pckt,
+         const char *                  key,
+         size_t                        key_len,
+         unsigned                      unencrypted,
+         EVP_MD_CTX *                  mdctx );
+
+
+uint32_t
+tinytac_pckt_session_id(
+         TinyTac *                     tt );
+
 
 #endif /* end of header */
@@ -0,0 +1,533 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LRELOAD_C 1
+#include "lreload.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <assert.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#   include <sys/inotify.h>
+#endif
+
+#include "lconf.h"
+#include "lmemory.h"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// state of a configuration file when the configuration was last read
+typedef struct _tinytac_reload_file
+{
+   int                     exists;
+   dev_t                   dev;
+   ino_t                   ino;
+   off_t                   size;
+   struct timespec         mtime;
+} tinytac_reload_file_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static void
+tinytac_reload_apply(
+         TinyTac *                     tt,
+         int                           resolve );
+
+
+static int
+tinytac_reload_changed(
+         void );
+
+
+static void
+tinytac_reload_stat(
+         const char *                  path,
+         tinytac_reload_file_t *       file );
+
+
+static int
+tinytac_reload_strscmp(
+         char * const *                strs1,
+         char * const *                strs2 );
+
+
+static void
+tinytac_reload_wait(
+         void );
+
+
+static void
+tinytac_reload_watch(
+         void );
+
+
+static void *
+tinytac_reload_worker(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// handles which follow configuration changes and the last reading of the
+// configuration, protected by tinytac_reload_mutex
+static pthread_mutex_t           tinytac_reload_mutex = PTHREAD_MUTEX_INITIALIZER;
+static TinyTac **                tinytac_reload_handles;
+static size_t                    tinytac_reload_len;
+static size_t                    tinytac_reload_size;
+static int                       tinytac_reload_started;
+static char *                    tinytac_reload_hosts;   // NULL until configuration was read
+static char **                   tinytac_reload_keys;
+
+
+// only used by worker
+static char **                   tinytac_reload_paths;
+static tinytac_reload_file_t *   tinytac_reload_files;
+static int                       tinytac_reload_fd = -1;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// adds handle to handles which follow changes of the configuration files
+///
+/// The worker which watches the configuration files is started with the
+/// first handle.  The worker holds no reference to the handle, so
+/// tinytac_tinytac_free() removes the handle before it is released.
+///
+/// @param[in]  tt            reference to library handle
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_reload_add(
+         TinyTac *                     tt )
+{
+   int                     rc;
+   size_t                  pos;
+   void *                  ptr;
+   pthread_t               thread;
+   pthread_attr_t          attr;
+   sigset_t                set;
+   sigset_t                oset;
+
+   TinyTacDebugTrace();
+
+   assert(tt != NULL);
+
+   pthread_mutex_lock(&tinytac_reload_mutex);
+
+   for(pos = 0; (pos < tinytac_reload_len); pos++)
+   {
+      if (tinytac_reload_handles[pos] == tt)
+      {
+         pthread_mutex_unlock(&tinytac_reload_mutex);
+         return(TTAC_SUCCESS);
+      };
+   };
+
+   if (tinytac_reload_len == tinytac_reload_size)
+   {
+      if ((ptr = tinytac_mem_realloc(tinytac_reload_handles, (sizeof(TinyTac *) * (tinytac_reload_size + 8)))) == NULL)
+      {
+         pthread_mutex_unlock(&tinytac_reload_mutex);
+         return(TTAC_ENOMEM);
+      };
+      tinytac_reload_handles  = ptr;
+      tinytac_reload_size    += 8;
+   };
+
+   // worker does not handle signals of the application
+   if (!(tinytac_reload_started))
+   {
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      sigfillset(&set);
+      pthread_sigmask(SIG_SETMASK, &set, &oset);
+      rc = pthread_create(&thread, &attr, &tinytac_reload_worker, NULL);
+      pthread_sigmask(SIG_SETMASK, &oset, NULL);
+      pthread_attr_destroy(&attr);
+      if ((rc))
+      {
+         pthread_mutex_unlock(&tinytac_reload_mutex);
+         return(TTAC_ENOMEM);
+      };
+      tinytac_reload_started = 1;
+   };
+
+   tinytac_reload_handles[tinytac_reload_len++] = tt;
+
+   // handle was initialized before the files changed
+   tinytac_reload_apply(tt, TTAC_NO);
+
+   pthread_mutex_unlock(&tinytac_reload_mutex);
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// publishes servers and keys of the last reading to handle
+///
+/// Servers or keys which were set on the handle by the application are
+/// kept.  The caller holds tinytac_reload_mutex.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  resolve       TTAC_YES to publish unchanged servers again so
+///                           that their names are resolved again
+void
+tinytac_reload_apply(
+         TinyTac *                     tt,
+         int                           resolve )
+{
+   unsigned                flags;
+   tinytac_servers_t *     servers;
+
+   TinyTacDebugTrace();
+
+   if (!(tinytac_reload_hosts))
+      return;
+
+   // servers set by the application in the meantime are not replaced
+   pthread_mutex_lock(&tt->servers_mutex);
+   if ((servers = atomic_load_explicit(&tt->servers, memory_order_relaxed)) == NULL)
+   {
+      pthread_mutex_unlock(&tt->servers_mutex);
+      return;
+   };
+
+   flags = (TTAC_SERVERS_HOSTS | TTAC_SERVERS_KEYS) & ~tt->servers_pinned;
+   if ( (resolve != TTAC_YES) && ((servers->hosts)) && (!(strcmp(servers->hosts, tinytac_reload_hosts))) )
+      flags &= ~TTAC_SERVERS_HOSTS;
+   if (!(tinytac_reload_strscmp(servers->keys, tinytac_reload_keys)))
+      flags &= ~TTAC_SERVERS_KEYS;
+
+   if ( ((flags)) && (tinytac_servers_publish(tt, tinytac_reload_hosts, tinytac_reload_keys, flags) != TTAC_SUCCESS) )
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to apply configuration changes", __func__);
+   pthread_mutex_unlock(&tt->servers_mutex);
+
+   return;
+}
+
+
+/// compares configuration files with their state when they were read
+///
+/// @return    Returns TTAC_YES if a file was changed, created or removed.
+int
+tinytac_reload_changed(
+         void )
+{
+   size_t                  pos;
+   tinytac_reload_file_t   file;
+   tinytac_reload_file_t * prev;
+
+   if (!(tinytac_reload_paths))
+      return(TTAC_NO);
+   if (!(tinytac_reload_files))
+      return(TTAC_YES);
+
+   for(pos = 0; ((tinytac_reload_paths[pos])); pos++)
+   {
+      prev = &tinytac_reload_files[pos];
+      tinytac_reload_stat(tinytac_reload_paths[pos], &file);
+      if (file.exists != prev->exists)
+         return(TTAC_YES);
+      if ( (file.dev != prev->dev) || (file.ino != prev->ino) || (file.size != prev->size) )
+         return(TTAC_YES);
+      if ( (file.mtime.tv_sec != prev->mtime.tv_sec) || (file.mtime.tv_nsec != prev->mtime.tv_nsec) )
+         return(TTAC_YES);
+   };
+
+   return(TTAC_NO);
+}
+
+
+/// removes handle from handles which follow configuration changes
+///
+/// @param[in]  tt            reference to library handle
+void
+tinytac_reload_remove(
+         TinyTac *                     tt )
+{
+   size_t                  pos;
+
+   TinyTacDebugTrace();
+
+   pthread_mutex_lock(&tinytac_reload_mutex);
+   for(pos = 0; (pos < tinytac_reload_len); pos++)
+   {
+      if (tinytac_reload_handles[pos] != tt)
+         continue;
+      tinytac_reload_handles[pos] = tinytac_reload_handles[--tinytac_reload_len];
+      break;
+   };
+   pthread_mutex_unlock(&tinytac_reload_mutex);
+
+   return;
+}
+
+
+/// records state of configuration file
+///
+/// @param[in]  path          path of configuration file
+/// @param[out] file          state of file
+void
+tinytac_reload_stat(
+         const char *                  path,
+         tinytac_reload_file_t *       file )
+{
+   struct stat             sb;
+
+   memset(file, 0, sizeof(tinytac_reload_file_t));
+   if (stat(path, &sb) == -1)
+      return;
+
+   file->exists   = TTAC_YES;
+   file->dev      = sb.st_dev;
+   file->ino      = sb.st_ino;
+   file->size     = sb.st_size;
+   file->mtime    = sb.st_mtim;
+
+   return;
+}
+
+
+/// compares NULL terminated lists of strings
+///
+/// @param[in]  strs1         first list or NULL
+/// @param[in]  strs2         second list or NULL
+///
+/// @return    Returns zero if the lists are equal.
+int
+tinytac_reload_strscmp(
+         char * const *                strs1,
+         char * const *                strs2 )
+{
+   size_t                  pos;
+   int                     rc;
+
+   if (strs1 == strs2)
+      return(0);
+   if ( (!(strs1)) || (!(strs2)) )
+      return(((strs1)) ? 1 : -1);
+
+   for(pos = 0; ( ((strs1[pos])) && ((strs2[pos])) ); pos++)
+      if ((rc = strcmp(strs1[pos], strs2[pos])) != 0)
+         return(rc);
+
+   if (strs1[pos] == strs2[pos])
+      return(0);
+   return(((strs1[pos])) ? 1 : -1);
+}
+
+
+/// waits until a configuration file was changed
+///
+/// Without inotify, the files are checked every TTAC_RELOAD_INTERVAL
+/// seconds.  With inotify, events are collected until the directories of
+/// the files have been quiet for TTAC_RELOAD_SETTLE milliseconds, so that
+/// a file is not read while an editor is still writing it.
+void
+tinytac_reload_wait(
+         void )
+{
+   struct pollfd           pfd;
+   char                    buff[4096];
+
+   TinyTacDebugTrace();
+
+   while(1)
+   {
+      if (tinytac_reload_fd == -1)
+      {
+         sleep(TTAC_RELOAD_INTERVAL);
+      } else
+      {
+         pfd.fd      = tinytac_reload_fd;
+         pfd.events  = POLLIN;
+         pfd.revents = 0;
+         if (poll(&pfd, 1, -1) == -1)
+            continue;
+         do
+         {
+            while (read(tinytac_reload_fd, buff, sizeof(buff)) > 0);
+         } while (poll(&pfd, 1, TTAC_RELOAD_SETTLE) > 0);
+      };
+      if ((tinytac_reload_changed()))
+         return;
+   };
+
+   return;
+}
+
+
+/// records state of configuration files and watches their directories
+///
+/// Directories are watched instead of the files so that files which are
+/// created, or replaced by renaming a new copy, are noticed.
+void
+tinytac_reload_watch(
+         void )
+{
+   size_t                  len;
+   size_t                  pos;
+   void *                  ptr;
+#ifdef HAVE_SYS_INOTIFY_H
+   char *                  slash;
+   char                    dir[512];
+#endif
+
+   TinyTacDebugTrace();
+
+   for(len = 0; ( ((tinytac_reload_paths)) && ((tinytac_reload_paths[len])) ); len++);
+
+   if ((ptr = tinytac_mem_realloc(tinytac_reload_files, (sizeof(tinytac_reload_file_t) * (len+1)))) == NULL)
+   {
+      tinytac_mem_free(tinytac_reload_files);
+      tinytac_reload_files = NULL;
+      return;
+   };
+   tinytac_reload_files = ptr;
+   for(pos = 0; (pos < len); pos++)
+      tinytac_reload_stat(tinytac_reload_paths[pos], &tinytac_reload_files[pos]);
+
+#ifdef HAVE_SYS_INOTIFY_H
+   if (tinytac_reload_fd != -1)
+      close(tinytac_reload_fd);
+   if ((tinytac_reload_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK)) == -1)
+      return;
+   for(pos = 0; (pos < len); pos++)
+   {
+      tinytacb_strlcpy(dir, tinytac_reload_paths[pos], sizeof(dir));
+      if ((slash = strrchr(dir, '/')) == NULL)
+         tinytacb_strlcpy(dir, ".", sizeof(dir));
+      else if (slash == dir)
+         slash[1] = '\0';
+      else
+         slash[0] = '\0';
+      if (inotify_add_watch(tinytac_reload_fd, dir, (IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) == -1)
+         TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): unable to watch %s", __func__, dir);
+   };
+#endif
+
+   return;
+}
+
+
+/// re-reads configuration files each time they change
+///
+/// @param[in]  arg           unused
+///
+/// @return    Does not return.
+void *
+tinytac_reload_worker(
+         void *                        arg )
+{
+   size_t                  pos;
+   char *                  hosts;
+   char **                 keys;
+   char **                 paths;
+
+   TinyTacDebugTrace();
+
+   (void)arg;
+
+   while(1)
+   {
+      // state of files is recorded before they are read, so that a change
+      // while the files are read is noticed by the next wait
+      tinytac_reload_watch();
+
+      if (tinytac_conf_reload(&hosts, &keys, &paths) == TTAC_SUCCESS)
+      {
+         TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): configured servers \"%s\"", __func__, hosts);
+
+         pthread_mutex_lock(&tinytac_reload_mutex);
+         if ((tinytac_reload_hosts))
+            free(tinytac_reload_hosts);
+         tinytacb_strsfree(tinytac_reload_keys);
+         tinytac_reload_hosts = hosts;
+         tinytac_reload_keys  = keys;
+         for(pos = 0; (pos < tinytac_reload_len); pos++)
+            tinytac_reload_apply(tinytac_reload_handles[pos], TTAC_YES);
+         pthread_mutex_unlock(&tinytac_reload_mutex);
+
+         if ((tinytac_reload_strscmp(paths, tinytac_reload_paths)))
+         {
+            tinytacb_strsfree(tinytac_reload_paths);
+            tinytac_reload_paths = paths;
+            tinytac_reload_watch();
+         } else
+         {
+            tinytacb_strsfree(paths);
+         };
+      };
+
+      tinytac_reload_wait();
+   };
+
+   return(NULL);
+}
+
+
+/* end of source */
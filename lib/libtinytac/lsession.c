@@ -0,0 +1,486 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LSESSION_C 1
+#include "lsession.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "lcapture.h"
+#include "lmemory.h"
+#include "lnetwork.h"
+#include "lprobe.h"
+#include "lproto.h"
+#include "lstats.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static void
+tinytac_session_destroy(
+         tinytac_session_t *           sess );
+
+
+static int
+tinytac_session_error(
+         tinytac_session_t *           sess );
+
+
+static int
+tinytac_session_grow(
+         tinytac_session_buff_t *      buff,
+         size_t                        size );
+
+
+static int
+tinytac_session_read(
+         int                           s,
+         void *                        buf,
+         size_t                        len );
+
+
+static int
+tinytac_session_recv(
+         tinytac_session_t *           sess,
+         tinytac_pckt_t **             replyp );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-------------------//
+// session functions //
+//-------------------//
+#pragma mark session functions
+
+/// starts session with a new session_id
+///
+/// Idle sessions of the handle are reused with their buffers, so the steps
+/// of a session do not allocate memory once buffers have grown to the size
+/// of the exchanged packets.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  s             socket connected to TACACS+ server or -1 to
+///                           connect to configured servers
+/// @param[in]  minor         minor version requested by the session
+/// @param[out] sessp         pointer to store session
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_session_alloc(
+         TinyTac *                     tt,
+         int                           s,
+         uint8_t                       minor,
+         tinytac_session_t **          sessp )
+{
+   int                     rc;
+   tinytac_session_t *     sess;
+
+   TinyTacDebugTrace();
+
+   assert(tt    != NULL);
+   assert(sessp != NULL);
+
+   *sessp = NULL;
+
+   pthread_mutex_lock(&tt->sessions_mutex);
+   if ((sess = tt->sessions) != NULL)
+   {
+      tt->sessions = sess->next;
+      tt->sessions_cnt--;
+   };
+   pthread_mutex_unlock(&tt->sessions_mutex);
+
+   if (!(sess))
+   {
+      if ((sess = tinytac_mem_calloc(1, sizeof(tinytac_session_t))) == NULL)
+         return(TTAC_ENOMEM);
+      if ((sess->mdctx = EVP_MD_CTX_new()) != NULL)
+         EVP_DigestInit_ex(sess->mdctx, EVP_md5(), NULL);
+      if ( (!(sess->mdctx)) || ((tinytac_session_grow(&sess->req, TTAC_SESSION_BUFF_SIZE))) || ((tinytac_session_grow(&sess->reply, TTAC_SESSION_BUFF_SIZE))) )
+      {
+         tinytac_session_destroy(sess);
+         return(TTAC_ENOMEM);
+      };
+   };
+
+   sess->next        = NULL;
+   sess->tt          = tt;
+   sess->servers     = tinytac_servers_acquire(tt);
+   sess->key         = tinytac_net_key(sess->servers);
+   sess->s           = s;
+   sess->own         = TTAC_NO;
+   sess->metrics     = NULL;
+   sess->session_id  = tinytac_pckt_session_id(tt);
+   sess->seq_no      = 0;
+   sess->version     = TTAC_VERSION(TAC_PLUS_MAJOR_VER, minor);
+
+   if (s == -1)
+   {
+      if ((rc = tinytac_net_connect(tt, sess->servers, &sess->s, &sess->metrics)) != TTAC_SUCCESS)
+      {
+         tinytac_session_free(sess);
+         return(rc);
+      };
+      sess->own = TTAC_YES;
+   };
+
+   *sessp = sess;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// frees session and its buffers
+///
+/// @param[in]  sess          reference to session
+void
+tinytac_session_destroy(
+         tinytac_session_t *           sess )
+{
+   EVP_MD_CTX_free(sess->mdctx);
+   tinytac_mem_free(sess->req.data);
+   tinytac_mem_free(sess->reply.data);
+   tinytac_mem_free(sess);
+   return;
+}
+
+
+/// returns error of failed read or write and counts timeouts
+///
+/// @param[in]  sess          reference to session
+///
+/// @return    Returns TTAC_EBADMSG or TTAC_ENETWORK.
+int
+tinytac_session_error(
+         tinytac_session_t *           sess )
+{
+   if (errno == EBADMSG)
+      return(TTAC_EBADMSG);
+   if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+      tinytac_metrics_add(sess->tt, sess->metrics, TTAC_STAT_TIMEOUTS, 1);
+   return(TTAC_ENETWORK);
+}
+
+
+/// sends request of current step and receives the server's reply
+///
+/// The reply is stored in the reply buffer of the session and remains
+/// valid until the next exchange.  The version of the reply is used by the
+/// following requests of the session.
+///
+/// @param[in]  sess          reference to session
+/// @param[out] replyp        pointer to store un-obfuscated reply packet
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_session_exchange(
+         tinytac_session_t *           sess,
+         tinytac_pckt_t **             replyp )
+{
+   int                  rc;
+   uint64_t             start;
+   tinytac_pckt_t *     reply;
+
+   assert(sess   != NULL);
+   assert(replyp != NULL);
+
+   reply = NULL;
+
+   tinytac_metrics_add(sess->tt, sess->metrics, TTAC_STAT_REQUESTS, 1);
+   tinytac_trace_session(ntohl(sess->session_id));
+   TinyTacProbe3(request__start, ntohl(sess->session_id), TTAC_METRICS_SERVER(sess->metrics), ntohl(((tinytac_pckt_t *)sess->req.data)->pckt_length));
+   start = (TinyTacProbeEnabled(request__done)) ? tinytac_metrics_now() : 0;
+
+   if ( ((rc = tinytac_session_send(sess)) == TTAC_SUCCESS) )
+      rc = tinytac_session_recv(sess, &reply);
+   if (TinyTacProbeEnabled(request__done))
+      TinyTacProbe4(request__done, ntohl(sess->session_id), TTAC_METRICS_SERVER(sess->metrics), rc, TinyTacProbeUsec(start, tinytac_metrics_now()));
+   if (rc != TTAC_SUCCESS)
+   {
+      tinytac_metrics_add(sess->tt, sess->metrics, TTAC_STAT_FAILURES, 1);
+      return(rc);
+   };
+
+   sess->seq_no   = reply->pckt_seq_no;
+   sess->version  = reply->pckt_version;
+   *replyp        = reply;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// frees idle sessions of handle
+///
+/// @param[in]  tt            reference to library handle
+void
+tinytac_session_flush(
+         TinyTac *                     tt )
+{
+   tinytac_session_t *     sess;
+
+   while ((sess = tt->sessions) != NULL)
+   {
+      tt->sessions = sess->next;
+      tinytac_session_destroy(sess);
+   };
+   tt->sessions_cnt = 0;
+
+   return;
+}
+
+
+/// ends session and keeps it for reuse
+///
+/// @param[in]  sess          reference to session
+void
+tinytac_session_free(
+         tinytac_session_t *           sess )
+{
+   TinyTac *      tt;
+
+   if (!(sess))
+      return;
+
+   if ( ((sess->own)) && (sess->s != -1) )
+      close(sess->s);
+   tinytac_servers_release(sess->servers);
+   sess->s        = -1;
+   sess->own      = TTAC_NO;
+   sess->servers  = NULL;
+   sess->key      = NULL;
+
+   tt = sess->tt;
+   pthread_mutex_lock(&tt->sessions_mutex);
+   if (tt->sessions_cnt < TTAC_SESSION_FREE_MAX)
+   {
+      sess->next     = tt->sessions;
+      tt->sessions   = sess;
+      tt->sessions_cnt++;
+      sess           = NULL;
+   };
+   pthread_mutex_unlock(&tt->sessions_mutex);
+
+   if ((sess))
+      tinytac_session_destroy(sess);
+
+   return;
+}
+
+
+/// grows buffer to hold at least 'size' bytes
+///
+/// @param[in]  buff          buffer of session
+/// @param[in]  size          required size
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+tinytac_session_grow(
+         tinytac_session_buff_t *      buff,
+         size_t                        size )
+{
+   size_t         len;
+   void *         ptr;
+
+   if (size <= buff->size)
+      return(0);
+   for(len = ((buff->size)) ? buff->size : TTAC_SESSION_BUFF_SIZE; (len < size); len <<= 1);
+   if ((ptr = tinytac_mem_realloc(buff->data, len)) == NULL)
+      return(-1);
+   buff->data = ptr;
+   buff->size = len;
+
+   return(0);
+}
+
+
+/// reads exactly 'len' bytes from socket
+///
+/// @param[in]  s             connected socket
+/// @param[out] buf           buffer to store data
+/// @param[in]  len           number of bytes to read
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+tinytac_session_read(
+         int                           s,
+         void *                        buf,
+         size_t                        len )
+{
+   ssize_t        rc;
+
+   if ((rc = recv(s, buf, len, MSG_WAITALL)) == -1)
+      return(-1);
+   if (((size_t)rc) != len)
+   {
+      errno = EBADMSG;
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+/// reads reply of current step into the reply buffer
+///
+/// @param[in]  sess          reference to session
+/// @param[out] replyp        pointer to store un-obfuscated reply packet
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_session_recv(
+         tinytac_session_t *           sess,
+         tinytac_pckt_t **             replyp )
+{
+   size_t               len;
+   uint64_t             start;
+   tinytac_pckt_t *     reply;
+
+   if (tinytac_session_read(sess->s, sess->reply.data, sizeof(tinytac_pckt_t)) == -1)
+      return(tinytac_session_error(sess));
+   tinytac_metrics_phase(sess->tt, sess->metrics, TTAC_PHASE_FIRST_BYTE, sess->sent);
+   len = ntohl(((tinytac_pckt_t *)sess->reply.data)->pckt_length);
+   if ((tinytac_session_grow(&sess->reply, (sizeof(tinytac_pckt_t) + len))))
+      return(TTAC_ENOMEM);
+   reply = (tinytac_pckt_t *)sess->reply.data;
+   if (tinytac_session_read(sess->s, reply->pckt_body, len) == -1)
+      return(tinytac_session_error(sess));
+   start = tinytac_metrics_phase(sess->tt, sess->metrics, TTAC_PHASE_REPLY, sess->sent);
+   TinyTacProbe4(recv, ntohl(sess->session_id), TTAC_METRICS_SERVER(sess->metrics), (sizeof(tinytac_pckt_t) + len), TinyTacProbeUsec(sess->sent, start));
+   tinytac_capture(sess->s, reply, TTAC_CAPTURE_RECV);
+
+   if ( (reply->pckt_session_id != sess->session_id) ||
+        (reply->pckt_type       != ((tinytac_pckt_t *)sess->req.data)->pckt_type) ||
+        (reply->pckt_seq_no     != ((sess->seq_no + 1) & 0xff)) )
+      return(TTAC_EBADMSG);
+   tinytac_pckt_obfuscate_ctx(reply, sess->key, strlen(sess->key), TTAC_YES, sess->mdctx);
+   tinytac_metrics_phase(sess->tt, sess->metrics, TTAC_PHASE_DEOBFUSCATE, start);
+   if (TinyTacProbeEnabled(deobfuscate))
+      TinyTacProbe3(deobfuscate, ntohl(sess->session_id), (sizeof(tinytac_pckt_t) + len), TinyTacProbeUsec(start, tinytac_metrics_now()));
+   tinytac_capture(sess->s, reply, (TTAC_CAPTURE_RECV | TTAC_CAPTURE_PLAIN));
+
+   *replyp = reply;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// starts next request of session in request buffer
+///
+/// The header of the packet is initialized with the session_id, the next
+/// seq_no and the negotiated version.  The body is left to the caller.
+///
+/// @param[in]  sess          reference to session
+/// @param[in]  pckt_type     TAC_PLUS_TYPE_*
+/// @param[in]  nbytes        size of packet body
+///
+/// @return    Returns packet or NULL on error.
+tinytac_pckt_t *
+tinytac_session_request(
+         tinytac_session_t *           sess,
+         uint8_t                       pckt_type,
+         size_t                        nbytes )
+{
+   tinytac_pckt_t *     pckt;
+
+   assert(sess != NULL);
+
+   if ((tinytac_session_grow(&sess->req, (sizeof(tinytac_pckt_t) + nbytes))))
+      return(NULL);
+
+   pckt                    = (tinytac_pckt_t *)sess->req.data;
+   pckt->pckt_version      = sess->version;
+   pckt->pckt_type         = pckt_type;
+   pckt->pckt_seq_no       = (uint8_t)(sess->seq_no + 1);
+   pckt->pckt_flags        = TAC_PLUS_UNENCRYPTED_FLAG | TAC_PLUS_SINGLE_CONNECT_FLAG;
+   pckt->pckt_session_id   = sess->session_id;
+   pckt->pckt_length       = htonl((uint32_t)nbytes);
+
+   return(pckt);
+}
+
+
+/// sends request of current step without waiting for a reply
+///
+/// @param[in]  sess          reference to session
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_session_send(
+         tinytac_session_t *           sess )
+{
+   tinytac_pckt_t *     req;
+   uint64_t             start;
+   struct iovec         iov;
+
+   assert(sess != NULL);
+
+   req = (tinytac_pckt_t *)sess->req.data;
+   tinytac_capture(sess->s, req, (TTAC_CAPTURE_SENT | TTAC_CAPTURE_PLAIN));
+   tinytac_pckt_obfuscate_ctx(req, sess->key, strlen(sess->key), TTAC_NO, sess->mdctx);
+   iov.iov_base   = req;
+   iov.iov_len    = sizeof(tinytac_pckt_t) + ntohl(req->pckt_length);
+   start          = tinytac_metrics_now();
+   if (tinytac_net_sendv(sess->s, &iov, 1) == -1)
+      return(tinytac_session_error(sess));
+   sess->sent     = tinytac_metrics_phase(sess->tt, sess->metrics, TTAC_PHASE_SEND, start);
+   sess->seq_no   = req->pckt_seq_no;
+   TinyTacProbe4(send, ntohl(sess->session_id), TTAC_METRICS_SERVER(sess->metrics), iov.iov_len, TinyTacProbeUsec(start, sess->sent));
+
+   return(TTAC_SUCCESS);
+}
+
+
+/* end of source */
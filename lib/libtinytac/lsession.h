@@ -0,0 +1,135 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LSESSION_H
+#define _LIB_LIBTINYTAC_LSESSION_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+#include <openssl/evp.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SESSION_BUFF_SIZE      1024        // initial size of request and reply buffers
+#define TTAC_SESSION_FREE_MAX       64          // idle sessions kept by a handle
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// buffer reused by every step of a session, grown to the largest packet
+typedef struct _tinytac_session_buff
+{
+   uint8_t *               data;
+   size_t                  size;
+} tinytac_session_buff_t;
+
+
+struct _tinytac_session
+{
+   tinytac_session_t *     next;       // link of idle sessions
+   TinyTac *               tt;
+   tinytac_servers_t *     servers;    // servers and keys used by session
+   char *                  key;
+   int                     s;
+   int                     own;        // socket was connected by session
+   uint32_t                session_id; // network byte order
+   uint8_t                 seq_no;     // seq_no of last packet sent or received
+   uint8_t                 version;    // major and negotiated minor version
+   EVP_MD_CTX *            mdctx;      // digest context of obfuscation pads
+   tinytac_metrics_t *     metrics;    // metrics of connected server
+   uint64_t                sent;       // time last request was written
+   tinytac_session_buff_t  req;
+   tinytac_session_buff_t  reply;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+tinytac_session_alloc(
+         TinyTac *                     tt,
+         int                           s,
+         uint8_t                       minor,
+         tinytac_session_t **          sessp );
+
+
+int
+tinytac_session_exchange(
+         tinytac_session_t *           sess,
+         tinytac_pckt_t **             replyp );
+
+
+void
+tinytac_session_flush(
+         TinyTac *                     tt );
+
+
+void
+tinytac_session_free(
+         tinytac_session_t *           sess );
+
+
+tinytac_pckt_t *
+tinytac_session_request(
+         tinytac_session_t *           sess,
+         uint8_t                       pckt_type,
+         size_t                        nbytes );
+
+
+int
+tinytac_session_send(
+         tinytac_session_t *           sess );
+
+
+#endif /* end of header */
@@ -0,0 +1,584 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LSHM_C 1
+#include "lshm.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <assert.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include "lmemory.h"
+#include "lnetwork.h"
+#include "lproto.h"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// Each entry is guarded by a sequence lock.  A writer claims the entry by
+// moving an even sequence to odd, fills the entry, and then releases it by
+// advancing the sequence to the next even value.  Readers copy the entry and
+// discard the copy if the sequence was odd or changed during the copy.  The
+// time of the claim is recorded before the sequence is moved to odd so that
+// an entry left odd by a writer which died can be reclaimed by a later
+// writer.  The fields from key_mac through data are authenticated by
+// entry_mac so that a process without the shared secret cannot inject
+// replies or pass off a torn entry.
+typedef struct _tinytac_shm_entry
+{
+   _Atomic uint64_t        seq;
+   _Atomic uint64_t        claimed;    // monotonic time of last claim
+   uint8_t                 entry_mac[TTAC_SHM_MAC_LEN];
+   uint8_t                 key_mac[TTAC_SHM_MAC_LEN];
+   uint64_t                expires;
+   uint32_t                data_len;
+   uint8_t                 data[TTAC_SHM_DATA_MAX];
+} tinytac_shm_entry_t;
+
+
+// Expiration times are monotonic seconds, which restart after a reboot
+// while a file backed segment does not.  The header records the realtime of
+// the monotonic epoch and the entries are discarded when a process finds a
+// different epoch.
+typedef struct _tinytac_shm_header
+{
+   _Atomic uint64_t        magic;
+   _Atomic int64_t         epoch;      // realtime of monotonic clock zero
+   uint32_t                buckets;
+   uint32_t                ways;
+   uint32_t                entry_size;
+   uint8_t                 pad[36];
+} tinytac_shm_header_t;
+
+
+struct _tinytac_shm
+{
+   char *                  path;
+   size_t                  map_len;
+   tinytac_shm_header_t *  hdr;        // NULL if the segment could not be attached
+   tinytac_shm_entry_t *   entries;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static tinytac_shm_t *
+tinytac_shm_attach(
+         TinyTac *                     tt );
+
+
+static int64_t
+tinytac_shm_epoch(
+         void );
+
+
+static int
+tinytac_shm_mac(
+         TinyTac *                     tt,
+         const void *                  data,
+         size_t                        len,
+         uint8_t *                     md );
+
+
+static tinytac_shm_t *
+tinytac_shm_open(
+         const char *                  path );
+
+
+static void
+tinytac_shm_reset(
+         tinytac_shm_t *               shm );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-------------------------------//
+// shared memory cache functions //
+//-------------------------------//
+#pragma mark shared memory cache functions
+
+/// attaches handle to the shared memory cache configured by TTAC_OPT_SHM_CACHE
+///
+/// @param[in]  tt            reference to library handle
+///
+/// @return    Returns mapping on success or NULL if unavailable.
+tinytac_shm_t *
+tinytac_shm_attach(
+         TinyTac *                     tt )
+{
+   tinytac_shm_t *      shm;
+
+   pthread_mutex_lock(&tt->cache_mutex);
+
+   if ( ((tt->shm)) && ( (!(tt->shm_cache)) || ((strcmp(tt->shm->path, tt->shm_cache))) ) )
+   {
+      tinytac_shm_free(tt->shm);
+      tt->shm = NULL;
+   };
+   if ( (!(tt->shm)) && ((tt->shm_cache)) )
+      tt->shm = tinytac_shm_open(tt->shm_cache);
+   shm = tt->shm;
+
+   pthread_mutex_unlock(&tt->cache_mutex);
+
+   if ( (!(shm)) || (!(shm->hdr)) )
+      return(NULL);
+
+   return(shm);
+}
+
+
+/// determines realtime at which the monotonic clock was zero
+///
+/// @return    Returns seconds since the Unix epoch.
+int64_t
+tinytac_shm_epoch(
+         void )
+{
+   struct timespec      rt;
+   struct timespec      mono;
+   clock_gettime(CLOCK_REALTIME,  &rt);
+   clock_gettime(CLOCK_MONOTONIC, &mono);
+   return((int64_t)rt.tv_sec - (int64_t)mono.tv_sec);
+}
+
+
+void
+tinytac_shm_free(
+         tinytac_shm_t *               shm )
+{
+   TinyTacDebugTrace();
+   if (!(shm))
+      return;
+   if ((shm->hdr))
+      munmap(shm->hdr, shm->map_len);
+   tinytac_mem_free(shm);
+   return;
+}
+
+
+/// retrieves copy of reply from shared memory cache
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  key           cache key of request
+/// @param[in]  req           request used to set session_id and seq_no of reply
+/// @param[out] replyp        pointer to store copy of cached reply
+///
+/// @return    Returns TTAC_SUCCESS on cache hit, TTAC_ENOENT on cache miss,
+///            or an error code.
+int
+tinytac_shm_lookup(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        req,
+         tinytac_pckt_t **             replyp )
+{
+   size_t                  way;
+   size_t                  len;
+   uint64_t                seq;
+   uint64_t                now;
+   uint8_t                 key_mac[TTAC_SHM_MAC_LEN];
+   uint8_t                 entry_mac[TTAC_SHM_MAC_LEN];
+   tinytac_shm_t *         shm;
+   tinytac_shm_entry_t *   bucket;
+   tinytac_shm_entry_t *   entry;
+   tinytac_shm_entry_t     copy;
+   tinytac_pckt_t *        reply;
+
+   TinyTacDebugTrace();
+
+   if ((shm = tinytac_shm_attach(tt)) == NULL)
+      return(TTAC_ENOENT);
+   if (tinytac_shm_mac(tt, key->bytes, key->len, key_mac) != TTAC_SUCCESS)
+      return(TTAC_ENOENT);
+
+   now    = tinytac_cache_now();
+   bucket = &shm->entries[(key->hash & (TTAC_SHM_BUCKETS - 1)) * TTAC_SHM_WAYS];
+
+   for(way = 0; (way < TTAC_SHM_WAYS); way++)
+   {
+      entry = &bucket[way];
+
+      // copy entry under sequence lock
+      if (((seq = atomic_load_explicit(&entry->seq, memory_order_acquire)) & 1))
+         continue;
+      if ((memcmp(entry->key_mac, key_mac, sizeof(key_mac))))
+         continue;
+      memcpy(copy.entry_mac, entry->entry_mac, offsetof(tinytac_shm_entry_t, data) - offsetof(tinytac_shm_entry_t, entry_mac));
+      if ((len = copy.data_len) > TTAC_SHM_DATA_MAX)
+         continue;
+      memcpy(copy.data, entry->data, len);
+      atomic_thread_fence(memory_order_acquire);
+      if (atomic_load_explicit(&entry->seq, memory_order_relaxed) != seq)
+         continue;
+
+      // validate copy
+      if ((memcmp(copy.key_mac, key_mac, sizeof(key_mac))))
+         continue;
+      if (copy.expires <= now)
+         continue;
+      if (len < sizeof(tinytac_pckt_t))
+         continue;
+      if ((sizeof(tinytac_pckt_t) + ntohl(((tinytac_pckt_t *)copy.data)->pckt_length)) != len)
+         continue;
+      len += offsetof(tinytac_shm_entry_t, data) - offsetof(tinytac_shm_entry_t, key_mac);
+      if (tinytac_shm_mac(tt, copy.key_mac, len, entry_mac) != TTAC_SUCCESS)
+         continue;
+      if ((memcmp(copy.entry_mac, entry_mac, sizeof(entry_mac))))
+         continue;
+
+      if ((reply = tinytac_mem_alloc(copy.data_len)) == NULL)
+         return(TTAC_ENOMEM);
+      memcpy(reply, copy.data, copy.data_len);
+
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): cache hit %016" PRIx64, __func__, key->hash);
+
+      reply->pckt_session_id  = req->pckt_session_id;
+      reply->pckt_seq_no      = (req->pckt_seq_no + 1) & 0xff;
+      *replyp                 = reply;
+
+      return(TTAC_SUCCESS);
+   };
+
+   return(TTAC_ENOENT);
+}
+
+
+/// computes HMAC-SHA256 of data using the shared secret of the handle
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  data          data to authenticate
+/// @param[in]  len           length of data
+/// @param[out] md            buffer of TTAC_SHM_MAC_LEN bytes
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+tinytac_shm_mac(
+         TinyTac *                     tt,
+         const void *                  data,
+         size_t                        len,
+         uint8_t *                     md )
+{
+   int                  rc;
+   char *               secret;
+   unsigned             md_len;
+   tinytac_servers_t *  servers;
+
+   // an unauthenticated cache would allow any process with access to the
+   // segment to forge authorization replies
+   servers  = tinytac_servers_acquire(tt);
+   secret   = tinytac_net_key(servers);
+   md_len   = TTAC_SHM_MAC_LEN;
+   if (!(secret[0]))
+      rc = TTAC_EINVAL;
+   else if (HMAC(EVP_sha256(), secret, (int)strlen(secret), data, len, md, &md_len) == NULL)
+      rc = TTAC_EUNKNOWN;
+   else
+      rc = TTAC_SUCCESS;
+   tinytac_servers_release(servers);
+
+   return(rc);
+}
+
+
+/// maps shared memory cache
+///
+/// Paths starting with '/' and not containing any other '/' are treated as
+/// POSIX shared memory object names, all other paths are treated as regular
+/// files.  The segment is created if it does not exist.
+///
+/// @param[in]  path          name of shared memory object or file
+///
+/// @return    Returns mapping on success or NULL on error.  If the segment
+///            could not be attached, a mapping without a header is returned
+///            so the attempt is not repeated for every request.
+tinytac_shm_t *
+tinytac_shm_open(
+         const char *                  path )
+{
+   int                     fd;
+   size_t                  size;
+   size_t                  path_len;
+   uint64_t                magic;
+   int64_t                 epoch;
+   int64_t                 prev;
+   void *                  map;
+   struct stat             sb;
+   tinytac_shm_t *         shm;
+   tinytac_shm_header_t *  hdr;
+
+   TinyTacDebugTrace();
+
+   path_len = strlen(path);
+   if ((shm = tinytac_mem_alloc(sizeof(tinytac_shm_t) + path_len + 1)) == NULL)
+      return(NULL);
+   memset(shm, 0, sizeof(tinytac_shm_t));
+   shm->path = (char *)&shm[1];
+   memcpy(shm->path, path, path_len+1);
+
+   size = sizeof(tinytac_shm_header_t) + (sizeof(tinytac_shm_entry_t) * TTAC_SHM_BUCKETS * TTAC_SHM_WAYS);
+
+   // open segment
+   if ( (path[0] == '/') && (!(strchr(&path[1], '/'))) )
+      fd = shm_open(path, O_RDWR | O_CREAT, TTAC_SHM_MODE);
+   else
+      fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, TTAC_SHM_MODE);
+   if (fd == -1)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to open %s", __func__, path);
+      return(shm);
+   };
+
+   // size new segments, refuse segments created with different geometry
+   if (fstat(fd, &sb) == -1)
+   {
+      close(fd);
+      return(shm);
+   };
+
+   // segment is shared with the group, refuse segments of other users or
+   // segments which other users are able to access
+   if ( (!(S_ISREG(sb.st_mode))) || ( (sb.st_uid != geteuid()) && (sb.st_uid != 0) ) || ((sb.st_mode & S_IRWXO)) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected owner or mode", __func__, path);
+      close(fd);
+      return(shm);
+   };
+   if (sb.st_size == 0)
+   {
+      if (ftruncate(fd, (off_t)size) == -1)
+      {
+         close(fd);
+         return(shm);
+      };
+   }
+   else if ((size_t)sb.st_size != size)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected size", __func__, path);
+      close(fd);
+      return(shm);
+   };
+
+   map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED)
+      return(shm);
+   hdr = map;
+
+   // initialize header of new segment; concurrent initializers write identical values
+   if (atomic_load_explicit(&hdr->magic, memory_order_acquire) == 0)
+   {
+      hdr->buckets      = TTAC_SHM_BUCKETS;
+      hdr->ways         = TTAC_SHM_WAYS;
+      hdr->entry_size   = sizeof(tinytac_shm_entry_t);
+      magic             = 0;
+      atomic_compare_exchange_strong_explicit(&hdr->magic, &magic, TTAC_SHM_MAGIC, memory_order_release, memory_order_acquire);
+   };
+   if ( (atomic_load_explicit(&hdr->magic, memory_order_acquire) != TTAC_SHM_MAGIC) ||
+        (hdr->buckets    != TTAC_SHM_BUCKETS) ||
+        (hdr->ways       != TTAC_SHM_WAYS) ||
+        (hdr->entry_size != sizeof(tinytac_shm_entry_t)) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected format", __func__, path);
+      munmap(map, size);
+      return(shm);
+   };
+
+   shm->hdr       = hdr;
+   shm->map_len   = size;
+   shm->entries   = (tinytac_shm_entry_t *)&hdr[1];
+
+   // discard entries written before a reboot or a large clock step
+   epoch = tinytac_shm_epoch();
+   prev  = atomic_load_explicit(&hdr->epoch, memory_order_acquire);
+   if ( (prev < (epoch - TTAC_SHM_EPOCH_SLEW)) || (prev > (epoch + TTAC_SHM_EPOCH_SLEW)) )
+   {
+      if ((atomic_compare_exchange_strong_explicit(&hdr->epoch, &prev, epoch, memory_order_acq_rel, memory_order_acquire)))
+      {
+         TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s is from a previous boot", __func__, path);
+         tinytac_shm_reset(shm);
+      };
+   };
+
+   return(shm);
+}
+
+
+/// discards all entries of shared memory cache
+///
+/// Writers of a previous boot no longer exist, so entries left odd are
+/// reset as well.
+///
+/// @param[in]  shm           mapped shared memory cache
+void
+tinytac_shm_reset(
+         tinytac_shm_t *               shm )
+{
+   size_t                  idx;
+   uint64_t                seq;
+   tinytac_shm_entry_t *   entry;
+
+   for(idx = 0; (idx < (TTAC_SHM_BUCKETS * TTAC_SHM_WAYS)); idx++)
+   {
+      entry = &shm->entries[idx];
+      seq   = atomic_load_explicit(&entry->seq, memory_order_relaxed) | 1;
+      atomic_store_explicit(&entry->seq, seq, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+      memset(entry->key_mac, 0, sizeof(entry->key_mac));
+      entry->expires = 0;
+      atomic_store_explicit(&entry->claimed, 0, memory_order_relaxed);
+      atomic_store_explicit(&entry->seq, seq+1, memory_order_release);
+   };
+
+   return;
+}
+
+
+/// stores copy of reply in shared memory cache
+///
+/// The store is skipped if the reply is too large for an entry or if the
+/// selected entry is being written by another process.  An entry which has
+/// been claimed for longer than TTAC_SHM_CLAIM_TIMEOUT belongs to a writer
+/// which died and is claimed again.
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  key           cache key of request
+/// @param[in]  reply         un-obfuscated authorization REPLY packet
+void
+tinytac_shm_store(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        reply )
+{
+   int                     ttl;
+   size_t                  way;
+   size_t                  len;
+   uint64_t                seq;
+   uint64_t                claim;
+   uint64_t                now;
+   tinytac_shm_t *         shm;
+   tinytac_shm_entry_t *   bucket;
+   tinytac_shm_entry_t *   entry;
+   tinytac_shm_entry_t     copy;
+
+   TinyTacDebugTrace();
+
+   if ((ttl = tinytac_cache_ttl(tt, reply)) < 1)
+      return;
+   if ((len = sizeof(tinytac_pckt_t) + ntohl(reply->pckt_length)) > TTAC_SHM_DATA_MAX)
+      return;
+   if ((shm = tinytac_shm_attach(tt)) == NULL)
+      return;
+
+   // prepare entry
+   now            = tinytac_cache_now();
+   copy.expires   = now + (uint64_t)ttl;
+   copy.data_len  = (uint32_t)len;
+   memcpy(copy.data, reply, len);
+   ((tinytac_pckt_t *)copy.data)->pckt_session_id  = 0;
+   ((tinytac_pckt_t *)copy.data)->pckt_seq_no      = 0;
+   if (tinytac_shm_mac(tt, key->bytes, key->len, copy.key_mac) != TTAC_SUCCESS)
+      return;
+   len += offsetof(tinytac_shm_entry_t, data) - offsetof(tinytac_shm_entry_t, key_mac);
+   if (tinytac_shm_mac(tt, copy.key_mac, len, copy.entry_mac) != TTAC_SUCCESS)
+      return;
+
+   // select entry: same key, expired entry, or entry expiring soonest
+   bucket = &shm->entries[(key->hash & (TTAC_SHM_BUCKETS - 1)) * TTAC_SHM_WAYS];
+   entry  = &bucket[0];
+   for(way = 0; (way < TTAC_SHM_WAYS); way++)
+   {
+      if (!(memcmp(bucket[way].key_mac, copy.key_mac, sizeof(copy.key_mac))))
+      {
+         entry = &bucket[way];
+         break;
+      };
+      if (bucket[way].expires < entry->expires)
+         entry = &bucket[way];
+   };
+
+   // claim entry, or reclaim entry abandoned by a dead writer
+   seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+   if ((seq & 1))
+   {
+      if (now < (atomic_load_explicit(&entry->claimed, memory_order_relaxed) + TTAC_SHM_CLAIM_TIMEOUT))
+         return;
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): reclaiming abandoned entry", __func__);
+      claim = seq + 2;
+   } else {
+      claim = seq + 1;
+   };
+   atomic_store_explicit(&entry->claimed, now, memory_order_relaxed);
+   if (!(atomic_compare_exchange_strong_explicit(&entry->seq, &seq, claim, memory_order_acq_rel, memory_order_relaxed)))
+      return;
+   atomic_thread_fence(memory_order_release);
+
+   // write and release entry
+   memcpy(entry->entry_mac, copy.entry_mac, offsetof(tinytac_shm_entry_t, data) - offsetof(tinytac_shm_entry_t, entry_mac) + copy.data_len);
+   atomic_store_explicit(&entry->seq, claim+1, memory_order_release);
+
+   return;
+}
+
+/* end of source */
@@ -0,0 +1,91 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LSHM_H
+#define _LIB_LIBTINYTAC_LSHM_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+#include "lcache.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SHM_MAGIC              0x3248534341545454ULL   // "TTTACSH2"
+#define TTAC_SHM_BUCKETS            1024
+#define TTAC_SHM_WAYS               4
+#define TTAC_SHM_MAC_LEN            32
+#define TTAC_SHM_DATA_MAX           428
+#define TTAC_SHM_MODE               0660
+#define TTAC_SHM_EPOCH_SLEW         60       // seconds the monotonic epoch may drift before the segment is reset
+#define TTAC_SHM_CLAIM_TIMEOUT      5        // seconds after which an entry left odd by a dead writer is reclaimed
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+void
+tinytac_shm_free(
+         tinytac_shm_t *               shm );
+
+
+int
+tinytac_shm_lookup(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        req,
+         tinytac_pckt_t **             replyp );
+
+
+void
+tinytac_shm_store(
+         TinyTac *                     tt,
+         const tinytac_cache_key_t *   key,
+         const tinytac_pckt_t *        reply );
+
+
+#endif /* end of header */
@@ -0,0 +1,536 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LSNAPSHOT_C 1
+#include "lsnapshot.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <assert.h>
+
+#include "lmemory.h"
+#include "lproto.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SNAPSHOT_ALIGN(len)    (((len) + 7) & ~((size_t)7))
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// Snapshot file, stored in host byte order and only read by the user which
+// wrote it.  The header is followed by the consulted configuration files and
+// by the options applied from the files and the environment.
+typedef struct _tinytac_snapshot_hdr
+{
+   uint64_t                magic;
+   uint64_t                schema;     // library version and option table
+   uint64_t                env_hash;   // TINYTAC* environment variables
+   uint32_t                uid;
+   uint32_t                files_len;  // bytes of file entries
+   uint32_t                opts_len;   // bytes of option entries
+   uint32_t                reserved;
+} tinytac_snapshot_hdr_t;
+
+
+// configuration file consulted while loading, followed by its path
+typedef struct _tinytac_snapshot_file
+{
+   uint64_t                dev;
+   uint64_t                ino;
+   int64_t                 mtime_sec;
+   int64_t                 mtime_nsec;
+   int64_t                 size;
+   uint32_t                exists;
+   uint32_t                len;        // aligned length of path
+} tinytac_snapshot_file_t;
+
+
+// option applied while loading, followed by its value
+typedef struct _tinytac_snapshot_opt
+{
+   uint32_t                opt_id;
+   uint32_t                len;        // aligned length of value, 0 if NULL
+} tinytac_snapshot_opt_t;
+
+
+typedef struct _tinytac_snapshot_buff
+{
+   uint8_t *               data;
+   size_t                  len;
+   size_t                  size;
+} tinytac_snapshot_buff_t;
+
+
+struct _tinytac_snapshot
+{
+   int                     tainted;    // configuration depends on more than files and environment
+   tinytac_snapshot_hdr_t  hdr;
+   tinytac_snapshot_buff_t files;
+   tinytac_snapshot_buff_t opts;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static void *
+tinytac_snapshot_append(
+         tinytac_snapshot_t *          snap,
+         tinytac_snapshot_buff_t *     buff,
+         size_t                        len );
+
+
+static uint64_t
+tinytac_snapshot_env(
+         void );
+
+
+static void
+tinytac_snapshot_stat(
+         const char *                  path,
+         tinytac_snapshot_file_t *     entry );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+extern char ** environ;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//--------------------//
+// snapshot functions //
+//--------------------//
+#pragma mark snapshot functions
+
+/// starts recording of a snapshot
+///
+/// @param[in]  schema        hash of library version and option table
+///
+/// @return    Returns snapshot or NULL if memory could not be allocated.
+tinytac_snapshot_t *
+tinytac_snapshot_alloc(
+         uint64_t                      schema )
+{
+   tinytac_snapshot_t *    snap;
+
+   TinyTacDebugTrace();
+
+   if ((snap = tinytac_mem_calloc(1, sizeof(tinytac_snapshot_t))) == NULL)
+      return(NULL);
+
+   snap->hdr.magic      = TTAC_SNAPSHOT_MAGIC;
+   snap->hdr.schema     = schema;
+   snap->hdr.env_hash   = tinytac_snapshot_env();
+   snap->hdr.uid        = (uint32_t)getuid();
+
+   return(snap);
+}
+
+
+/// grows buffer of snapshot
+///
+/// A failed allocation taints the snapshot so that it is not saved.
+///
+/// @param[in]  snap          snapshot being recorded
+/// @param[in]  buff          buffer of file or option entries
+/// @param[in]  len           number of bytes to append
+///
+/// @return    Returns pointer to appended bytes or NULL.
+void *
+tinytac_snapshot_append(
+         tinytac_snapshot_t *          snap,
+         tinytac_snapshot_buff_t *     buff,
+         size_t                        len )
+{
+   size_t      size;
+   void *      ptr;
+
+   if ((snap->tainted))
+      return(NULL);
+
+   if ((buff->len + len) > buff->size)
+   {
+      for(size = ((buff->size)) ? buff->size : 512; (size < (buff->len + len)); size <<= 1);
+      if ((ptr = tinytac_mem_realloc(buff->data, size)) == NULL)
+      {
+         snap->tainted = 1;
+         return(NULL);
+      };
+      buff->data = ptr;
+      buff->size = size;
+   };
+
+   ptr        = &buff->data[buff->len];
+   buff->len += len;
+   memset(ptr, 0, len);
+
+   return(ptr);
+}
+
+
+/// hashes TINYTAC* environment variables
+///
+/// The hashes of the variables are summed so the result does not depend on
+/// the order of the environment.
+///
+/// @return    Returns hash of environment.
+uint64_t
+tinytac_snapshot_env(
+         void )
+{
+   size_t      pos;
+   uint64_t    hash;
+
+   hash = 0;
+   for(pos = 0; ( ((environ)) && ((environ[pos])) ); pos++)
+      if (!(strncmp(environ[pos], "TINYTAC", 7)))
+         hash += tinytac_hash(TTAC_HASH_INIT, environ[pos], strlen(environ[pos]));
+
+   return(hash);
+}
+
+
+void
+tinytac_snapshot_free(
+         tinytac_snapshot_t *          snap )
+{
+   TinyTacDebugTrace();
+   if (!(snap))
+      return;
+   tinytac_mem_free(snap->files.data);
+   tinytac_mem_free(snap->opts.data);
+   tinytac_mem_free(snap);
+   return;
+}
+
+
+/// applies configuration from a valid snapshot
+///
+/// The snapshot is mapped into memory and is only applied if it is owned by
+/// the effective user, was written for the current library, user and
+/// environment, and none of the consulted configuration files changed.
+///
+/// @param[in]  file          path of snapshot
+/// @param[in]  schema        hash of library version and option table
+/// @param[in]  apply         function which applies an option value
+///
+/// @return    Returns TTAC_SUCCESS if the snapshot was applied, TTAC_ENOENT
+///            if the snapshot is missing or stale, or an error code.
+int
+tinytac_snapshot_load(
+         const char *                  file,
+         uint64_t                      schema,
+         int (*apply)(unsigned opt_id, const char * value) )
+{
+   int                              fd;
+   int                              rc;
+   size_t                           off;
+   size_t                           start;
+   size_t                           end;
+   struct stat                      sb;
+   uint8_t *                        map;
+   const tinytac_snapshot_hdr_t *   hdr;
+   const tinytac_snapshot_file_t *  entry;
+   const tinytac_snapshot_opt_t *   opt;
+   tinytac_snapshot_file_t          cur;
+
+   TinyTacDebugTrace();
+
+   assert(file  != NULL);
+   assert(apply != NULL);
+
+   if ((fd = open(file, O_RDONLY | O_NOFOLLOW)) == -1)
+      return(TTAC_ENOENT);
+   if ( (fstat(fd, &sb) == -1) || (sb.st_uid != geteuid()) || ((sb.st_mode & 077)) || ((size_t)sb.st_size < sizeof(tinytac_snapshot_hdr_t)) )
+   {
+      close(fd);
+      return(TTAC_ENOENT);
+   };
+   map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED)
+      return(TTAC_ENOENT);
+
+   // verify header against library, user and environment
+   hdr = (const tinytac_snapshot_hdr_t *)map;
+   rc  = TTAC_ENOENT;
+   if ( (hdr->magic    == TTAC_SNAPSHOT_MAGIC) &&
+        (hdr->schema   == schema) &&
+        (hdr->uid      == (uint32_t)getuid()) &&
+        (hdr->env_hash == tinytac_snapshot_env()) &&
+        ((sizeof(tinytac_snapshot_hdr_t) + hdr->files_len + hdr->opts_len) == (size_t)sb.st_size) )
+      rc = TTAC_SUCCESS;
+
+   // verify configuration files are unchanged
+   off = sizeof(tinytac_snapshot_hdr_t);
+   end = off + ((rc == TTAC_SUCCESS) ? hdr->files_len : 0);
+   while ( (rc == TTAC_SUCCESS) && (off < end) )
+   {
+      entry = (const tinytac_snapshot_file_t *)&map[off];
+      if ( ((off + sizeof(tinytac_snapshot_file_t)) > end) || (!(entry->len)) || ((off + sizeof(tinytac_snapshot_file_t) + entry->len) > end) )
+      {
+         rc = TTAC_ENOENT;
+         break;
+      };
+      off += sizeof(tinytac_snapshot_file_t) + entry->len;
+      if ((map[off-1]))
+      {
+         rc = TTAC_ENOENT;
+         break;
+      };
+      tinytac_snapshot_stat((const char *)&entry[1], &cur);
+      cur.len = entry->len;
+      if ((memcmp(entry, &cur, sizeof(cur))))
+      {
+         TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): %s changed", __func__, (const char *)&entry[1]);
+         rc = TTAC_ENOENT;
+      };
+   };
+
+   // verify option entries before applying any of them
+   start = off;
+   end   = off + ((rc == TTAC_SUCCESS) ? hdr->opts_len : 0);
+   while ( (rc == TTAC_SUCCESS) && (off < end) )
+   {
+      opt = (const tinytac_snapshot_opt_t *)&map[off];
+      if ( ((off + sizeof(tinytac_snapshot_opt_t)) > end) || ((off + sizeof(tinytac_snapshot_opt_t) + opt->len) > end) )
+      {
+         rc = TTAC_ENOENT;
+         break;
+      };
+      off += sizeof(tinytac_snapshot_opt_t) + opt->len;
+      if ( ((opt->len)) && ((map[off-1])) )
+         rc = TTAC_ENOENT;
+   };
+
+   // apply options
+   for(off = start; ( (rc == TTAC_SUCCESS) && (off < end) ); off += sizeof(tinytac_snapshot_opt_t) + opt->len)
+   {
+      opt = (const tinytac_snapshot_opt_t *)&map[off];
+      if (apply(opt->opt_id, (((opt->len)) ? (const char *)&opt[1] : NULL)) == TTAC_ENOMEM)
+         rc = TTAC_ENOMEM;
+   };
+
+   munmap(map, (size_t)sb.st_size);
+
+   TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): %s %s", __func__, file, ((rc == TTAC_SUCCESS) ? "applied" : "not applied"));
+
+   return(rc);
+}
+
+
+/// records option applied while loading configuration
+///
+/// @param[in]  snap          snapshot being recorded
+/// @param[in]  opt_id        option identifier
+/// @param[in]  value         value of option or NULL
+void
+tinytac_snapshot_opt(
+         tinytac_snapshot_t *          snap,
+         unsigned                      opt_id,
+         const char *                  value )
+{
+   size_t                     len;
+   tinytac_snapshot_opt_t *   opt;
+
+   if (!(snap))
+      return;
+
+   len = ((value)) ? TTAC_SNAPSHOT_ALIGN(strlen(value) + 1) : 0;
+   if ((opt = tinytac_snapshot_append(snap, &snap->opts, (sizeof(tinytac_snapshot_opt_t) + len))) == NULL)
+      return;
+   opt->opt_id = opt_id;
+   opt->len    = (uint32_t)len;
+   if ((value))
+      memcpy(&opt[1], value, strlen(value));
+
+   return;
+}
+
+
+/// records configuration file consulted while loading configuration
+///
+/// Files which do not exist are recorded so that creating them invalidates
+/// the snapshot.
+///
+/// @param[in]  snap          snapshot being recorded
+/// @param[in]  path          path of configuration file
+void
+tinytac_snapshot_path(
+         tinytac_snapshot_t *          snap,
+         const char *                  path )
+{
+   size_t                     len;
+   tinytac_snapshot_file_t *  entry;
+
+   if (!(snap))
+      return;
+
+   len = TTAC_SNAPSHOT_ALIGN(strlen(path) + 1);
+   if ((entry = tinytac_snapshot_append(snap, &snap->files, (sizeof(tinytac_snapshot_file_t) + len))) == NULL)
+      return;
+   tinytac_snapshot_stat(path, entry);
+   entry->len = (uint32_t)len;
+   memcpy(&entry[1], path, strlen(path));
+
+   return;
+}
+
+
+/// writes snapshot
+///
+/// The snapshot is written to a temporary file which is renamed over the
+/// previous snapshot, so concurrent processes never map a partial file.
+///
+/// @param[in]  snap          snapshot being recorded
+/// @param[in]  file          path of snapshot
+void
+tinytac_snapshot_save(
+         tinytac_snapshot_t *          snap,
+         const char *                  file )
+{
+   int            fd;
+   ssize_t        len;
+   char           tmp[512];
+   struct iovec   iov[3];
+
+   TinyTacDebugTrace();
+
+   if ( (!(snap)) || ((snap->tainted)) )
+      return;
+   if ((size_t)snprintf(tmp, sizeof(tmp), "%s.XXXXXX", file) >= sizeof(tmp))
+      return;
+   if ((fd = mkstemp(tmp)) == -1)
+      return;
+
+   snap->hdr.files_len  = (uint32_t)snap->files.len;
+   snap->hdr.opts_len   = (uint32_t)snap->opts.len;
+   iov[0].iov_base      = &snap->hdr;
+   iov[0].iov_len       = sizeof(snap->hdr);
+   iov[1].iov_base      = snap->files.data;
+   iov[1].iov_len       = snap->files.len;
+   iov[2].iov_base      = snap->opts.data;
+   iov[2].iov_len       = snap->opts.len;
+   len = writev(fd, iov, 3);
+   close(fd);
+
+   if ( (len != (ssize_t)(sizeof(snap->hdr) + snap->files.len + snap->opts.len)) || (rename(tmp, file) == -1) )
+   {
+      unlink(tmp);
+      return;
+   };
+
+   TinyTacDebug(TTAC_DEBUG_PARSE, "   == %s(): wrote %s", __func__, file);
+
+   return;
+}
+
+
+/// records file status used to detect changes of a configuration file
+///
+/// @param[in]  path          path of configuration file
+/// @param[out] entry         file entry to store status
+void
+tinytac_snapshot_stat(
+         const char *                  path,
+         tinytac_snapshot_file_t *     entry )
+{
+   struct stat    sb;
+
+   memset(entry, 0, sizeof(tinytac_snapshot_file_t));
+   if (stat(path, &sb) == -1)
+      return;
+
+   entry->exists     = 1;
+   entry->dev        = (uint64_t)sb.st_dev;
+   entry->ino        = (uint64_t)sb.st_ino;
+   entry->mtime_sec  = (int64_t)sb.st_mtim.tv_sec;
+   entry->mtime_nsec = (int64_t)sb.st_mtim.tv_nsec;
+   entry->size       = (int64_t)sb.st_size;
+
+   return;
+}
+
+
+/// marks snapshot as not reproducible from files and environment
+///
+/// @param[in]  snap          snapshot being recorded
+void
+tinytac_snapshot_taint(
+         tinytac_snapshot_t *          snap )
+{
+   if ((snap))
+      snap->tainted = 1;
+   return;
+}
+
+
+/* end of source */
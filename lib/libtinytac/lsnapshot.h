@@ -0,0 +1,114 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LSNAPSHOT_H
+#define _LIB_LIBTINYTAC_LSNAPSHOT_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SNAPSHOT_MAGIC         0x50414e5343415454ULL   // "TTACSNAP" in little endian
+#define TTAC_SNAPSHOT_NAME          "tinytac.snapshot"      // file name within XDG_RUNTIME_DIR
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytac_snapshot tinytac_snapshot_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+tinytac_snapshot_t *
+tinytac_snapshot_alloc(
+         uint64_t                      schema );
+
+
+void
+tinytac_snapshot_free(
+         tinytac_snapshot_t *          snap );
+
+
+int
+tinytac_snapshot_load(
+         const char *                  file,
+         uint64_t                      schema,
+         int (*apply)(unsigned opt_id, const char * value) );
+
+
+void
+tinytac_snapshot_opt(
+         tinytac_snapshot_t *          snap,
+         unsigned                      opt_id,
+         const char *                  value );
+
+
+void
+tinytac_snapshot_path(
+         tinytac_snapshot_t *          snap,
+         const char *                  path );
+
+
+void
+tinytac_snapshot_save(
+         tinytac_snapshot_t *          snap,
+         const char *                  file );
+
+
+void
+tinytac_snapshot_taint(
+         tinytac_snapshot_t *          snap );
+
+
+#endif /* end of header */
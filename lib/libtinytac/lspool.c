@@ -0,0 +1,540 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LSPOOL_C 1
+#include "lspool.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <assert.h>
+
+#include "lacct.h"
+#include "lcache.h"
+#include "lmemory.h"
+#include "lproto.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SPOOL_ALIGN(len)       (((len) + 7) & ~((size_t)7))
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// The spool is a ring of records following a header page.  Offsets in the
+// header are logical and only increase; the position within the ring is
+// the offset modulo the size of the ring.  Writers of any process reserve
+// space by advancing tail with compare-and-swap, mark the record pending
+// with its length, copy the record, and publish it by storing its length
+// without the pending flag.  The drainer replays records from head and
+// zeroes them before advancing head, so that free space is always zero.  A
+// writer which terminated before marking its record therefore left only
+// zeroes, and the record ends where the next marked record starts.
+typedef struct _tinytac_spool_header
+{
+   _Atomic uint64_t        magic;
+   uint64_t                size;       // bytes in ring
+   uint8_t                 pad0[48];
+   _Atomic uint64_t        tail;       // offset of next record
+   uint8_t                 pad1[56];
+   _Atomic uint64_t        head;       // offset of oldest record not replayed
+   _Atomic uint64_t        synced;     // offset up to which records were written to disk
+} tinytac_spool_header_t;
+
+
+typedef struct _tinytac_spool_record
+{
+   _Atomic uint32_t        len;        // length of packet and TTAC_SPOOL_* flags
+   uint32_t                sum;        // checksum of packet
+   uint8_t                 data[];
+} tinytac_spool_rec_t;
+
+
+struct _tinytac_spool
+{
+   int                        fd;
+   size_t                     map_len;
+   tinytac_spool_header_t *   hdr;
+   uint8_t *                  ring;
+   uint64_t                   stall_pos;
+   uint64_t                   stall_next;
+   uint64_t                   stall_since;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static uint64_t
+tinytac_spool_next(
+         tinytac_spool_t *             spool,
+         uint64_t                      pos,
+         uint64_t                      tail );
+
+
+static int
+tinytac_spool_stalled(
+         tinytac_spool_t *             spool,
+         uint64_t                      pos,
+         uint64_t                      next );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-----------------//
+// spool functions //
+//-----------------//
+#pragma mark spool functions
+
+/// appends un-obfuscated record to spool
+///
+/// @param[in]  spool         reference to spool
+/// @param[in]  pckt          accounting REQUEST
+///
+/// @return    Returns 0 on success or -1 if the spool is full.
+int
+tinytac_spool_append(
+         tinytac_spool_t *             spool,
+         const tinytac_pckt_t *        pckt )
+{
+   size_t                  len;
+   size_t                  need;
+   size_t                  pad;
+   uint64_t                size;
+   uint64_t                tail;
+   uint64_t                head;
+   uint64_t                pos;
+   tinytac_spool_rec_t *   rec;
+
+   len   = sizeof(tinytac_pckt_t) + ntohl(pckt->pckt_length);
+   need  = TTAC_SPOOL_ALIGN(sizeof(tinytac_spool_rec_t) + len);
+   size  = spool->hdr->size;
+   if (need > size)
+      return(-1);
+
+   // reserve record, and filler if the record would wrap around the ring
+   tail = atomic_load_explicit(&spool->hdr->tail, memory_order_relaxed);
+   do
+   {
+      pos   = tail % size;
+      pad   = ((pos + need) > size) ? (size_t)(size - pos) : 0;
+      head  = atomic_load_explicit(&spool->hdr->head, memory_order_acquire);
+      if ((tail + pad + need - head) > size)
+         return(-1);
+   } while (!(atomic_compare_exchange_weak_explicit(&spool->hdr->tail, &tail, (tail + pad + need), memory_order_acq_rel, memory_order_relaxed)));
+
+   if ((pad))
+   {
+      rec = (tinytac_spool_rec_t *)&spool->ring[pos];
+      atomic_store_explicit(&rec->len, (TTAC_SPOOL_PAD | (uint32_t)pad), memory_order_release);
+      pos = 0;
+   };
+
+   // mark must precede the data so that a partial record is never unmarked
+   rec = (tinytac_spool_rec_t *)&spool->ring[pos];
+   atomic_store_explicit(&rec->len, (TTAC_SPOOL_PENDING | (uint32_t)len), memory_order_relaxed);
+   atomic_thread_fence(memory_order_release);
+   memcpy(rec->data, pckt, len);
+   rec->sum = (uint32_t)tinytac_hash(TTAC_HASH_INIT, pckt, len);
+   atomic_store_explicit(&rec->len, (uint32_t)len, memory_order_release);
+
+   return(0);
+}
+
+
+void
+tinytac_spool_close(
+         tinytac_spool_t *             spool )
+{
+   TinyTacDebugTrace();
+   if (!(spool))
+      return;
+   munmap(spool->hdr, spool->map_len);
+   close(spool->fd);
+   tinytac_mem_free(spool);
+   return;
+}
+
+
+/// marks records before cursor as replayed
+///
+/// @param[in]  spool         reference to spool
+/// @param[in]  cursor        offset returned by tinytac_spool_read()
+void
+tinytac_spool_commit(
+         tinytac_spool_t *             spool,
+         uint64_t                      cursor )
+{
+   uint64_t       pos;
+   uint64_t       off;
+   uint64_t       len;
+   uint64_t       size;
+
+   size  = spool->hdr->size;
+   pos   = atomic_load_explicit(&spool->hdr->head, memory_order_relaxed);
+
+   while (pos < cursor)
+   {
+      off   = pos % size;
+      len   = ((cursor - pos) < (size - off)) ? (cursor - pos) : (size - off);
+      memset(&spool->ring[off], 0, (size_t)len);
+      pos  += len;
+   };
+
+   atomic_store_explicit(&spool->hdr->head, cursor, memory_order_release);
+
+   return;
+}
+
+
+/// maps spool, creating it if it does not exist
+///
+/// @param[in]  path          file name of spool
+/// @param[in]  size          bytes in ring of a new spool
+///
+/// @return    Returns spool on success or NULL on error.
+tinytac_spool_t *
+tinytac_spool_open(
+         const char *                  path,
+         size_t                        size )
+{
+   int                        fd;
+   size_t                     page;
+   uint64_t                   magic;
+   void *                     map;
+   struct stat                sb;
+   tinytac_spool_t *          spool;
+   tinytac_spool_header_t *   hdr;
+
+   TinyTacDebugTrace();
+
+   page  = (size_t)sysconf(_SC_PAGESIZE);
+   size  = (size < page) ? page : size;
+   size  = (size > TTAC_SPOOL_LEN_MASK) ? TTAC_SPOOL_LEN_MASK : size;
+   size  = (size + page - 1) & ~(page - 1);
+
+   if ((fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, TTAC_SPOOL_MODE)) == -1)
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): unable to open %s", __func__, path);
+      return(NULL);
+   };
+
+   // size new spool while holding lock so that concurrent creators agree
+   if ( (flock(fd, LOCK_EX) == -1) || (fstat(fd, &sb) == -1) )
+   {
+      close(fd);
+      return(NULL);
+   };
+
+   // refuse spools which other users are able to modify
+   if ( (!(S_ISREG(sb.st_mode))) || (sb.st_uid != geteuid()) || ((sb.st_mode & (S_IWGRP | S_IWOTH))) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected owner or mode", __func__, path);
+      close(fd);
+      return(NULL);
+   };
+   if ( (sb.st_size == 0) && (ftruncate(fd, (off_t)(TTAC_SPOOL_HDR_SIZE + size)) == -1) )
+   {
+      close(fd);
+      return(NULL);
+   };
+   if (sb.st_size == 0)
+      sb.st_size = (off_t)(TTAC_SPOOL_HDR_SIZE + size);
+   flock(fd, LOCK_UN);
+
+   if ( (sb.st_size <= TTAC_SPOOL_HDR_SIZE) || (((sb.st_size - TTAC_SPOOL_HDR_SIZE) % 8)) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected size", __func__, path);
+      close(fd);
+      return(NULL);
+   };
+
+   map = mmap(NULL, (size_t)sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (map == MAP_FAILED)
+   {
+      close(fd);
+      return(NULL);
+   };
+   hdr = map;
+
+   // initialize header of new spool; concurrent initializers write identical values
+   if (atomic_load_explicit(&hdr->magic, memory_order_acquire) == 0)
+   {
+      hdr->size   = (uint64_t)sb.st_size - TTAC_SPOOL_HDR_SIZE;
+      magic       = 0;
+      atomic_compare_exchange_strong_explicit(&hdr->magic, &magic, TTAC_SPOOL_MAGIC, memory_order_release, memory_order_acquire);
+   };
+   if ( (atomic_load_explicit(&hdr->magic, memory_order_acquire) != TTAC_SPOOL_MAGIC) ||
+        (hdr->size != ((uint64_t)sb.st_size - TTAC_SPOOL_HDR_SIZE)) ||
+        (hdr->size >  TTAC_SPOOL_LEN_MASK) )
+   {
+      TinyTacDebug(TTAC_DEBUG_CONNS, "   == %s(): %s has unexpected format", __func__, path);
+      munmap(map, (size_t)sb.st_size);
+      close(fd);
+      return(NULL);
+   };
+
+   if ((spool = tinytac_mem_alloc(sizeof(tinytac_spool_t))) == NULL)
+   {
+      munmap(map, (size_t)sb.st_size);
+      close(fd);
+      return(NULL);
+   };
+   spool->fd            = fd;
+   spool->map_len       = (size_t)sb.st_size;
+   spool->hdr           = hdr;
+   spool->ring          = ((uint8_t *)map) + TTAC_SPOOL_HDR_SIZE;
+   spool->stall_pos     = UINT64_MAX;
+   spool->stall_next    = UINT64_MAX;
+   spool->stall_since   = 0;
+
+   return(spool);
+}
+
+
+/// copies records from replay cursor
+///
+/// Damaged records are skipped.  A record which is not published within
+/// TTAC_SPOOL_STALL seconds is assumed to belong to a process which
+/// terminated while writing it and is skipped.  The length of a record
+/// which was never marked is taken from the start of the next record.
+///
+/// @param[in]  spool         reference to spool
+/// @param[out] batch         list to store copies of records
+/// @param[in]  max           size of list
+/// @param[out] cursorp       pointer to store offset following the records
+///
+/// @return    Returns number of records copied.
+size_t
+tinytac_spool_read(
+         tinytac_spool_t *             spool,
+         tinytac_pckt_t **             batch,
+         size_t                        max,
+         uint64_t *                    cursorp )
+{
+   size_t                  n;
+   size_t                  need;
+   uint32_t                len;
+   uint64_t                pos;
+   uint64_t                off;
+   uint64_t                next;
+   uint64_t                tail;
+   uint64_t                size;
+   tinytac_spool_rec_t *   rec;
+   tinytac_pckt_t *        pckt;
+
+   size  = spool->hdr->size;
+   pos   = atomic_load_explicit(&spool->hdr->head, memory_order_relaxed);
+   tail  = atomic_load_explicit(&spool->hdr->tail, memory_order_acquire);
+
+   for(n = 0; ( (n < max) && (pos < tail) ); pos += need)
+   {
+      off   = pos % size;
+      rec   = (tinytac_spool_rec_t *)&spool->ring[off];
+      len   = atomic_load_explicit(&rec->len, memory_order_acquire);
+      need  = TTAC_SPOOL_ALIGN(sizeof(tinytac_spool_rec_t) + (len & TTAC_SPOOL_LEN_MASK));
+
+      // filler must end at the end of the ring
+      if ((len & TTAC_SPOOL_PAD))
+      {
+         if ((len & TTAC_SPOOL_LEN_MASK) != (size - off))
+         {
+            pos = tail;
+            break;
+         };
+         need = (size_t)(size - off);
+         continue;
+      };
+
+      // unpublished record
+      if ( (!(len)) || ((len & TTAC_SPOOL_PENDING)) )
+      {
+         next = ((len)) ? (pos + need) : tinytac_spool_next(spool, pos, tail);
+         if (!(tinytac_spool_stalled(spool, pos, next)))
+            break;
+         need = (size_t)(next - pos);
+         continue;
+      };
+
+      if ( (len < sizeof(tinytac_pckt_t)) || (len > TTAC_ACCT_RECORD_MAX) || ((off + need) > size) )
+      {
+         pos = tail;
+         break;
+      };
+      if (rec->sum != (uint32_t)tinytac_hash(TTAC_HASH_INIT, rec->data, len))
+         continue;
+      if (ntohl(((tinytac_pckt_t *)rec->data)->pckt_length) != (len - sizeof(tinytac_pckt_t)))
+         continue;
+
+      if ((pckt = tinytac_mem_alloc(len)) == NULL)
+         break;
+      memcpy(pckt, rec->data, len);
+      batch[n++] = pckt;
+   };
+
+   *cursorp = (pos < tail) ? pos : tail;
+
+   return(n);
+}
+
+
+/// finds start of record following a record which was never marked
+///
+/// @param[in]  spool         reference to spool
+/// @param[in]  pos           offset of unmarked record
+/// @param[in]  tail          offset following the last reserved record
+///
+/// @return    Returns offset of next marked record or tail.
+uint64_t
+tinytac_spool_next(
+         tinytac_spool_t *             spool,
+         uint64_t                      pos,
+         uint64_t                      tail )
+{
+   uint64_t                size;
+   tinytac_spool_rec_t *   rec;
+
+   size = spool->hdr->size;
+
+   for(pos += 8; (pos < tail); pos += 8)
+   {
+      rec = (tinytac_spool_rec_t *)&spool->ring[pos % size];
+      if (atomic_load_explicit(&rec->len, memory_order_acquire) != 0)
+         return(pos);
+   };
+
+   return(tail);
+}
+
+
+/// determines if record at offset has been unpublished for too long
+///
+/// The end of a record which was never marked must not change during the
+/// wait, otherwise a record of a live writer may have been included.
+///
+/// @param[in]  spool         reference to spool
+/// @param[in]  pos           offset of record
+/// @param[in]  next          offset following record
+///
+/// @return    Returns 1 if the record should be skipped, otherwise 0.
+int
+tinytac_spool_stalled(
+         tinytac_spool_t *             spool,
+         uint64_t                      pos,
+         uint64_t                      next )
+{
+   uint64_t now;
+   now = tinytac_cache_now();
+   if ( (spool->stall_pos != pos) || (spool->stall_next != next) )
+   {
+      spool->stall_pos     = pos;
+      spool->stall_next    = next;
+      spool->stall_since   = now;
+      return(0);
+   };
+   return(((now - spool->stall_since) >= TTAC_SPOOL_STALL) ? 1 : 0);
+}
+
+
+/// writes records appended since the previous call to disk
+///
+/// @param[in]  spool         reference to spool
+void
+tinytac_spool_sync(
+         tinytac_spool_t *             spool )
+{
+   uint64_t tail;
+   tail = atomic_load_explicit(&spool->hdr->tail, memory_order_acquire);
+   if (tail == atomic_load_explicit(&spool->hdr->synced, memory_order_relaxed))
+      return;
+   if (msync(spool->hdr, spool->map_len, MS_SYNC) == -1)
+      return;
+   atomic_store_explicit(&spool->hdr->synced, tail, memory_order_relaxed);
+   return;
+}
+
+
+/// obtains exclusive right to replay spool
+///
+/// @param[in]  spool         reference to spool
+///
+/// @return    Returns 0 on success or -1 if another drainer holds the spool.
+int
+tinytac_spool_trylock(
+         tinytac_spool_t *             spool )
+{
+   return((flock(spool->fd, LOCK_EX | LOCK_NB) == -1) ? -1 : 0);
+}
+
+
+void
+tinytac_spool_unlock(
+         tinytac_spool_t *             spool )
+{
+   flock(spool->fd, LOCK_UN);
+   return;
+}
+
+
+/* end of source */
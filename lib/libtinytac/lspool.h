@@ -0,0 +1,117 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LSPOOL_H
+#define _LIB_LIBTINYTAC_LSPOOL_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_SPOOL_MAGIC            0x314c505343415454ULL   // "TTACSPL1"
+#define TTAC_SPOOL_HDR_SIZE         4096
+#define TTAC_SPOOL_MODE             0600
+#ifndef TTAC_SPOOL_STALL
+#   define TTAC_SPOOL_STALL         10          // seconds before an unfinished record is skipped
+#endif
+
+#define TTAC_SPOOL_PENDING          0x80000000U // record is being written
+#define TTAC_SPOOL_PAD              0x40000000U // filler before end of ring
+#define TTAC_SPOOL_LEN_MASK         0x3fffffffU
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+tinytac_spool_append(
+         tinytac_spool_t *             spool,
+         const tinytac_pckt_t *        pckt );
+
+
+void
+tinytac_spool_close(
+         tinytac_spool_t *             spool );
+
+
+void
+tinytac_spool_commit(
+         tinytac_spool_t *             spool,
+         uint64_t                      cursor );
+
+
+tinytac_spool_t *
+tinytac_spool_open(
+         const char *                  path,
+         size_t                        size );
+
+
+size_t
+tinytac_spool_read(
+         tinytac_spool_t *             spool,
+         tinytac_pckt_t **             batch,
+         size_t                        max,
+         uint64_t *                    cursorp );
+
+
+void
+tinytac_spool_sync(
+         tinytac_spool_t *             spool );
+
+
+int
+tinytac_spool_trylock(
+         tinytac_spool_t *             spool );
+
+
+void
+tinytac_spool_unlock(
+         tinytac_spool_t *             spool );
+
+
+#endif /* end of header */
@@ -0,0 +1,788 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _LIB_LIBTINYTAC_LSTATS_C 1
+#include "lstats.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+#ifdef HAVE_SCHED_GETCPU
+#   include <sched.h>
+#endif
+
+#include "lacct.h"
+#include "lcache.h"
+#include "lmemory.h"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// text rendered into buffer of caller
+typedef struct _tinytac_stats_text
+{
+   char *                  buff;
+   size_t                  size;
+   size_t                  len;        // length of complete text, may exceed size
+} tinytac_stats_text_t;
+
+
+// exported counter
+typedef struct _tinytac_stats_counter
+{
+   const char *            name;
+   const char *            help;
+   int                     servers;    // counted for each server
+} tinytac_stats_counter_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static size_t
+tinytac_metrics_bucket(
+         uint64_t                      usec );
+
+
+static tinytac_metrics_stripe_t *
+tinytac_metrics_stripe(
+         tinytac_metrics_t *           metrics );
+
+
+static void
+tinytac_metrics_sum(
+         tinytac_metrics_t *           metrics,
+         uint64_t *                    counters );
+
+
+static void
+tinytac_stats_printf(
+         tinytac_stats_text_t *        text,
+         const char *                  fmt,
+         ... );
+
+
+static void
+tinytac_trace_phase(
+         tinytac_metrics_t *           server,
+         unsigned                      phase,
+         uint64_t                      start,
+         uint64_t                      end );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// serializes resets with reads of metrics, never taken by requests
+static pthread_mutex_t     tinytac_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static const tinytac_stats_counter_t tinytac_stats_counters[TTAC_STAT_MAX] =
+{
+   [TTAC_STAT_REQUESTS]       = { "requests",       "Requests sent to servers.",                    TTAC_YES },
+   [TTAC_STAT_FAILURES]       = { "failures",       "Requests and connections which failed.",       TTAC_YES },
+   [TTAC_STAT_TIMEOUTS]       = { "timeouts",       "Connects, reads and writes which timed out.",  TTAC_YES },
+   [TTAC_STAT_RETRIES]        = { "retries",        "Servers tried after a server failed.",         TTAC_NO },
+   [TTAC_STAT_CACHE_HITS]     = { "cache_hits",     "Authorizations answered by caches.",           TTAC_NO },
+   [TTAC_STAT_CACHE_MISSES]   = { "cache_misses",   "Authorizations not found in caches.",          TTAC_NO },
+};
+
+
+static const char * tinytac_stats_phases[TTAC_PHASES] =
+{
+   [TTAC_PHASE_RESOLVE]       = "resolve",
+   [TTAC_PHASE_CONNECT]       = "connect",
+   [TTAC_PHASE_SEND]          = "send",
+   [TTAC_PHASE_FIRST_BYTE]    = "first_byte",
+   [TTAC_PHASE_REPLY]         = "reply",
+   [TTAC_PHASE_DEOBFUSCATE]   = "deobfuscate",
+};
+
+
+// timing of the last request of the calling thread
+static _Thread_local tinytac_trace_t   tinytac_trace_tls;
+
+
+#ifndef HAVE_SCHED_GETCPU
+static atomic_uint               tinytac_metrics_threads;
+static _Thread_local unsigned    tinytac_metrics_tstripe;
+#endif
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-------------------//
+// metrics functions //
+//-------------------//
+#pragma mark metrics functions
+
+/// adds to counter of handle and server
+///
+/// @param[in]  tt            reference to library handle or NULL
+/// @param[in]  server        metrics of server or NULL
+/// @param[in]  counter       TTAC_STAT_* counter
+/// @param[in]  n             amount to add
+void
+tinytac_metrics_add(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           server,
+         unsigned                      counter,
+         uint64_t                      n )
+{
+   assert(counter < TTAC_STAT_MAX);
+   if ( ((tt)) && ((tt->metrics)) )
+      atomic_fetch_add_explicit(&tinytac_metrics_stripe(tt->metrics)->counters[counter], n, memory_order_relaxed);
+   if ((server))
+      atomic_fetch_add_explicit(&tinytac_metrics_stripe(server)->counters[counter], n, memory_order_relaxed);
+   return;
+}
+
+
+/// allocates zeroed metrics of handle or of each server of a set
+///
+/// @param[in]  n             number of metrics
+///
+/// @return    Returns array of metrics or NULL on error.
+tinytac_metrics_t *
+tinytac_metrics_alloc(
+         size_t                        n )
+{
+   size_t               pos;
+   tinytac_metrics_t *  metrics;
+   n = ((n)) ? n : 1;
+   if ((metrics = tinytac_mem_calloc(n, sizeof(tinytac_metrics_t))) == NULL)
+      return(NULL);
+   for(pos = 0; (pos < n); pos++)
+      metrics[pos].server = (int)pos;
+   return(metrics);
+}
+
+
+/// returns histogram bucket of latency
+///
+/// @param[in]  usec          latency in microseconds
+///
+/// @return    Returns index of bucket.
+size_t
+tinytac_metrics_bucket(
+         uint64_t                      usec )
+{
+   unsigned msb;
+
+   if (usec < 16)
+      return((size_t)usec);
+   if (usec > 0xffffffffULL)
+      usec = 0xffffffffULL;
+
+#if defined(__GNUC__)
+   msb = 63 - (unsigned)__builtin_clzll(usec);
+#else
+   for(msb = 4; ((usec >> (msb + 1))); msb++);
+#endif
+
+   return((size_t)(((msb - 2) * 8) + ((usec >> (msb - 3)) & 0x07)));
+}
+
+
+/// copies counters counted since the last reset
+///
+/// @param[in]  metrics       metrics of handle or server
+/// @param[out] counters      array of TTAC_STAT_MAX counters
+void
+tinytac_metrics_counters(
+         tinytac_metrics_t *           metrics,
+         uint64_t *                    counters )
+{
+   size_t      idx;
+
+   pthread_mutex_lock(&tinytac_metrics_mutex);
+   tinytac_metrics_sum(metrics, counters);
+   for(idx = 0; (idx < TTAC_STAT_MAX); idx++)
+      counters[idx] -= metrics->base[idx];
+   pthread_mutex_unlock(&tinytac_metrics_mutex);
+
+   return;
+}
+
+
+void
+tinytac_metrics_free(
+         tinytac_metrics_t *           metrics )
+{
+   tinytac_mem_free(metrics);
+   return;
+}
+
+
+/// adds metrics of replaced server to metrics of its replacement
+///
+/// @param[in]  dst           metrics of server in new set
+/// @param[in]  src           metrics of server in replaced set
+void
+tinytac_metrics_merge(
+         tinytac_metrics_t *           dst,
+         tinytac_metrics_t *           src )
+{
+   size_t      pos;
+   size_t      idx;
+   unsigned    phase;
+
+   pthread_mutex_lock(&tinytac_metrics_mutex);
+   for(pos = 0; (pos < TTAC_METRICS_STRIPES); pos++)
+      for(idx = 0; (idx < TTAC_STAT_MAX); idx++)
+         atomic_fetch_add_explicit(&dst->stripes[pos].counters[idx], atomic_load_explicit(&src->stripes[pos].counters[idx], memory_order_relaxed), memory_order_relaxed);
+   for(phase = 0; (phase < TTAC_PHASES); phase++)
+   {
+      atomic_fetch_add_explicit(&dst->sum[phase], atomic_load_explicit(&src->sum[phase], memory_order_relaxed), memory_order_relaxed);
+      for(idx = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+         atomic_fetch_add_explicit(&dst->hist[phase][idx], atomic_load_explicit(&src->hist[phase][idx], memory_order_relaxed), memory_order_relaxed);
+   };
+   memcpy(dst->base,       src->base,        sizeof(dst->base));
+   memcpy(dst->base_sum,   src->base_sum,    sizeof(dst->base_sum));
+   memcpy(dst->base_hist,  src->base_hist,   sizeof(dst->base_hist));
+   pthread_mutex_unlock(&tinytac_metrics_mutex);
+
+   return;
+}
+
+
+/// formats host and port of server as name of its statistics
+///
+/// @param[in]  budp          URL of server
+/// @param[out] buff          buffer to store name
+/// @param[in]  size          size of buffer
+void
+tinytac_metrics_name(
+         const BindleURLDesc *         budp,
+         char *                        buff,
+         size_t                        size )
+{
+   const char *   host;
+   host = ((budp->bud_host)) ? budp->bud_host : "";
+   if ((strchr(host, ':')))
+      snprintf(buff, size, "[%s]:%u", host, (unsigned)budp->bud_port);
+   else
+      snprintf(buff, size, "%s:%u", host, (unsigned)budp->bud_port);
+   return;
+}
+
+
+/// returns monotonic time used to measure phases
+///
+/// @return    Returns time in nanoseconds.
+uint64_t
+tinytac_metrics_now(
+         void )
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec);
+}
+
+
+/// counts latency of phase in histograms of handle and server
+///
+/// @param[in]  tt            reference to library handle or NULL
+/// @param[in]  server        metrics of server or NULL
+/// @param[in]  phase         TTAC_PHASE_* phase
+/// @param[in]  start         time phase started
+///
+/// @return    Returns time phase ended.
+uint64_t
+tinytac_metrics_phase(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           server,
+         unsigned                      phase,
+         uint64_t                      start )
+{
+   uint64_t    now;
+   uint64_t    usec;
+   size_t      idx;
+
+   assert(phase < TTAC_PHASES);
+
+   now = tinytac_metrics_now();
+   tinytac_trace_phase(server, phase, start, now);
+   if ( ((!(tt)) || (!(tt->metrics))) && (!(server)) )
+      return(now);
+
+   usec  = (now > start) ? ((now - start) / 1000) : 0;
+   idx   = tinytac_metrics_bucket(usec);
+   if ( ((tt)) && ((tt->metrics)) )
+   {
+      atomic_fetch_add_explicit(&tt->metrics->hist[phase][idx], 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&tt->metrics->sum[phase], usec, memory_order_relaxed);
+   };
+   if ((server))
+   {
+      atomic_fetch_add_explicit(&server->hist[phase][idx], 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&server->sum[phase], usec, memory_order_relaxed);
+   };
+
+   return(now);
+}
+
+
+/// copies metrics counted since the last reset
+///
+/// @param[in]  metrics       metrics of handle or server
+/// @param[out] stats         statistics to populate, the server name is
+///                           not modified
+void
+tinytac_metrics_read(
+         tinytac_metrics_t *           metrics,
+         tinytac_stats_t *             stats )
+{
+   size_t      idx;
+   unsigned    phase;
+   uint64_t    counters[TTAC_STAT_MAX];
+
+   pthread_mutex_lock(&tinytac_metrics_mutex);
+
+   tinytac_metrics_sum(metrics, counters);
+   stats->requests      = counters[TTAC_STAT_REQUESTS]      - metrics->base[TTAC_STAT_REQUESTS];
+   stats->failures      = counters[TTAC_STAT_FAILURES]      - metrics->base[TTAC_STAT_FAILURES];
+   stats->timeouts      = counters[TTAC_STAT_TIMEOUTS]      - metrics->base[TTAC_STAT_TIMEOUTS];
+   stats->retries       = counters[TTAC_STAT_RETRIES]       - metrics->base[TTAC_STAT_RETRIES];
+   stats->cache_hits    = counters[TTAC_STAT_CACHE_HITS]    - metrics->base[TTAC_STAT_CACHE_HITS];
+   stats->cache_misses  = counters[TTAC_STAT_CACHE_MISSES]  - metrics->base[TTAC_STAT_CACHE_MISSES];
+
+   for(phase = 0; (phase < TTAC_PHASES); phase++)
+   {
+      stats->count[phase]  = 0;
+      stats->sum[phase]    = atomic_load_explicit(&metrics->sum[phase], memory_order_relaxed) - metrics->base_sum[phase];
+      for(idx = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+      {
+         stats->hist[phase][idx]  = atomic_load_explicit(&metrics->hist[phase][idx], memory_order_relaxed) - metrics->base_hist[phase][idx];
+         stats->count[phase]     += stats->hist[phase][idx];
+      };
+   };
+
+   pthread_mutex_unlock(&tinytac_metrics_mutex);
+
+   return;
+}
+
+
+/// starts counting metrics from zero
+///
+/// @param[in]  metrics       metrics of handle or server
+void
+tinytac_metrics_reset(
+         tinytac_metrics_t *           metrics )
+{
+   size_t      idx;
+   unsigned    phase;
+
+   pthread_mutex_lock(&tinytac_metrics_mutex);
+
+   tinytac_metrics_sum(metrics, metrics->base);
+   for(phase = 0; (phase < TTAC_PHASES); phase++)
+   {
+      metrics->base_sum[phase] = atomic_load_explicit(&metrics->sum[phase], memory_order_relaxed);
+      for(idx = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+         metrics->base_hist[phase][idx] = atomic_load_explicit(&metrics->hist[phase][idx], memory_order_relaxed);
+   };
+
+   pthread_mutex_unlock(&tinytac_metrics_mutex);
+
+   return;
+}
+
+
+/// returns counters of CPU running the calling thread
+///
+/// Threads on different CPUs update different cache lines.  Without
+/// sched_getcpu() each thread is assigned a stripe when it first counts.
+///
+/// @param[in]  metrics       metrics of handle or server
+///
+/// @return    Returns stripe of counters.
+tinytac_metrics_stripe_t *
+tinytac_metrics_stripe(
+         tinytac_metrics_t *           metrics )
+{
+#ifdef HAVE_SCHED_GETCPU
+   int cpu;
+   if ((cpu = sched_getcpu()) < 0)
+      cpu = 0;
+   return(&metrics->stripes[(unsigned)cpu & (TTAC_METRICS_STRIPES-1)]);
+#else
+   if (!(tinytac_metrics_tstripe))
+      tinytac_metrics_tstripe = atomic_fetch_add_explicit(&tinytac_metrics_threads, 1, memory_order_relaxed) + 1;
+   return(&metrics->stripes[tinytac_metrics_tstripe & (TTAC_METRICS_STRIPES-1)]);
+#endif
+}
+
+
+/// adds counters of all stripes
+///
+/// @param[in]  metrics       metrics of handle or server
+/// @param[out] counters      array of TTAC_STAT_MAX counters
+void
+tinytac_metrics_sum(
+         tinytac_metrics_t *           metrics,
+         uint64_t *                    counters )
+{
+   size_t      pos;
+   size_t      idx;
+
+   for(idx = 0; (idx < TTAC_STAT_MAX); idx++)
+      counters[idx] = 0;
+   for(pos = 0; (pos < TTAC_METRICS_STRIPES); pos++)
+      for(idx = 0; (idx < TTAC_STAT_MAX); idx++)
+         counters[idx] += atomic_load_explicit(&metrics->stripes[pos].counters[idx], memory_order_relaxed);
+
+   return;
+}
+
+
+//-----------------//
+// stats functions //
+//-----------------//
+#pragma mark stats functions
+
+uint64_t
+tinytac_stats_bucket(
+         size_t                        idx )
+{
+   unsigned shift;
+   if (idx >= TTAC_STATS_BUCKETS)
+      return(UINT64_MAX);
+   if (idx < 16)
+      return((uint64_t)idx);
+   shift = (unsigned)(idx / 8) - 1;
+   return(((uint64_t)((idx % 8) + 9) << shift) - 1);
+}
+
+
+int
+tinytac_stats_openmetrics(
+         TinyTac *                     tt,
+         char *                        buff,
+         size_t                        size,
+         size_t *                      lenp )
+{
+   size_t                  idx;
+   size_t                  len;
+   size_t                  pos;
+   size_t                  sessions;
+   unsigned                counter;
+   unsigned                phase;
+   uint64_t                total;
+   uint64_t                queued;
+   uint64_t                dropped;
+   uint64_t                counters[TTAC_STAT_MAX];
+   uint64_t                scounters[TTAC_STAT_MAX];
+   char                    labels[sizeof(((tinytac_stats_t *)NULL)->server) + 48];
+   const char *            name;
+   tinytac_servers_t *     servers;
+   tinytac_metrics_t *     metrics;
+   tinytac_stats_text_t    text;
+   tinytac_stats_t         stats;
+
+   TinyTacDebugTrace();
+
+   assert(tt != NULL);
+   assert( ((buff)) || (!(size)) );
+
+   text.buff   = buff;
+   text.size   = size;
+   text.len    = 0;
+   if ((size))
+      buff[0] = '\0';
+   if ((lenp))
+      *lenp = 0;
+
+   if (!(tt->metrics))
+      return(TTAC_EINVAL);
+
+   servers = tinytac_servers_acquire(tt);
+   for(len = 0; ( ((servers)) && ((servers->metrics)) && ((servers->budps)) && ((servers->budps[len])) ); len++);
+
+   // samples of a metric family are listed together; counters of servers
+   // are read per family because the buffer of the caller is the only
+   // memory available
+   tinytac_metrics_counters(tt->metrics, counters);
+   for(counter = 0; (counter < TTAC_STAT_MAX); counter++)
+   {
+      name = tinytac_stats_counters[counter].name;
+      tinytac_stats_printf(&text, "# TYPE tinytac_%s counter\n", name);
+      tinytac_stats_printf(&text, "# HELP tinytac_%s %s\n", name, tinytac_stats_counters[counter].help);
+      tinytac_stats_printf(&text, "tinytac_%s_total %" PRIu64 "\n", name, counters[counter]);
+      for(idx = 0; ( ((tinytac_stats_counters[counter].servers)) && (idx < len) ); idx++)
+      {
+         tinytac_metrics_name(servers->budps[idx], stats.server, sizeof(stats.server));
+         tinytac_metrics_counters(&servers->metrics[idx], scounters);
+         tinytac_stats_printf(&text, "tinytac_%s_total{server=\"%s\"} %" PRIu64 "\n", name, stats.server, scounters[counter]);
+      };
+   };
+
+   // pooled sessions, cache and accounting queue
+   pthread_mutex_lock(&tt->sessions_mutex);
+   sessions = tt->sessions_cnt;
+   pthread_mutex_unlock(&tt->sessions_mutex);
+   tinytac_acct_stats(tt, &queued, &dropped);
+   tinytac_stats_printf(&text, "# TYPE tinytac_sessions_idle gauge\n");
+   tinytac_stats_printf(&text, "# HELP tinytac_sessions_idle Idle sessions kept for reuse.\n");
+   tinytac_stats_printf(&text, "tinytac_sessions_idle %zu\n", sessions);
+   tinytac_stats_printf(&text, "# TYPE tinytac_cache_entries gauge\n");
+   tinytac_stats_printf(&text, "# HELP tinytac_cache_entries Replies in authorization cache of process.\n");
+   tinytac_stats_printf(&text, "tinytac_cache_entries %zu\n", tinytac_cache_count(tt));
+   tinytac_stats_printf(&text, "# TYPE tinytac_acct_queued gauge\n");
+   tinytac_stats_printf(&text, "# HELP tinytac_acct_queued Accounting records waiting to be sent.\n");
+   tinytac_stats_printf(&text, "tinytac_acct_queued %" PRIu64 "\n", queued);
+   tinytac_stats_printf(&text, "# TYPE tinytac_acct_dropped counter\n");
+   tinytac_stats_printf(&text, "# HELP tinytac_acct_dropped Accounting records discarded.\n");
+   tinytac_stats_printf(&text, "tinytac_acct_dropped_total %" PRIu64 "\n", dropped);
+
+   // latency histograms of handle followed by servers, microseconds are
+   // truncated so a bucket holds latencies below its largest value plus one;
+   // every eighth bucket ends below a power of two and is always listed so
+   // the boundaries of a series do not change between scrapes
+   tinytac_stats_printf(&text, "# TYPE tinytac_latency_seconds histogram\n");
+   tinytac_stats_printf(&text, "# HELP tinytac_latency_seconds Latency of phases of requests.\n");
+   for(idx = 0; (idx <= len); idx++)
+   {
+      stats.server[0] = '\0';
+      metrics         = tt->metrics;
+      if ((idx))
+      {
+         tinytac_metrics_name(servers->budps[idx-1], stats.server, sizeof(stats.server));
+         metrics = &servers->metrics[idx-1];
+      };
+      tinytac_metrics_read(metrics, &stats);
+      for(phase = 0; (phase < TTAC_PHASES); phase++)
+      {
+         if ((idx))
+            snprintf(labels, sizeof(labels), "phase=\"%s\",server=\"%s\"", tinytac_stats_phases[phase], stats.server);
+         else
+            snprintf(labels, sizeof(labels), "phase=\"%s\"", tinytac_stats_phases[phase]);
+         for(pos = 0, total = 0; (pos < TTAC_STATS_BUCKETS); pos++)
+         {
+            total += stats.hist[phase][pos];
+            if ((pos % 8) != 7)
+               continue;
+            tinytac_stats_printf(&text, "tinytac_latency_seconds_bucket{%s,le=\"%.6f\"} %" PRIu64 "\n", labels, ((double)(tinytac_stats_bucket(pos) + 1) / 1000000.0), total);
+         };
+         tinytac_stats_printf(&text, "tinytac_latency_seconds_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n", labels, stats.count[phase]);
+         tinytac_stats_printf(&text, "tinytac_latency_seconds_count{%s} %" PRIu64 "\n", labels, stats.count[phase]);
+         tinytac_stats_printf(&text, "tinytac_latency_seconds_sum{%s} %.6f\n", labels, ((double)stats.sum[phase] / 1000000.0));
+      };
+   };
+
+   tinytac_servers_release(servers);
+
+   tinytac_stats_printf(&text, "# EOF\n");
+
+   if ((lenp))
+      *lenp = text.len;
+
+   return((text.len < size) ? TTAC_SUCCESS : TTAC_ENOBUFS);
+}
+
+
+uint64_t
+tinytac_stats_percentile(
+         const tinytac_stats_t *       stats,
+         unsigned                      phase,
+         double                        percentile )
+{
+   size_t      idx;
+   uint64_t    rank;
+   uint64_t    seen;
+
+   assert(stats != NULL);
+
+   if ( (phase >= TTAC_PHASES) || (!(stats->count[phase])) )
+      return(0);
+
+   percentile  = (percentile < 0.0)   ? 0.0   : percentile;
+   percentile  = (percentile > 100.0) ? 100.0 : percentile;
+   rank        = (uint64_t)(((double)stats->count[phase] * percentile) / 100.0);
+   rank        = (rank < 1) ? 1 : rank;
+
+   for(idx = 0, seen = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+      if ((seen += stats->hist[phase][idx]) >= rank)
+         return(tinytac_stats_bucket(idx));
+
+   return(tinytac_stats_bucket(TTAC_STATS_BUCKETS - 1));
+}
+
+
+/// appends formatted text to buffer of caller
+///
+/// Text which does not fit is counted but not written.
+///
+/// @param[in]  text          text being rendered
+/// @param[in]  fmt           printf() format
+void
+tinytac_stats_printf(
+         tinytac_stats_text_t *        text,
+         const char *                  fmt,
+         ... )
+{
+   int            rc;
+   size_t         avail;
+   va_list        args;
+
+   avail = (text->len < text->size) ? (text->size - text->len) : 0;
+
+   va_start(args, fmt);
+   rc = vsnprintf((((avail)) ? &text->buff[text->len] : NULL), avail, fmt, args);
+   va_end(args);
+
+   if (rc > 0)
+      text->len += (size_t)rc;
+
+   return;
+}
+
+
+//-----------------//
+// trace functions //
+//-----------------//
+#pragma mark trace functions
+
+/// starts timing of a request made by the calling thread
+void
+tinytac_trace_begin(
+         void )
+{
+   memset(&tinytac_trace_tls, 0, sizeof(tinytac_trace_tls));
+   tinytac_trace_tls.server   = -1;
+   tinytac_trace_tls.start    = tinytac_metrics_now();
+   return;
+}
+
+
+/// finishes timing of request made by the calling thread
+///
+/// @param[in]  rc            result of request
+///
+/// @return    Returns result of request.
+int
+tinytac_trace_end(
+         int                           rc )
+{
+   tinytac_trace_tls.end      = tinytac_metrics_now();
+   tinytac_trace_tls.result   = rc;
+   return(rc);
+}
+
+
+/// records phase of request in trace of the calling thread
+///
+/// Resolving the name of a server starts another attempt, so phases of a
+/// previous server are discarded.
+///
+/// @param[in]  server        metrics of server or NULL
+/// @param[in]  phase         TTAC_PHASE_* phase
+/// @param[in]  start         time phase started
+/// @param[in]  end           time phase ended
+void
+tinytac_trace_phase(
+         tinytac_metrics_t *           server,
+         unsigned                      phase,
+         uint64_t                      start,
+         uint64_t                      end )
+{
+   tinytac_trace_t *    trace;
+
+   trace = &tinytac_trace_tls;
+   if (phase == TTAC_PHASE_RESOLVE)
+   {
+      memset(trace->phase_start, 0, sizeof(trace->phase_start));
+      memset(trace->phase_end,   0, sizeof(trace->phase_end));
+      trace->attempts++;
+   };
+   trace->phase_start[phase]  = start;
+   trace->phase_end[phase]    = end;
+   trace->server              = TTAC_METRICS_SERVER(server);
+
+   return;
+}
+
+
+/// copies timing of the last request of the calling thread
+///
+/// @param[out] trace         trace to populate
+void
+tinytac_trace_read(
+         tinytac_trace_t *             trace )
+{
+   memcpy(trace, &tinytac_trace_tls, sizeof(tinytac_trace_t));
+   return;
+}
+
+
+/// records session_id of request sent by the calling thread
+///
+/// @param[in]  session_id    session_id in host byte order
+void
+tinytac_trace_session(
+         uint32_t                      session_id )
+{
+   tinytac_trace_tls.session_id = session_id;
+   return;
+}
+
+/* end of source */
@@ -0,0 +1,187 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _LIB_LIBTINYTAC_LSTATS_H
+#define _LIB_LIBTINYTAC_LSTATS_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libtinytac.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define TTAC_METRICS_STRIPES        16    // counters per metrics, power of two
+
+
+// position of server of metrics in list of hosts, -1 if not a server
+#define TTAC_METRICS_SERVER( metrics ) (((metrics)) ? (metrics)->server : -1)
+
+
+// counters of metrics
+#define TTAC_STAT_REQUESTS          0
+#define TTAC_STAT_FAILURES          1
+#define TTAC_STAT_TIMEOUTS          2
+#define TTAC_STAT_RETRIES           3
+#define TTAC_STAT_CACHE_HITS        4
+#define TTAC_STAT_CACHE_MISSES      5
+#define TTAC_STAT_MAX               6
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// counters updated by threads running on the same CPU, padded to a cache line
+typedef struct _tinytac_metrics_stripe
+{
+   _Atomic uint64_t        counters[TTAC_STAT_MAX];
+   uint8_t                 pad[64 - (TTAC_STAT_MAX * sizeof(uint64_t))];
+} tinytac_metrics_stripe_t;
+
+
+// Metrics are only added to while requests are running.  A reset records
+// the current values as the base which is subtracted when the metrics are
+// read, so threads never wait for a reset and no sample is lost.
+struct _tinytac_metrics
+{
+   tinytac_metrics_stripe_t   stripes[TTAC_METRICS_STRIPES];
+   _Atomic uint64_t           sum[TTAC_PHASES];
+   _Atomic uint64_t           hist[TTAC_PHASES][TTAC_STATS_BUCKETS];
+   uint64_t                   base[TTAC_STAT_MAX];    // values at last reset
+   uint64_t                   base_sum[TTAC_PHASES];
+   uint64_t                   base_hist[TTAC_PHASES][TTAC_STATS_BUCKETS];
+   int                        server;  // position in list of hosts
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+void
+tinytac_metrics_add(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           server,
+         unsigned                      counter,
+         uint64_t                      n );
+
+
+tinytac_metrics_t *
+tinytac_metrics_alloc(
+         size_t                        n );
+
+
+void
+tinytac_metrics_counters(
+         tinytac_metrics_t *           metrics,
+         uint64_t *                    counters );
+
+
+void
+tinytac_metrics_free(
+         tinytac_metrics_t *           metrics );
+
+
+void
+tinytac_metrics_merge(
+         tinytac_metrics_t *           dst,
+         tinytac_metrics_t *           src );
+
+
+void
+tinytac_metrics_name(
+         const BindleURLDesc *         budp,
+         char *                        buff,
+         size_t                        size );
+
+
+uint64_t
+tinytac_metrics_now(
+         void );
+
+
+uint64_t
+tinytac_metrics_phase(
+         TinyTac *                     tt,
+         tinytac_metrics_t *           server,
+         unsigned                      phase,
+         uint64_t                      start );
+
+
+void
+tinytac_metrics_read(
+         tinytac_metrics_t *           metrics,
+         tinytac_stats_t *             stats );
+
+
+void
+tinytac_metrics_reset(
+         tinytac_metrics_t *           metrics );
+
+
+void
+tinytac_trace_begin(
+         void );
+
+
+int
+tinytac_trace_end(
+         int                           rc );
+
+
+void
+tinytac_trace_read(
+         tinytac_trace_t *             trace );
+
+
+void
+tinytac_trace_session(
+         uint32_t                      session_id );
+
+
+#endif /* end of header */
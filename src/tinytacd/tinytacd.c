@@ -0,0 +1,1194 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _SRC_TINYTACD_TINYTACD_C 1
+#include "tinytacd.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <syslog.h>
+#include <errno.h>
+#include <assert.h>
+#include <grp.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <tinytac.h>
+#include <bindle_prefix.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#ifndef PACKAGE_BUGREPORT
+#   define PACKAGE_BUGREPORT "unknown"
+#endif
+#ifndef PACKAGE_COPYRIGHT
+#   define PACKAGE_COPYRIGHT "unknown"
+#endif
+#ifndef PACKAGE_NAME
+#   define PACKAGE_NAME "Tiny TACACS+ Client Library"
+#endif
+#ifndef PACKAGE_VERSION
+#   define PACKAGE_VERSION "unknown"
+#endif
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         int                           argc,
+         char *                        argv[] );
+
+
+static int
+ttd_accept(
+         ttd_config_t *                cnf );
+
+
+static int
+ttd_cli_arguments(
+         ttd_config_t *                cnf,
+         int                           argc,
+         char * const *                argv );
+
+
+static void
+ttd_client_close(
+         ttd_config_t *                cnf,
+         size_t                        idx );
+
+
+static int
+ttd_client_read(
+         ttd_config_t *                cnf,
+         size_t                        idx );
+
+
+static int
+ttd_exchange(
+         ttd_worker_t *                w,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp );
+
+
+static int
+ttd_forward(
+         ttd_worker_t *                w,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp );
+
+
+static int
+ttd_listen(
+         ttd_config_t *                cnf );
+
+
+static void
+ttd_log(
+         ttd_config_t *                cnf,
+         int                           priority,
+         const char *                  fmt,
+         ... );
+
+
+static int
+ttd_loop(
+         ttd_config_t *                cnf );
+
+
+static time_t
+ttd_now(
+         void );
+
+
+static int
+ttd_pckt_read(
+         ttd_config_t *                cnf,
+         int                           fd,
+         tinytac_pckt_t **             pcktp,
+         size_t *                      lenp,
+         int                           flags );
+
+
+static int
+ttd_session(
+         ttd_worker_t *                w,
+         int                           fd,
+         tinytac_pckt_t *              pckt );
+
+
+static void
+ttd_signal(
+         int                           sig );
+
+
+static int
+ttd_stats(
+         ttd_worker_t *                w,
+         int                           fd,
+         tinytac_pckt_t *              pckt );
+
+
+static void
+ttd_upstream_close(
+         ttd_worker_t *                w );
+
+
+static int
+ttd_usage(
+         ttd_config_t *                cnf );
+
+
+static void *
+ttd_worker(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static ttd_config_t *   ttd_signal_cnf = NULL;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//---------------//
+// main function //
+//---------------//
+#pragma mark main function
+
+int main(int argc, char * argv[])
+{
+   int                           rc;
+   int                           ival;
+   int                           pos;
+   ttd_config_t *                cnf;
+   struct sigaction              sa;
+
+   if ((cnf = calloc(1, sizeof(ttd_config_t))) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   cnf->lsock        = -1;
+   cnf->wake[0]      = -1;
+   cnf->wake[1]      = -1;
+   cnf->nworkers     = TTD_DFLT_WORKERS;
+   cnf->cache_size   = TTD_DFLT_CACHE_SIZE;
+   cnf->sock_path    = TTD_DFLT_SOCKET;
+   cnf->sock_gid     = (gid_t)-1;
+   pthread_mutex_init(&cnf->queue_mutex, NULL);
+   pthread_cond_init(&cnf->queue_cond, NULL);
+
+   // determine program name
+   if ((cnf->prog_name = strrchr(argv[0], '/')) != NULL)
+      cnf->prog_name = &cnf->prog_name[1];
+   if (!(cnf->prog_name))
+      cnf->prog_name = argv[0];
+
+   // initialize state
+   if ((rc = tinytac_set_option(NULL, TTAC_OPT_DEBUG_IDENT, PROGRAM_NAME)) != TTAC_SUCCESS)
+   {
+      fprintf(stderr, "%s: tinytac_set_option(%s): %s\n", PROGRAM_NAME, "TTAC_OPT_DEBUG_IDENT", tinytac_strerror(rc));
+      return(1);
+   };
+   if ((rc = tinytac_initialize(&cnf->tt, NULL, NULL, 0)) != TTAC_SUCCESS)
+   {
+      fprintf(stderr, "%s: tinytac_initialize(): %s\n", PROGRAM_NAME, tinytac_strerror(rc));
+      return(1);
+   };
+
+   // the daemon is the proxy, never forward to another proxy
+   if ((rc = tinytac_set_option(cnf->tt, TTAC_OPT_PROXY, "")) != TTAC_SUCCESS)
+   {
+      fprintf(stderr, "%s: tinytac_set_option(%s): %s\n", PROGRAM_NAME, "TTAC_OPT_PROXY", tinytac_strerror(rc));
+      return(1);
+   };
+
+   // process cli arguments
+   if ((rc = ttd_cli_arguments(cnf, argc, argv)) != 0)
+      return((rc == -1) ? 0 : 1);
+   tinytac_get_option(cnf->tt, TTAC_OPT_KEY, &cnf->key);
+   if (!(cnf->key))
+      cnf->key = tinytacb_strdup("");
+
+   // share authorization replies and in-flight requests between clients
+   ival = TTAC_YES;
+   tinytac_set_option(cnf->tt, TTAC_OPT_COALESCE, &ival);
+   tinytac_set_option(cnf->tt, TTAC_OPT_CACHE_SIZE, &cnf->cache_size);
+
+   // open listening socket before detaching so errors are reported
+   if (ttd_listen(cnf) != 0)
+      return(1);
+   if (pipe2(cnf->wake, O_CLOEXEC | O_NONBLOCK) == -1)
+   {
+      fprintf(stderr, "%s: pipe: %s\n", cnf->prog_name, strerror(errno));
+      return(1);
+   };
+
+   if (!(cnf->opts & TTD_OPT_FOREGROUND))
+   {
+      if (daemon(0, 0) == -1)
+      {
+         fprintf(stderr, "%s: daemon: %s\n", cnf->prog_name, strerror(errno));
+         return(1);
+      };
+      openlog(PROGRAM_NAME, LOG_PID, LOG_DAEMON);
+      ival = TTAC_YES;
+      tinytac_set_option(NULL, TTAC_OPT_DEBUG_SYSLOG, &ival);
+   };
+
+   // install signal handlers
+   ttd_signal_cnf = cnf;
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = &ttd_signal;
+   sigaction(SIGINT,  &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+   sa.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &sa, NULL);
+
+   // start workers
+   if ((cnf->workers = calloc((size_t)cnf->nworkers, sizeof(ttd_worker_t))) == NULL)
+   {
+      ttd_log(cnf, LOG_ERR, "out of virtual memory");
+      return(1);
+   };
+   for(pos = 0; (pos < cnf->nworkers); pos++)
+   {
+      cnf->workers[pos].cnf = cnf;
+      cnf->workers[pos].s   = -1;
+      if ((errno = pthread_create(&cnf->workers[pos].thread, NULL, &ttd_worker, &cnf->workers[pos])) != 0)
+      {
+         ttd_log(cnf, LOG_ERR, "pthread_create: %s", strerror(errno));
+         atomic_store(&cnf->stop, 1);
+         break;
+      };
+      cnf->workers[pos].started = 1;
+   };
+
+   ttd_log(cnf, LOG_INFO, "listening on %s with %i upstream connections", cnf->sock_path, cnf->nworkers);
+
+   rc = ttd_loop(cnf);
+
+   // stop workers
+   atomic_store(&cnf->stop, 1);
+   pthread_mutex_lock(&cnf->queue_mutex);
+   pthread_cond_broadcast(&cnf->queue_cond);
+   pthread_mutex_unlock(&cnf->queue_mutex);
+   for(pos = 0; (pos < cnf->nworkers); pos++)
+      if ((cnf->workers[pos].started))
+         pthread_join(cnf->workers[pos].thread, NULL);
+
+   // close connections
+   while ((cnf->nclients))
+      ttd_client_close(cnf, 0);
+   close(cnf->lsock);
+   close(cnf->wake[0]);
+   close(cnf->wake[1]);
+   unlink(cnf->sock_path);
+
+   ttd_log(cnf, LOG_INFO, "exiting");
+
+   tinytac_free(cnf->tt);
+   free(cnf->key);
+   free(cnf->workers);
+   free(cnf);
+
+   return(rc);
+}
+
+
+//------------------//
+// client functions //
+//------------------//
+#pragma mark client functions
+
+int
+ttd_accept(
+         ttd_config_t *                cnf )
+{
+   int                  fd;
+   struct timeval       tv;
+
+   if ((fd = accept4(cnf->lsock, NULL, NULL, SOCK_CLOEXEC)) == -1)
+      return(-1);
+   if (cnf->nclients >= TTD_MAX_CLIENTS)
+   {
+      ttd_log(cnf, LOG_WARNING, "too many clients");
+      close(fd);
+      return(-1);
+   };
+
+   // a stalled client must not stall the daemon
+   tv.tv_sec  = TTD_CLIENT_TIMEOUT;
+   tv.tv_usec = 0;
+   setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+   setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+   memset(&cnf->clients[cnf->nclients], 0, sizeof(ttd_client_t));
+   cnf->clients[cnf->nclients].fd   = fd;
+   cnf->nclients++;
+
+   return(0);
+}
+
+
+void
+ttd_client_close(
+         ttd_config_t *                cnf,
+         size_t                        idx )
+{
+   close(cnf->clients[idx].fd);
+   free(cnf->clients[idx].pckt);
+   cnf->nclients--;
+   cnf->clients[idx] = cnf->clients[cnf->nclients];
+   return;
+}
+
+
+/// reads available data of first packet of a client session and queues the
+/// packet for a worker once it is complete
+///
+/// The main loop serves every client, so only data which is already
+/// available is read.
+///
+/// @return    Returns 0 on success or -1 if the client must be closed.
+int
+ttd_client_read(
+         ttd_config_t *                cnf,
+         size_t                        idx )
+{
+   int                  rc;
+   ttd_client_t *       client;
+   ttd_job_t *          job;
+   tinytac_pckt_t *     pckt;
+
+   client = &cnf->clients[idx];
+
+   if (!(client->len))
+      client->since = ttd_now();
+   if ((rc = ttd_pckt_read(cnf, client->fd, &client->pckt, &client->len, MSG_DONTWAIT)) != 1)
+      return(rc);
+   pckt           = client->pckt;
+   client->pckt   = NULL;
+   client->len    = 0;
+
+   if ( (pckt->pckt_seq_no != 1) || ((job = malloc(sizeof(ttd_job_t))) == NULL) )
+   {
+      free(pckt);
+      return(-1);
+   };
+   job->next   = NULL;
+   job->fd     = client->fd;
+   job->pckt   = pckt;
+
+   client->busy = 1;
+
+   pthread_mutex_lock(&cnf->queue_mutex);
+   if ((cnf->queue_tail))
+      cnf->queue_tail->next = job;
+   else
+      cnf->queue_head = job;
+   cnf->queue_tail = job;
+   pthread_cond_signal(&cnf->queue_cond);
+   pthread_mutex_unlock(&cnf->queue_mutex);
+
+   return(0);
+}
+
+
+/// reads client packet into buffer
+///
+/// A partially read packet is kept in the buffer, the next call continues
+/// where the previous call stopped.  Packets longer than TTD_MAX_PCKT_LEN
+/// are rejected before the body is allocated.
+///
+/// @param[in]  cnf           daemon configuration
+/// @param[in]  fd            client connection
+/// @param[in]  pcktp         buffer of packet, allocated if NULL
+/// @param[in]  lenp          number of bytes in buffer
+/// @param[in]  flags         MSG_DONTWAIT to return once no data is
+///                           available, 0 to wait for the entire packet
+///
+/// @return    Returns 1 if the packet is complete and un-obfuscated, 0 if
+///            more data is needed, or -1 on error.
+int
+ttd_pckt_read(
+         ttd_config_t *                cnf,
+         int                           fd,
+         tinytac_pckt_t **             pcktp,
+         size_t *                      lenp,
+         int                           flags )
+{
+   size_t               want;
+   size_t               body;
+   ssize_t              rc;
+   void *               ptr;
+
+   if (!(*pcktp))
+   {
+      if ((*pcktp = malloc(sizeof(tinytac_pckt_t))) == NULL)
+         return(-1);
+      *lenp = 0;
+   };
+
+   for(;;)
+   {
+      // size of packet is known once the header is complete
+      want = sizeof(tinytac_pckt_t);
+      if (*lenp >= want)
+      {
+         if ((body = ntohl((*pcktp)->pckt_length)) > TTD_MAX_PCKT_LEN)
+         {
+            ttd_log(cnf, LOG_WARNING, "client packet too large (%zu bytes)", body);
+            return(-1);
+         };
+         want += body;
+         if (*lenp == want)
+            break;
+         if (*lenp == sizeof(tinytac_pckt_t))
+         {
+            if ((ptr = realloc(*pcktp, want)) == NULL)
+               return(-1);
+            *pcktp = ptr;
+         };
+      };
+
+      if ((rc = recv(fd, ((uint8_t *)*pcktp) + *lenp, want - *lenp, flags)) == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         if ( ((flags & MSG_DONTWAIT)) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) )
+            return(0);
+         return(-1);
+      };
+      if (rc == 0)
+         return(-1);
+      *lenp += (size_t)rc;
+   };
+
+   // a client which does not know the key must not have the daemon
+   // obfuscate its requests with the key
+   if (((*pcktp)->pckt_flags & TAC_PLUS_UNENCRYPTED_FLAG))
+   {
+      ttd_log(cnf, LOG_WARNING, "client packet is not obfuscated");
+      return(-1);
+   };
+   tinytac_pckt_obfuscate(*pcktp, cnf->key, strlen(cnf->key), TTAC_YES);
+
+   return(1);
+}
+
+
+//----------------//
+// loop functions //
+//----------------//
+#pragma mark loop functions
+
+int
+ttd_listen(
+         ttd_config_t *                cnf )
+{
+   int                     rc;
+   mode_t                  mask;
+   struct sockaddr_un      sa;
+   struct stat             sb;
+
+   if (strlen(cnf->sock_path) >= sizeof(sa.sun_path))
+   {
+      fprintf(stderr, "%s: %s: socket path too long\n", cnf->prog_name, cnf->sock_path);
+      return(1);
+   };
+   memset(&sa, 0, sizeof(sa));
+   sa.sun_family = AF_UNIX;
+   tinytacb_strlcpy(sa.sun_path, cnf->sock_path, sizeof(sa.sun_path));
+
+   // remove stale socket of previous instance
+   if ( (lstat(cnf->sock_path, &sb) == 0) && ((S_ISSOCK(sb.st_mode))) )
+      unlink(cnf->sock_path);
+
+   if ((cnf->lsock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1)
+   {
+      fprintf(stderr, "%s: socket: %s\n", cnf->prog_name, strerror(errno));
+      return(1);
+   };
+
+   // socket is not accessible by other users between bind() and chmod()
+   mask  = umask(0177);
+   rc    = bind(cnf->lsock, (struct sockaddr *)&sa, sizeof(sa));
+   umask(mask);
+   if (rc == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->sock_path, strerror(errno));
+      return(1);
+   };
+   if ( (cnf->sock_gid != (gid_t)-1) && (chown(cnf->sock_path, (uid_t)-1, cnf->sock_gid) == -1) )
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->sock_path, strerror(errno));
+      return(1);
+   };
+   if (chmod(cnf->sock_path, TTD_DFLT_SOCKET_MODE) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->sock_path, strerror(errno));
+      return(1);
+   };
+   if (listen(cnf->lsock, SOMAXCONN) == -1)
+   {
+      fprintf(stderr, "%s: listen: %s\n", cnf->prog_name, strerror(errno));
+      return(1);
+   };
+
+   return(0);
+}
+
+
+/// polls listening socket and idle clients until stopped
+int
+ttd_loop(
+         ttd_config_t *                cnf )
+{
+   int                  rc;
+   size_t               idx;
+   size_t               nfds;
+   size_t               pos;
+   time_t               now;
+   ttd_wake_t           msg;
+   struct pollfd        pfds[TTD_MAX_CLIENTS+2];
+   size_t               map[TTD_MAX_CLIENTS+2];
+
+   while (!(atomic_load(&cnf->stop)))
+   {
+      // drop clients which stalled in the middle of a packet
+      now = ttd_now();
+      for(idx = cnf->nclients; (idx > 0); idx--)
+      {
+         if ( ((cnf->clients[idx-1].busy)) || (!(cnf->clients[idx-1].len)) )
+            continue;
+         if ((now - cnf->clients[idx-1].since) > TTD_CLIENT_TIMEOUT)
+            ttd_client_close(cnf, idx-1);
+      };
+
+      // build poll list from idle clients
+      pfds[0].fd     = cnf->lsock;
+      pfds[0].events = POLLIN;
+      pfds[1].fd     = cnf->wake[0];
+      pfds[1].events = POLLIN;
+      nfds = 2;
+      for(idx = 0; (idx < cnf->nclients); idx++)
+      {
+         if ((cnf->clients[idx].busy))
+            continue;
+         pfds[nfds].fd     = cnf->clients[idx].fd;
+         pfds[nfds].events = POLLIN;
+         map[nfds]         = idx;
+         nfds++;
+      };
+
+      if ((rc = poll(pfds, (nfds_t)nfds, 1000)) == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         ttd_log(cnf, LOG_ERR, "poll: %s", strerror(errno));
+         return(1);
+      };
+      if (rc == 0)
+         continue;
+
+      // read idle clients first, client slots are not moved until the
+      // wake pipe and listening socket are processed
+      for(pos = nfds; (pos > 2); pos--)
+      {
+         if (!(pfds[pos-1].revents))
+            continue;
+         idx = map[pos-1];
+         if (ttd_client_read(cnf, idx) == -1)
+            ttd_client_close(cnf, idx);
+      };
+
+      // return clients released by workers
+      if ((pfds[1].revents & POLLIN))
+      {
+         while (read(cnf->wake[0], &msg, sizeof(msg)) == (ssize_t)sizeof(msg))
+         {
+            for(idx = 0; (idx < cnf->nclients); idx++)
+            {
+               if (cnf->clients[idx].fd != msg.fd)
+                  continue;
+               cnf->clients[idx].busy = 0;
+               if ((msg.close))
+                  ttd_client_close(cnf, idx);
+               break;
+            };
+         };
+      };
+
+      if ((pfds[0].revents & POLLIN))
+         ttd_accept(cnf);
+   };
+
+   return(0);
+}
+
+
+time_t
+ttd_now(
+         void )
+{
+   struct timespec      ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(ts.tv_sec);
+}
+
+
+void
+ttd_signal(
+         int                           sig )
+{
+   (void)sig;
+   if ((ttd_signal_cnf))
+      atomic_store(&ttd_signal_cnf->stop, 1);
+   return;
+}
+
+
+//-------------------//
+// logging functions //
+//-------------------//
+#pragma mark logging functions
+
+void
+ttd_log(
+         ttd_config_t *                cnf,
+         int                           priority,
+         const char *                  fmt,
+         ... )
+{
+   va_list args;
+   if ( (priority == LOG_DEBUG) && (!(cnf->opts & TTD_OPT_VERBOSE)) )
+      return;
+   va_start(args, fmt);
+   if (!(cnf->opts & TTD_OPT_FOREGROUND))
+   {
+      vsyslog(priority, fmt, args);
+   } else
+   {
+      fprintf(stderr, "%s: ", cnf->prog_name);
+      vfprintf(stderr, fmt, args);
+      fprintf(stderr, "\n");
+   };
+   va_end(args);
+   return;
+}
+
+
+//------------------//
+// worker functions //
+//------------------//
+#pragma mark worker functions
+
+/// exchanges packet with upstream server
+int
+ttd_exchange(
+         ttd_worker_t *                w,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp )
+{
+   uint32_t             session_id;
+   uint8_t              seq_no;
+   uint8_t              type;
+   tinytac_pckt_t *     reply;
+
+   session_id  = req->pckt_session_id;
+   seq_no      = req->pckt_seq_no;
+   type        = req->pckt_type;
+
+   if (tinytac_send(w->s, w->cnf->key, req) == -1)
+      return(TTAC_ENETWORK);
+   if (tinytac_recv(w->s, w->cnf->key, &reply) == -1)
+      return((errno == EBADMSG) ? TTAC_EBADMSG : TTAC_ENETWORK);
+
+   if ( (reply->pckt_session_id != session_id) ||
+        (reply->pckt_type       != type) ||
+        (reply->pckt_seq_no     != ((seq_no + 1) & 0xff)) )
+   {
+      tinytac_free(reply);
+      return(TTAC_EBADMSG);
+   };
+
+   *replyp = reply;
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// forwards client packet over the worker's upstream connection
+///
+/// The first packet of a session is retried once on a new connection if
+/// the server closed the previous single-connect connection.  The upstream
+/// connection is left open on success, ttd_session() closes it once the
+/// session is complete if the server did not negotiate single-connect.
+int
+ttd_forward(
+         ttd_worker_t *                w,
+         tinytac_pckt_t *              req,
+         tinytac_pckt_t **             replyp )
+{
+   int                  rc;
+   int                  attempt;
+
+   rc = TTAC_ENETWORK;
+
+   for(attempt = 0; (attempt < 2); attempt++)
+   {
+      if (w->s == -1)
+      {
+         if ((rc = tinytac_connect(w->cnf->tt, &w->s)) != TTAC_SUCCESS)
+         {
+            ttd_log(w->cnf, LOG_WARNING, "upstream: %s", tinytac_strerror(rc));
+            return(rc);
+         };
+      };
+
+      if ( (req->pckt_type == TAC_PLUS_TYPE_AUTHOR) && (req->pckt_seq_no == 1) )
+         rc = tinytac_author(w->cnf->tt, w->s, req, replyp, TTAC_REQ_NONE);
+      else
+         rc = ttd_exchange(w, req, replyp);
+
+      if (rc == TTAC_SUCCESS)
+         return(rc);
+
+      ttd_upstream_close(w);
+      if ( (rc != TTAC_ENETWORK) || (req->pckt_seq_no != 1) )
+         return(rc);
+
+      // restore plain text of request before retrying
+      tinytac_pckt_obfuscate(req, w->cnf->key, strlen(w->cnf->key), TTAC_YES);
+   };
+
+   return(rc);
+}
+
+
+/// relays one client session, including continuations of authentication
+///
+/// @return    Returns 0 if the client connection may be reused or -1 if it
+///            must be closed.
+int
+ttd_session(
+         ttd_worker_t *                w,
+         int                           fd,
+         tinytac_pckt_t *              pckt )
+{
+   int                  more;
+   size_t               len;
+   uint32_t             session_id;
+   uint8_t              seq_no;
+   tinytac_pckt_t *     reply;
+
+   // control requests are answered by the daemon
+   if (pckt->pckt_type == TTAC_PROXY_TYPE_STATS)
+      return(ttd_stats(w, fd, pckt));
+
+   for(;;)
+   {
+      if (ttd_forward(w, pckt, &reply) != TTAC_SUCCESS)
+      {
+         free(pckt);
+         return(-1);
+      };
+      free(pckt);
+
+      more = 0;
+      if ( (reply->pckt_type == TAC_PLUS_TYPE_AUTHEN) && (ntohl(reply->pckt_length) >= 1) )
+      {
+         switch(reply->pckt_body[0])
+         {
+            case TAC_PLUS_AUTHEN_STATUS_GETDATA: more = 1; break;
+            case TAC_PLUS_AUTHEN_STATUS_GETUSER: more = 1; break;
+            case TAC_PLUS_AUTHEN_STATUS_GETPASS: more = 1; break;
+            default: break;
+         };
+      };
+      session_id  = reply->pckt_session_id;
+      seq_no      = reply->pckt_seq_no;
+
+      // continuations must use the connection of the session
+      if ( (!(more)) && (!(reply->pckt_flags & TAC_PLUS_SINGLE_CONNECT_FLAG)) )
+         ttd_upstream_close(w);
+
+      if (tinytac_send(fd, w->cnf->key, reply) == -1)
+      {
+         tinytac_free(reply);
+         if ((more))
+            ttd_upstream_close(w);
+         return(-1);
+      };
+      tinytac_free(reply);
+
+      if (!(more))
+         return(0);
+
+      // wait for client to continue the session
+      pckt = NULL;
+      if (ttd_pckt_read(w->cnf, fd, &pckt, &len, 0) != 1)
+      {
+         free(pckt);
+         ttd_upstream_close(w);
+         return(-1);
+      };
+      if ( (pckt->pckt_session_id != session_id) || (pckt->pckt_seq_no != ((seq_no + 1) & 0xff)) )
+      {
+         free(pckt);
+         ttd_upstream_close(w);
+         return(-1);
+      };
+   };
+
+   return(0);
+}
+
+
+/// answers statistics request with OpenMetrics text of the daemon's handle
+///
+/// The body of the request must be TTAC_PROXY_STATS_BODY, so only clients
+/// which know the key receive the statistics.
+///
+/// @return    Returns 0 if the client connection may be reused or -1 if it
+///            must be closed.
+int
+ttd_stats(
+         ttd_worker_t *                w,
+         int                           fd,
+         tinytac_pckt_t *              pckt )
+{
+   int                  rc;
+   size_t               len;
+   size_t               size;
+   tinytac_pckt_t *     reply;
+   void *               ptr;
+
+   len = strlen(TTAC_PROXY_STATS_BODY);
+   if ( (ntohl(pckt->pckt_length) != len) || ((memcmp(pckt->pckt_body, TTAC_PROXY_STATS_BODY, len))) )
+   {
+      ttd_log(w->cnf, LOG_WARNING, "invalid statistics request");
+      free(pckt);
+      return(-1);
+   };
+
+   // statistics may grow between calls while sessions are relayed
+   reply = NULL;
+   size  = 0;
+   do
+   {
+      size = ((size)) ? (len + 1024) : 4096;
+      if ((ptr = realloc(reply, sizeof(tinytac_pckt_t) + size)) == NULL)
+      {
+         free(reply);
+         free(pckt);
+         return(-1);
+      };
+      reply = ptr;
+   } while((rc = tinytac_stats_openmetrics(w->cnf->tt, (char *)reply->pckt_body, size, &len)) == TTAC_ENOBUFS);
+   if (rc != TTAC_SUCCESS)
+   {
+      ttd_log(w->cnf, LOG_ERR, "statistics: %s", tinytac_strerror(rc));
+      free(reply);
+      free(pckt);
+      return(-1);
+   };
+
+   reply->pckt_version     = pckt->pckt_version;
+   reply->pckt_type        = pckt->pckt_type;
+   reply->pckt_seq_no      = (pckt->pckt_seq_no + 1) & 0xff;
+   reply->pckt_flags       = TAC_PLUS_UNENCRYPTED_FLAG;  // plain text until sent
+   reply->pckt_session_id  = pckt->pckt_session_id;
+   reply->pckt_length      = htonl((uint32_t)len);
+   free(pckt);
+
+   rc = tinytac_send(fd, w->cnf->key, reply);
+   free(reply);
+
+   return((rc == -1) ? -1 : 0);
+}
+
+
+void
+ttd_upstream_close(
+         ttd_worker_t *                w )
+{
+   if (w->s == -1)
+      return;
+   close(w->s);
+   w->s = -1;
+   return;
+}
+
+
+void *
+ttd_worker(
+         void *                        arg )
+{
+   ttd_worker_t *       w;
+   ttd_config_t *       cnf;
+   ttd_job_t *          job;
+   ttd_wake_t           msg;
+
+   w   = arg;
+   cnf = w->cnf;
+
+   for(;;)
+   {
+      pthread_mutex_lock(&cnf->queue_mutex);
+      while ( (!(cnf->queue_head)) && (!(atomic_load(&cnf->stop))) )
+         pthread_cond_wait(&cnf->queue_cond, &cnf->queue_mutex);
+      if ((atomic_load(&cnf->stop)))
+      {
+         pthread_mutex_unlock(&cnf->queue_mutex);
+         break;
+      };
+      job = cnf->queue_head;
+      if ((cnf->queue_head = job->next) == NULL)
+         cnf->queue_tail = NULL;
+      pthread_mutex_unlock(&cnf->queue_mutex);
+
+      // relay session and hand client back to main loop
+      msg.fd      = job->fd;
+      msg.close   = (ttd_session(w, job->fd, job->pckt) == -1) ? 1 : 0;
+      free(job);
+      if (write(cnf->wake[1], &msg, sizeof(msg)) != (ssize_t)sizeof(msg))
+         ttd_log(cnf, LOG_ERR, "unable to release client: %s", strerror(errno));
+   };
+
+   ttd_upstream_close(w);
+
+   // release queued jobs
+   pthread_mutex_lock(&cnf->queue_mutex);
+   while ((job = cnf->queue_head) != NULL)
+   {
+      cnf->queue_head = job->next;
+      free(job->pckt);
+      free(job);
+   };
+   cnf->queue_tail = NULL;
+   pthread_mutex_unlock(&cnf->queue_mutex);
+
+   return(NULL);
+}
+
+
+//-----------------//
+// usage functions //
+//-----------------//
+#pragma mark usage functions
+
+int
+ttd_cli_arguments(
+         ttd_config_t *                cnf,
+         int                           argc,
+         char * const *                argv )
+{
+   int            c;
+   int            opt_index;
+   int            ival;
+   int            rc;
+   char *         end;
+   struct group * gr;
+
+   // getopt options
+   static const char *  short_opt = "C:c:dfg:H:hk:s:Vv";
+   static struct option long_opt[] =
+   {
+      {"debug",            no_argument,       NULL, 'd' },
+      {"foreground",       no_argument,       NULL, 'f' },
+      {"help",             no_argument,       NULL, 'h' },
+      {"version",          no_argument,       NULL, 'V' },
+      {"verbose",          no_argument,       NULL, 'v' },
+      { NULL, 0, NULL, 0 }
+   };
+
+   optind    = 1;
+   opt_index = 0;
+
+   while((c = getopt_long(argc, argv, short_opt, long_opt, &opt_index)) != -1)
+   {
+      switch(c)
+      {
+         case -1:       /* no more arguments */
+         case 0:        /* long options toggles */
+         break;
+
+         case 'C':
+         cnf->cache_size = (int)strtol(optarg, NULL, 0);
+         if (cnf->cache_size < 0)
+         {  fprintf(stderr, "%s: invalid cache size `%s'\n", PROGRAM_NAME, optarg);
+            return(1);
+         };
+         break;
+
+         case 'c':
+         cnf->nworkers = (int)strtol(optarg, NULL, 0);
+         if ( (cnf->nworkers < 1) || (cnf->nworkers > TTD_MAX_WORKERS) )
+         {  fprintf(stderr, "%s: upstream connections must be between 1 and %i\n", PROGRAM_NAME, TTD_MAX_WORKERS);
+            return(1);
+         };
+         break;
+
+         case 'd':
+         ival = TTAC_DEBUG_ANY; tinytac_set_option(NULL, TTAC_OPT_DEBUG_LEVEL, &ival);
+         break;
+
+         case 'f':
+         cnf->opts |= TTD_OPT_FOREGROUND;
+         break;
+
+         case 'g':
+         if ((gr = getgrnam(optarg)) != NULL)
+            cnf->sock_gid = gr->gr_gid;
+         else
+            cnf->sock_gid = (gid_t)strtoul(optarg, &end, 10);
+         if ( (!(gr)) && ( (!(optarg[0])) || ((end[0])) ) )
+         {  fprintf(stderr, "%s: unknown group `%s'\n", PROGRAM_NAME, optarg);
+            return(1);
+         };
+         break;
+
+         case 'H':
+         if ((rc = tinytac_set_option(cnf->tt, TTAC_OPT_HOSTS, optarg)) != TTAC_SUCCESS)
+         {  fprintf(stderr, "%s: tinytac_set_option(TTAC_OPT_HOSTS): %s\n", PROGRAM_NAME, tinytac_strerror(rc));
+            return(1);
+         };
+         break;
+
+         case 'h':
+         ttd_usage(cnf);
+         return(-1);
+
+         case 'k':
+         if ((rc = tinytac_set_option(cnf->tt, TTAC_OPT_KEY, optarg)) != TTAC_SUCCESS)
+         {  fprintf(stderr, "%s: tinytac_set_option(TTAC_OPT_KEY): %s\n", PROGRAM_NAME, tinytac_strerror(rc));
+            return(1);
+         };
+         break;
+
+         case 's':
+         cnf->sock_path = optarg;
+         break;
+
+         case 'V':
+         printf("%s (%s) %s\n", PROGRAM_NAME, PACKAGE_NAME, PACKAGE_VERSION);
+         return(-1);
+
+         case 'v':
+         cnf->opts |= TTD_OPT_VERBOSE;
+         break;
+
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         return(1);
+
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         return(1);
+      };
+   };
+
+   if (optind != argc)
+   {
+      fprintf(stderr, "%s: unexpected argument -- \"%s\"\n", PROGRAM_NAME, argv[optind]);
+      fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+int
+ttd_usage(
+         ttd_config_t *                cnf )
+{
+   (void)cnf;
+   printf("Usage: %s [OPTIONS]\n", PROGRAM_NAME);
+   printf("OPTIONS:\n");
+   printf("  -C size                   authorization cache entries (default: %i)\n", TTD_DFLT_CACHE_SIZE);
+   printf("  -c num                    upstream connections (default: %i)\n", TTD_DFLT_WORKERS);
+   printf("  -d, --debug               print debug messages\n");
+   printf("  -f, --foreground          do not detach from terminal\n");
+   printf("  -g group                  group allowed to use socket\n");
+   printf("  -H host                   TACACS+ host\n");
+   printf("  -h, --help                print this help and exit\n");
+   printf("  -k key                    TACACS+ key\n");
+   printf("  -s path                   Unix domain socket (default: %s)\n", TTD_DFLT_SOCKET);
+   printf("  -V, --version             print version number and exit\n");
+   printf("  -v, --verbose             print verbose messages\n");
+   printf("\n");
+   return(0);
+}
+
+/* end of source */
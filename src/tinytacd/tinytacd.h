@@ -0,0 +1,152 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#ifndef _SRC_TINYTACD_TINYTACD_H
+#define _SRC_TINYTACD_TINYTACD_H 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <tinytac_compat.h>
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "tinytacd"
+
+#ifndef TTD_DFLT_SOCKET
+#   define TTD_DFLT_SOCKET          "/var/run/tinytacd.sock"
+#endif
+#define TTD_DFLT_SOCKET_MODE        0660
+#define TTD_DFLT_WORKERS            4
+#define TTD_DFLT_CACHE_SIZE         1024
+#define TTD_MAX_WORKERS             64
+#define TTD_MAX_CLIENTS             1024
+#define TTD_CLIENT_TIMEOUT          5
+#define TTD_MAX_PCKT_LEN            65536    // maximum body length of a client packet
+
+#define TTD_OPT_FOREGROUND          0x00000001U
+#define TTD_OPT_VERBOSE             0x00000002U
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _tinytacd_config     ttd_config_t;
+typedef struct _tinytacd_client     ttd_client_t;
+typedef struct _tinytacd_job        ttd_job_t;
+typedef struct _tinytacd_wake       ttd_wake_t;
+typedef struct _tinytacd_worker     ttd_worker_t;
+
+
+// local client connection, owned by the main loop while idle and by a
+// worker while one of its sessions is in progress.  The main loop reads
+// the first packet of a session into pckt as data arrives.
+struct _tinytacd_client
+{
+   int                        fd;
+   int                        busy;
+   size_t                     len;     // bytes of pckt received
+   time_t                     since;   // monotonic time of first byte of pckt
+   tinytac_pckt_t *           pckt;    // allocated with malloc()
+};
+
+
+// first packet of a client session queued for a worker
+struct _tinytacd_job
+{
+   ttd_job_t *                next;
+   int                        fd;
+   tinytac_pckt_t *           pckt;
+};
+
+
+// message from worker returning a client connection to the main loop
+struct _tinytacd_wake
+{
+   int                        fd;
+   int                        close;
+};
+
+
+// worker thread with its single-connect upstream connection
+struct _tinytacd_worker
+{
+   ttd_config_t *             cnf;
+   pthread_t                  thread;
+   int                        s;
+   int                        started;
+};
+
+
+struct _tinytacd_config
+{
+   unsigned                   opts;
+   int                        lsock;
+   int                        wake[2];
+   int                        nworkers;
+   int                        cache_size;
+   size_t                     nclients;
+   const char *               prog_name;
+   const char *               sock_path;
+   gid_t                      sock_gid;
+   char *                     key;
+   TinyTac *                  tt;
+   ttd_worker_t *             workers;
+   ttd_job_t *                queue_head;
+   ttd_job_t *                queue_tail;
+   pthread_mutex_t            queue_mutex;
+   pthread_cond_t             queue_cond;
+   atomic_int                 stop;
+   ttd_client_t               clients[TTD_MAX_CLIENTS];
+};
+
+
+#endif /* end of header */
@@ -126,36 +126,64 @@ ttu_widget_t ttu_widget_map[] =
    {  .name       = "acct",
       .desc       = "TACACS+ accounting client",
       .usage      = NULL,
+      .options    = NULL,
       .aliases    = (const char * const[]) { "accounting", NULL },
       .func_exec  = &ttu_widget_acct,
+      .func_opt   = NULL,
       .func_usage = NULL,
    },
    {  .name       = "authen",
       .desc       = "TACACS+ authentication client",
       .usage      = " username",
+      .options    = NULL,
       .aliases    = (const char * const[]) { "authentication", NULL },
       .func_exec  = &ttu_widget_authen,
+      .func_opt   = NULL,
       .func_usage = NULL,
    },
    {  .name       = "author",
       .desc       = "TACACS+ authorization client",
       .usage      = " username cmd [ arg1 arg2 ... argN ]",
+      .options    = NULL,
       .aliases    = (const char * const[]) { "authorization", NULL },
       .func_exec  = &ttu_widget_author,
+      .func_opt   = NULL,
       .func_usage = NULL,
    },
+   {  .name       = "bench",
+      .desc       = "TACACS+ load generator",
+      .usage      = " username",
+      .options    = "c:j:l:m:n:Pt:",
+      .aliases    = (const char * const[]) { "benchmark", NULL },
+      .func_exec  = &ttu_widget_bench,
+      .func_opt   = &ttu_widget_bench_option,
+      .func_usage = &ttu_widget_bench_usage,
+   },
    {  .name       = "config",
       .desc       = "print configuration",
       .usage      = NULL,
+      .options    = NULL,
       .aliases    = (const char * const[]) { "configuration", NULL },
       .func_exec  = &ttu_widget_config,
+      .func_opt   = NULL,
+      .func_usage = NULL,
+   },
+   {  .name       = "stats",
+      .desc       = "print statistics of tinytacd in OpenMetrics format",
+      .usage      = NULL,
+      .options    = NULL,
+      .aliases    = (const char * const[]) { "statistics", "metrics", NULL },
+      .func_exec  = &ttu_widget_stats,
+      .func_opt   = NULL,
       .func_usage = NULL,
    },
    {  .name       = NULL,
       .desc       = NULL,
       .usage      = NULL,
+      .options    = NULL,
       .aliases    = NULL,
       .func_exec  = NULL,
+      .func_opt   = NULL,
       .func_usage = NULL,
    }
 };
@@ -380,6 +408,56 @@ ttu_password(
 }
 
 
+/// prints timing trace of the last request of the calling thread
+///
+/// The trace is printed only if -v was given.  Phases which were not
+/// reached are skipped, each phase is listed with its duration and its
+/// start relative to the start of the request.
+///
+/// @param[in]  cnf           utility configuration
+void
+ttu_trace(
+         ttu_config_t *                cnf )
+{
+   unsigned          phase;
+   double            start;
+   double            msec;
+   tinytac_trace_t   trace;
+
+   static const char * phases[TTAC_PHASES] =
+   {
+      [TTAC_PHASE_RESOLVE]       = "resolve",
+      [TTAC_PHASE_CONNECT]       = "connect",
+      [TTAC_PHASE_SEND]          = "send",
+      [TTAC_PHASE_FIRST_BYTE]    = "first byte",
+      [TTAC_PHASE_REPLY]         = "reply",
+      [TTAC_PHASE_DEOBFUSCATE]   = "deobfuscate",
+   };
+
+   if (!(cnf->opts & TTUTILS_OPT_VERBOSE))
+      return;
+   if (tinytac_get_option(cnf->tt, TTAC_OPT_TRACE, &trace) != TTAC_SUCCESS)
+      return;
+
+   tru_verbose(cnf, "session_id:   0x%08x\n", (unsigned)trace.session_id);
+   tru_verbose(cnf, "server:       %i\n", trace.server);
+   tru_verbose(cnf, "attempts:     %u\n", trace.attempts);
+   tru_verbose(cnf, "result:       %s\n", tinytac_strerror(trace.result));
+   for(phase = 0; (phase < TTAC_PHASES); phase++)
+   {
+      if (!(trace.phase_start[phase]))
+         continue;
+      start = (double)(trace.phase_start[phase] - trace.start) / 1000000.0;
+      msec  = (double)(trace.phase_end[phase] - trace.phase_start[phase]) / 1000000.0;
+      tru_verbose(cnf, "%-13s %10.3f ms (at %.3f ms)\n", phases[phase], msec, start);
+   };
+   msec = (double)(trace.end - trace.start) / 1000000.0;
+   tru_verbose(cnf, "%-13s %10.3f ms\n", "total", msec);
+
+   return;
+}
+
+
 //-----------------//
 // usage functions //
 //-----------------//
@@ -397,6 +475,7 @@ ttu_cli_arguments(
    int            ival;
    int            rc;
    void *         ptr;
+   char           opts[64];
 
    // getopt options
    static const char *  short_opt = "+46a:dH:hK:k:VvqWw:y:";
@@ -416,7 +495,10 @@ ttu_cli_arguments(
    if ((cnf->widget))
       short_opt = &short_opt[1];
 
-   while((c = getopt_long(argc, argv, short_opt, long_opt, &opt_index)) != -1)
+   // append options of widget
+   snprintf(opts, sizeof(opts), "%s%s", short_opt, ( ((cnf->widget)) && ((cnf->widget->options)) ) ? cnf->widget->options : "");
+
+   while((c = getopt_long(argc, argv, opts, long_opt, &opt_index)) != -1)
    {
       switch(c)
       {
@@ -514,6 +596,12 @@ ttu_cli_arguments(
          return(1);
 
          default:
+         if ( ((cnf->widget)) && ((cnf->widget->func_opt)) )
+         {
+            if ((rc = cnf->widget->func_opt(cnf, c, optarg)) != 0)
+               return(rc);
+            break;
+         };
          fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
          return(1);
@@ -88,8 +88,10 @@ struct _tinytac_util_widget
    const char *               name;
    const char *               desc;
    const char *               usage;
+   const char *               options;    // getopt() options of widget
    const char * const *       aliases;
    int  (*func_exec)(ttu_config_t * cnf);
+   int  (*func_opt)(ttu_config_t * cnf, int c, const char * arg);
    int  (*func_usage)(ttu_config_t * cnf);
 };
 
@@ -153,6 +155,11 @@ ttu_password(
          ttu_config_t *                cnf );
 
 
+extern void
+ttu_trace(
+         ttu_config_t *                cnf );
+
+
 //------------------//
 // usage prototypes //
 //------------------//
@@ -192,6 +199,23 @@ ttu_widget_authen(
          ttu_config_t *                cnf );
 
 
+extern int
+ttu_widget_bench(
+         ttu_config_t *                cnf );
+
+
+extern int
+ttu_widget_bench_option(
+         ttu_config_t *                cnf,
+         int                           c,
+         const char *                  arg );
+
+
+extern int
+ttu_widget_bench_usage(
+         ttu_config_t *                cnf );
+
+
 extern int
 ttu_widget_author(
          ttu_config_t *                cnf );
@@ -202,4 +226,9 @@ ttu_widget_config(
          ttu_config_t *                cnf );
 
 
+extern int
+ttu_widget_stats(
+         ttu_config_t *                cnf );
+
+
 #endif /* end of header */
@@ -95,13 +95,23 @@ int
 ttu_widget_authen(
          ttu_config_t *                cnf )
 {
-   int rc;
+   int            rc;
+   int            ival;
+   unsigned       authen_type;
+   const char *   user;
 
    assert(cnf != NULL);
 
    // initial processing of cli arguments
    if ((rc = ttu_cli_arguments(cnf, cnf->argc, cnf->argv)) != 0)
       return((rc == -1) ? 0 : 1);
+   if ((cnf->argc - optind) < 1)
+   {
+      fprintf(stderr, "%s: missing required argument\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      return(1);
+   };
+   user = cnf->argv[optind];
    if ((ttu_password(cnf)))
       return(1);
    if (!(cnf->pass))
@@ -111,7 +121,28 @@ ttu_widget_authen(
       return(1);
    };
 
-   return(0);
+   // prefer ASCII login unless restricted by -a
+   ival = TTAC_NO;
+   tinytac_get_option(cnf->tt, TTAC_OPT_AUTHEN_ASCII, &ival);
+   authen_type = (ival == TTAC_YES) ? TAC_PLUS_AUTHEN_TYPE_ASCII : TAC_PLUS_AUTHEN_TYPE_PAP;
+
+   rc = tinytac_authen_login(cnf->tt, -1, user, cnf->pass, authen_type, TTAC_REQ_NONE);
+   ttu_trace(cnf);
+   switch(rc)
+   {
+      case TTAC_SUCCESS:
+      ttu_printf(cnf, "%s: authentication succeeded\n", user);
+      return(0);
+
+      case TTAC_EACCES:
+      ttu_printf(cnf, "%s: authentication failed\n", user);
+      return(1);
+
+      default:
+      break;
+   };
+
+   return(ttu_error(cnf, 1, "tinytac_authen_login(): %s", tinytac_strerror(rc)));
 }
 
 
@@ -75,6 +75,10 @@
 //////////////////
 #pragma mark - Prototypes
 
+static void
+ttu_author_free(
+         char **                       args );
+
 
 /////////////////
 //             //
@@ -91,19 +95,112 @@
 /////////////////
 #pragma mark - Functions
 
+/// releases AV pairs built from the command line, the first pair is static
+void
+ttu_author_free(
+         char **                       args )
+{
+   int pos;
+   for(pos = 1; ((args[pos])); pos++)
+      free(args[pos]);
+   free(args);
+   return;
+}
+
+
 int
 ttu_widget_author(
          ttu_config_t *                cnf )
 {
-   int rc;
+   int                     rc;
+   int                     ival;
+   int                     argc;
+   int                     pos;
+   size_t                  len;
+   unsigned                authen_type;
+   unsigned                arg;
+   const char *            user;
+   char **                 args;
+   tinytac_pckt_t *        req;
+   tinytac_pckt_t *        reply;
+   tinytac_reply_view_t    view;
 
    assert(cnf != NULL);
 
    // initial processing of cli arguments
    if ((rc = ttu_cli_arguments(cnf, cnf->argc, cnf->argv)) != 0)
       return((rc == -1) ? 0 : 1);
-
-   return(0);
+   if ((cnf->argc - optind) < 2)
+   {
+      fprintf(stderr, "%s: missing required argument\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      return(1);
+   };
+   user = cnf->argv[optind];
+
+   // shell command and its arguments as AV pairs
+   argc = cnf->argc - optind - 1;
+   if ((args = calloc((size_t)(argc + 2), sizeof(char *))) == NULL)
+      return(ttu_error(cnf, 1, "out of virtual memory"));
+   args[0] = "service=shell";
+   for(pos = 0; (pos < argc); pos++)
+   {
+      len = strlen(cnf->argv[optind + 1 + pos]) + 16;
+      if ((args[pos+1] = malloc(len)) == NULL)
+         break;
+      snprintf(args[pos+1], len, "%s=%s", ((pos)) ? "cmd-arg" : "cmd", cnf->argv[optind + 1 + pos]);
+   };
+   if (pos < argc)
+   {
+      ttu_author_free(args);
+      return(ttu_error(cnf, 1, "out of virtual memory"));
+   };
+
+   // prefer ASCII login unless restricted by -a
+   ival = TTAC_NO;
+   tinytac_get_option(cnf->tt, TTAC_OPT_AUTHEN_ASCII, &ival);
+   authen_type = (ival == TTAC_YES) ? TAC_PLUS_AUTHEN_TYPE_ASCII : TAC_PLUS_AUTHEN_TYPE_PAP;
+
+   rc = tinytac_pckt_author_req(cnf->tt, TAC_PLUS_AUTHEN_METH_TACACSPLUS, TAC_PLUS_PRIV_LVL_USER, (uint8_t)authen_type, TAC_PLUS_AUTHEN_SVC_LOGIN, user, cnf->prog_name, NULL, (const char * const *)args, &req);
+   ttu_author_free(args);
+   if (rc != TTAC_SUCCESS)
+      return(ttu_error(cnf, 1, "tinytac_pckt_author_req(): %s", tinytac_strerror(rc)));
+
+   rc = tinytac_author(cnf->tt, -1, req, &reply, TTAC_REQ_NONE);
+   tinytac_free(req);
+   ttu_trace(cnf);
+   if (rc != TTAC_SUCCESS)
+      return(ttu_error(cnf, 1, "tinytac_author(): %s", tinytac_strerror(rc)));
+   if ((rc = tinytac_pckt_reply_view(reply, &view)) != TTAC_SUCCESS)
+   {
+      tinytac_free(reply);
+      return(ttu_error(cnf, 1, "tinytac_pckt_reply_view(): %s", tinytac_strerror(rc)));
+   };
+
+   if ((view.server_msg.len))
+      ttu_printf(cnf, "%s: %.*s\n", user, (int)view.server_msg.len, view.server_msg.ptr);
+   switch(view.status)
+   {
+      case TAC_PLUS_AUTHOR_STATUS_PASS_ADD:
+      case TAC_PLUS_AUTHOR_STATUS_PASS_REPL:
+      ttu_printf(cnf, "%s: authorization succeeded\n", user);
+      for(arg = 0; (arg < view.arg_cnt); arg++)
+         ttu_printf(cnf, "   %.*s\n", (int)view.args[arg].len, view.args[arg].ptr);
+      rc = 0;
+      break;
+
+      case TAC_PLUS_AUTHOR_STATUS_FAIL:
+      ttu_printf(cnf, "%s: authorization failed\n", user);
+      rc = 1;
+      break;
+
+      default:
+      rc = ttu_error(cnf, 1, "%s: authorization error (status 0x%02x)", user, view.status);
+      break;
+   };
+   tinytac_free(reply);
+
+   return(rc);
 }
 
 
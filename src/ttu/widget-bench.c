@@ -0,0 +1,934 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _SRC_TTU_WIDGET_BENCH_C 1
+#include "tinytacutil.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <tinytac.h>
+#include <bindle_prefix.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+// types of requests
+#define TTU_BENCH_AUTHEN            0
+#define TTU_BENCH_AUTHOR            1
+#define TTU_BENCH_ACCT              2
+#define TTU_BENCH_TYPES             3
+
+#define TTU_BENCH_WEIGHT_MAX        100
+#define TTU_BENCH_WORKERS_MAX       65536
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+// requests and latencies of one type of request
+typedef struct _ttu_bench_result
+{
+   uint64_t                requests;
+   uint64_t                errors;
+   uint64_t                denied;     // refused by server
+   uint64_t                usec;       // sum of latencies
+   uint64_t                hist[TTAC_STATS_BUCKETS];
+} ttu_bench_result_t;
+
+
+// Requests block until the reply is read, so each session in flight is
+// driven by its own worker thread.
+typedef struct _ttu_bench_worker
+{
+   pthread_t               thread;
+   size_t                  id;
+   int                     s;          // pooled connection or -1
+   unsigned                used;       // sessions completed on pooled connection
+   uint8_t                 flags;      // flags of last reply read by widget
+   ttu_config_t *          cnf;
+   ttu_bench_result_t      results[TTU_BENCH_TYPES];
+} ttu_bench_worker_t;
+
+
+typedef struct _ttu_bench
+{
+   unsigned                threads;
+   unsigned                sessions;   // sessions in flight per thread
+   unsigned                pooled;
+   unsigned                seconds;
+   uint64_t                count;
+   const char *            json;
+   unsigned                weights[TTU_BENCH_TYPES];
+   unsigned                mix[TTU_BENCH_TYPES * TTU_BENCH_WEIGHT_MAX];
+   size_t                  mix_len;
+   _Atomic int64_t         remaining;  // requests left to send if count is set
+   atomic_int              stop;
+   atomic_int              refused;    // server did not keep pooled connections
+   uint64_t                deadline;
+   unsigned                authen_type;
+   const char *            user;
+   char *                  key;
+   uint64_t                bounds[TTAC_STATS_BUCKETS];
+} ttu_bench_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+static int
+ttu_bench_acct(
+         ttu_bench_worker_t *          w,
+         int                           s );
+
+
+static int
+ttu_bench_author(
+         ttu_bench_worker_t *          w,
+         int                           s );
+
+
+static size_t
+ttu_bench_bucket(
+         uint64_t                      usec );
+
+
+static const char *
+ttu_bench_connections(
+         void );
+
+
+static void
+ttu_bench_json(
+         FILE *                        fs,
+         const ttu_bench_result_t *    results,
+         double                        seconds );
+
+
+static void
+ttu_bench_merge(
+         ttu_bench_result_t *          dst,
+         const ttu_bench_result_t *    src );
+
+
+static int
+ttu_bench_mix(
+         ttu_config_t *                cnf,
+         const char *                  arg );
+
+
+static uint64_t
+ttu_bench_now(
+         void );
+
+
+static double
+ttu_bench_percentile(
+         const ttu_bench_result_t *    result,
+         double                        percentile );
+
+
+static void
+ttu_bench_report(
+         ttu_config_t *                cnf,
+         const ttu_bench_result_t *    results,
+         double                        seconds );
+
+
+static int
+ttu_bench_request(
+         ttu_bench_worker_t *          w,
+         unsigned                      type );
+
+
+static void *
+ttu_bench_worker(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static ttu_bench_t ttu_bench =
+{
+   .threads    = 1,
+   .sessions   = 1,
+   .weights    = { 1, 1, 1 },
+};
+
+
+static const char * ttu_bench_names[TTU_BENCH_TYPES + 1] =
+{
+   [TTU_BENCH_AUTHEN]   = "authen",
+   [TTU_BENCH_AUTHOR]   = "author",
+   [TTU_BENCH_ACCT]     = "acct",
+   [TTU_BENCH_TYPES]    = "total",
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+//-----------------//
+// bench functions //
+//-----------------//
+#pragma mark bench functions
+
+/// sends accounting STOP record and reads the server's reply
+///
+/// Accounting records are sent directly instead of through the queue of
+/// the library so that the latency of the server is measured.  The first
+/// key of the handle is used.
+///
+/// @param[in]  w             worker sending record
+/// @param[in]  s             pooled connection or -1 to connect
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+ttu_bench_acct(
+         ttu_bench_worker_t *          w,
+         int                           s )
+{
+   int                     rc;
+   int                     sock;
+   uint32_t                session_id;
+   tinytac_pckt_t *        req;
+   tinytac_pckt_t *        reply;
+   tinytac_reply_view_t    view;
+
+   static const char * const args[] = { "task_id=1", "service=shell", NULL };
+
+   rc = tinytac_pckt_acct_req(w->cnf->tt, TAC_PLUS_ACCT_FLAG_STOP, TAC_PLUS_AUTHEN_METH_TACACSPLUS, TAC_PLUS_PRIV_LVL_USER, (uint8_t)ttu_bench.authen_type, TAC_PLUS_AUTHEN_SVC_LOGIN, ttu_bench.user, "bench", NULL, args, &req);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   sock = s;
+   if ( (sock == -1) && ((rc = tinytac_connect(w->cnf->tt, &sock)) != TTAC_SUCCESS) )
+   {
+      tinytac_free(req);
+      return(rc);
+   };
+
+   session_id  = req->pckt_session_id;
+   reply       = NULL;
+   if (tinytac_send(sock, ttu_bench.key, req) == -1)
+      rc = TTAC_ENETWORK;
+   else if (tinytac_recv(sock, ttu_bench.key, &reply) == -1)
+      rc = (errno == EBADMSG) ? TTAC_EBADMSG : TTAC_ENETWORK;
+   if (s == -1)
+      close(sock);
+   tinytac_free(req);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   w->flags = reply->pckt_flags;
+   if ( (reply->pckt_session_id != session_id) || (tinytac_pckt_reply_view(reply, &view) != TTAC_SUCCESS) || (view.type != TAC_PLUS_TYPE_ACCT) )
+      rc = TTAC_EBADMSG;
+   else if (view.status != TAC_PLUS_ACCT_STATUS_SUCCESS)
+      rc = TTAC_EUNKNOWN;
+   tinytac_free(reply);
+
+   return(rc);
+}
+
+
+/// sends authorization request of a shell
+///
+/// @param[in]  w             worker sending request
+/// @param[in]  s             pooled connection or -1 to connect
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EACCES if the server
+///            refused the request, or an error code.
+int
+ttu_bench_author(
+         ttu_bench_worker_t *          w,
+         int                           s )
+{
+   int                     rc;
+   tinytac_pckt_t *        req;
+   tinytac_pckt_t *        reply;
+   tinytac_reply_view_t    view;
+
+   static const char * const args[] = { "service=shell", "cmd=", NULL };
+
+   rc = tinytac_pckt_author_req(w->cnf->tt, TAC_PLUS_AUTHEN_METH_TACACSPLUS, TAC_PLUS_PRIV_LVL_USER, (uint8_t)ttu_bench.authen_type, TAC_PLUS_AUTHEN_SVC_LOGIN, ttu_bench.user, "bench", NULL, args, &req);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   // caches and coalescing would hide the latency of the server
+   rc = tinytac_author(w->cnf->tt, s, req, &reply, (TTAC_REQ_NOCACHE | TTAC_REQ_NOCOALESCE));
+   tinytac_free(req);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+
+   w->flags = reply->pckt_flags;
+   if (tinytac_pckt_reply_view(reply, &view) != TTAC_SUCCESS)
+      rc = TTAC_EBADMSG;
+   else if (view.status == TAC_PLUS_AUTHOR_STATUS_FAIL)
+      rc = TTAC_EACCES;
+   else if ( (view.status != TAC_PLUS_AUTHOR_STATUS_PASS_ADD) && (view.status != TAC_PLUS_AUTHOR_STATUS_PASS_REPL) )
+      rc = TTAC_EUNKNOWN;
+   tinytac_free(reply);
+
+   return(rc);
+}
+
+
+/// returns latency histogram bucket of microseconds
+size_t
+ttu_bench_bucket(
+         uint64_t                      usec )
+{
+   size_t      low;
+   size_t      high;
+   size_t      mid;
+
+   low  = 0;
+   high = TTAC_STATS_BUCKETS - 1;
+   while (low < high)
+   {
+      mid = (low + high) / 2;
+      if (ttu_bench.bounds[mid] < usec)
+         low = mid + 1;
+      else
+         high = mid;
+   };
+
+   return(low);
+}
+
+
+/// returns description of connections used by run
+const char *
+ttu_bench_connections(
+         void )
+{
+   if (!(ttu_bench.pooled))
+      return("per-request");
+   if ((atomic_load(&ttu_bench.refused)))
+      return("per-request (single-connect refused)");
+   return("pooled");
+}
+
+
+/// writes results as JSON
+///
+/// @param[in]  fs            file stream
+/// @param[in]  results       results of each type followed by the total
+/// @param[in]  seconds       duration of run
+void
+ttu_bench_json(
+         FILE *                        fs,
+         const ttu_bench_result_t *    results,
+         double                        seconds )
+{
+   unsigned                   type;
+   double                     rate;
+   const ttu_bench_result_t * result;
+
+   fprintf(fs, "{\n");
+   fprintf(fs, "   \"threads\": %u,\n", ttu_bench.threads);
+   fprintf(fs, "   \"sessions\": %u,\n", ttu_bench.sessions);
+   fprintf(fs, "   \"connections\": \"%s\",\n", ttu_bench_connections());
+   fprintf(fs, "   \"seconds\": %.3f,\n", seconds);
+   fprintf(fs, "   \"requests\": {\n");
+   for(type = 0; (type <= TTU_BENCH_TYPES); type++)
+   {
+      result = &results[type];
+      rate   = ((result->requests)) ? ((double)result->errors / (double)result->requests) : 0.0;
+      fprintf(fs, "      \"%s\": {\n", ttu_bench_names[type]);
+      fprintf(fs, "         \"requests\": %llu,\n", (unsigned long long)result->requests);
+      fprintf(fs, "         \"errors\": %llu,\n", (unsigned long long)result->errors);
+      fprintf(fs, "         \"denied\": %llu,\n", (unsigned long long)result->denied);
+      fprintf(fs, "         \"error_rate\": %.6f,\n", rate);
+      fprintf(fs, "         \"throughput\": %.3f,\n", (seconds > 0.0) ? ((double)result->requests / seconds) : 0.0);
+      fprintf(fs, "         \"latency_ms\": {\n");
+      fprintf(fs, "            \"mean\": %.3f,\n", ((result->requests)) ? ((double)result->usec / (double)result->requests / 1000.0) : 0.0);
+      fprintf(fs, "            \"p50\": %.3f,\n", ttu_bench_percentile(result, 50.0));
+      fprintf(fs, "            \"p90\": %.3f,\n", ttu_bench_percentile(result, 90.0));
+      fprintf(fs, "            \"p99\": %.3f,\n", ttu_bench_percentile(result, 99.0));
+      fprintf(fs, "            \"p99.9\": %.3f\n", ttu_bench_percentile(result, 99.9));
+      fprintf(fs, "         }\n");
+      fprintf(fs, "      }%s\n", (type < TTU_BENCH_TYPES) ? "," : "");
+   };
+   fprintf(fs, "   }\n");
+   fprintf(fs, "}\n");
+
+   return;
+}
+
+
+/// adds results of worker to results of run
+///
+/// @param[in]  dst           results of run
+/// @param[in]  src           results of worker
+void
+ttu_bench_merge(
+         ttu_bench_result_t *          dst,
+         const ttu_bench_result_t *    src )
+{
+   size_t      idx;
+   dst->requests  += src->requests;
+   dst->errors    += src->errors;
+   dst->denied    += src->denied;
+   dst->usec      += src->usec;
+   for(idx = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+      dst->hist[idx] += src->hist[idx];
+   return;
+}
+
+
+/// parses request mix and builds the sequence of request types
+///
+/// Types are interleaved by weight, so "author=8,acct=1" sends an
+/// accounting record after every eight authorizations.
+///
+/// @param[in]  cnf           utility configuration
+/// @param[in]  arg           comma separated list of type[=weight]
+///
+/// @return    Returns 0 on success or 1 on error.
+int
+ttu_bench_mix(
+         ttu_config_t *                cnf,
+         const char *                  arg )
+{
+   unsigned       type;
+   unsigned       pick;
+   unsigned       total;
+   long           weight;
+   size_t         len;
+   size_t         pos;
+   const char *   ptr;
+   char *         end;
+   int            current[TTU_BENCH_TYPES];
+
+   memset(ttu_bench.weights, 0, sizeof(ttu_bench.weights));
+
+   for(ptr = arg; ((*ptr)); ptr = ((*end)) ? &end[1] : end)
+   {
+      len = strcspn(ptr, "=,");
+      for(type = 0; (type < TTU_BENCH_TYPES); type++)
+         if ( (strlen(ttu_bench_names[type]) == len) && (!(strncasecmp(ptr, ttu_bench_names[type], len))) )
+            break;
+      if (type == TTU_BENCH_TYPES)
+         return(ttu_error(cnf, 1, "unknown request type in mix `%s'", arg));
+      end    = (char *)&ptr[len];
+      weight = 1;
+      if (*end == '=')
+         weight = strtol(&end[1], &end, 10);
+      if ( (weight < 0) || (weight > TTU_BENCH_WEIGHT_MAX) || ( ((*end)) && (*end != ',') ) )
+         return(ttu_error(cnf, 1, "invalid weight in mix `%s'", arg));
+      ttu_bench.weights[type] = (unsigned)weight;
+   };
+
+   total = 0;
+   for(type = 0; (type < TTU_BENCH_TYPES); type++)
+      total += ttu_bench.weights[type];
+   if (!(total))
+      return(ttu_error(cnf, 1, "empty request mix `%s'", arg));
+
+   // smooth weighted round robin
+   memset(current, 0, sizeof(current));
+   for(pos = 0; (pos < total); pos++)
+   {
+      for(type = 0, pick = 0; (type < TTU_BENCH_TYPES); type++)
+      {
+         current[type] += (int)ttu_bench.weights[type];
+         if (current[type] > current[pick])
+            pick = type;
+      };
+      current[pick]        -= (int)total;
+      ttu_bench.mix[pos]    = pick;
+   };
+   ttu_bench.mix_len = total;
+
+   return(0);
+}
+
+
+/// returns monotonic time in nanoseconds
+uint64_t
+ttu_bench_now(
+         void )
+{
+   struct timespec      ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec);
+}
+
+
+/// returns latency below which a percentage of requests fall
+///
+/// @param[in]  result        results of type of request
+/// @param[in]  percentile    percentage of requests, 0 to 100
+///
+/// @return    Returns upper bound of latency in milliseconds.
+double
+ttu_bench_percentile(
+         const ttu_bench_result_t *    result,
+         double                        percentile )
+{
+   size_t         idx;
+   uint64_t       seen;
+   double         target;
+
+   if (!(result->requests))
+      return(0.0);
+
+   target = (percentile * (double)result->requests) / 100.0;
+   for(idx = 0, seen = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+   {
+      seen += result->hist[idx];
+      if ( ((result->hist[idx])) && ((double)seen >= target) )
+         return((double)ttu_bench.bounds[idx] / 1000.0);
+   };
+
+   return((double)ttu_bench.bounds[TTAC_STATS_BUCKETS - 1] / 1000.0);
+}
+
+
+/// prints results as a table
+///
+/// @param[in]  cnf           utility configuration
+/// @param[in]  results       results of each type followed by the total
+/// @param[in]  seconds       duration of run
+void
+ttu_bench_report(
+         ttu_config_t *                cnf,
+         const ttu_bench_result_t *    results,
+         double                        seconds )
+{
+   unsigned                   type;
+   const ttu_bench_result_t * result;
+
+   ttu_printf(cnf, "%u threads x %u sessions, %s connections, %.3f seconds\n", ttu_bench.threads, ttu_bench.sessions, ttu_bench_connections(), seconds);
+   ttu_printf(cnf, "%-8s %10s %8s %8s %8s %10s %9s %9s %9s %9s\n", "type", "requests", "errors", "denied", "error%", "req/s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms");
+   for(type = 0; (type <= TTU_BENCH_TYPES); type++)
+   {
+      result = &results[type];
+      if ( (type < TTU_BENCH_TYPES) && (!(ttu_bench.weights[type])) )
+         continue;
+      ttu_printf(cnf, "%-8s %10llu %8llu %8llu %8.3f %10.1f %9.3f %9.3f %9.3f %9.3f\n",
+         ttu_bench_names[type],
+         (unsigned long long)result->requests,
+         (unsigned long long)result->errors,
+         (unsigned long long)result->denied,
+         ((result->requests)) ? (((double)result->errors * 100.0) / (double)result->requests) : 0.0,
+         (seconds > 0.0) ? ((double)result->requests / seconds) : 0.0,
+         ttu_bench_percentile(result, 50.0),
+         ttu_bench_percentile(result, 90.0),
+         ttu_bench_percentile(result, 99.0),
+         ttu_bench_percentile(result, 99.9));
+   };
+
+   return;
+}
+
+
+/// sends request of type on pooled or new connection
+///
+/// A pooled connection is replaced after a network or protocol error.  A
+/// request which fails on a reused connection is sent once more on a new
+/// connection, since the server may have closed the connection after the
+/// previous session.  If the server does not acknowledge
+/// TAC_PLUS_SINGLE_CONNECT_FLAG, or closes a connection after its first
+/// session, the remaining requests of all workers use per-request
+/// connections.
+///
+/// @param[in]  w             worker sending request
+/// @param[in]  type          TTU_BENCH_* type of request
+///
+/// @return    Returns TTAC_SUCCESS on success, TTAC_EACCES if the server
+///            refused the request, or an error code.
+int
+ttu_bench_request(
+         ttu_bench_worker_t *          w,
+         unsigned                      type )
+{
+   int            rc;
+   int            s;
+   unsigned       used;
+
+   s = -1;
+   if ( ((ttu_bench.pooled)) && (!(atomic_load_explicit(&ttu_bench.refused, memory_order_relaxed))) )
+   {
+      if (w->s == -1)
+      {
+         if ((rc = tinytac_connect(w->cnf->tt, &w->s)) != TTAC_SUCCESS)
+            return(rc);
+         w->used = 0;
+      };
+      s = w->s;
+   };
+
+   // authentication replies are not visible to the widget
+   w->flags = TAC_PLUS_SINGLE_CONNECT_FLAG;
+
+   switch(type)
+   {
+      case TTU_BENCH_AUTHEN:
+      rc = tinytac_authen_login(w->cnf->tt, s, ttu_bench.user, w->cnf->pass, ttu_bench.authen_type, TTAC_REQ_NOOFFLINE);
+      break;
+
+      case TTU_BENCH_AUTHOR:
+      rc = ttu_bench_author(w, s);
+      break;
+
+      default:
+      rc = ttu_bench_acct(w, s);
+      break;
+   };
+
+   if (s == -1)
+      return(rc);
+
+   if ( (rc == TTAC_SUCCESS) || (rc == TTAC_EACCES) )
+   {
+      if ((w->flags & TAC_PLUS_SINGLE_CONNECT_FLAG))
+      {
+         w->used++;
+         return(rc);
+      };
+      atomic_store(&ttu_bench.refused, 1);
+   };
+
+   used  = w->used;
+   close(w->s);
+   w->s  = -1;
+
+   // connection closed by the server is reported as a short read
+   if ( ( (rc != TTAC_ENETWORK) && (rc != TTAC_EBADMSG) ) || (!(used)) )
+      return(rc);
+   if (used == 1)
+      atomic_store(&ttu_bench.refused, 1);
+
+   return(ttu_bench_request(w, type));
+}
+
+
+/// sends requests until the count or the duration is reached
+///
+/// @param[in]  arg           reference to worker
+///
+/// @return    Returns NULL.
+void *
+ttu_bench_worker(
+         void *                        arg )
+{
+   int                     rc;
+   size_t                  pos;
+   uint64_t                start;
+   uint64_t                usec;
+   ttu_bench_worker_t *    w;
+   ttu_bench_result_t *    result;
+
+   w = arg;
+
+   // workers start at different positions of the request mix
+   for(pos = w->id; (!(atomic_load_explicit(&ttu_bench.stop, memory_order_relaxed))); pos++)
+   {
+      start = ttu_bench_now();
+      if ( ((ttu_bench.deadline)) && (start >= ttu_bench.deadline) )
+         break;
+      if ( ((ttu_bench.count)) && (atomic_fetch_sub_explicit(&ttu_bench.remaining, 1, memory_order_relaxed) <= 0) )
+         break;
+
+      result   = &w->results[ttu_bench.mix[pos % ttu_bench.mix_len]];
+      rc       = ttu_bench_request(w, ttu_bench.mix[pos % ttu_bench.mix_len]);
+      usec     = (ttu_bench_now() - start) / 1000;
+
+      result->requests++;
+      result->usec += usec;
+      result->hist[ttu_bench_bucket(usec)]++;
+      if (rc == TTAC_EACCES)
+         result->denied++;
+      else if (rc != TTAC_SUCCESS)
+         result->errors++;
+   };
+
+   if (w->s != -1)
+      close(w->s);
+   w->s = -1;
+
+   return(NULL);
+}
+
+
+//------------------//
+// widget functions //
+//------------------//
+#pragma mark widget functions
+
+int
+ttu_widget_bench(
+         ttu_config_t *                cnf )
+{
+   int                     rc;
+   int                     ival;
+   size_t                  pos;
+   size_t                  idx;
+   size_t                  workers_len;
+   unsigned                type;
+   uint64_t                start;
+   double                  seconds;
+   FILE *                  fs;
+   ttu_bench_worker_t *    workers;
+   ttu_bench_result_t      results[TTU_BENCH_TYPES + 1];
+   struct sigaction        sa;
+
+   assert(cnf != NULL);
+
+   // initial processing of cli arguments
+   if ((rc = ttu_cli_arguments(cnf, cnf->argc, cnf->argv)) != 0)
+      return((rc == -1) ? 0 : 1);
+   if ((cnf->argc - optind) < 1)
+   {
+      fprintf(stderr, "%s: missing required argument\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      return(1);
+   };
+   ttu_bench.user = cnf->argv[optind];
+   if (!(ttu_bench.mix_len))
+      ttu_bench_mix(cnf, "authen,author,acct");
+
+   if ((ttu_bench.weights[TTU_BENCH_AUTHEN]))
+   {
+      if ((ttu_password(cnf)))
+         return(1);
+      if (!(cnf->pass))
+      {
+         fprintf(stderr, "%s: missing required argument -W, -w, or -y\n", cnf->prog_name);
+         fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+         return(1);
+      };
+   };
+   if ( ((ttu_bench.weights[TTU_BENCH_ACCT])) && ((tinytac_get_option(cnf->tt, TTAC_OPT_KEY, &ttu_bench.key) != TTAC_SUCCESS) || (!(ttu_bench.key))) )
+      return(ttu_error(cnf, 1, "accounting requires a key"));
+
+   // prefer ASCII login unless restricted by -a
+   ival = TTAC_NO;
+   tinytac_get_option(cnf->tt, TTAC_OPT_AUTHEN_ASCII, &ival);
+   ttu_bench.authen_type = (ival == TTAC_YES) ? TAC_PLUS_AUTHEN_TYPE_ASCII : TAC_PLUS_AUTHEN_TYPE_PAP;
+
+   for(idx = 0; (idx < TTAC_STATS_BUCKETS); idx++)
+      ttu_bench.bounds[idx] = tinytac_stats_bucket(idx);
+
+   workers_len = (size_t)ttu_bench.threads * (size_t)ttu_bench.sessions;
+   if (workers_len > TTU_BENCH_WORKERS_MAX)
+   {
+      free(ttu_bench.key);
+      return(ttu_error(cnf, 1, "more than %u sessions in flight", TTU_BENCH_WORKERS_MAX));
+   };
+   if ((workers = calloc(workers_len, sizeof(ttu_bench_worker_t))) == NULL)
+   {
+      free(ttu_bench.key);
+      return(ttu_error(cnf, 1, "out of virtual memory"));
+   };
+
+   // run for ten seconds unless limited by count
+   if ( (!(ttu_bench.count)) && (!(ttu_bench.seconds)) )
+      ttu_bench.seconds = 10;
+   start = ttu_bench_now();
+   atomic_store(&ttu_bench.remaining, (int64_t)ttu_bench.count);
+   atomic_store(&ttu_bench.stop, 0);
+   ttu_bench.deadline = ((ttu_bench.seconds)) ? (start + ((uint64_t)ttu_bench.seconds * 1000000000ULL)) : 0;
+
+   // connections closed by servers are reported as errors
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &sa, NULL);
+
+   rc = 0;
+   for(pos = 0; (pos < workers_len); pos++)
+   {
+      workers[pos].id   = pos;
+      workers[pos].s    = -1;
+      workers[pos].cnf  = cnf;
+      if ((errno = pthread_create(&workers[pos].thread, NULL, &ttu_bench_worker, &workers[pos])) != 0)
+      {
+         rc = ttu_error(cnf, 1, "pthread_create: %s", strerror(errno));
+         atomic_store(&ttu_bench.stop, 1);
+         break;
+      };
+   };
+   workers_len = pos;
+
+   // merge results of workers
+   memset(results, 0, sizeof(results));
+   for(pos = 0; (pos < workers_len); pos++)
+   {
+      pthread_join(workers[pos].thread, NULL);
+      for(type = 0; (type < TTU_BENCH_TYPES); type++)
+      {
+         ttu_bench_merge(&results[type],            &workers[pos].results[type]);
+         ttu_bench_merge(&results[TTU_BENCH_TYPES], &workers[pos].results[type]);
+      };
+   };
+   seconds = (double)(ttu_bench_now() - start) / 1000000000.0;
+   free(workers);
+   free(ttu_bench.key);
+   ttu_bench.key = NULL;
+   if (rc != 0)
+      return(rc);
+
+   ttu_bench_report(cnf, results, seconds);
+
+   if (!(ttu_bench.json))
+      return(0);
+   if (!(strcmp(ttu_bench.json, "-")))
+   {
+      ttu_bench_json(stdout, results, seconds);
+      return(0);
+   };
+   if ((fs = fopen(ttu_bench.json, "w")) == NULL)
+      return(ttu_error(cnf, 1, "%s: %s", ttu_bench.json, strerror(errno)));
+   ttu_bench_json(fs, results, seconds);
+   fclose(fs);
+
+   return(0);
+}
+
+
+int
+ttu_widget_bench_option(
+         ttu_config_t *                cnf,
+         int                           c,
+         const char *                  arg )
+{
+   long           ival;
+   char *         end;
+
+   switch(c)
+   {
+      case 'c':
+      ival = strtol(arg, &end, 10);
+      if ( ((*end)) || (ival < 1) )
+         return(ttu_error(cnf, 1, "invalid count `%s'", arg));
+      ttu_bench.count = (uint64_t)ival;
+      return(0);
+
+      case 'j':
+      ttu_bench.json = arg;
+      return(0);
+
+      case 'l':
+      ival = strtol(arg, &end, 10);
+      if ( ((*end)) || (ival < 1) || (ival > 86400) )
+         return(ttu_error(cnf, 1, "invalid duration `%s'", arg));
+      ttu_bench.seconds = (unsigned)ival;
+      return(0);
+
+      case 'm':
+      return(ttu_bench_mix(cnf, arg));
+
+      case 'n':
+      ival = strtol(arg, &end, 10);
+      if ( ((*end)) || (ival < 1) || (ival > TTU_BENCH_WORKERS_MAX) )
+         return(ttu_error(cnf, 1, "invalid number of sessions `%s'", arg));
+      ttu_bench.sessions = (unsigned)ival;
+      return(0);
+
+      case 'P':
+      ttu_bench.pooled = 1;
+      return(0);
+
+      case 't':
+      ival = strtol(arg, &end, 10);
+      if ( ((*end)) || (ival < 1) || (ival > TTU_BENCH_WORKERS_MAX) )
+         return(ttu_error(cnf, 1, "invalid number of threads `%s'", arg));
+      ttu_bench.threads = (unsigned)ival;
+      return(0);
+
+      default:
+      break;
+   };
+
+   fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+   fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+   return(1);
+}
+
+
+int
+ttu_widget_bench_usage(
+         ttu_config_t *                cnf )
+{
+   assert(cnf != NULL);
+   printf("BENCH OPTIONS:\n");
+   printf("  -c count                  stop after count requests\n");
+   printf("  -j file                   write JSON report to file, - for stdout\n");
+   printf("  -l seconds                stop after seconds (default: 10)\n");
+   printf("  -m mix                    request types and weights (default: authen=1,author=1,acct=1)\n");
+   printf("  -n sessions               sessions in flight per thread (default: 1)\n");
+   printf("  -P                        reuse single-connect connections (default: connect per request)\n");
+   printf("  -t threads                number of threads (default: 1)\n");
+   return(0);
+}
+
+
+/* end of source */
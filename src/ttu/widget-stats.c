@@ -0,0 +1,156 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _SRC_TTU_WIDGET_STATS_C 1
+#include "tinytacutil.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <tinytac.h>
+#include <bindle_prefix.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// prints statistics of tinytacd in OpenMetrics format
+///
+/// Statistics are exported by the daemon listening on the socket of
+/// TTAC_OPT_PROXY, which relays the requests of every process on the host.
+int
+ttu_widget_stats(
+         ttu_config_t *                cnf )
+{
+   int                     rc;
+   int                     s;
+   size_t                  len;
+   char *                  key;
+   char *                  path;
+   tinytac_pckt_t *        req;
+   tinytac_pckt_t *        reply;
+   struct sockaddr_un      sa;
+
+   assert(cnf != NULL);
+
+   if ((rc = ttu_cli_arguments(cnf, cnf->argc, cnf->argv)) != 0)
+      return((rc == -1) ? 0 : 1);
+
+   if ((rc = tinytac_get_option(cnf->tt, TTAC_OPT_PROXY, &path)) != TTAC_SUCCESS)
+      return(ttu_error(cnf, 1, "tinytac_get_option(TTAC_OPT_PROXY): %s", tinytac_strerror(rc)));
+   if (!(path))
+      return(ttu_error(cnf, 1, "socket of tinytacd is not configured (TINYTAC_PROXY)"));
+   if (strlen(path) >= sizeof(sa.sun_path))
+   {
+      ttu_error(cnf, 1, "%s: socket path too long", path);
+      free(path);
+      return(1);
+   };
+   memset(&sa, 0, sizeof(sa));
+   sa.sun_family = AF_UNIX;
+   strncpy(sa.sun_path, path, sizeof(sa.sun_path)-1);
+   free(path);
+
+   if ((rc = tinytac_get_option(cnf->tt, TTAC_OPT_KEY, &key)) != TTAC_SUCCESS)
+      return(ttu_error(cnf, 1, "tinytac_get_option(TTAC_OPT_KEY): %s", tinytac_strerror(rc)));
+   if (!(key))
+      return(ttu_error(cnf, 1, "missing key of tinytacd"));
+
+   // request is obfuscated with the key like requests relayed by tinytacd
+   len = strlen(TTAC_PROXY_STATS_BODY);
+   if ((req = malloc(sizeof(tinytac_pckt_t) + len)) == NULL)
+   {
+      free(key);
+      return(ttu_error(cnf, 1, "out of virtual memory"));
+   };
+   req->pckt_version    = (TAC_PLUS_MAJOR_VER << 4) | TAC_PLUS_MINOR_VER_DEFAULT;
+   req->pckt_type       = TTAC_PROXY_TYPE_STATS;
+   req->pckt_seq_no     = 1;
+   req->pckt_flags      = TAC_PLUS_UNENCRYPTED_FLAG;  // plain text until sent
+   req->pckt_session_id = htonl((uint32_t)getpid());
+   req->pckt_length     = htonl((uint32_t)len);
+   memcpy(req->pckt_body, TTAC_PROXY_STATS_BODY, len);
+
+   if ((s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1)
+   {
+      free(key);
+      free(req);
+      return(ttu_error(cnf, 1, "socket(): %s", strerror(errno)));
+   };
+   if (connect(s, (struct sockaddr *)&sa, sizeof(sa)) == -1)
+   {
+      ttu_error(cnf, 1, "%s: %s", sa.sun_path, strerror(errno));
+      close(s);
+      free(key);
+      free(req);
+      return(1);
+   };
+
+   rc = tinytac_send(s, key, req);
+   free(req);
+   if (rc != -1)
+      rc = tinytac_recv(s, key, &reply);
+   free(key);
+   close(s);
+   if (rc == -1)
+      return(ttu_error(cnf, 1, "%s: %s", sa.sun_path, strerror(errno)));
+
+   if ( (reply->pckt_type != TTAC_PROXY_TYPE_STATS) || (reply->pckt_seq_no != 2) )
+   {
+      tinytac_free(reply);
+      return(ttu_error(cnf, 1, "%s: invalid reply", sa.sun_path));
+   };
+
+   ttu_printf(cnf, "%.*s", (int)ntohl(reply->pckt_length), (char *)reply->pckt_body);
+   tinytac_free(reply);
+
+   return(0);
+}
+
+
+/* end of source */
@@ -0,0 +1,748 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_ACCT_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "acct-test"
+
+#define TEST_KEY              "secret"
+#define TEST_CONNS            8
+#define TEST_RECORDS          200
+#define TEST_DROP_DELAY       1000        // microseconds before each reply
+#define TEST_WATCHDOG_WAIT    2500000     // microseconds, two intervals of one second
+#define TEST_ELAPSED          "elapsed_time="
+#define TEST_USER_WATCHED     "watched"
+#define TEST_USER_UNWATCHED   "unwatched"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _test_server
+{
+   pthread_t               thread;
+   pthread_mutex_t         mutex;
+   int                     listener;
+   int                     wakeup[2];
+   int                     port;
+   useconds_t              delay;
+   size_t                  records;       // START and STOP records
+   size_t                  watchdogs;     // WATCHDOG records of watched session
+   size_t                  elapsed;       // WATCHDOG records with elapsed_time
+   size_t                  stray;         // malformed or unexpected records
+} test_server_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static int
+test_block(
+         void );
+
+
+static void
+test_count(
+         const tinytac_pckt_t *        req );
+
+
+static int
+test_drop(
+         void );
+
+
+static int
+test_dropped(
+         TinyTac *                     tt,
+         uint64_t *                    droppedp );
+
+
+static int
+test_open(
+         TinyTac **                    ttp,
+         int                           queue,
+         int                           policy );
+
+
+static int
+test_reply(
+         int                           s );
+
+
+static void *
+test_serve(
+         void *                        arg );
+
+
+static int
+test_start(
+         useconds_t                    delay );
+
+
+static void
+test_stop(
+         void );
+
+
+static int
+test_submit(
+         TinyTac *                     tt,
+         const char *                  user,
+         uint32_t *                    idp );
+
+
+static int
+test_watchdog(
+         void );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static char             test_key[] = TEST_KEY;
+static test_server_t    test_srv = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+
+   errs  = 0;
+   errs += test_block();
+   errs += test_drop();
+   errs += test_watchdog();
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// verifies that a full queue blocks the caller without losing records
+///
+/// @return    Returns number of failed checks.
+int
+test_block(
+         void )
+{
+   int                  errs;
+   size_t               pos;
+   TinyTac *            tt;
+
+   if ((test_start(0)))
+      return(1);
+   if ((test_open(&tt, 2, TTAC_ACCT_BLOCK)))
+   {
+      test_stop();
+      return(1);
+   };
+
+   errs = 0;
+   for(pos = 0; (pos < TEST_RECORDS); pos++)
+   {
+      if (test_submit(tt, TEST_USER_UNWATCHED, NULL) != TTAC_SUCCESS)
+      {
+         printf("%s: block: unable to submit record %zu\n", PROGRAM_NAME, pos);
+         errs++;
+         break;
+      };
+   };
+   tinytac_free(tt);
+   test_stop();
+
+   if (test_srv.records != pos)
+   {
+      printf("%s: block: server received %zu of %zu records\n", PROGRAM_NAME, test_srv.records, pos);
+      errs++;
+   };
+   if ((test_srv.stray))
+   {
+      printf("%s: block: server received %zu unexpected records\n", PROGRAM_NAME, test_srv.stray);
+      errs++;
+   };
+
+   return(errs);
+}
+
+
+/// records accounting REQUEST received by the server
+///
+/// @param[in]  req           accounting REQUEST
+void
+test_count(
+         const tinytac_pckt_t *        req )
+{
+   size_t                        len;
+   size_t                        off;
+   size_t                        pos;
+   size_t                        last;
+   int                           watched;
+   const tinytac_acct_req_t *    body;
+   const uint8_t *               bytes;
+
+   body  = (const tinytac_acct_req_t *)req->pckt_body;
+   bytes = req->pckt_body;
+   len   = ntohl(req->pckt_length);
+
+   pthread_mutex_lock(&test_srv.mutex);
+
+   if ( (req->pckt_type != TAC_PLUS_TYPE_ACCT) || (len < sizeof(tinytac_acct_req_t)) )
+   {
+      test_srv.stray++;
+      pthread_mutex_unlock(&test_srv.mutex);
+      return;
+   };
+
+   // user, port, rem_addr and all but the last argument precede the last argument
+   off  = sizeof(tinytac_acct_req_t) + body->bdy_arg_cnt;
+   last = off + body->bdy_user_len + body->bdy_port_len + body->bdy_rem_addr_len;
+   for(pos = 0; ( ((body->bdy_arg_cnt)) && (pos < (size_t)(body->bdy_arg_cnt - 1)) ); pos++)
+      last += body->bdy_bytes[pos];
+   if ( (off + body->bdy_user_len) > len )
+   {
+      test_srv.stray++;
+      pthread_mutex_unlock(&test_srv.mutex);
+      return;
+   };
+   watched = ( (body->bdy_user_len == strlen(TEST_USER_WATCHED)) && (!(memcmp(&bytes[off], TEST_USER_WATCHED, body->bdy_user_len))) );
+
+   if (!(body->bdy_flags & TAC_PLUS_ACCT_FLAG_WATCHDOG))
+      test_srv.records++;
+   else if (!(watched))
+      test_srv.stray++;
+   else
+   {
+      test_srv.watchdogs++;
+      if ( ((body->bdy_arg_cnt)) && ((last + strlen(TEST_ELAPSED)) <= len) &&
+           (!(memcmp(&bytes[last], TEST_ELAPSED, strlen(TEST_ELAPSED)))) )
+         test_srv.elapsed++;
+   };
+
+   pthread_mutex_unlock(&test_srv.mutex);
+
+   return;
+}
+
+
+/// verifies that discarded records are counted when the queue overflows
+///
+/// The server delays every reply, so the single queued record is replaced
+/// by later records.  Every submitted record is either received by the
+/// server or counted as dropped.
+///
+/// @return    Returns number of failed checks.
+int
+test_drop(
+         void )
+{
+   int                  errs;
+   size_t               pos;
+   uint64_t             dropped;
+   TinyTac *            tt;
+
+   if ((test_start(TEST_DROP_DELAY)))
+      return(1);
+   if ((test_open(&tt, 1, TTAC_ACCT_DROP)))
+   {
+      test_stop();
+      return(1);
+   };
+
+   errs = 0;
+   for(pos = 0; (pos < TEST_RECORDS); pos++)
+   {
+      if (test_submit(tt, TEST_USER_UNWATCHED, NULL) != TTAC_SUCCESS)
+      {
+         printf("%s: drop: unable to submit record %zu\n", PROGRAM_NAME, pos);
+         errs++;
+         break;
+      };
+   };
+   if ((test_dropped(tt, &dropped)))
+   {
+      printf("%s: drop: unable to read dropped records\n", PROGRAM_NAME);
+      errs++;
+   };
+   tinytac_free(tt);
+   test_stop();
+
+   if ((errs))
+      return(errs);
+   if (!(dropped))
+   {
+      printf("%s: drop: no record was dropped\n", PROGRAM_NAME);
+      errs++;
+   };
+   if ((test_srv.records + dropped) != pos)
+   {
+      printf("%s: drop: %zu received and %llu dropped of %zu records\n", PROGRAM_NAME, test_srv.records, (unsigned long long)dropped, pos);
+      errs++;
+   };
+
+   return(errs);
+}
+
+
+/// reads number of dropped accounting records from statistics of handle
+///
+/// @param[in]  tt            reference to library handle
+/// @param[out] droppedp      pointer to store number of dropped records
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+test_dropped(
+         TinyTac *                     tt,
+         uint64_t *                    droppedp )
+{
+   char *               text;
+   char *               ptr;
+   size_t               len;
+   unsigned long long   dropped;
+
+   if (tinytac_stats_openmetrics(tt, NULL, 0, &len) != TTAC_ENOBUFS)
+      return(-1);
+   if ((text = malloc(len + 1)) == NULL)
+      return(-1);
+   if (tinytac_stats_openmetrics(tt, text, len + 1, NULL) != TTAC_SUCCESS)
+   {
+      free(text);
+      return(-1);
+   };
+   if ((ptr = strstr(text, "\ntinytac_acct_dropped_total ")) == NULL)
+   {
+      free(text);
+      return(-1);
+   };
+   if (sscanf(ptr, " tinytac_acct_dropped_total %llu", &dropped) != 1)
+   {
+      free(text);
+      return(-1);
+   };
+   free(text);
+   *droppedp = (uint64_t)dropped;
+
+   return(0);
+}
+
+
+/// allocates handle which sends accounting records to the test server
+///
+/// @param[out] ttp           pointer to store handle
+/// @param[in]  queue         size of accounting queue
+/// @param[in]  policy        TTAC_ACCT_BLOCK or TTAC_ACCT_DROP
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+test_open(
+         TinyTac **                    ttp,
+         int                           queue,
+         int                           policy )
+{
+   char                 hosts[64];
+
+   snprintf(hosts, sizeof(hosts), "tacacs+://127.0.0.1:%i", test_srv.port);
+   if (tinytac_initialize(ttp, hosts, TEST_KEY, TTAC_NOINIT) != TTAC_SUCCESS)
+   {
+      printf("%s: tinytac_initialize(): unable to allocate handle\n", PROGRAM_NAME);
+      return(-1);
+   };
+   if ( (tinytac_set_option(*ttp, TTAC_OPT_ACCT_QUEUE, &queue) != TTAC_SUCCESS) ||
+        (tinytac_set_option(*ttp, TTAC_OPT_ACCT_POLICY, &policy) != TTAC_SUCCESS) )
+   {
+      printf("%s: tinytac_set_option(): unable to set accounting queue\n", PROGRAM_NAME);
+      tinytac_free(*ttp);
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+/// answers one accounting REQUEST on connection
+///
+/// @param[in]  s             connected socket
+///
+/// @return    Returns 0 on success or -1 if the connection was closed.
+int
+test_reply(
+         int                           s )
+{
+   tinytac_pckt_t *           req;
+   tinytac_pckt_t *           reply;
+   tinytac_acct_reply_t *     body;
+   size_t                     len;
+
+   if (tinytac_recv(s, test_key, &req) != TTAC_SUCCESS)
+      return(-1);
+   test_count(req);
+
+   len = offsetof(tinytac_acct_reply_t, bdy_bytes);
+   if ((reply = calloc(1, sizeof(tinytac_pckt_t) + sizeof(tinytac_acct_reply_t))) == NULL)
+   {
+      tinytac_free(req);
+      return(-1);
+   };
+   reply->pckt_version     = req->pckt_version;
+   reply->pckt_type        = req->pckt_type;
+   reply->pckt_seq_no      = (uint8_t)(req->pckt_seq_no + 1);
+   reply->pckt_flags       = TAC_PLUS_SINGLE_CONNECT_FLAG | TAC_PLUS_UNENCRYPTED_FLAG;
+   reply->pckt_session_id  = req->pckt_session_id;
+   reply->pckt_length      = htonl((uint32_t)len);
+   body                    = (tinytac_acct_reply_t *)reply->pckt_body;
+   body->bdy_status        = TAC_PLUS_ACCT_STATUS_SUCCESS;
+   tinytac_free(req);
+
+   if ((test_srv.delay))
+      usleep(test_srv.delay);
+   if (tinytac_send(s, test_key, reply) != TTAC_SUCCESS)
+   {
+      free(reply);
+      return(-1);
+   };
+   free(reply);
+
+   return(0);
+}
+
+
+/// accepts connections and answers accounting requests until woken up
+///
+/// @param[in]  arg           unused
+///
+/// @return    Returns NULL.
+void *
+test_serve(
+         void *                        arg )
+{
+   struct pollfd        fds[TEST_CONNS + 2];
+   nfds_t               nfds;
+   nfds_t               pos;
+   int                  s;
+   int                  opt;
+
+   (void)arg;
+
+   opt            = 1;
+
+   fds[0].fd      = test_srv.wakeup[0];
+   fds[0].events  = POLLIN;
+   fds[0].revents = 0;
+   fds[1].fd      = test_srv.listener;
+   fds[1].events  = POLLIN;
+   fds[1].revents = 0;
+   nfds           = 2;
+
+   while(!(fds[0].revents))
+   {
+      if (poll(fds, nfds, -1) == -1)
+         continue;
+      for(pos = 2; (pos < nfds); pos++)
+      {
+         if (!(fds[pos].revents))
+            continue;
+         if (test_reply(fds[pos].fd) == 0)
+            continue;
+         close(fds[pos].fd);
+         fds[pos--] = fds[--nfds];
+      };
+      if (!(fds[1].revents & POLLIN))
+         continue;
+      if ((s = accept(test_srv.listener, NULL, NULL)) == -1)
+         continue;
+      // replies of a pipelined batch are written separately
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+      if (nfds == (TEST_CONNS + 2))
+      {
+         close(s);
+         continue;
+      };
+      fds[nfds].fd      = s;
+      fds[nfds].events  = POLLIN;
+      fds[nfds].revents = 0;
+      nfds++;
+   };
+
+   for(pos = 2; (pos < nfds); pos++)
+      close(fds[pos].fd);
+
+   return(NULL);
+}
+
+
+/// starts test server on ephemeral port of loopback address
+///
+/// @param[in]  delay         microseconds to wait before each reply
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+test_start(
+         useconds_t                    delay )
+{
+   struct sockaddr_in   sin;
+   socklen_t            len;
+
+   test_srv.delay       = delay;
+   test_srv.records     = 0;
+   test_srv.watchdogs   = 0;
+   test_srv.elapsed     = 0;
+   test_srv.stray       = 0;
+
+   memset(&sin, 0, sizeof(sin));
+   sin.sin_family       = AF_INET;
+   sin.sin_addr.s_addr  = htonl(INADDR_LOOPBACK);
+   sin.sin_port         = 0;
+   len                  = sizeof(sin);
+
+   if ((test_srv.listener = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+   {
+      printf("%s: socket(): unable to create listener\n", PROGRAM_NAME);
+      return(-1);
+   };
+   if ( (bind(test_srv.listener, (struct sockaddr *)&sin, len) == -1) ||
+        (listen(test_srv.listener, TEST_CONNS) == -1) ||
+        (getsockname(test_srv.listener, (struct sockaddr *)&sin, &len) == -1) )
+   {
+      printf("%s: bind(): unable to listen on loopback address\n", PROGRAM_NAME);
+      close(test_srv.listener);
+      return(-1);
+   };
+   test_srv.port = ntohs(sin.sin_port);
+   if (pipe(test_srv.wakeup) == -1)
+   {
+      printf("%s: pipe(): unable to create pipe\n", PROGRAM_NAME);
+      close(test_srv.listener);
+      return(-1);
+   };
+   if (pthread_create(&test_srv.thread, NULL, &test_serve, NULL) != 0)
+   {
+      printf("%s: pthread_create(): unable to start server\n", PROGRAM_NAME);
+      close(test_srv.wakeup[0]);
+      close(test_srv.wakeup[1]);
+      close(test_srv.listener);
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+/// stops test server
+void
+test_stop(
+         void )
+{
+   if (write(test_srv.wakeup[1], "", 1) == -1)
+      printf("%s: write(): unable to wake up server\n", PROGRAM_NAME);
+   pthread_join(test_srv.thread, NULL);
+   close(test_srv.wakeup[0]);
+   close(test_srv.wakeup[1]);
+   close(test_srv.listener);
+   return;
+}
+
+
+/// submits accounting START record of user
+///
+/// @param[in]  tt            reference to library handle
+/// @param[in]  user          user name
+/// @param[out] idp           pointer to store watchdog session or NULL
+///
+/// @return    Returns TTAC_SUCCESS on success or an error code.
+int
+test_submit(
+         TinyTac *                     tt,
+         const char *                  user,
+         uint32_t *                    idp )
+{
+   int                  rc;
+   tinytac_pckt_t *     pckt;
+   const char *         args[] = { "service=shell", NULL };
+
+   rc = tinytac_pckt_acct_req(tt, TAC_PLUS_ACCT_FLAG_START, TAC_PLUS_AUTHEN_METH_TACACSPLUS,
+      TAC_PLUS_PRIV_LVL_USER, TAC_PLUS_AUTHEN_TYPE_ASCII, TAC_PLUS_AUTHEN_SVC_LOGIN, user,
+      PROGRAM_NAME, "127.0.0.1", args, &pckt);
+   if (rc != TTAC_SUCCESS)
+      return(rc);
+   if ( ((idp)) && ((rc = tinytac_acct_watch(tt, pckt, idp)) != TTAC_SUCCESS) )
+   {
+      tinytac_free(pckt);
+      return(rc);
+   };
+   if ((rc = tinytac_acct_submit(tt, pckt)) != TTAC_SUCCESS)
+   {
+      if ((idp))
+         tinytac_acct_unwatch(tt, *idp);
+      tinytac_free(pckt);
+      return(rc);
+   };
+
+   return(TTAC_SUCCESS);
+}
+
+
+/// verifies that only watched sessions report to the timer wheel
+///
+/// One watched and one unwatched session are started with an interval of
+/// one second, for which the jitter is zero.  After two and a half seconds
+/// the watched session must have sent WATCHDOG records with an
+/// elapsed_time argument and the unwatched session none.
+///
+/// @return    Returns number of failed checks.
+int
+test_watchdog(
+         void )
+{
+   int                  errs;
+   int                  interval;
+   uint32_t             id;
+   TinyTac *            tt;
+
+   if ((test_start(0)))
+      return(1);
+   if ((test_open(&tt, 16, TTAC_ACCT_BLOCK)))
+   {
+      test_stop();
+      return(1);
+   };
+   interval = 1;
+   if (tinytac_set_option(tt, TTAC_OPT_ACCT_WATCHDOG, &interval) != TTAC_SUCCESS)
+   {
+      printf("%s: tinytac_set_option(): unable to set watchdog interval\n", PROGRAM_NAME);
+      tinytac_free(tt);
+      test_stop();
+      return(1);
+   };
+
+   errs = 0;
+   if ( (test_submit(tt, TEST_USER_WATCHED, &id) != TTAC_SUCCESS) ||
+        (test_submit(tt, TEST_USER_UNWATCHED, NULL) != TTAC_SUCCESS) )
+   {
+      printf("%s: watchdog: unable to submit records\n", PROGRAM_NAME);
+      errs++;
+   }
+   else
+   {
+      usleep(TEST_WATCHDOG_WAIT);
+      if (tinytac_acct_unwatch(tt, id) != TTAC_SUCCESS)
+      {
+         printf("%s: watchdog: unable to unwatch session\n", PROGRAM_NAME);
+         errs++;
+      };
+      if (tinytac_acct_unwatch(tt, id) != TTAC_ENOENT)
+      {
+         printf("%s: watchdog: session unwatched twice\n", PROGRAM_NAME);
+         errs++;
+      };
+   };
+   tinytac_free(tt);
+   test_stop();
+
+   if ((errs))
+      return(errs);
+   if (test_srv.records != 2)
+   {
+      printf("%s: watchdog: server received %zu of 2 START records\n", PROGRAM_NAME, test_srv.records);
+      errs++;
+   };
+   if (!(test_srv.watchdogs))
+   {
+      printf("%s: watchdog: watched session sent no WATCHDOG record\n", PROGRAM_NAME);
+      errs++;
+   };
+   if (test_srv.elapsed != test_srv.watchdogs)
+   {
+      printf("%s: watchdog: %zu of %zu WATCHDOG records without elapsed_time\n", PROGRAM_NAME, (test_srv.watchdogs - test_srv.elapsed), test_srv.watchdogs);
+      errs++;
+   };
+   if ((test_srv.stray))
+   {
+      printf("%s: watchdog: server received %zu unexpected records\n", PROGRAM_NAME, test_srv.stray);
+      errs++;
+   };
+
+   return(errs);
+}
+
+
+/* end of source */
@@ -0,0 +1,458 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_ARENA_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "larena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "arena-test"
+
+#define TEST_ROUNDS           100
+#define TEST_SMALL            100
+#define TEST_LARGE            (TTAC_ARENA_SIZE * 3)
+#define TEST_ALIGN            (_Alignof(max_align_t))
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static int
+test_align(
+         void );
+
+
+static void
+test_free(
+         void *                        ptr );
+
+
+static int
+test_large(
+         void );
+
+
+static void *
+test_malloc(
+         size_t                        size );
+
+
+static int
+test_nested(
+         void );
+
+
+static void *
+test_realloc(
+         void *                        ptr,
+         size_t                        size );
+
+
+static int
+test_reuse(
+         void );
+
+
+static int
+test_steady(
+         void );
+
+
+static void *
+test_thread(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static atomic_size_t    test_allocs;
+static atomic_size_t    test_frees;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+   size_t               allocs;
+   size_t               frees;
+   pthread_t            thread;
+   void *               res;
+
+   if (tinytac_set_allocator(&test_malloc, &test_realloc, &test_free) != TTAC_SUCCESS)
+   {
+      printf("%s: tinytac_set_allocator(): unable to set allocator\n", PROGRAM_NAME);
+      return(1);
+   };
+
+   // chunks of an exiting thread are freed
+   allocs = atomic_load(&test_allocs);
+   frees  = atomic_load(&test_frees);
+   pthread_create(&thread, NULL, &test_thread, NULL);
+   pthread_join(thread, &res);
+   errs   = (int)(intptr_t)res;
+   allocs = atomic_load(&test_allocs) - allocs;
+   frees  = atomic_load(&test_frees)  - frees;
+   if (!(allocs))
+   {
+      printf("%s: thread: no chunk was allocated with the library allocator\n", PROGRAM_NAME);
+      errs++;
+   };
+   if (allocs != frees)
+   {
+      printf("%s: thread: %zu of %zu chunks not freed at thread exit\n", PROGRAM_NAME, (allocs - frees), allocs);
+      errs++;
+   };
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// verifies that allocations are aligned for any type
+///
+/// @return    Returns number of failed checks.
+int
+test_align(
+         void )
+{
+   int                     errs;
+   size_t                  size;
+   uint8_t *               ptr;
+   tinytac_arena_mark_t    mark;
+
+   errs = 0;
+   tinytac_arena_mark(&mark);
+   for(size = 1; (size <= (TEST_ALIGN * 4)); size++)
+   {
+      if ((ptr = tinytac_arena_alloc(size)) == NULL)
+      {
+         printf("%s: align: unable to allocate %zu bytes\n", PROGRAM_NAME, size);
+         errs++;
+         break;
+      };
+      if (((uintptr_t)ptr % TEST_ALIGN) != 0)
+      {
+         printf("%s: align: allocation of %zu bytes is not aligned\n", PROGRAM_NAME, size);
+         errs++;
+      };
+      memset(ptr, 0xa5, size);
+   };
+   tinytac_arena_reset(&mark);
+
+   return(errs);
+}
+
+
+/// counts memory released by the library
+///
+/// @param[in]  ptr           memory to free
+void
+test_free(
+         void *                        ptr )
+{
+   if ((ptr))
+      atomic_fetch_add(&test_frees, 1);
+   free(ptr);
+   return;
+}
+
+
+/// verifies allocations larger than a chunk
+///
+/// @return    Returns number of failed checks.
+int
+test_large(
+         void )
+{
+   int                     errs;
+   uint8_t *               small;
+   uint8_t *               large;
+   uint8_t *               after;
+   tinytac_arena_mark_t    mark;
+
+   errs = 0;
+   tinytac_arena_mark(&mark);
+   small = tinytac_arena_alloc(TEST_SMALL);
+   large = tinytac_arena_alloc(TEST_LARGE);
+   after = tinytac_arena_alloc(TEST_SMALL);
+   if ( (!(small)) || (!(large)) || (!(after)) )
+   {
+      printf("%s: large: unable to allocate %i bytes\n", PROGRAM_NAME, TEST_LARGE);
+      tinytac_arena_reset(&mark);
+      return(1);
+   };
+   memset(small, 0x11, TEST_SMALL);
+   memset(after, 0x33, TEST_SMALL);
+   memset(large, 0x22, TEST_LARGE);
+   if ( (small[TEST_SMALL - 1] != 0x11) || (after[0] != 0x33) )
+   {
+      printf("%s: large: allocation overlaps other allocations\n", PROGRAM_NAME);
+      errs++;
+   };
+   tinytac_arena_reset(&mark);
+
+   // chunk released by the reset is reused for the next large allocation
+   tinytac_arena_alloc(TEST_SMALL);
+   if (tinytac_arena_alloc(TEST_LARGE) != large)
+   {
+      printf("%s: large: chunk of large allocation was not reused\n", PROGRAM_NAME);
+      errs++;
+   };
+   tinytac_arena_reset(&mark);
+
+   return(errs);
+}
+
+
+/// counts memory allocated by the library
+///
+/// @param[in]  size          number of bytes to allocate
+///
+/// @return    Returns pointer to memory or NULL.
+void *
+test_malloc(
+         size_t                        size )
+{
+   atomic_fetch_add(&test_allocs, 1);
+   return(malloc(size));
+}
+
+
+/// verifies that a reset to an outer mark releases inner allocations
+///
+/// @return    Returns number of failed checks.
+int
+test_nested(
+         void )
+{
+   int                     errs;
+   void *                  outer;
+   void *                  inner;
+   tinytac_arena_mark_t    outer_mark;
+   tinytac_arena_mark_t    inner_mark;
+
+   errs = 0;
+   tinytac_arena_mark(&outer_mark);
+   outer = tinytac_arena_alloc(TEST_SMALL);
+   tinytac_arena_mark(&inner_mark);
+   inner = tinytac_arena_alloc(TEST_SMALL);
+
+   tinytac_arena_reset(&inner_mark);
+   if (tinytac_arena_alloc(TEST_SMALL) != inner)
+   {
+      printf("%s: nested: inner allocation was not released\n", PROGRAM_NAME);
+      errs++;
+   };
+   // spill inner allocations into further chunks
+   tinytac_arena_mark(&inner_mark);
+   tinytac_arena_alloc(TTAC_ARENA_SIZE);
+   tinytac_arena_alloc(TTAC_ARENA_SIZE);
+
+   tinytac_arena_reset(&outer_mark);
+   if (tinytac_arena_alloc(TEST_SMALL) != outer)
+   {
+      printf("%s: nested: outer allocation was not released\n", PROGRAM_NAME);
+      errs++;
+   };
+   tinytac_arena_reset(&outer_mark);
+
+   return(errs);
+}
+
+
+/// counts memory resized by the library
+///
+/// @param[in]  ptr           memory to resize
+/// @param[in]  size          new size of memory
+///
+/// @return    Returns pointer to memory or NULL.
+void *
+test_realloc(
+         void *                        ptr,
+         size_t                        size )
+{
+   if (!(ptr))
+      atomic_fetch_add(&test_allocs, 1);
+   return(realloc(ptr, size));
+}
+
+
+/// verifies that memory released by a reset is returned again
+///
+/// @return    Returns number of failed checks.
+int
+test_reuse(
+         void )
+{
+   int                     errs;
+   void *                  first;
+   void *                  second;
+   tinytac_arena_mark_t    mark;
+
+   errs = 0;
+   tinytac_arena_mark(&mark);
+   if ((first = tinytac_arena_alloc(TEST_SMALL)) == NULL)
+   {
+      printf("%s: reuse: unable to allocate %i bytes\n", PROGRAM_NAME, TEST_SMALL);
+      return(1);
+   };
+   tinytac_arena_reset(&mark);
+   second = tinytac_arena_alloc(TEST_SMALL);
+   if (first != second)
+   {
+      printf("%s: reuse: memory released by reset was not reused\n", PROGRAM_NAME);
+      errs++;
+   };
+   tinytac_arena_reset(&mark);
+
+   return(errs);
+}
+
+
+/// verifies that repeated requests do not allocate after the first one
+///
+/// Each request spills over several chunks, including one larger than
+/// TTAC_ARENA_SIZE, so every chunk must be taken from the spare list.
+///
+/// @return    Returns number of failed checks.
+int
+test_steady(
+         void )
+{
+   size_t                  round;
+   size_t                  pos;
+   size_t                  allocs;
+   tinytac_arena_mark_t    mark;
+
+   allocs = 0;
+   for(round = 0; (round < TEST_ROUNDS); round++)
+   {
+      if (round == 1)
+         allocs = atomic_load(&test_allocs);
+      tinytac_arena_mark(&mark);
+      for(pos = 0; (pos < 5); pos++)
+      {
+         if (!(tinytac_arena_alloc(TTAC_ARENA_SIZE / 2)))
+         {
+            printf("%s: steady: unable to allocate memory\n", PROGRAM_NAME);
+            tinytac_arena_reset(&mark);
+            return(1);
+         };
+      };
+      if (!(tinytac_arena_alloc(TEST_LARGE)))
+      {
+         printf("%s: steady: unable to allocate %i bytes\n", PROGRAM_NAME, TEST_LARGE);
+         tinytac_arena_reset(&mark);
+         return(1);
+      };
+      tinytac_arena_reset(&mark);
+   };
+
+   if ((allocs = atomic_load(&test_allocs) - allocs) != 0)
+   {
+      printf("%s: steady: %zu chunks allocated after first request\n", PROGRAM_NAME, allocs);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+/// runs checks in a thread whose arena is freed when it exits
+///
+/// @param[in]  arg           unused
+///
+/// @return    Returns number of failed checks.
+void *
+test_thread(
+         void *                        arg )
+{
+   int                  errs;
+
+   (void)arg;
+
+   errs  = 0;
+   errs += test_reuse();
+   errs += test_nested();
+   errs += test_align();
+   errs += test_large();
+   errs += test_steady();
+
+   return((void *)(intptr_t)errs);
+}
+
+
+/* end of source */
@@ -0,0 +1,313 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_AUTHOR_MERGE_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <tinytac.h>
+#include <tinytac_plus.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "author-merge-test"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _test_merge
+{
+   const char *            name;
+   uint8_t                 status;
+   int                     rc;
+   const char * const *    args;
+   const char * const *    reply;
+   const char * const *    result;
+} test_merge_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static int
+test_merge(
+         const test_merge_t *          test );
+
+
+static tinytac_pckt_t *
+test_reply(
+         uint8_t                       status,
+         const char * const *          args );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static const char * const test_args[] =
+{
+   "service=shell",
+   "cmd=show",
+   "priv-lvl=1",
+   "cmd-arg=running-config",
+   "priv-lvl=2",
+   "autocmd*menu",
+   NULL
+};
+
+
+static const char * const test_reply_args[] =
+{
+   "priv-lvl=15",
+   "timeout*30",
+   "autocmd=exit",
+   NULL
+};
+
+
+// request pairs of attributes in the reply are superseded regardless of
+// their separator, reply pairs are appended in order
+static const char * const test_add[] =
+{
+   "service=shell",
+   "cmd=show",
+   "cmd-arg=running-config",
+   "priv-lvl=15",
+   "timeout*30",
+   "autocmd=exit",
+   NULL
+};
+
+
+static const char * const test_none[] =
+{
+   NULL
+};
+
+
+static const test_merge_t test_merges[] =
+{
+   { "PASS_ADD",                   TAC_PLUS_AUTHOR_STATUS_PASS_ADD,  TTAC_SUCCESS, test_args, test_reply_args, test_add        },
+   { "PASS_ADD without request",   TAC_PLUS_AUTHOR_STATUS_PASS_ADD,  TTAC_SUCCESS, NULL,      test_reply_args, test_reply_args },
+   { "PASS_ADD without reply",     TAC_PLUS_AUTHOR_STATUS_PASS_ADD,  TTAC_SUCCESS, test_args, test_none,       test_args       },
+   { "PASS_REPL",                  TAC_PLUS_AUTHOR_STATUS_PASS_REPL, TTAC_SUCCESS, test_args, test_reply_args, test_reply_args },
+   { "PASS_REPL without reply",    TAC_PLUS_AUTHOR_STATUS_PASS_REPL, TTAC_SUCCESS, test_args, test_none,       test_none       },
+   { "FAIL",                       TAC_PLUS_AUTHOR_STATUS_FAIL,      TTAC_EINVAL,  test_args, test_reply_args, NULL            },
+   { "ERROR",                      TAC_PLUS_AUTHOR_STATUS_ERROR,     TTAC_EINVAL,  test_args, test_none,       NULL            },
+   { NULL, 0, 0, NULL, NULL, NULL }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+   int                  rc;
+   size_t               pos;
+   size_t               len;
+   char **              argv;
+   void *               arena;
+   tinytac_pckt_t *     reply;
+
+   errs = 0;
+
+   for(pos = 0; ((test_merges[pos].name)); pos++)
+      errs += test_merge(&test_merges[pos]);
+
+   // arenas which are too small are rejected without writing past their end
+   if ((reply = test_reply(TAC_PLUS_AUTHOR_STATUS_PASS_ADD, test_reply_args)) == NULL)
+      return(1);
+   for(len = 0, rc = TTAC_ENOBUFS; ( (rc == TTAC_ENOBUFS) && (len < 4096) ); len++)
+   {
+      if ((arena = malloc(((len)) ? len : 1)) == NULL)
+         break;
+      if ( ((rc = tinytac_author_merge(test_args, reply, arena, len, &argv)) == TTAC_ENOBUFS) && ((argv)) )
+      {
+         printf("%s: arena of %zu bytes: argument vector returned with error\n", PROGRAM_NAME, len);
+         errs++;
+      };
+      free(arena);
+   };
+   if (rc != TTAC_SUCCESS)
+   {
+      printf("%s: no arena size was sufficient\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   // accounting replies cannot be merged
+   reply->pckt_type = TAC_PLUS_TYPE_ACCT;
+   arena = malloc(4096);
+   if ( ((arena)) && (tinytac_author_merge(test_args, reply, arena, 4096, &argv) == TTAC_SUCCESS) )
+   {
+      printf("%s: accounting reply was merged\n", PROGRAM_NAME);
+      errs++;
+   };
+   free(arena);
+   free(reply);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// merges request arguments with reply and compares result
+///
+/// @param[in]  test          arguments, reply, and expected result
+///
+/// @return    Returns number of failed checks.
+int
+test_merge(
+         const test_merge_t *          test )
+{
+   int                  rc;
+   size_t               pos;
+   char **              argv;
+   uint64_t             arena[512];
+   tinytac_pckt_t *     reply;
+
+   if ((reply = test_reply(test->status, test->reply)) == NULL)
+      return(1);
+   rc = tinytac_author_merge(test->args, reply, arena, sizeof(arena), &argv);
+   free(reply);
+
+   if (rc != test->rc)
+   {
+      printf("%s: %s: returned %s\n", PROGRAM_NAME, test->name, tinytac_strerror(rc));
+      return(1);
+   };
+   if (!(test->result))
+      return(0);
+
+   for(pos = 0; ( ((argv[pos])) && ((test->result[pos])) ); pos++)
+   {
+      if ((strcmp(argv[pos], test->result[pos])))
+      {
+         printf("%s: %s: argument %zu is \"%s\", expected \"%s\"\n", PROGRAM_NAME, test->name, pos, argv[pos], test->result[pos]);
+         return(1);
+      };
+   };
+   if ( ((argv[pos])) || ((test->result[pos])) )
+   {
+      printf("%s: %s: unexpected number of arguments\n", PROGRAM_NAME, test->name);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+/// builds unobfuscated authorization REPLY
+///
+/// @param[in]  status        TAC_PLUS_AUTHOR_STATUS_*
+/// @param[in]  args          NULL terminated AV pairs
+///
+/// @return    Returns packet on success or NULL on error.
+tinytac_pckt_t *
+test_reply(
+         uint8_t                       status,
+         const char * const *          args )
+{
+   size_t               arg_cnt;
+   size_t               len;
+   size_t               off;
+   size_t               pos;
+   tinytac_pckt_t *     pckt;
+
+   for(arg_cnt = 0, len = 6; ((args[arg_cnt])); arg_cnt++)
+      len += 1 + strlen(args[arg_cnt]);
+
+   if ((pckt = calloc(1, sizeof(tinytac_pckt_t) + len)) == NULL)
+   {
+      printf("%s: out of virtual memory\n", PROGRAM_NAME);
+      return(NULL);
+   };
+   pckt->pckt_version      = (TAC_PLUS_MAJOR_VER << 4) | TAC_PLUS_MINOR_VER_DEFAULT;
+   pckt->pckt_type         = TAC_PLUS_TYPE_AUTHOR;
+   pckt->pckt_seq_no       = 2;
+   pckt->pckt_flags        = TAC_PLUS_UNENCRYPTED_FLAG;
+   pckt->pckt_session_id   = htonl(0x12345678);
+   pckt->pckt_length       = htonl((uint32_t)len);
+   pckt->pckt_body[0]      = status;
+   pckt->pckt_body[1]      = (uint8_t)arg_cnt;
+
+   off = 6 + arg_cnt;
+   for(pos = 0; (pos < arg_cnt); pos++)
+   {
+      pckt->pckt_body[6 + pos] = (uint8_t)strlen(args[pos]);
+      memcpy(&pckt->pckt_body[off], args[pos], strlen(args[pos]));
+      off += strlen(args[pos]);
+   };
+
+   return(pckt);
+}
+
+
+/* end of source */
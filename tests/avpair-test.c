@@ -0,0 +1,201 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_AVPAIR_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <string.h>
+
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "avpair-test"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+// names which must not match a well-known attribute
+static const char * const test_unknown[] =
+{
+   "",
+   "a",
+   "ac",
+   "acls",
+   "ACL",
+   "servic",
+   "services",
+   "priv_lvl",
+   "cmd-args",
+   "start-time",
+   "shell:roles",
+   NULL
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+   unsigned             id;
+   unsigned             pos;
+   size_t               len;
+   long long            ival;
+   const char *         name;
+   char                 buff[64];
+   tinytac_slice_t      str;
+   tinytac_slice_t      args[4];
+   tinytac_avpairs_t    avp;
+
+   errs = 0;
+
+   // every well-known attribute maps to its own identifier, including
+   // names which are followed by a separator and value
+   for(id = TTAC_AV_UNKNOWN + 1; (id < TTAC_AV_MAX); id++)
+   {
+      if ((name = tinytac_av_name(id)) == NULL)
+      {
+         printf("%s: attribute %u: missing name\n", PROGRAM_NAME, id);
+         errs++;
+         continue;
+      };
+      len = strlen(name);
+      if (tinytac_av_id(name, len) != id)
+      {
+         printf("%s: attribute %u: \"%s\" returned %u\n", PROGRAM_NAME, id, name, tinytac_av_id(name, len));
+         errs++;
+      };
+      snprintf(buff, sizeof(buff), "%s=value", name);
+      if (tinytac_av_id(buff, len) != id)
+      {
+         printf("%s: attribute %u: \"%s\" with value returned %u\n", PROGRAM_NAME, id, name, tinytac_av_id(buff, len));
+         errs++;
+      };
+   };
+   if ( ((tinytac_av_name(TTAC_AV_UNKNOWN))) || ((tinytac_av_name(TTAC_AV_MAX))) )
+   {
+      printf("%s: name returned for unknown attribute\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   // names of other lengths or case are not well-known
+   for(pos = 0; ((test_unknown[pos])); pos++)
+   {
+      if ((id = tinytac_av_id(test_unknown[pos], strlen(test_unknown[pos]))) != TTAC_AV_UNKNOWN)
+      {
+         printf("%s: \"%s\" returned %u\n", PROGRAM_NAME, test_unknown[pos], id);
+         errs++;
+      };
+   };
+
+   // parse pairs and look up values
+   args[0].ptr = "service=shell";    args[0].len = strlen(args[0].ptr);
+   args[1].ptr = "priv-lvl*15";      args[1].len = strlen(args[1].ptr);
+   args[2].ptr = "x-vendor=1";       args[2].len = strlen(args[2].ptr);
+   args[3].ptr = "service=ppp";      args[3].len = strlen(args[3].ptr);
+   if (tinytac_avpairs_parse(&avp, args, 4) != TTAC_SUCCESS)
+   {
+      printf("%s: tinytac_avpairs_parse(): failed\n", PROGRAM_NAME);
+      return(1);
+   };
+   if ( (tinytac_avpairs_get_str(&avp, TTAC_AV_SERVICE, &str) != TTAC_SUCCESS) || (str.len != 5) || ((memcmp(str.ptr, "shell", 5))) )
+   {
+      printf("%s: service: unexpected value\n", PROGRAM_NAME);
+      errs++;
+   };
+   if ( (tinytac_avpairs_get_int(&avp, TTAC_AV_PRIV_LVL, &ival) != TTAC_SUCCESS) || (ival != 15) || (!(avp.optional[1])) )
+   {
+      printf("%s: priv-lvl: unexpected value\n", PROGRAM_NAME);
+      errs++;
+   };
+   if ( (avp.id[2] != TTAC_AV_UNKNOWN) || (tinytac_avpairs_get_str(&avp, TTAC_AV_CMD, &str) != TTAC_ENOENT) )
+   {
+      printf("%s: unknown attribute was indexed\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   // pairs without separator or name are rejected
+   args[0].ptr = "service";          args[0].len = strlen(args[0].ptr);
+   if (tinytac_avpairs_parse(&avp, args, 1) != TTAC_ESYNTAX)
+   {
+      printf("%s: pair without separator was accepted\n", PROGRAM_NAME);
+      errs++;
+   };
+   args[0].ptr = "=shell";           args[0].len = strlen(args[0].ptr);
+   if (tinytac_avpairs_parse(&avp, args, 1) != TTAC_ESYNTAX)
+   {
+      printf("%s: pair without name was accepted\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/* end of source */
@@ -0,0 +1,326 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_REPLY_VIEW_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <tinytac.h>
+#include <tinytac_plus.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "reply-view-test"
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _test_body
+{
+   const char *         name;
+   uint8_t              type;
+   size_t               len;
+   const uint8_t *      body;
+} test_body_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static tinytac_pckt_t *
+test_pckt(
+         uint8_t                       type,
+         const uint8_t *               body,
+         size_t                        len );
+
+
+static int
+test_view(
+         const test_body_t *           test );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static const uint8_t test_authen[] =
+{
+   TAC_PLUS_AUTHEN_STATUS_GETPASS, 0x01,     // status, flags
+   0x00, 0x09,                               // server_msg_len
+   0x00, 0x02,                               // data_len
+   'P', 'a', 's', 's', 'w', 'o', 'r', 'd', ':',
+   0xde, 0xad
+};
+
+
+static const uint8_t test_author[] =
+{
+   TAC_PLUS_AUTHOR_STATUS_PASS_ADD, 0x02,    // status, arg_cnt
+   0x00, 0x03,                               // server_msg_len
+   0x00, 0x02,                               // data_len
+   0x0d, 0x07,                               // arg lengths
+   'm', 's', 'g',
+   'd', 'd',
+   's', 'e', 'r', 'v', 'i', 'c', 'e', '=', 's', 'h', 'e', 'l', 'l',
+   'c', 'm', 'd', '=', 's', 'h', 'w'
+};
+
+
+static const uint8_t test_acct[] =
+{
+   0x00, 0x02,                               // server_msg_len
+   0x00, 0x01,                               // data_len
+   TAC_PLUS_ACCT_STATUS_SUCCESS,             // status
+   'o', 'k',
+   'd'
+};
+
+
+static const test_body_t test_bodies[] =
+{
+   { "authentication", TAC_PLUS_TYPE_AUTHEN, sizeof(test_authen), test_authen },
+   { "authorization",  TAC_PLUS_TYPE_AUTHOR, sizeof(test_author), test_author },
+   { "accounting",     TAC_PLUS_TYPE_ACCT,   sizeof(test_acct),   test_acct   },
+   { NULL, 0, 0, NULL }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                     errs;
+   size_t                  pos;
+   tinytac_pckt_t *        pckt;
+   tinytac_reply_view_t    view;
+
+   errs = 0;
+
+   for(pos = 0; ((test_bodies[pos].name)); pos++)
+      errs += test_view(&test_bodies[pos]);
+
+   // fields of authorization REPLY reference the body
+   if ((pckt = test_pckt(TAC_PLUS_TYPE_AUTHOR, test_author, sizeof(test_author))) == NULL)
+      return(1);
+   if (tinytac_pckt_reply_view(pckt, &view) != TTAC_SUCCESS)
+   {
+      printf("%s: authorization: valid reply was rejected\n", PROGRAM_NAME);
+      free(pckt);
+      return(1);
+   };
+   if ( (view.status != TAC_PLUS_AUTHOR_STATUS_PASS_ADD) || (view.arg_cnt != 2) ||
+        (view.server_msg.len != 3) || ((memcmp(view.server_msg.ptr, "msg", 3))) ||
+        (view.data.len != 2) || ((memcmp(view.data.ptr, "dd", 2))) ||
+        (view.args[0].len != 13) || ((memcmp(view.args[0].ptr, "service=shell", 13))) ||
+        (view.args[1].len != 7) || ((memcmp(view.args[1].ptr, "cmd=shw", 7))) )
+   {
+      printf("%s: authorization: fields do not match body\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   // obfuscated packets are not mapped
+   pckt->pckt_flags = 0;
+   if (tinytac_pckt_reply_view(pckt, &view) != TTAC_EINVAL)
+   {
+      printf("%s: obfuscated reply was accepted\n", PROGRAM_NAME);
+      errs++;
+   };
+
+   // requests and unknown types are not replies
+   pckt->pckt_flags = TAC_PLUS_UNENCRYPTED_FLAG;
+   pckt->pckt_type  = 0x04;
+   if (tinytac_pckt_reply_view(pckt, &view) != TTAC_EBADMSG)
+   {
+      printf("%s: reply of unknown type was accepted\n", PROGRAM_NAME);
+      errs++;
+   };
+   free(pckt);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+tinytac_pckt_t *
+test_pckt(
+         uint8_t                       type,
+         const uint8_t *               body,
+         size_t                        len )
+{
+   tinytac_pckt_t *     pckt;
+
+   // allocated without slack so reads past the body are detected by
+   // memory checkers
+   if ((pckt = malloc(sizeof(tinytac_pckt_t) + len + 1)) == NULL)
+   {
+      printf("%s: out of virtual memory\n", PROGRAM_NAME);
+      return(NULL);
+   };
+   pckt->pckt_version      = (TAC_PLUS_MAJOR_VER << 4) | TAC_PLUS_MINOR_VER_DEFAULT;
+   pckt->pckt_type         = type;
+   pckt->pckt_seq_no       = 2;
+   pckt->pckt_flags        = TAC_PLUS_UNENCRYPTED_FLAG;
+   pckt->pckt_session_id   = htonl(0x12345678);
+   pckt->pckt_length       = htonl((uint32_t)len);
+   if ((len))
+      memcpy(pckt->pckt_body, body, len);
+
+   return(pckt);
+}
+
+
+/// checks that a reply is accepted only when every field fits the body
+///
+/// The complete body must be accepted.  Every shorter body and every body
+/// in which one length field exceeds the remaining bytes must be rejected.
+///
+/// @param[in]  test          REPLY body
+///
+/// @return    Returns number of failed checks.
+int
+test_view(
+         const test_body_t *           test )
+{
+   int                     errs;
+   size_t                  len;
+   size_t                  pos;
+   uint8_t                 body[64];
+   tinytac_pckt_t *        pckt;
+   tinytac_reply_view_t    view;
+
+   errs = 0;
+
+   for(len = 0; (len <= test->len); len++)
+   {
+      if ((pckt = test_pckt(test->type, test->body, len)) == NULL)
+         return(errs + 1);
+      switch(tinytac_pckt_reply_view(pckt, &view))
+      {
+         case TTAC_SUCCESS:
+         if (len < test->len)
+         {
+            printf("%s: %s: body truncated to %zu bytes was accepted\n", PROGRAM_NAME, test->name, len);
+            errs++;
+         };
+         break;
+
+         case TTAC_EBADMSG:
+         if (len == test->len)
+         {
+            printf("%s: %s: valid body was rejected\n", PROGRAM_NAME, test->name);
+            errs++;
+         };
+         break;
+
+         default:
+         printf("%s: %s: unexpected result for body of %zu bytes\n", PROGRAM_NAME, test->name, len);
+         errs++;
+         break;
+      };
+      free(pckt);
+   };
+
+   // increase each length byte so its field ends past the body
+   for(pos = 0; (pos < test->len); pos++)
+   {
+      memcpy(body, test->body, test->len);
+      switch(test->type)
+      {
+         case TAC_PLUS_TYPE_AUTHEN:
+         if ( (pos != 3) && (pos != 5) )
+            continue;
+         break;
+
+         case TAC_PLUS_TYPE_AUTHOR:
+         if ( (pos != 1) && (pos != 3) && (pos != 5) && (pos != 6) && (pos != 7) )
+            continue;
+         break;
+
+         default:
+         if ( (pos != 1) && (pos != 3) )
+            continue;
+         break;
+      };
+      body[pos]++;
+      if ((pckt = test_pckt(test->type, body, test->len)) == NULL)
+         return(errs + 1);
+      if (tinytac_pckt_reply_view(pckt, &view) != TTAC_EBADMSG)
+      {
+         printf("%s: %s: length at offset %zu exceeding body was accepted\n", PROGRAM_NAME, test->name, pos);
+         errs++;
+      };
+      free(pckt);
+   };
+
+   return(errs);
+}
+
+
+/* end of source */
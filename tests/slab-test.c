@@ -0,0 +1,325 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_SLAB_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "slab-test"
+
+#define TEST_HANDLES          8           // not more than half of a magazine
+#define TEST_THREADS          4
+#define TEST_ROUNDS           2000
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+typedef struct _test_exchange
+{
+   pthread_mutex_t         mutex;
+   size_t                  cnt;
+   TinyTac *               handles[TEST_HANDLES * TEST_THREADS];
+} test_exchange_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static void *
+test_free_handles(
+         void *                        arg );
+
+
+static void *
+test_hold_handle(
+         void *                        arg );
+
+
+static int
+test_recycle(
+         void );
+
+
+static int
+test_stress(
+         void );
+
+
+static void *
+test_stress_thread(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static TinyTac *        test_handles[TEST_HANDLES];
+static test_exchange_t  test_exchange = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+
+   errs  = 0;
+   errs += test_recycle();
+   errs += test_stress();
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// frees handles allocated by the main thread and exits
+///
+/// @param[in]  arg           unused
+///
+/// @return    Returns NULL.
+void *
+test_free_handles(
+         void *                        arg )
+{
+   size_t               pos;
+   (void)arg;
+   for(pos = 0; (pos < TEST_HANDLES); pos++)
+      tinytac_free(test_handles[pos]);
+   return(NULL);
+}
+
+
+/// allocates a single handle and exits while holding it
+///
+/// The magazine of the thread is refilled from the depot and still caches
+/// the remaining objects when the thread exits.
+///
+/// @param[in]  arg           pointer to store handle
+///
+/// @return    Returns NULL.
+void *
+test_hold_handle(
+         void *                        arg )
+{
+   TinyTac **           ttp = arg;
+   if (tinytac_initialize(ttp, NULL, NULL, TTAC_NOINIT) != TTAC_SUCCESS)
+      *ttp = NULL;
+   return(NULL);
+}
+
+
+/// verifies that objects cached by exiting threads are reused
+///
+/// Handles freed by one thread are returned to the depot when the thread
+/// exits.  A second thread refills its magazine from the depot, takes one
+/// handle and exits.  The handles left in its magazine must be returned to
+/// the depot, so the main thread reuses every remaining handle.
+///
+/// @return    Returns number of failed checks.
+int
+test_recycle(
+         void )
+{
+   int                  errs;
+   size_t               pos;
+   size_t               idx;
+   TinyTac *            held;
+   TinyTac *            reused[TEST_HANDLES];
+   pthread_t            thread;
+
+   for(pos = 0; (pos < TEST_HANDLES); pos++)
+   {
+      if (tinytac_initialize(&test_handles[pos], NULL, NULL, TTAC_NOINIT) != TTAC_SUCCESS)
+      {
+         printf("%s: tinytac_initialize(): unable to allocate handle\n", PROGRAM_NAME);
+         return(1);
+      };
+   };
+
+   pthread_create(&thread, NULL, &test_free_handles, NULL);
+   pthread_join(thread, NULL);
+   pthread_create(&thread, NULL, &test_hold_handle, &held);
+   pthread_join(thread, NULL);
+   if (!(held))
+   {
+      printf("%s: recycle: unable to allocate handle in thread\n", PROGRAM_NAME);
+      return(1);
+   };
+
+   errs = 0;
+   for(pos = 0; (pos < (TEST_HANDLES - 1)); pos++)
+   {
+      if (tinytac_initialize(&reused[pos], NULL, NULL, TTAC_NOINIT) != TTAC_SUCCESS)
+      {
+         printf("%s: tinytac_initialize(): unable to allocate handle\n", PROGRAM_NAME);
+         errs++;
+         break;
+      };
+      for(idx = 0; ( (idx < TEST_HANDLES) && (reused[pos] != test_handles[idx]) ); idx++);
+      if ( (idx == TEST_HANDLES) || (reused[pos] == held) )
+      {
+         printf("%s: recycle: handle %zu was not taken from the depot\n", PROGRAM_NAME, pos);
+         errs++;
+      };
+   };
+   for(idx = 0; (idx < pos); idx++)
+      tinytac_free(reused[idx]);
+   tinytac_free(held);
+
+   return(errs);
+}
+
+
+/// allocates and frees handles from several threads
+///
+/// Handles are passed between threads, so objects are freed into the
+/// magazines of other threads than the one which allocated them.
+///
+/// @return    Returns number of failed checks.
+int
+test_stress(
+         void )
+{
+   int                  errs;
+   size_t               pos;
+   void *               res;
+   pthread_t            threads[TEST_THREADS];
+
+   errs = 0;
+   for(pos = 0; (pos < TEST_THREADS); pos++)
+      pthread_create(&threads[pos], NULL, &test_stress_thread, NULL);
+   for(pos = 0; (pos < TEST_THREADS); pos++)
+   {
+      pthread_join(threads[pos], &res);
+      if ((res))
+         errs++;
+   };
+   for(pos = 0; (pos < test_exchange.cnt); pos++)
+      tinytac_free(test_exchange.handles[pos]);
+
+   return(errs);
+}
+
+
+/// allocates handles and frees handles allocated by other threads
+///
+/// @param[in]  arg           unused
+///
+/// @return    Returns NULL on success or a non-NULL value on error.
+void *
+test_stress_thread(
+         void *                        arg )
+{
+   unsigned             round;
+   size_t               pos;
+   TinyTac *            tt;
+   TinyTac *            own[TEST_HANDLES];
+
+   (void)arg;
+
+   for(round = 0; (round < TEST_ROUNDS); round++)
+   {
+      for(pos = 0; (pos < TEST_HANDLES); pos++)
+      {
+         if (tinytac_initialize(&own[pos], NULL, NULL, TTAC_NOINIT) != TTAC_SUCCESS)
+         {
+            printf("%s: stress: unable to allocate handle\n", PROGRAM_NAME);
+            while (pos > 0)
+               tinytac_free(own[--pos]);
+            return(arg);
+         };
+      };
+
+      // swap own handles with handles left by other threads
+      pthread_mutex_lock(&test_exchange.mutex);
+      for(pos = 0; (pos < TEST_HANDLES); pos++)
+      {
+         tt = own[pos];
+         if ((test_exchange.cnt))
+            own[pos] = test_exchange.handles[--test_exchange.cnt];
+         else
+            own[pos] = NULL;
+         test_exchange.handles[test_exchange.cnt++] = tt;
+      };
+      pthread_mutex_unlock(&test_exchange.mutex);
+
+      for(pos = 0; (pos < TEST_HANDLES); pos++)
+         tinytac_free(own[pos]);
+   };
+
+   return(NULL);
+}
+
+
+/* end of source */
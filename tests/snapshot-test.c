@@ -0,0 +1,401 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_SNAPSHOT_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "lsnapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <tinytac.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "snapshot-test"
+
+#define TEST_SCHEMA           0x74736574ULL
+#define TEST_OPT_VALUE        1           // option recorded with value
+#define TEST_OPT_EMPTY        2           // option recorded without value
+#define TEST_VALUE            "tacacs+://127.0.0.1"
+#define TEST_CONF             "hosts tacacs+://127.0.0.1\n"
+#define TEST_ENV              "TINYTAC_SNAPSHOT_TEST"
+
+#define TEST_MODIFIED         0           // size of configuration file changed
+#define TEST_TOUCHED          1           // modification time of configuration file changed
+#define TEST_CREATED          2           // missing configuration file was created
+#define TEST_SCHEMA_CHANGED   3           // library or option table changed
+#define TEST_ENVIRON          4           // TINYTAC variable of environment changed
+#define TEST_MODE             5           // snapshot is accessible by other users
+#define TEST_TRUNCATED        6           // snapshot was truncated
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static int
+test_apply(
+         unsigned                      opt_id,
+         const char *                  value );
+
+
+static int
+test_prepare(
+         int                           tainted );
+
+
+static int
+test_stale(
+         const char *                  desc,
+         int                           change );
+
+
+static int
+test_tainted(
+         void );
+
+
+static int
+test_valid(
+         void );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#pragma mark - Variables
+
+static size_t           test_applied;
+static size_t           test_invalid;
+static char             test_conf[64];
+static char             test_missing[64];
+static char             test_file[64];
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+   char                 dir[] = "snapshot-test.XXXXXX";
+
+   if (mkdtemp(dir) == NULL)
+   {
+      printf("%s: mkdtemp(): unable to create directory\n", PROGRAM_NAME);
+      return(1);
+   };
+   snprintf(test_conf,    sizeof(test_conf),    "%s/tinytac.conf", dir);
+   snprintf(test_missing, sizeof(test_missing), "%s/missing.conf", dir);
+   snprintf(test_file,    sizeof(test_file),    "%s/%s", dir, TTAC_SNAPSHOT_NAME);
+
+   errs  = 0;
+   errs += test_valid();
+   errs += test_stale("modified file",          TEST_MODIFIED);
+   errs += test_stale("touched file",           TEST_TOUCHED);
+   errs += test_stale("created file",           TEST_CREATED);
+   errs += test_stale("changed schema",         TEST_SCHEMA_CHANGED);
+   errs += test_stale("changed environment",    TEST_ENVIRON);
+   errs += test_stale("readable snapshot",      TEST_MODE);
+   errs += test_stale("truncated snapshot",     TEST_TRUNCATED);
+   errs += test_tainted();
+
+   unlink(test_file);
+   unlink(test_missing);
+   unlink(test_conf);
+   rmdir(dir);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// records option applied from snapshot
+///
+/// @param[in]  opt_id        option identifier
+/// @param[in]  value         value of option or NULL
+///
+/// @return    Returns TTAC_SUCCESS.
+int
+test_apply(
+         unsigned                      opt_id,
+         const char *                  value )
+{
+   test_applied++;
+   switch(opt_id)
+   {
+      case TEST_OPT_VALUE:
+      if ( (!(value)) || ((strcmp(value, TEST_VALUE))) )
+         test_invalid++;
+      break;
+
+      case TEST_OPT_EMPTY:
+      if ((value))
+         test_invalid++;
+      break;
+
+      default:
+      test_invalid++;
+      break;
+   };
+   return(TTAC_SUCCESS);
+}
+
+
+/// writes configuration file and saves snapshot which consulted it
+///
+/// The snapshot records the existing configuration file, a configuration
+/// file which does not exist, and two options.
+///
+/// @param[in]  tainted       taint snapshot before saving it
+///
+/// @return    Returns 0 on success or -1 on error.
+int
+test_prepare(
+         int                           tainted )
+{
+   int                     fd;
+   tinytac_snapshot_t *    snap;
+
+   unsetenv(TEST_ENV);
+   unlink(test_file);
+   unlink(test_missing);
+   if ((fd = open(test_conf, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+   {
+      printf("%s: open(): unable to create %s\n", PROGRAM_NAME, test_conf);
+      return(-1);
+   };
+   if (write(fd, TEST_CONF, strlen(TEST_CONF)) != (ssize_t)strlen(TEST_CONF))
+   {
+      printf("%s: write(): unable to write %s\n", PROGRAM_NAME, test_conf);
+      close(fd);
+      return(-1);
+   };
+   close(fd);
+
+   if ((snap = tinytac_snapshot_alloc(TEST_SCHEMA)) == NULL)
+   {
+      printf("%s: tinytac_snapshot_alloc(): out of virtual memory\n", PROGRAM_NAME);
+      return(-1);
+   };
+   tinytac_snapshot_path(snap, test_conf);
+   tinytac_snapshot_path(snap, test_missing);
+   tinytac_snapshot_opt(snap, TEST_OPT_VALUE, TEST_VALUE);
+   tinytac_snapshot_opt(snap, TEST_OPT_EMPTY, NULL);
+   if ((tainted))
+      tinytac_snapshot_taint(snap);
+   tinytac_snapshot_save(snap, test_file);
+   tinytac_snapshot_free(snap);
+
+   return(0);
+}
+
+
+/// verifies that a stale snapshot is not applied
+///
+/// @param[in]  desc          description of change
+/// @param[in]  change        change which makes the snapshot stale
+///
+/// @return    Returns number of failed checks.
+int
+test_stale(
+         const char *                  desc,
+         int                           change )
+{
+   int                  fd;
+   int                  rc;
+   uint64_t             schema;
+   struct stat          sb;
+   struct timespec      times[2];
+
+   if ((test_prepare(0)))
+      return(1);
+   schema = TEST_SCHEMA;
+   rc     = 0;
+
+   switch(change)
+   {
+      case TEST_MODIFIED:
+      if ((fd = open(test_conf, O_WRONLY | O_APPEND)) == -1)
+         rc = -1;
+      else if (write(fd, TEST_CONF, strlen(TEST_CONF)) == -1)
+         rc = -1;
+      if (fd != -1)
+         close(fd);
+      break;
+
+      case TEST_TOUCHED:
+      times[0].tv_sec  = 0;
+      times[0].tv_nsec = UTIME_OMIT;
+      times[1].tv_sec  = 1000000000;
+      times[1].tv_nsec = 0;
+      rc = utimensat(AT_FDCWD, test_conf, times, 0);
+      break;
+
+      case TEST_CREATED:
+      if ((fd = open(test_missing, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+         rc = -1;
+      else
+         close(fd);
+      break;
+
+      case TEST_SCHEMA_CHANGED:
+      schema++;
+      break;
+
+      case TEST_ENVIRON:
+      rc = setenv(TEST_ENV, "1", 1);
+      break;
+
+      case TEST_MODE:
+      rc = chmod(test_file, 0644);
+      break;
+
+      case TEST_TRUNCATED:
+      if ((rc = stat(test_file, &sb)) == 0)
+         rc = truncate(test_file, (sb.st_size - 1));
+      break;
+
+      default:
+      break;
+   };
+   if (rc == -1)
+   {
+      printf("%s: %s: unable to change files\n", PROGRAM_NAME, desc);
+      return(1);
+   };
+
+   test_applied = 0;
+   rc = tinytac_snapshot_load(test_file, schema, &test_apply);
+   unsetenv(TEST_ENV);
+
+   if (rc != TTAC_ENOENT)
+   {
+      printf("%s: %s: stale snapshot was loaded\n", PROGRAM_NAME, desc);
+      return(1);
+   };
+   if ((test_applied))
+   {
+      printf("%s: %s: %zu options of stale snapshot applied\n", PROGRAM_NAME, desc, test_applied);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+/// verifies that a tainted snapshot is not saved
+///
+/// @return    Returns number of failed checks.
+int
+test_tainted(
+         void )
+{
+   if ((test_prepare(1)))
+      return(1);
+   if (access(test_file, F_OK) == 0)
+   {
+      printf("%s: tainted: tainted snapshot was saved\n", PROGRAM_NAME);
+      return(1);
+   };
+   return(0);
+}
+
+
+/// verifies that an unchanged snapshot is applied
+///
+/// @return    Returns number of failed checks.
+int
+test_valid(
+         void )
+{
+   int                  errs;
+
+   if ((test_prepare(0)))
+      return(1);
+
+   errs           = 0;
+   test_applied   = 0;
+   test_invalid   = 0;
+   if (tinytac_snapshot_load(test_file, TEST_SCHEMA, &test_apply) != TTAC_SUCCESS)
+   {
+      printf("%s: valid: unable to load snapshot\n", PROGRAM_NAME);
+      return(1);
+   };
+   if (test_applied != 2)
+   {
+      printf("%s: valid: %zu of 2 options applied\n", PROGRAM_NAME, test_applied);
+      errs++;
+   };
+   if ((test_invalid))
+   {
+      printf("%s: valid: %zu options applied with wrong value\n", PROGRAM_NAME, test_invalid);
+      errs++;
+   };
+
+   return(errs);
+}
+
+
+/* end of source */
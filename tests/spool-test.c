@@ -0,0 +1,481 @@
+/*
+ *  Tiny TACACS+ Client Library
+ *  Copyright (C) 2022 David M. Syzdek <david@syzdek.net>.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of David M. Syzdek nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DAVID M. SYZDEK BE LIABLE FOR
+ *  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+#define _TESTS_SPOOL_TEST_C 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "lspool.h"
+#include "lmemory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+
+#include <tinytac_plus.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#undef PROGRAM_NAME
+#define PROGRAM_NAME "spool-test"
+
+#define TEST_RING_SIZE        4096
+#define TEST_ROUNDS           500
+#define TEST_BATCH            5
+#define TEST_REC_HDR          8           // length and checksum preceding packet
+#define TEST_REC_SIZE(len)    ((TEST_REC_HDR + sizeof(tinytac_pckt_t) + (len) + 7) & ~((size_t)7))
+
+#define TEST_CORRUPT          0           // data of record was modified
+#define TEST_PENDING          1           // writer terminated while copying record
+#define TEST_UNMARKED         2           // writer terminated before marking record
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+main(
+         void );
+
+
+static int
+test_check(
+         const char *                  name,
+         tinytac_pckt_t *              pckt,
+         uint32_t                      seq );
+
+
+static int
+test_damaged(
+         const char *                  path,
+         const char *                  name,
+         int                           damage );
+
+
+static tinytac_spool_t *
+test_open(
+         const char *                  path );
+
+
+static tinytac_pckt_t *
+test_pckt(
+         uint32_t                      seq );
+
+
+static size_t
+test_pckt_len(
+         uint32_t                      seq );
+
+
+static int
+test_poke(
+         const char *                  path,
+         uint64_t                      off,
+         const void *                  data,
+         size_t                        len );
+
+
+static int
+test_wrap(
+         const char *                  path );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+int
+main(
+         void )
+{
+   int                  errs;
+   int                  fd;
+   char                 path[] = "spool-test.XXXXXX";
+
+   if ((fd = mkstemp(path)) == -1)
+   {
+      printf("%s: mkstemp(): unable to create spool\n", PROGRAM_NAME);
+      return(1);
+   };
+   close(fd);
+
+   errs  = 0;
+   errs += test_wrap(path);
+   errs += test_damaged(path, "damaged record",       TEST_CORRUPT);
+   errs += test_damaged(path, "unpublished record",   TEST_PENDING);
+   errs += test_damaged(path, "unmarked record",      TEST_UNMARKED);
+
+   unlink(path);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// compares record read from spool with the record which was appended
+///
+/// @param[in]  name          name of test
+/// @param[in]  pckt          record read from spool
+/// @param[in]  seq           sequence number of expected record
+///
+/// @return    Returns 0 if the records match, otherwise 1.
+int
+test_check(
+         const char *                  name,
+         tinytac_pckt_t *              pckt,
+         uint32_t                      seq )
+{
+   int                  rc;
+   tinytac_pckt_t *     expect;
+
+   if ((expect = test_pckt(seq)) == NULL)
+      return(1);
+   rc = (memcmp(pckt, expect, (sizeof(tinytac_pckt_t) + test_pckt_len(seq))) != 0) ? 1 : 0;
+   if ((rc))
+      printf("%s: %s: record %u was expected, record %u was read\n", PROGRAM_NAME, name, seq, ntohl(pckt->pckt_session_id));
+   free(expect);
+
+   return(rc);
+}
+
+
+/// replays a spool in which the second of three records was damaged
+///
+/// The record is corrupted, left pending as if its writer terminated while
+/// copying it, or zeroed as if its writer terminated before marking it.
+/// The first and third records must be replayed, the unfinished records
+/// only after TTAC_SPOOL_STALL seconds.
+///
+/// @param[in]  path          file name of spool
+/// @param[in]  name          name of test
+/// @param[in]  damage        TEST_CORRUPT, TEST_PENDING, or TEST_UNMARKED
+///
+/// @return    Returns number of failed checks.
+int
+test_damaged(
+         const char *                  path,
+         const char *                  name,
+         int                           damage )
+{
+   int                  errs;
+   size_t               n;
+   size_t               pos;
+   uint32_t             seq;
+   uint32_t             len;
+   uint64_t             off;
+   uint64_t             cursor;
+   uint8_t              zero[TEST_REC_SIZE(255)];
+   tinytac_pckt_t *     pckt;
+   tinytac_pckt_t *     batch[TEST_BATCH];
+   tinytac_spool_t *    spool;
+
+   if ((spool = test_open(path)) == NULL)
+      return(1);
+
+   for(seq = 1; (seq <= 3); seq++)
+   {
+      if ((pckt = test_pckt(seq)) == NULL)
+         break;
+      if (tinytac_spool_append(spool, pckt) == -1)
+         printf("%s: %s: unable to append record %u\n", PROGRAM_NAME, name, seq);
+      free(pckt);
+   };
+
+   // second record follows the first record
+   off = TEST_REC_SIZE(test_pckt_len(1));
+   len = (uint32_t)(sizeof(tinytac_pckt_t) + test_pckt_len(2));
+   switch(damage)
+   {
+      case TEST_PENDING:
+      len |= TTAC_SPOOL_PENDING;
+      test_poke(path, off, &len, sizeof(len));
+      break;
+
+      case TEST_UNMARKED:
+      memset(zero, 0, sizeof(zero));
+      test_poke(path, off, zero, TEST_REC_SIZE(test_pckt_len(2)));
+      break;
+
+      default:
+      test_poke(path, (off + TEST_REC_HDR + sizeof(tinytac_pckt_t)), "X", 1);
+      break;
+   };
+
+   errs  = 0;
+   n     = tinytac_spool_read(spool, batch, TEST_BATCH, &cursor);
+   if ( (damage == TEST_CORRUPT) && (n != 2) )
+   {
+      printf("%s: %s: %zu records were read, 2 were expected\n", PROGRAM_NAME, name, n);
+      errs++;
+   };
+   if ( (damage != TEST_CORRUPT) && (n != 1) )
+   {
+      printf("%s: %s: %zu records were read before the unfinished record, 1 was expected\n", PROGRAM_NAME, name, n);
+      errs++;
+   };
+   for(pos = 0; (pos < n); pos++)
+   {
+      errs += test_check(name, batch[pos], (uint32_t)((pos * 2) + 1));
+      tinytac_mem_free(batch[pos]);
+   };
+   tinytac_spool_commit(spool, cursor);
+
+   // unfinished record is skipped once it stalled
+   if (damage != TEST_CORRUPT)
+   {
+      if ((n = tinytac_spool_read(spool, batch, TEST_BATCH, &cursor)) != 0)
+      {
+         printf("%s: %s: unfinished record was skipped before it stalled\n", PROGRAM_NAME, name);
+         errs++;
+      };
+      for(pos = 0; (pos < n); pos++)
+         tinytac_mem_free(batch[pos]);
+      sleep(TTAC_SPOOL_STALL + 1);
+      if ((n = tinytac_spool_read(spool, batch, TEST_BATCH, &cursor)) != 1)
+      {
+         printf("%s: %s: %zu records were read after the unfinished record, 1 was expected\n", PROGRAM_NAME, name, n);
+         errs++;
+      };
+      for(pos = 0; (pos < n); pos++)
+      {
+         errs += test_check(name, batch[pos], 3);
+         tinytac_mem_free(batch[pos]);
+      };
+      tinytac_spool_commit(spool, cursor);
+   };
+
+   if (tinytac_spool_read(spool, batch, TEST_BATCH, &cursor) != 0)
+   {
+      printf("%s: %s: spool is not empty after replay\n", PROGRAM_NAME, name);
+      errs++;
+   };
+   tinytac_spool_close(spool);
+
+   return(errs);
+}
+
+
+/// creates new spool
+///
+/// @param[in]  path          file name of spool
+///
+/// @return    Returns spool on success or NULL on error.
+tinytac_spool_t *
+test_open(
+         const char *                  path )
+{
+   tinytac_spool_t *    spool;
+   unlink(path);
+   if ((spool = tinytac_spool_open(path, TEST_RING_SIZE)) == NULL)
+      printf("%s: tinytac_spool_open(): unable to open %s\n", PROGRAM_NAME, path);
+   return(spool);
+}
+
+
+/// builds accounting REQUEST whose body is derived from sequence number
+///
+/// @param[in]  seq           sequence number of record
+///
+/// @return    Returns packet on success or NULL on error.
+tinytac_pckt_t *
+test_pckt(
+         uint32_t                      seq )
+{
+   size_t               len;
+   size_t               pos;
+   tinytac_pckt_t *     pckt;
+
+   len = test_pckt_len(seq);
+   if ((pckt = malloc(sizeof(tinytac_pckt_t) + len)) == NULL)
+   {
+      printf("%s: out of virtual memory\n", PROGRAM_NAME);
+      return(NULL);
+   };
+   pckt->pckt_version      = (TAC_PLUS_MAJOR_VER << 4) | TAC_PLUS_MINOR_VER_DEFAULT;
+   pckt->pckt_type         = TAC_PLUS_TYPE_ACCT;
+   pckt->pckt_seq_no       = 1;
+   pckt->pckt_flags        = 0;
+   pckt->pckt_session_id   = htonl(seq);
+   pckt->pckt_length       = htonl((uint32_t)len);
+   for(pos = 0; (pos < len); pos++)
+      pckt->pckt_body[pos] = (uint8_t)(seq + pos);
+
+   return(pckt);
+}
+
+
+/// returns length of body of record, which varies so that records and
+/// fillers end at different offsets of the ring
+size_t
+test_pckt_len(
+         uint32_t                      seq )
+{
+   return(((size_t)seq * 37) % 256);
+}
+
+
+/// writes to file of spool, which is shared with its mapping
+///
+/// @param[in]  path          file name of spool
+/// @param[in]  off           offset within ring
+/// @param[in]  data          bytes to write
+/// @param[in]  len           number of bytes
+///
+/// @return    Returns 0 on success or 1 on error.
+int
+test_poke(
+         const char *                  path,
+         uint64_t                      off,
+         const void *                  data,
+         size_t                        len )
+{
+   int      fd;
+   ssize_t  rc;
+
+   if ((fd = open(path, O_WRONLY)) == -1)
+      return(1);
+   rc = pwrite(fd, data, len, (off_t)(TTAC_SPOOL_HDR_SIZE + off));
+   close(fd);
+
+   return((rc == (ssize_t)len) ? 0 : 1);
+}
+
+
+/// appends and replays records until the ring wrapped many times
+///
+/// Records are appended until the spool is full, then replayed in small
+/// batches.  Every appended record must be replayed once and in order,
+/// including records which follow a filler at the end of the ring and
+/// records written before the spool was reopened.
+///
+/// @param[in]  path          file name of spool
+///
+/// @return    Returns number of failed checks.
+int
+test_wrap(
+         const char *                  path )
+{
+   int                  errs;
+   int                  full;
+   size_t               n;
+   size_t               pos;
+   unsigned             round;
+   uint32_t             next;
+   uint32_t             expect;
+   uint64_t             cursor;
+   tinytac_pckt_t *     pckt;
+   tinytac_pckt_t *     batch[TEST_BATCH];
+   tinytac_spool_t *    spool;
+
+   if ((spool = test_open(path)) == NULL)
+      return(1);
+
+   errs     = 0;
+   next     = 1;
+   expect   = 1;
+
+   for(round = 0; ( (round < TEST_ROUNDS) && (!(errs)) ); round++)
+   {
+      // fill spool, leaving part of it unread every other round
+      for(full = 0; (!(full)); next++)
+      {
+         if ((pckt = test_pckt(next)) == NULL)
+            return(errs + 1);
+         full = tinytac_spool_append(spool, pckt);
+         free(pckt);
+      };
+      next--;
+
+      // replayed records must survive closing the spool
+      if ((round % 50) == 0)
+      {
+         tinytac_spool_close(spool);
+         if ((spool = tinytac_spool_open(path, TEST_RING_SIZE)) == NULL)
+         {
+            printf("%s: wrap: unable to reopen spool\n", PROGRAM_NAME);
+            return(errs + 1);
+         };
+      };
+
+      do
+      {
+         n = tinytac_spool_read(spool, batch, TEST_BATCH, &cursor);
+         for(pos = 0; (pos < n); pos++)
+         {
+            errs += test_check("wrap", batch[pos], expect++);
+            tinytac_mem_free(batch[pos]);
+         };
+         tinytac_spool_commit(spool, cursor);
+      } while ( ((n)) && ( ((round % 2)) || ((next - expect) > 8) ) );
+   };
+
+   // drain remaining records
+   while ((n = tinytac_spool_read(spool, batch, TEST_BATCH, &cursor)) != 0)
+   {
+      for(pos = 0; (pos < n); pos++)
+      {
+         errs += test_check("wrap", batch[pos], expect++);
+         tinytac_mem_free(batch[pos]);
+      };
+      tinytac_spool_commit(spool, cursor);
+   };
+   if (expect != next)
+   {
+      printf("%s: wrap: %u records were appended, %u were read\n", PROGRAM_NAME, (next - 1), (expect - 1));
+      errs++;
+   };
+
+   tinytac_spool_close(spool);
+
+   return(errs);
+}
+
+
+/* end of source */